@@ -0,0 +1,70 @@
+#pragma once
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+#include <string>
+#include <vector>
+#include "shader.hpp"
+#include "model.hpp"
+#include "scene.hpp"
+#include "LightmapBaker.hpp"
+#include "ShadowAtlas.hpp"
+
+// Per-instance animation parameters, uploaded once as instanced vertex attributes
+// (locations 3-7 in animated.vert)
+struct AnimatedInstance {
+    glm::vec4 basePosition;  // xyz = base position, w = flags (1 rotate, 2 float, 4 orbit)
+    glm::vec4 orbit;         // xyz = orbit center, w = orbit radius
+    glm::vec4 motion;        // orbitSpeed, orbitPhase, floatAmplitude, floatSpeed
+    glm::vec4 spin;          // floatPhase, rotationSpeed, base rotation x, base rotation y
+    glm::vec4 rotationScale; // base rotation z, scale xyz
+};
+
+// Baked irradiance at one instance (IrradianceProbes, 9 RGB coefficients packed into
+// 7 vec4s), instanced vertex attributes at locations 8-14 of animated.vert
+struct InstanceProbeLighting {
+    glm::vec4 packed[7];
+};
+
+// Draws objects whose procedural animation (orbit, float, spin) is a closed-form
+// function of time. The transform is rebuilt in the vertex shader from the time
+// uniform, so these objects cost no CPU time and no per-frame uploads - except
+// their probe lighting while a bake applies (a few floats per instance).
+class AnimatedInstanceRenderer {
+private:
+    struct InstanceGroup {
+        MaterialHandle material = INVALID_MATERIAL;
+        GLuint VAO = 0;         // Model vertices + instance attributes
+        const Model* model = nullptr; // Vertex count is read at draw time (meshes may stream in late)
+        GLsizei instanceCount = 0;
+    };
+
+    GLuint instanceBuffer = 0;         // All AnimatedInstance records, grouped by model
+    GLuint probeBuffer = 0;            // InstanceProbeLighting per record, same order
+    size_t instanceBytes = 0;          // Both buffers, reported to GpuMemory
+    std::vector<AnimatedInstance> instances;       // CPU copy, to find where instances are
+    std::vector<InstanceProbeLighting> probeLighting;
+    std::vector<InstanceGroup> groups;
+    float animationStart = 0.0f;       // Time the phases were captured at
+
+    // Position part of animated.vert at this time
+    glm::vec3 instancePosition(const AnimatedInstance& instance, float time) const;
+
+public:
+    ~AnimatedInstanceRenderer();
+
+    // Capture animation state of every object flagged gpuAnimated and upload it
+    void initialize(const Scene& scene, const std::vector<DrawBatch>& batches, float startTime);
+    void cleanup();
+
+    // Sample the probes at every instance's position at this time and upload the result
+    // (read by the PROBE_STATIC_LIGHTS variants)
+    void updateProbeLighting(const IrradianceProbes& probes, float time);
+
+    // Bounding sphere of every instance at this time (shadow casters, see ShadowAtlas)
+    void getInstanceSpheres(float time, std::vector<ShadowCaster>& spheres) const;
+
+    // Draw all animated instances (assumes shader is active with view uniforms and time set)
+    void draw(Shader& shader) const;
+
+    size_t getInstanceCount() const;
+};
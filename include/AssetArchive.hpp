@@ -0,0 +1,82 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// On-disk layout of a .bpak archive:
+//   ArchiveHeader | ArchiveEntry[entryCount] (sorted by nameHash) | blobs (each aligned to ARCHIVE_ALIGNMENT)
+// Blobs are stored ready for upload (flattened vertex arrays, decoded pixels, shader text)
+// so the runtime can hand mapped memory straight to OpenGL.
+namespace ArchiveFormat {
+    const char MAGIC[4] = { 'B', 'P', 'A', 'K' };
+    const uint32_t VERSION = 1;
+    const uint64_t ALIGNMENT = 4096;  // Blob alignment (page size)
+}
+
+enum class ArchiveEntryType : uint32_t {
+    Raw = 0,
+    Mesh = 1,            // Interleaved floats, 8 per vertex (width = vertex count)
+    TextureRaw = 2,      // Decoded pixels, flipped for GL (width, height, channels)
+    TextureEncoded = 3,  // Original PNG/JPEG bytes, decoded with stbi_load_from_memory
+    Shader = 4,          // GLSL source text
+    TextureCompressed = 5 // DDS file with a BCn mip chain (cooked with --compress-textures)
+};
+
+namespace ArchiveFlags {
+    const uint32_t COMPRESSED = 1;  // Blob is Compression::compress output
+}
+
+struct ArchiveHeader {
+    char magic[4];
+    uint32_t version;
+    uint32_t entryCount;
+    uint32_t reserved;
+    uint64_t tocOffset;    // Offset of the first ArchiveEntry
+    uint64_t reserved2;
+};
+
+struct ArchiveEntry {       // 64 bytes, TOC stays cache-line aligned
+    uint64_t nameHash;      // AssetArchive::hashName of the normalized path
+    uint64_t offset;        // Blob offset from start of file
+    uint64_t storedSize;    // Bytes in the archive
+    uint64_t size;          // Bytes after decompression
+    uint32_t type;          // ArchiveEntryType
+    uint32_t flags;         // ArchiveFlags
+    uint32_t width;         // Vertex count for meshes, pixel width for textures
+    uint32_t height;
+    uint32_t channels;
+    uint32_t reserved[3];
+};
+
+static_assert(sizeof(ArchiveEntry) == 64, "ArchiveEntry must stay 64 bytes");
+
+// Read-only view of a memory-mapped archive. Once mounted, loaders check it
+// before touching loose files under assets/ and shaders/.
+class AssetArchive {
+public:
+    // Map archive into memory (returns false and stays unmounted if missing/invalid)
+    static bool mount(const std::string& path);
+    static void unmount();
+    static bool isMounted() { return mappedData != nullptr; }
+
+    // Look up an entry by path, nullptr if not packed
+    static const ArchiveEntry* find(const std::string& name);
+
+    // Pointer to entry contents. Uncompressed entries point straight into the mapping
+    // (zero-copy); compressed ones are inflated into scratch.
+    static const uint8_t* data(const ArchiveEntry& entry, std::vector<uint8_t>& scratch);
+
+    // 64-bit FNV-1a of the normalized path ("assets/models/book.obj")
+    static uint64_t hashName(const std::string& name);
+
+    // 64-bit FNV-1a of raw bytes (content hashes for caches)
+    static uint64_t hashBytes(const uint8_t* data, size_t size);
+
+private:
+    static const uint8_t* mappedData;
+    static size_t mappedSize;
+    static const ArchiveEntry* entries;
+    static uint32_t entryCount;
+    static void* fileHandle;     // Platform handles kept for unmapping
+    static void* mappingHandle;
+};
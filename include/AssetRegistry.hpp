@@ -0,0 +1,232 @@
+#pragma once
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include "model.hpp"
+#include "texture.hpp"
+
+// Typed index into an AssetPool. The generation detects handles to slots that
+// were freed and reused (generation 0 = null handle).
+template <typename T>
+struct AssetHandle {
+    uint32_t index = 0;
+    uint32_t generation = 0;
+
+    bool isValid() const { return generation != 0; }
+    bool operator==(const AssetHandle& other) const { return index == other.index && generation == other.generation; }
+    bool operator!=(const AssetHandle& other) const { return !(*this == other); }
+};
+
+// Storage for one asset type: owns the objects, deduplicates by path and counts references.
+// Assets whose count drops to zero stay alive until collect() (called between frames),
+// so nothing is destroyed while a draw that uses it might still be in flight this frame.
+template <typename T>
+class AssetPool {
+public:
+    AssetHandle<T> find(const std::string& path) const {
+        auto it = lookup.find(path);
+        if (it == lookup.end()) return AssetHandle<T>();
+        return AssetHandle<T>{ it->second, slots[it->second].generation };
+    }
+
+    AssetHandle<T> add(const std::string& path, std::unique_ptr<T> asset) {
+        uint32_t index;
+        if (!freeSlots.empty()) {
+            index = freeSlots.back();
+            freeSlots.pop_back();
+        }
+        else {
+            index = static_cast<uint32_t>(slots.size());
+            slots.emplace_back();
+        }
+
+        Slot& slot = slots[index];
+        slot.asset = std::move(asset);
+        slot.path = path;
+        slot.refCount = 0;
+        lookup[path] = index;
+        unreferenced.push_back(index);  // Collected unless someone takes a reference
+        return AssetHandle<T>{ index, slot.generation };
+    }
+
+    T* get(AssetHandle<T> handle) const {
+        const Slot* slot = resolve(handle);
+        return slot ? slot->asset.get() : nullptr;
+    }
+
+    void addRef(AssetHandle<T> handle) {
+        if (Slot* slot = resolve(handle)) slot->refCount++;
+    }
+
+    void release(AssetHandle<T> handle) {
+        Slot* slot = resolve(handle);
+        if (slot && slot->refCount > 0 && --slot->refCount == 0) {
+            unreferenced.push_back(handle.index);
+        }
+    }
+
+    uint32_t getRefCount(AssetHandle<T> handle) const {
+        const Slot* slot = resolve(handle);
+        return slot ? slot->refCount : 0;
+    }
+
+    // Destroy assets nobody references any more. Returns how many were freed.
+    size_t collect() {
+        size_t freed = 0;
+        for (uint32_t index : unreferenced) {
+            Slot& slot = slots[index];
+            if (!slot.asset || slot.refCount > 0) continue;  // Re-acquired or already freed
+
+            lookup.erase(slot.path);
+            slot.asset.reset();
+            slot.path.clear();
+            if (++slot.generation == 0) slot.generation = 1;  // Invalidate outstanding handles
+            freeSlots.push_back(index);
+            freed++;
+        }
+        unreferenced.clear();
+        return freed;
+    }
+
+    // Destroy everything regardless of references. Returns how many were still referenced.
+    size_t clear() {
+        size_t referenced = 0;
+        for (const auto& slot : slots) {
+            if (slot.asset && slot.refCount > 0) referenced++;
+        }
+        slots.clear();
+        freeSlots.clear();
+        unreferenced.clear();
+        lookup.clear();
+        return referenced;
+    }
+
+    size_t size() const { return lookup.size(); }
+
+    // Visit every live asset
+    template <typename Function>
+    void forEach(Function function) const {
+        for (const auto& slot : slots) {
+            if (slot.asset) function(*slot.asset);
+        }
+    }
+
+    // Visit every live asset together with its handle
+    template <typename Function>
+    void forEachHandle(Function function) {
+        for (uint32_t index = 0; index < slots.size(); index++) {
+            if (slots[index].asset) function(AssetHandle<T>{ index, slots[index].generation }, *slots[index].asset);
+        }
+    }
+
+private:
+    struct Slot {
+        std::unique_ptr<T> asset;
+        std::string path;
+        uint32_t refCount = 0;
+        uint32_t generation = 1;
+    };
+
+    Slot* resolve(AssetHandle<T> handle) {
+        if (handle.index >= slots.size() || slots[handle.index].generation != handle.generation) return nullptr;
+        return slots[handle.index].asset ? &slots[handle.index] : nullptr;
+    }
+    const Slot* resolve(AssetHandle<T> handle) const {
+        return const_cast<AssetPool*>(this)->resolve(handle);
+    }
+
+    std::vector<Slot> slots;
+    std::vector<uint32_t> freeSlots;
+    std::vector<uint32_t> unreferenced;  // Slots whose count hit zero since the last collect()
+    std::unordered_map<std::string, uint32_t> lookup;
+};
+
+template <typename T>
+class AssetRef;
+
+using ModelRef = AssetRef<Model>;
+using TextureRef = AssetRef<GpuTexture>;
+
+// Central owner of GPU assets. Loads are deduplicated by path; callers hold
+// AssetRefs and the asset is destroyed (GL objects included) once the last
+// ref is gone and collectGarbage() runs. Not thread-safe - GL thread only.
+class AssetRegistry {
+public:
+    // Load (or share the already loaded) mesh / texture at path.
+    // While AsyncLoader is running these return placeholders that fill in later.
+    static ModelRef loadModel(const std::string& path);
+    static TextureRef loadTexture(const std::string& path);
+
+    // Get or build a packed occlusion/roughness/metallic texture (shared by OrmSource::key)
+    static TextureRef loadOrmTexture(const OrmSource& source);
+
+    // Free assets that are no longer referenced (call between frames)
+    static size_t collectGarbage();
+
+    // Destroy every asset - call before the GL context goes away
+    static void shutdown();
+
+    static size_t getModelCount() { return models.size(); }
+    static size_t getTextureCount() { return textures.size(); }
+
+    // GPU memory held by all loaded textures (mip chains included)
+    static size_t getTextureMemory();
+
+    // Keep GpuMemory under its budget (call once per frame). Over budget, textures are reloaded
+    // with their top mip dropped, least recently bound first; ones unused for a while drop to
+    // their smallest level. Levels come back when there is headroom again and the texture is in use.
+    static void enforceTextureBudget();
+
+    // Textures currently below full resolution because of the budget
+    static size_t getReducedTextureCount();
+
+    template <typename T>
+    static AssetPool<T>& pool();
+
+private:
+    // Re-decode a texture (from the texture cache) and upload it at its droppedLevels
+    static void reloadTexture(AssetHandle<GpuTexture> handle);
+
+    static AssetPool<Model> models;
+    static AssetPool<GpuTexture> textures;
+    static bool budgetWarningShown;
+};
+
+template <>
+inline AssetPool<Model>& AssetRegistry::pool<Model>() { return models; }
+
+template <>
+inline AssetPool<GpuTexture>& AssetRegistry::pool<GpuTexture>() { return textures; }
+
+// Owning reference to a registry asset: copies add a reference, destruction releases it.
+// Moving a ref doesn't touch the count, so refs can be moved across threads.
+template <typename T>
+class AssetRef {
+public:
+    AssetRef() = default;
+    explicit AssetRef(AssetHandle<T> handle) : handle(handle) { AssetRegistry::pool<T>().addRef(handle); }
+    AssetRef(const AssetRef& other) : handle(other.handle) { AssetRegistry::pool<T>().addRef(handle); }
+    AssetRef(AssetRef&& other) noexcept : handle(other.handle) { other.handle = AssetHandle<T>(); }
+    ~AssetRef() { reset(); }
+
+    AssetRef& operator=(AssetRef other) noexcept {
+        std::swap(handle, other.handle);
+        return *this;
+    }
+
+    void reset() {
+        if (handle.isValid()) AssetRegistry::pool<T>().release(handle);
+        handle = AssetHandle<T>();
+    }
+
+    T* get() const { return AssetRegistry::pool<T>().get(handle); }
+    T* operator->() const { return get(); }
+    explicit operator bool() const { return handle.isValid(); }
+    AssetHandle<T> getHandle() const { return handle; }
+
+private:
+    AssetHandle<T> handle;
+};
@@ -0,0 +1,94 @@
+#pragma once
+#include <GL/glew.h>
+#include <string>
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include "texture.hpp"
+#include "TextureStreamer.hpp"
+#include "MeshData.hpp"
+#include "AssetRegistry.hpp"
+
+// Background asset streaming. A pool of worker threads does file I/O and decoding in
+// parallel (and copies texture mips into the TextureStreamer ring when it is enabled);
+// the GL thread uploads finished assets in processUploads() under a per-frame time and byte budget.
+// Callers get a usable handle immediately (placeholder texture / placeholder mesh)
+// and the real data is uploaded into that same handle once it arrives.
+class AsyncLoader {
+public:
+    // Spawn decode workers (0 = one per core, leaving one for the GL thread)
+    static void start(unsigned int workerCount = 0);
+    static void stop();                 // Join the workers and drop anything not yet uploaded
+    static bool isRunning() { return running; }
+    static size_t getWorkerCount() { return workers.size(); }
+
+    // Queue a decode; the result is uploaded into the existing texture object.
+    // Requests hold a reference, so the target stays alive until it has been filled.
+    static void loadTexture(const TextureRef& texture, const std::string& path, bool flip = true);
+
+    // Queue a packed ORM build (Texture::decodeOrm) into an existing texture object
+    static void loadOrmTexture(const TextureRef& texture, const OrmSource& source);
+
+    // Queue a texture to be decoded again from its source and uploaded at its droppedLevels
+    // (memory budget). Clears the texture's reloading flag once uploaded.
+    static void reloadTexture(const TextureRef& texture);
+
+    // Queue a mesh load; the result replaces the model's placeholder vertices
+    static void loadMesh(const ModelRef& model, const std::string& path);
+
+    // Upload finished assets until budgetMs has elapsed or budgetBytes of texture data has been
+    // submitted (at least one per call). Must be called from the thread that owns the GL context.
+    // Returns uploads done.
+    static size_t processUploads(double budgetMs, size_t budgetBytes);
+
+    // Nothing queued, decoding or waiting for upload
+    static bool isIdle();
+    static size_t getPendingCount();
+
+private:
+    // Refs are only ever moved on the worker thread (never copied or dropped there),
+    // so reference counts are touched on the GL thread only
+    struct Request {
+        std::string path;
+        TextureRef texture;  // Target texture (texture requests)
+        ModelRef model;      // Target model (mesh requests)
+        bool flip = true;
+        bool packedOrm = false;  // Texture built from orm instead of path
+        OrmSource orm;
+        int droppedLevels = 0;   // Top mips to leave out at upload
+    };
+
+    struct Result {
+        Request request;
+        bool success = false;
+        DecodedImage image;          // Texture requests
+        StagedImage staged;          // Texture mips already copied into the TextureStreamer ring
+        bool isStaged = false;
+        MeshData mesh;               // Mesh requests loaded from OBJ
+        std::vector<uint8_t> scratch;
+        const float* vertices = nullptr;  // Into mesh, scratch or the mapped archive
+        size_t vertexCount = 0;
+        double decodeMs = 0.0;       // Worker time spent on this asset
+    };
+
+    static void workerLoop();
+    static void beginBurst();
+    static void decode(Result& result);
+
+    static std::vector<std::thread> workers;
+    static std::mutex mutex;
+    static std::condition_variable wake;
+    static std::deque<Request> requests;  // Waiting for the worker
+    static std::deque<Result> results;    // Waiting for the GL thread
+    static size_t pending;                // Requested but not yet uploaded
+
+    // Stats for the current streaming burst (reported when it drains)
+    static std::chrono::steady_clock::time_point burstStart;
+    static double burstDecodeMs;
+    static size_t burstAssets;
+    static bool running;
+    static bool stopping;
+};
@@ -0,0 +1,61 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+// GPU texture formats stored in the cache / archive. BCn formats use 4x4 pixel blocks.
+enum class BlockFormat : uint32_t {
+    None = 0,  // Uncompressed 8-bit, no prebuilt mips (placeholders)
+    BC1 = 1,   // RGB, 8 bytes/block (opaque albedo)
+    BC3 = 3,   // RGBA, 16 bytes/block (albedo with alpha, when BC7 isn't available)
+    BC4 = 4,   // R, 8 bytes/block (roughness, metallic, masks)
+    BC5 = 5,   // RG, 16 bytes/block (tangent-space normals, z rebuilt in the shader)
+    BC7 = 7,   // RGBA, 16 bytes/block (albedo with alpha)
+    RGBA8 = 8, // Uncompressed RGBA, 4 bytes/pixel (compression off)
+    R8 = 9     // Uncompressed single channel, 1 byte/pixel (compression off)
+};
+
+// What a texture holds - decides which format it is compressed to
+enum class TextureUsage {
+    Albedo,
+    SingleChannel,
+    Normal
+};
+
+// One mip level inside a contiguous mip chain
+struct ImageLevel {
+    uint32_t width;
+    uint32_t height;
+    size_t offset;  // Byte offset of the level in the chain
+    size_t size;    // Byte size of the level
+};
+
+// CPU texture compressor, used by the BABELPack cooker and by the runtime cache
+// (Texture::decode). No OpenGL calls, safe on worker threads.
+namespace BlockCompression {
+    bool isCompressed(BlockFormat format);
+    size_t blockBytes(BlockFormat format);
+    size_t levelBytes(BlockFormat format, uint32_t width, uint32_t height);
+
+    // Guess usage from the file name (".._roughness.png", "pillar_skfb_m.png", "_nor_gl" ...)
+    TextureUsage usageFromPath(const std::string& path);
+
+    // Pick the format for a usage. BC7 needs GL 4.2 / ARB_texture_compression_bptc.
+    BlockFormat chooseFormat(TextureUsage usage, bool hasAlpha, bool allowBC7);
+
+    // True if a 4-channel image has any pixel with alpha < 255
+    bool hasAlpha(const uint8_t* pixels, uint32_t width, uint32_t height, uint32_t channels);
+
+    // Build the full mip chain of an 8-bit image (MipChain, gamma-correct for albedo) and
+    // encode every level to format. Levels are appended to out, level 0 first.
+    void encodeMipChain(const uint8_t* pixels, uint32_t width, uint32_t height, uint32_t channels,
+        BlockFormat format, bool gammaCorrect, std::vector<ImageLevel>& levels, std::vector<uint8_t>& out);
+
+    // Single-block encoders. rgba is 16 pixels (row-major, 4 bytes each).
+    void encodeBC1(const uint8_t* rgba, uint8_t* out);
+    void encodeBC3(const uint8_t* rgba, uint8_t* out);
+    void encodeBC4(const uint8_t* rgba, int channel, uint8_t* out);
+    void encodeBC5(const uint8_t* rgba, uint8_t* out);
+    void encodeBC7(const uint8_t* rgba, uint8_t* out);
+}
@@ -0,0 +1,70 @@
+#pragma once
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+#include <cstdint>
+#include <vector>
+#include "shader.hpp"
+
+class LightingManager;
+
+// Clustered forward shading. Each view's frustum is cut into a 16x9 grid of screen tiles times
+// 24 exponential depth slices; every light is assigned on the CPU to the clusters its range
+// sphere overlaps, and the CLUSTERED_LIGHTS variants of standard.frag only loop over the list
+// of the cluster a fragment falls in. Cost per pixel follows the lights that actually reach it,
+// not the scene's light count. Lists are rebuilt for every view, portal views included.
+//
+// Lights live in texture buffers (GL 3.1), so there is no block-sized limit on their number.
+class ClusteredLighting {
+public:
+    static const int TILES_X = 16;   // Must match standard.frag
+    static const int TILES_Y = 9;
+    static const int SLICES = 24;
+    static const int CLUSTER_COUNT = TILES_X * TILES_Y * SLICES;
+    static const int MAX_LIGHTS = 4096;
+
+    static bool initialize();
+    static void shutdown();
+    static bool isEnabled() { return gridBuffer != 0; }
+
+    // Sampler units of the light, grid and index buffers (once per program)
+    static void setupSamplers(const Shader& shader);
+
+    // Once per frame: copy every light's position, range, colour and attenuation if any changed
+    static void updateLights(const LightingManager& lighting);
+
+    // Per view: assign the lights to this view's clusters, upload the lists and bind the buffers
+    static void buildView(const glm::mat4& view, const glm::mat4& projection);
+
+    static void printStats();
+
+private:
+    // Clusters one light covers in the current view
+    struct LightBox {
+        uint16_t light;
+        uint8_t x0, x1, y0, y1, s0, s1;
+    };
+
+    // Where each light is and how far it reaches (world space), kept from updateLights
+    struct LightBounds {
+        glm::vec3 position;
+        float range;
+    };
+
+    static void growIndexBuffer(size_t count);
+
+    static GLuint lightBuffer, lightTexture;  // RGBA32F, 3 texels per light
+    static GLuint gridBuffer, gridTexture;    // RG32UI per cluster: first index, light count
+    static GLuint indexBuffer, indexTexture;  // R16UI light indices, cluster by cluster
+    static size_t indexCapacity;
+    static uint64_t uploadedVersion;
+
+    static std::vector<LightBounds> lights;
+    static std::vector<glm::vec4> lightData;  // Staging for lightBuffer (rewritten every frame lights animate)
+    static std::vector<LightBox> boxes;
+    static std::vector<uint32_t> grid;
+    static std::vector<uint16_t> indices;
+
+    // Last view, for the debug output
+    static size_t lastIndexCount;
+    static uint32_t lastMaxPerCluster;
+};
@@ -0,0 +1,14 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+// Small LZ77 block codec (LZ4-style token stream) used for per-entry compression
+// in the asset archive. Fast to decode, no external dependencies.
+namespace Compression {
+    // Compress src into out (out is overwritten). Returns compressed size.
+    size_t compress(const uint8_t* src, size_t size, std::vector<uint8_t>& out);
+
+    // Decompress exactly rawSize bytes into dst. Returns false on malformed input.
+    bool decompress(const uint8_t* src, size_t size, uint8_t* dst, size_t rawSize);
+}
@@ -0,0 +1,18 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+#include "BlockCompression.hpp"
+
+// Minimal DDS container (DX10 extended header) holding one 2D texture and its mip chain.
+// Rows are stored bottom-up (already flipped for OpenGL), same as decoded archive textures.
+namespace DdsFile {
+    // Serialize a mip chain (levels index into data)
+    void serialize(BlockFormat format, const std::vector<ImageLevel>& levels, const uint8_t* data,
+        std::vector<uint8_t>& out);
+
+    // Parse a DDS image in memory. Level offsets are relative to payload, which points into file.
+    // Accepts DX10 headers and the legacy DXT1/DXT5/ATI1/ATI2 FourCCs.
+    bool parse(const uint8_t* file, size_t size, BlockFormat& format, std::vector<ImageLevel>& levels,
+        const uint8_t*& payload);
+}
@@ -0,0 +1,74 @@
+#pragma once
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+#include <vector>
+#include <memory>
+#include "shader.hpp"
+
+class LightingManager;
+
+// Optional deferred path for the main view. Opaque lit geometry is drawn once into a G-buffer
+// (albedo + occlusion, normal, roughness/metallic, depth) with the GBUFFER variants of
+// standard.frag; lights are then added by instanced spheres sized to each light's range, so a
+// light only costs the pixels it can reach and hidden fragments are never lit. A resolve pass
+// adds ambient and writes HDR color and depth into the scene target (PostProcess), so light
+// sources and portal surfaces are drawn forward on top and everything is tone mapped together.
+//
+// Portal views stay forward: a G-buffer at the portals' render target size would cost more
+// memory than every other target together.
+class DeferredRenderer {
+private:
+    struct LightInstance {
+        glm::vec4 positionRange;   // xyz = position, w = range (PointLight::getRange)
+        glm::vec4 colorIntensity;  // rgb = color, a = intensity
+        glm::vec4 falloff;         // constant, linear, quadratic, shadow atlas row (-1 = none)
+    };
+
+    std::unique_ptr<Shader> lightShader;    // shaders/deferred_light.vert/.frag
+    std::unique_ptr<Shader> resolveShader;  // shaders/fullscreen.vert + deferred_resolve.frag
+    bool samplersSet = false;
+
+    int width = 0, height = 0;
+    GLuint gBuffer = 0;          // Framebuffer of the textures below
+    GLuint albedoTexture = 0;    // RGBA8: albedo, occlusion
+    GLuint normalTexture = 0;    // RGB10_A2: world normal * 0.5 + 0.5
+    GLuint materialTexture = 0;  // RG8: roughness, metallic
+    GLuint depthTexture = 0;     // DEPTH24_STENCIL8
+    GLuint lightBuffer = 0;      // Framebuffer: HDR accumulation + copy of the depth for volume tests
+    GLuint accumulationTexture = 0;  // RGBA16F, lights added with blending
+    GLuint lightDepth = 0;       // Depth renderbuffer (sampling the G-buffer depth while testing
+                                 // against it would be a feedback loop)
+    size_t targetBytes = 0;      // Reported to GpuMemory
+
+    GLuint sphereVAO = 0, sphereVBO = 0, sphereEBO = 0;
+    GLsizei sphereIndexCount = 0;
+    GLuint instanceBuffer = 0;
+    size_t instanceCapacity = 0;
+    std::vector<LightInstance> instances;  // Staging, kept between frames (lights animate every frame)
+    GLsizei lightCount = 0;
+    uint64_t uploadedVersion = 0;
+    GLuint fullscreenVAO = 0;    // Empty - fullscreen.vert builds its triangle from gl_VertexID
+
+    void createTargets(int newWidth, int newHeight);
+    void destroyTargets();
+
+public:
+    ~DeferredRenderer();
+
+    bool initialize();
+    void cleanup();
+    bool isInitialized() const { return sphereVAO != 0; }
+
+    // Once per frame: rebuild the light instances if the lights changed
+    void updateLights(const LightingManager& lighting);
+
+    // Bind and clear the G-buffer (resized to width x height when that changed). Draw opaque lit
+    // geometry with GBUFFER programs afterwards.
+    void beginGeometry(int width, int height);
+
+    // Light the G-buffer and resolve it into targetFramebuffer (color and depth). The view's
+    // ViewData range must still be bound.
+    void resolve(const glm::mat4& view, const glm::mat4& projection, GLuint targetFramebuffer);
+
+    GLsizei getLightCount() const { return lightCount; }
+};
@@ -0,0 +1,82 @@
+#pragma once
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+#include <string>
+#include <vector>
+#include <memory>
+#include "shader.hpp"
+#include "model.hpp"
+#include "scene.hpp"
+
+// Layout matches the indirect command read by glMultiDrawArraysIndirect
+struct DrawArraysIndirectCommand {
+    GLuint count;          // Vertices per instance
+    GLuint instanceCount;  // Filled in by the culling compute shader
+    GLuint first;          // First vertex in the merged vertex buffer
+    GLuint baseInstance;   // Start of this mesh's slots in the visible list
+};
+
+// Per-object data stored in the object SSBO (std430 layout, 96 bytes)
+struct GpuObject {
+    glm::mat4 model;         // Object-to-world transform
+    glm::vec4 localSphere;   // Bounding sphere in model space (xyz = center, w = radius)
+    GLuint commandIndex;     // Which indirect command (mesh) this object belongs to
+    GLuint materialLayer;    // Material handle = texture array layer (read by indirect.vert)
+    GLuint padding[2];
+};
+
+// GPU-driven path (GL 4.3+): transforms and bounds live in an SSBO, a compute pass
+// frustum-culls them per view and writes indirect commands, then every material is
+// drawn with one glMultiDrawArraysIndirect (or all materials with one, when they live in
+// texture arrays). CPU cost per view doesn't depend on object count.
+class GpuDrivenRenderer {
+private:
+    struct BatchRange {
+        MaterialHandle material;
+        bool lightSource;
+        GLuint firstCommand;
+        GLsizei commandCount;
+    };
+
+    std::unique_ptr<Shader> cullShader;  // shaders/cull.comp
+
+    GLuint vertexBuffer = 0;     // All meshes merged into one VBO
+    GLuint objectBuffer = 0;     // SSBO of GpuObject
+    GLuint commandBuffer = 0;    // Indirect commands written by the cull pass
+    GLuint commandTemplate = 0;  // Commands with instanceCount = 0, copied in before every cull
+    GLuint visibleBuffer = 0;    // Visible object indices (instanced vertex attribute)
+    GLuint VAO = 0;
+    GLsizeiptr commandBytes = 0; // Size of the command buffer
+    size_t meshBytes = 0;        // Reported to GpuMemory (merged vertex buffer)
+    size_t bufferBytes = 0;      // Reported to GpuMemory (everything else)
+
+    std::vector<BatchRange> batchRanges; // Standard materials first, then light sources
+    GLsizei lightFirstCommand = 0;       // Commands [0, lightFirstCommand) use the standard shader
+    GLsizei commandCount = 0;
+    std::vector<size_t> sceneIndices;    // Scene object index for every GPU object
+    std::vector<GpuObject> objects;      // CPU copy used to stream transforms
+    bool initialized = false;
+
+public:
+    ~GpuDrivenRenderer();
+
+    // True when the context exposes compute shaders and multi-draw indirect
+    static bool isSupported();
+
+    // Build merged geometry, object SSBO and command buffers for the given scene
+    bool initialize(const Scene& scene, const std::vector<DrawBatch>& batches);
+    void cleanup();
+
+    // Upload current object transforms (once per frame, not per view)
+    void updateTransforms(const Scene& scene);
+
+    // Frustum-cull all objects for one view on the GPU
+    void cull(const glm::mat4& view, const glm::mat4& projection);
+
+    // Issue one multi-draw per material, or a single one with texture arrays
+    // (assumes shader is active with view uniforms set)
+    void drawBatches(const Shader& shader, bool lightSources) const;
+
+    bool isInitialized() const { return initialized; }
+    size_t getObjectCount() const { return objects.size(); }
+};
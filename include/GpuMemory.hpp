@@ -0,0 +1,51 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <GL/glew.h>
+
+// What an allocation is used for (one counter each)
+enum class GpuMemoryCategory {
+    Textures,        // Streamed material textures (AssetRegistry) - the only evictable category
+    MaterialArrays,  // Texture-array material backend
+    VirtualTextures, // Physical page cache and page tables (fixed size)
+    RenderTargets,   // Portal framebuffers
+    Meshes,          // Model vertex buffers
+    Buffers,         // Instance, indirect and other scene buffers
+    Count
+};
+
+// Video memory accounting. Every GL allocation reports its size here, so the numbers are
+// our own estimate (driver padding and the default framebuffer aren't included).
+// With a budget set, AssetRegistry::enforceTextureBudget() drops texture mips to stay under it.
+class GpuMemory {
+public:
+    static void allocate(GpuMemoryCategory category, size_t bytes);
+    static void release(GpuMemoryCategory category, size_t bytes);
+
+    static size_t getUsed(GpuMemoryCategory category) { return used[static_cast<int>(category)]; }
+    static size_t getTotal();
+    static size_t getPeak() { return peak; }
+    static const char* getCategoryName(GpuMemoryCategory category);
+
+    // Budget in bytes (0 = unlimited). detectBudget() uses 80% of dedicated video memory
+    // when the driver reports it (NVX_gpu_memory_info / ATI_meminfo), else stays unlimited.
+    static void setBudget(size_t bytes) { budget = bytes; }
+    static size_t getBudget() { return budget; }
+    static void detectBudget();
+
+    // Frame counter for least-recently-used tracking (call once at the start of every frame)
+    static void beginFrame() { frame++; }
+    static uint64_t getFrame() { return frame; }
+
+    // Size of a single-level 2D image with an uncompressed internal format
+    static size_t imageBytes(GLsizei width, GLsizei height, GLenum internalFormat);
+
+    // Print the per-category table
+    static void printReport();
+
+private:
+    static size_t used[static_cast<int>(GpuMemoryCategory::Count)];
+    static size_t peak;
+    static size_t budget;
+    static uint64_t frame;
+};
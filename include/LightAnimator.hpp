@@ -0,0 +1,49 @@
+#pragma once
+#include <glm/glm.hpp>
+#include <cstddef>
+#include <vector>
+
+class Scene;
+class LightingManager;
+
+// How one light's intensity moves, as a multiplier of its baseIntensity. An amount of 0 switches
+// a term off - it is still evaluated, every light runs the same arithmetic.
+struct LightTrack {
+    float flickerAmount = 0.0f;  // Flame flicker: three incommensurate waves, up to this fraction
+    float flickerSpeed = 8.0f;   // Radians per second of the slowest wave
+    float curveAmount = 0.0f;    // Slow swell (one sine), up to this fraction
+    float curveSpeed = 0.5f;     // Radians per second
+    float phase = 0.0f;          // Shifts both, so identical lights don't pulse in step
+};
+
+// Data-driven point light animation. Tracks live in parallel arrays (one column per parameter,
+// padded to groups of four) and are evaluated for every light in one SSE2 pass per frame (a scalar
+// loop without SSE2), without per-light branches or allocation; the results go straight into
+// LightingManager's lights, which the light buffers upload once. Attachments make a light follow
+// a scene object (by index into Scene::objects) at an offset in the object's space - the torch
+// lights ride on the torch meshes. Static lights are refused: the lightmap has baked them.
+class LightAnimator {
+public:
+    // Add a track (or an attachment) to one of the manager's lights
+    bool animate(const LightingManager& lighting, int light, const LightTrack& track);
+    bool attach(const LightingManager& lighting, int light, const Scene& scene, size_t object,
+        const glm::vec3& offset = glm::vec3(0.0f));
+    void clear();
+
+    // Once per frame after the scene update: write positions and intensities, mark them animated
+    void update(float time, const Scene& scene, LightingManager& lighting);
+
+    size_t getTrackCount() const { return lights.size(); }
+    size_t getAttachmentCount() const { return attachedLights.size(); }
+
+private:
+    // Intensity tracks
+    std::vector<int> lights;
+    std::vector<float> flickerAmount, flickerSpeed, curveAmount, curveSpeed, phase;
+    std::vector<float> factors;  // Evaluated multipliers
+
+    // Attachments
+    std::vector<int> attachedLights;
+    std::vector<size_t> attachedObjects;
+    std::vector<glm::vec3> attachedOffsets;
+};
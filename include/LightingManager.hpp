@@ -1,7 +1,8 @@
 ﻿#pragma once
 #include <vector>
+#include <cstdint>
+#include <GL/glew.h>
 #include <glm/glm.hpp>
-#include "shader.hpp"
 
 // Simplified point light structure - removed all unused animation properties
 struct PointLight {
@@ -12,6 +13,8 @@ struct PointLight {
     float linear;            // (used in 1/(constant + linear*d + quadratic*d²))
     float quadratic;
     float baseIntensity;     // Original intensity before modifications (used for drama mode)
+    bool isStatic = false;   // Never moves - static geometry may take its light from the lightmap (Lightmap)
+    bool castsShadows = false; // Gets a row of the point shadow atlas (ShadowAtlas), first MAX_SHADOWED_LIGHTS only
 
     // Constructor with reasonable defaults
     PointLight(const glm::vec3& pos, const glm::vec3& col, float intens = 1.0f,
@@ -19,10 +22,20 @@ struct PointLight {
         : position(pos), color(col), intensity(intens), baseIntensity(intens),
         constant(constant), linear(linear), quadratic(quadratic) {
     }
+
+    // Distance at which the light's contribution falls below LightingManager::LIGHT_CUTOFF
+    // (clustered shading assigns it to clusters within this radius and fades it out there)
+    float getRange() const;
 };
 
 class LightingManager {
 public:
+    static const int MAX_POINT_LIGHTS = 16;        // Size of the LightingData block's array (shaders)
+    static const int MAX_SHADOWED_LIGHTS = 8;      // Rows of the shadow atlas (ShadowAtlas)
+    static constexpr float LIGHT_CUTOFF = 0.05f;   // Light reaching a surface below this is treated as none
+
+    // Edit through the methods below, or call markDirty() after changing these directly
+    // (LightAnimator writes positions and intensities every frame and calls markAnimated())
     std::vector<PointLight> pointLights;           // All point lights in scene
 
     // Global ambient lighting - fixed to actual values used
@@ -32,8 +45,19 @@ public:
     // Main setup and management
     void setupLibraryLighting(float roomRadius, float roomHeight); // Create initial lighting setup
     void addPointLight(const PointLight& light);                   // Add new point light
-    void bindToShader(Shader& shader) const;                      // Upload all lights to shader
-    void updateTorchPositions(const std::vector<glm::vec3>& torchPositions); // Sync lights with animated objects
+    void addTorchWing(int count, float roomRadius, float roomHeight); // Small wall torches (clustered shading test)
+    void markDirty() { version++; setupVersion++; }                // Lights changed - rewrite the uniform buffer
+    void markAnimated() { version++; }                             // Only positions/intensities changed (LightAnimator)
+    void updateUniformBuffer();                                    // Once per frame: upload if changed, bind
+    uint64_t getVersion() const { return version; }                // Any change (GPU copies re-upload)
+    uint64_t getSetupVersion() const { return setupVersion; }      // Changes other than animation
+    int getActiveLightCount() const {                                // Lights the shaders see (first MAX_POINT_LIGHTS)
+        return pointLights.size() < static_cast<size_t>(MAX_POINT_LIGHTS) ? static_cast<int>(pointLights.size()) : MAX_POINT_LIGHTS;
+    }
+    int getStaticLightCount() const;                                // Leading isStatic lights (baked into the lightmap)
+    const std::vector<int>& getShadowSlots() const;                 // Per light: its shadow atlas row, or -1
+    void enableShadows(bool enabled) { shadows = enabled; markDirty(); } // Shadow atlas exists (slots are all -1 without)
+    void cleanup();
 
     // Lighting controls
     void setTorchIntensity(float intensity);        // Control torch brightness
@@ -47,4 +71,14 @@ public:
 
     // Preset modes
     void setDramaticMode(bool enabled); // Toggle warmer/brighter lighting
+
+private:
+    size_t sceneLights = 0;       // Lamp and orbiting torches (what the torch controls affect)
+    bool shadows = false;         // ShadowAtlas is up - castsShadows lights get rows
+    GLuint uniformBuffer = 0;     // LightingData block (std140)
+    uint64_t version = 1;         // Bumped on every change
+    uint64_t setupVersion = 1;    // Bumped on every change except animation
+    mutable std::vector<int> shadowSlots;     // getShadowSlots() result for slotsVersion
+    mutable uint64_t slotsVersion = 0;
+    uint64_t uploadedVersion = 0; // Version the buffer holds
 };
\ No newline at end of file
@@ -0,0 +1,58 @@
+#pragma once
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+#include <string>
+#include <vector>
+#include "shader.hpp"
+#include "LightmapBaker.hpp"
+
+class Scene;
+class LightingManager;
+
+// Baked lighting for the static room geometry (floor, ceiling, walls, columns, door frames, shelves),
+// made offline by LightmapBaker. Those objects draw with the LIGHTMAP_STATIC_LIGHTS variants of the
+// standard shaders: ambient, the static lights (with shadows) and one bounce of their light are a
+// single texture fetch, and only the moving lights are evaluated per fragment, in portal views too.
+// A bake is only used while the static lights and ambient match what it was made with - drama mode
+// changes the lamp, so the room falls back to dynamic lighting until it is switched off.
+// The same bake has irradiance probes, which light the animated books the same way (PROBE_STATIC_LIGHTS).
+class Lightmap {
+public:
+    static const char* const FILE_PATH;  // Written by BABEL --bake-lightmaps
+
+    // Read a baked file and upload its atlas (false if there is none)
+    static bool load(const std::string& path);
+    static void shutdown();
+    static bool isLoaded() { return texture != 0; }
+
+    // Give the static objects (the first objects of the scene, in bake order) their lightmap
+    // coordinates. Call once their meshes have streamed in; a bake of another layout is refused.
+    static bool attach(Scene& scene);
+
+    // Once per frame: decide whether the bake still matches the lights
+    static void updateLights(const LightingManager& lightingManager);
+
+    // Lightmapped objects use it this frame; it replaces this many leading lights
+    static bool isActive() { return active; }
+    static int getStaticLightCount() { return staticLightCount; }
+
+    // The bake's irradiance probes for moving objects (nullptr while the bake doesn't apply)
+    static const IrradianceProbes* getProbes() { return active && !data.probes.empty() ? &data.probes : nullptr; }
+
+    // Sampler unit (once per program) and the atlas binding (once per view)
+    static void setupSamplers(const Shader& shader);
+    static void bindTexture();
+
+    // Bake inputs from the scene's lights (the baker and the match check use the same)
+    static std::vector<BakeLight> bakeLights(const LightingManager& lightingManager);
+    static glm::vec3 bakeAmbient(const LightingManager& lightingManager);
+
+private:
+    static GLuint texture;
+    static size_t textureBytes;
+    static LightmapData data;       // Texels dropped after upload, coordinates after attach
+    static bool attached;
+    static bool active;
+    static int staticLightCount;
+    static uint64_t checkedVersion;  // Light setup version the match was last checked for
+};
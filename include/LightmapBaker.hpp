@@ -0,0 +1,109 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <glm/glm.hpp>
+#include "MeshData.hpp"
+
+// Static point light as the bake evaluates it (same attenuation and diffuse term as standard.frag)
+struct BakeLight {
+    glm::vec3 position;
+    glm::vec3 color;
+    float intensity;
+    float constant, linear, quadratic;
+};
+
+// Static mesh and where the bake finds it again at runtime
+struct BakeMesh {
+    std::string path;  // Model path (identifies the mesh in the lightmap file)
+    MeshData data;
+};
+
+// One placement of a static mesh. Every instance gets its own rectangle of the atlas.
+struct BakeInstance {
+    uint32_t mesh;        // Index into the meshes passed to bake()
+    glm::mat4 transform;  // Model matrix
+    glm::vec3 albedo;     // Average diffuse reflectance (colour of the light it bounces)
+};
+
+struct BakeSettings {
+    uint32_t atlasSize = 1024;     // Square atlas, texels per side
+    float texelsPerMeter = 16.0f;  // Starting density, lowered until every instance fits
+    int indirectSamples = 128;     // Hemisphere rays per texel (one bounce + ambient occlusion)
+    float occlusionDistance = 1.0f; // Ambient is blocked by geometry closer than this
+    float probeSpacing = 1.0f;     // Irradiance probe grid step in meters
+    int probeSamples = 256;        // Sphere rays per probe
+    unsigned int threads = 0;      // 0 = one per core
+};
+
+// Grid of L2 spherical-harmonics irradiance probes over the static geometry's bounds, for objects
+// that move. Each probe holds 9 RGB coefficients of the irradiance itself (the cosine convolution is
+// already applied), so a normal's irradiance is one SH dot product - the lightmap's units, times albedo.
+struct IrradianceProbes {
+    static const int COEFFICIENTS = 9;
+
+    glm::vec3 origin = glm::vec3(0.0f);  // Position of probe (0,0,0)
+    float spacing = 1.0f;
+    glm::uvec3 size = glm::uvec3(0);     // Probes per axis
+    std::vector<glm::vec3> coefficients; // COEFFICIENTS per probe, x fastest then y then z
+    std::vector<uint8_t> valid;          // 0 where the probe sits inside geometry (most rays see back faces)
+
+    bool empty() const { return valid.empty(); }
+
+    // Trilinear blend of the 8 surrounding probes, skipping invalid ones
+    void sample(const glm::vec3& position, glm::vec3 out[COEFFICIENTS]) const;
+
+    // Irradiance for a normal from 9 coefficients (what the shader evaluates)
+    static glm::vec3 evaluate(const glm::vec3 coefficients[COEFFICIENTS], const glm::vec3& normal);
+};
+
+// Baked lighting of the static geometry, as written by LightmapBaker and read by Lightmap.
+// Texels hold linear irradiance (RGB half floats, alpha = 1 where a surface was baked):
+// static lights with shadows, one bounce of their light and occlusion-weighted ambient.
+// The shader multiplies it by albedo.
+struct LightmapData {
+    // Second UV set of one mesh: its charts laid out in [0,1], shared by its instances
+    struct Mesh {
+        std::string path;
+        uint32_t vertexCount = 0;
+        std::vector<float> coords;  // 2 per vertex
+    };
+
+    // Where one instance's copy of its mesh layout sits in the atlas (uv * scale + offset)
+    struct Instance {
+        uint32_t mesh = 0;
+        glm::vec4 scaleOffset = glm::vec4(0.0f);
+    };
+
+    uint32_t width = 0, height = 0;
+    std::vector<uint16_t> texels;  // RGBA half floats, row 0 at the bottom (GL order)
+    std::vector<Mesh> meshes;
+    std::vector<Instance> instances;
+    IrradianceProbes probes;       // Same lighting for dynamic objects
+    uint64_t layoutSignature = 0;  // Instances and meshes it was baked for
+    uint64_t lightSignature = 0;   // Static lights and ambient it was baked with
+
+    bool save(const std::string& path) const;
+    bool load(const std::string& path);
+};
+
+// CPU lightmap baker for static geometry. No OpenGL, so it runs headless (BABEL --bake-lightmaps).
+//
+// Each mesh is cut into charts of adjacent triangles facing roughly the same way, each chart is
+// projected onto its plane and the charts are packed into a per-mesh layout (the UV2 set).
+// Every instance then gets a copy of its mesh's layout in one shared atlas at the same texel density.
+// Texels are traced in parallel against a BVH of all instances, four triangles per SSE test,
+// then the irradiance probes are traced against the same BVH.
+// Random numbers are seeded per texel, so the result is identical for any thread count.
+class LightmapBaker {
+public:
+    static bool bake(const std::vector<BakeMesh>& meshes, const std::vector<BakeInstance>& instances,
+        const std::vector<BakeLight>& lights, const glm::vec3& ambient, const BakeSettings& settings,
+        LightmapData& out);
+
+    // Identify what a lightmap was baked for, so stale bakes are not applied
+    static uint64_t layoutSignature(const std::vector<BakeMesh>& meshes, const std::vector<BakeInstance>& instances);
+    static uint64_t layoutSignature(const std::vector<uint32_t>& meshVertexCounts, const std::vector<uint32_t>& instanceMeshes,
+        const std::vector<glm::mat4>& instanceTransforms);
+    static uint64_t lightSignature(const std::vector<BakeLight>& lights, const glm::vec3& ambient);
+};
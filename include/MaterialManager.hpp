@@ -0,0 +1,81 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <GL/glew.h>
+#include "shader.hpp"
+#include "AssetRegistry.hpp"
+
+// Index into the material table, resolved once at load time
+using MaterialHandle = uint32_t;
+const MaterialHandle INVALID_MATERIAL = 0xFFFFFFFFu;
+
+// PBR texture set plus render parameters. Texture IDs are stable for the texture's lifetime
+// (streamed images are uploaded into their placeholder), so they are copied in at creation.
+struct Material {
+    std::string name;          // For debug output only, never touched while drawing
+    GLuint baseColor = 0;      // Texture unit 0
+    GLuint orm = 0;            // Texture unit 1 - R = occlusion, G = roughness, B = metallic
+    bool lightSource = false;  // Drawn with the light shader instead of the standard one
+
+    // Binds mark these as used for the memory budget's least-recently-used order
+    TextureRef baseColorTexture, ormTexture;
+};
+
+// How materials reach the shaders
+enum class MaterialBackend {
+    BoundTextures,  // Two texture units rebound per material switch
+    TextureArrays,  // Every material is a layer of two texture arrays, selected by index in the shader
+    VirtualTextures // Base colour from the virtual texture page cache (VirtualTexture), ORM still bound
+};
+
+// Material table built at load. Binding is an array lookup and does nothing
+// when the material is already bound, so no strings are hashed per draw.
+// With the TextureArrays backend switching material only changes the layer index,
+// so draws of different materials can share one instanced or multi-draw call.
+class MaterialManager {
+public:
+    // Add a material from textures loaded by TextureManager (names are looked up once here)
+    static MaterialHandle create(const std::string& name, const std::string& baseColor,
+        const std::string& orm, bool lightSource = false);
+
+    static const Material& get(MaterialHandle handle) { return materials[handle]; }
+    static size_t getMaterialCount() { return materials.size(); }
+
+    // Point a shader's sampler uniforms at the material texture units (once per program)
+    static void setupSamplers(const Shader& shader);
+
+    // Pack every material into layerSize x layerSize texture arrays (base color and ORM, both RGBA8)
+    // by resampling the loaded textures on the GPU.
+    // Call once streaming has finished so the layers hold the real images.
+    static bool buildTextureArrays(GLsizei layerSize);
+    static bool hasTextureArrays() { return baseColorArray != 0; }
+    static bool isBackendAvailable(MaterialBackend backend);
+
+    static void setBackend(MaterialBackend backend);
+    static MaterialBackend getBackend() { return backend; }
+
+    // Tell a shader which backend to sample from (once per shader per view).
+    // The virtual texture backend needs the VIRTUAL_TEXTURING build of standard.frag.
+    static void setupView(const Shader& shader);
+
+    // Make a material current for the next draw with this shader - binds its textures,
+    // or with texture arrays / virtual textures just sets the layer index. Skipped if nothing changed.
+    static void bind(MaterialHandle handle, const Shader& shader);
+
+    // Forget the bound material - call when other code changed texture units (new view, portals)
+    static void invalidate();
+
+    static void cleanup();
+
+private:
+    static std::vector<Material> materials;
+    static MaterialHandle bound;
+    static GLuint boundProgram;    // Program the layer index was last set on
+    static bool viewTexturesBound;  // Arrays or virtual texture cache, bound once per view
+
+    static MaterialBackend backend;
+    static GLuint baseColorArray;  // Texture unit 2
+    static GLuint ormArray;        // Texture unit 3
+    static size_t arrayBytes;      // Reported to GpuMemory
+};
@@ -0,0 +1,20 @@
+#pragma once
+#include <glm/glm.hpp>
+#include <string>
+#include <vector>
+
+// CPU-side mesh in the layout Model uploads: position(3) + normal(3) + texcoord(2).
+// No OpenGL calls, so it can be used from tools and worker threads.
+struct MeshData {
+    std::vector<float> vertices;   // Interleaved, 8 floats per vertex
+    glm::vec3 boundsMin = glm::vec3(0.0f);
+    glm::vec3 boundsMax = glm::vec3(0.0f);
+
+    size_t vertexCount() const { return vertices.size() / 8; }
+
+    // Load and flatten an OBJ file (returns false if the file couldn't be parsed)
+    static bool loadObj(const std::string& path, MeshData& out);
+
+    // Bounding box of interleaved vertex data
+    static void computeBounds(const float* vertices, size_t count, glm::vec3& outMin, glm::vec3& outMax);
+};
@@ -0,0 +1,21 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+#include "BlockCompression.hpp"
+
+// Offline mip chain generation for 8-bit RGBA images (BABELPack and the texture cache).
+// No OpenGL calls - replaces glGenerateMipmap so the driver never filters at load time.
+namespace MipChain {
+    // Expand a 1-4 channel image to RGBA (grey is replicated, missing alpha is 255)
+    void expandToRGBA(const uint8_t* pixels, uint32_t width, uint32_t height, uint32_t channels,
+        std::vector<uint8_t>& rgba);
+
+    // Halve an RGBA image with a 2x2 box filter (SSE2). gammaCorrect averages colour in linear
+    // space (sRGB decode/encode around the filter) so albedo mips don't darken; alpha is always linear.
+    void downsample(const uint8_t* src, uint32_t width, uint32_t height, uint8_t* dst, bool gammaCorrect);
+
+    // Build every level down to 1x1, level 0 first, back to back in out
+    void build(const uint8_t* rgba, uint32_t width, uint32_t height, bool gammaCorrect,
+        std::vector<ImageLevel>& levels, std::vector<uint8_t>& out);
+}
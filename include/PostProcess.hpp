@@ -0,0 +1,39 @@
+#pragma once
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+#include <memory>
+#include "shader.hpp"
+
+// HDR scene target and the one full-screen pass that finishes a frame. Every view renders linear
+// radiance - the main view into an R11G11B10F target, portal views into their own R11G11B10F
+// textures, composited into it still in HDR - and resolve() applies the warm tint, Reinhard tone
+// mapping and gamma 2.2 once per pixel - the same curve the lit shaders used to apply, on every
+// driver, so the image matches the old per-fragment output. Exposure and bloom belong here.
+class PostProcess {
+public:
+    static const GLenum COLOR_FORMAT = GL_R11F_G11F_B10F;  // 4 bytes per texel, like RGBA8
+    static const glm::vec3 BACKGROUND;  // Linear clear color (resolves to the old display clear color)
+
+    static bool initialize();
+    static void shutdown();
+
+    // Bind the scene target (resized to the framebuffer) and clear it to BACKGROUND
+    static void beginScene(int width, int height);
+    static GLuint getFramebuffer() { return framebuffer; }
+
+    // Clear the bound framebuffer's color to BACKGROUND and its depth (portal views use this too)
+    static void clear();
+
+    // Tint, tone map and encode the scene target into the default framebuffer
+    static void resolve();
+
+private:
+    static void createTarget(int width, int height);
+    static void destroyTarget();
+
+    static std::unique_ptr<Shader> shader;  // shaders/fullscreen.vert + post.frag
+    static GLuint framebuffer, colorTexture, depthTexture;
+    static GLuint fullscreenVAO;            // Empty - fullscreen.vert builds its triangle from gl_VertexID
+    static int width, height;
+    static size_t targetBytes;              // Reported to GpuMemory
+};
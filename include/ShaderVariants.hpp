@@ -0,0 +1,57 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <memory>
+#include <functional>
+#include <unordered_map>
+#include "shader.hpp"
+#include "MaterialManager.hpp"
+
+// Where lighting baked by --bake-lightmaps comes from: the lightmap (static objects) or the
+// irradiance probes (animated instances, sampled per instance on the CPU)
+enum class BakedLighting : uint32_t { None, Lightmap, Probes };
+
+// Compile-time features a scene program is specialised on. Each becomes a #define, so the
+// fragment shader has no runtime branches for them.
+struct ShaderFeatures {
+    int pointLights = 0;  // POINT_LIGHT_COUNT - the light loop runs exactly this many times
+    bool clusteredLights = false;  // CLUSTERED_LIGHTS - per-cluster light lists instead (pointLights unused)
+    bool gbuffer = false;          // GBUFFER - write the deferred G-buffer, no lighting (light keys unused)
+    BakedLighting baked = BakedLighting::None;  // LIGHTMAP_STATIC_LIGHTS / PROBE_STATIC_LIGHTS - ambient and
+    int staticLights = 0;                       // the first staticLights lights come from the bake instead
+    MaterialBackend materials = MaterialBackend::BoundTextures;  // MATERIAL_ARRAYS / VIRTUAL_TEXTURING
+
+    uint32_t key() const;
+    std::string defines() const;
+};
+
+// Every permutation of one vertex/fragment pair, compiled the first time its features are asked
+// for and kept for the rest of the run (the binary cache makes the next start free).
+class ShaderVariants {
+public:
+    // setup runs once on each new variant before it is first returned (sampler units)
+    using Setup = std::function<void(const Shader&)>;
+
+    ShaderVariants(const char* vertexPath, const char* fragmentPath, Setup setup = nullptr);
+
+    // The variant for these features, compiled now if this is the first request
+    Shader& get(const ShaderFeatures& features);
+
+    // Submit a variant for compilation without waiting for it (warm-up at startup)
+    void prepare(const ShaderFeatures& features);
+
+    size_t size() const { return variants.size(); }
+
+private:
+    struct Variant {
+        std::unique_ptr<Shader> shader;
+        bool ready = false;  // setup has run
+    };
+
+    Variant& find(const ShaderFeatures& features);
+
+    const char* vertexPath;
+    const char* fragmentPath;
+    Setup setup;
+    std::unordered_map<uint32_t, Variant> variants;  // By ShaderFeatures::key()
+};
@@ -0,0 +1,101 @@
+#pragma once
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+#include <cstdint>
+#include <functional>
+#include <vector>
+#include "shader.hpp"
+#include "LightingManager.hpp"
+
+// Moving object that casts shadows, as a bounding sphere (world space)
+struct ShadowCaster {
+    glm::vec3 center;
+    float radius;
+};
+
+// Point light shadows for the lights flagged castsShadows. Each one owns a row of six cube faces
+// in a depth atlas (FACE_SIZE texels each); standard.frag picks the face from the direction to
+// the light and compares with 2x2 PCF through the face's matrix in the ShadowData block.
+//
+// Two atlases: static geometry is rendered once per light position into a cache, and the atlas
+// the shaders read is that cache copied back (a depth blit) plus the moving casters drawn on top.
+// Only faces that some view of the last frame can see are considered, a face is only redone when
+// its light moved or the casters overlapping it changed, and at most faceBudget faces are
+// re-rendered per frame, oldest first - a skipped face keeps its last depth and matrix, so its
+// shadows lag a frame instead of popping.
+class ShadowAtlas {
+public:
+    static const int FACE_SIZE = 256;
+    static const int ROWS = LightingManager::MAX_SHADOWED_LIGHTS;
+
+    // Draws casters into the bound face (its view is current; lights inside a caster skip it)
+    using DrawCasters = std::function<void(const glm::vec3& lightPosition)>;
+
+    static bool initialize(int faceBudget);
+    static void shutdown();
+    static bool isEnabled() { return atlas != 0; }
+
+    // Sampler unit (once per program) and the atlas binding (once per view). The lit shaders
+    // always declare the atlas, so without one a 1x1 texture and an empty block stand in for it.
+    static void setupSamplers(const Shader& shader);
+    static void bindTexture();
+
+    // Views drawn this frame (main and portal views); the next update renders faces they see
+    static void addView(const glm::mat4& viewProjection);
+
+    // Static geometry changed (meshes streamed in) - every cached face is re-rendered
+    static void invalidate();
+
+    // Once per frame before the views: bring the visible faces up to date within the budget.
+    // Uses UniformBuffers view ranges, changes the framebuffer and viewport back to 0 / viewport.
+    static void update(const LightingManager& lighting, const glm::mat4& mainViewProjection,
+        const std::vector<ShadowCaster>& casters, const DrawCasters& drawStatic, const DrawCasters& drawMoving);
+
+    static void printStats();
+
+private:
+    struct Face {
+        glm::mat4 matrix;             // World to atlas (uv, depth) as last rendered
+        glm::vec3 lightPosition;      // Light position and range of the cached static depth
+        float range = 0.0f;
+        bool cached = false;          // Static depth is valid for lightPosition
+        bool rendered = false;        // Live tile has ever been written
+        uint64_t casterHash = 0;      // Casters overlapping it when last composed
+        uint64_t lastFrame = 0;       // Frame it was last composed
+    };
+
+    struct Row {
+        int light = -1;               // Index into LightingManager::pointLights
+        Face faces[6];
+    };
+
+    // A visible, out of date face waiting for its turn in the budget
+    struct Pending {
+        int row, face;
+        bool moved;
+        uint64_t casterHash;
+        float range;
+        glm::mat4 view, projection;
+    };
+
+    static void resetRow(Row& row, int light);
+    static void createFallback();
+    static void uploadMatrices();
+
+    static GLuint atlas, atlasFramebuffer;    // What the shaders sample (static + moving casters)
+    static GLuint cache, cacheFramebuffer;    // Static geometry only
+    static GLuint uniformBuffer;              // ShadowData block
+    static GLuint fallbackTexture, fallbackBuffer;  // 1x1 depth and zeroed block when the atlas failed
+    static size_t bytes;
+    static int faceBudget;
+    static uint64_t frame;
+    static Row rows[ROWS];
+    static std::vector<glm::mat4> views;      // View-projections drawn since the last update
+
+    // update() scratch, kept between frames so it doesn't allocate
+    static std::vector<glm::mat4> seenViews;
+    static std::vector<glm::vec4> seenPlanes;
+    static std::vector<glm::vec3> seenCorners;
+    static std::vector<Pending> pending;
+    static int lastStaticFaces, lastMovingFaces, lastSkippedFaces;
+};
@@ -2,27 +2,29 @@
 #include <string>
 #include <unordered_map>
 #include <GL/glew.h>
-#include "shader.hpp"
+#include "AssetRegistry.hpp"
 
 class TextureManager {
 public:
     // Load texture from file and store with given name
     static GLuint loadTexture(const std::string& name, const std::string& filePath);
 
-    // Get previously loaded texture by name
+    // Build a packed occlusion/roughness/metallic texture and store it with given name
+    static GLuint loadOrmTexture(const std::string& name, const OrmSource& source);
+
+    // Get previously loaded texture by name (load time only - MaterialManager keeps the IDs)
     static GLuint getTexture(const std::string& name);
 
+    // Same lookup, returning a reference that keeps the texture alive (empty if not found)
+    static TextureRef getTextureRef(const std::string& name);
+
     // Load all textures needed for the project
     static void loadAllTextures();
 
-    // Bind appropriate textures for different object types
-    // This handles PBR material setup (base color + roughness + metallic)
-    static void bindTextureForObject(const std::string& objectType, Shader& shader);
-
-    // Free all loaded textures
+    // Release all texture references (AssetRegistry frees the GL objects)
     static void cleanup();
 
 private:
-    // Static storage for all loaded textures (name -> OpenGL texture ID)
-    static std::unordered_map<std::string, GLuint> textures;
+    // Material texture names -> references into AssetRegistry (which owns the GL objects)
+    static std::unordered_map<std::string, TextureRef> textures;
 };
\ No newline at end of file
@@ -0,0 +1,62 @@
+#pragma once
+#include <GL/glew.h>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <condition_variable>
+#include "texture.hpp"
+
+// Ring of persistently mapped pixel unpack buffer memory for streamed texture uploads.
+// Decode workers copy the mip levels they want uploaded straight into the ring; the GL thread
+// then fills the texture from the ring (Texture::uploadStaged) and fences the region, which is
+// reused once the GPU has finished reading it. No upload waits for a copy from client memory.
+// Needs GL 4.4 / ARB_buffer_storage - without it AsyncLoader uploads from client memory as before.
+class TextureStreamer {
+public:
+    // Create and map the ring (GL thread, before AsyncLoader::start)
+    static bool initialize(size_t ringBytes);
+    static void shutdown();  // After AsyncLoader::stop
+    static bool isEnabled() { return mapped != nullptr; }
+
+    // Worker thread: copy the levels Texture::upload would use into the ring. Waits while the ring
+    // is full; returns false if the image can never fit or staging was cancelled (upload from memory).
+    static bool stage(const DecodedImage& image, int droppedLevels, StagedImage& staged);
+
+    // GL thread: upload a staged image into a texture and fence its region. Returns GPU memory used.
+    static size_t upload(GLuint textureID, const StagedImage& staged);
+
+    // GL thread: give back the region of a staged image that won't be uploaded
+    static void discard(const StagedImage& staged);
+
+    // GL thread, once per frame: free regions whose uploads the GPU has finished
+    static void retire();
+
+    // Wake and fail any worker waiting for space (AsyncLoader::stop, before joining).
+    // cancelStaging(false) accepts staging again.
+    static void cancelStaging(bool cancel = true);
+
+    static size_t getCapacity() { return capacity; }
+    static size_t getBytesInFlight();
+
+private:
+    // Regions are allocated in ring order and freed from the front
+    struct Region {
+        uint64_t id;
+        size_t offset, size;
+        GLsync fence = nullptr;  // Set once uploaded
+        bool discarded = false;
+    };
+
+    static bool findSpace(size_t size, size_t& offset);
+    static Region* findRegion(uint64_t id);
+
+    static GLuint buffer;
+    static uint8_t* mapped;
+    static size_t capacity;
+    static std::deque<Region> regions;
+    static uint64_t nextRegion;
+    static bool cancelled;
+    static std::mutex mutex;
+    static std::condition_variable spaceFreed;
+};
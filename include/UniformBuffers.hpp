@@ -0,0 +1,40 @@
+#pragma once
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+#include <cstddef>
+
+// std140 uniform blocks shared by every scene program (declared in each shader that uses them):
+//   FrameData    - time, written once per frame
+//   ViewData     - view/projection/camera position, one range per rendered view (portals included)
+//                  suballocated from one buffer, so switching views is a single glBindBufferRange
+//   LightingData - owned by LightingManager, rewritten only when the lights change
+//   ShadowData   - owned by ShadowAtlas, the point shadow face matrices
+class UniformBuffers {
+public:
+    static const GLuint FRAME_BINDING = 0;
+    static const GLuint VIEW_BINDING = 1;
+    static const GLuint LIGHTING_BINDING = 2;
+    static const GLuint SHADOW_BINDING = 3;
+
+    // Create the frame and view buffers (maxViews ranges per frame before the buffer is recycled early)
+    static void initialize(int maxViews);
+    static void shutdown();
+
+    // Point a program's blocks at the binding points above (Shader calls this after linking)
+    static void bindBlocks(GLuint program);
+
+    // Start of the frame: recycle the view ranges and write the frame block
+    static void beginFrame(float time);
+
+    // Write a view into the next free range and return its index; bindView makes it current
+    static int addView(const glm::mat4& view, const glm::mat4& projection, const glm::vec3& viewPos);
+    static void bindView(int index);
+
+private:
+    static GLuint frameBuffer;
+    static GLuint viewBuffer;
+    static GLsizeiptr viewStride;  // sizeof(ViewData) rounded up to GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT
+    static int maxViews;
+    static int viewCount;          // Ranges written this frame
+    static size_t bytes;           // Reported to GpuMemory
+};
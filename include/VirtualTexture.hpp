@@ -0,0 +1,136 @@
+#pragma once
+#include <GL/glew.h>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include "shader.hpp"
+
+// Virtual texturing for material base colours. Every image is split into 128x128 pages per mip
+// level (levels of 64x64 and below share one "tail" page); only the pages the camera actually
+// samples live in a fixed physical cache texture, so resident memory is the same whether the
+// scene uses ten unique textures or ten thousand.
+//
+// Each frame the scene shaders (standard.frag built with VIRTUAL_TEXTURING) write the page they
+// want into a feedback buffer for one pixel of every 4x4 tile, in portal views as well. The buffer
+// is read back a few frames later, missing pages are cut out of the uncompressed texture cache by
+// a loader thread, and the page table maps every page to itself or its nearest resident ancestor.
+// Needs GL 4.3 (shader storage buffers) - without it materials keep their regular textures.
+class VirtualTexture {
+public:
+    // Create the page cache (cacheSize x cacheSize pages), page tables and loader thread
+    static bool initialize(int cacheSize);
+    static void shutdown();
+    static bool isEnabled() { return cache != 0; }
+
+    // Back a material's base colour with the virtual texture of an image (shared between materials
+    // using the same image). Its size is only known once the loader has read it.
+    static void addMaterial(uint32_t material, const std::string& path);
+
+    // Sampler units and the feedback block binding (once per program)
+    static void setupSamplers(const Shader& shader);
+
+    // Bind the cache and page tables (once per view) and set the feedback stamp (once per shader per view)
+    static void bindTextures();
+    static void setupView(const Shader& shader);
+
+    // GL thread, start of the frame: read back finished feedback, request missing pages,
+    // upload loaded ones and rebuild the page tables that changed
+    static void update();
+
+    // GL thread, after every view has been drawn: copy this frame's feedback for readback
+    static void endFrame();
+
+    static int getCachePages() { return cacheSize * cacheSize; }
+    static int getResidentPages() { return residentPages; }
+    static void printStats();
+
+private:
+    // One image, shared by every material that uses it. Entries [entryBase, entryBase + entryCount)
+    // are its pages: level 0 row by row, then level 1 and so on, then the tail.
+    struct Source {
+        std::string path;
+        uint32_t width = 0, height = 0;
+        int levels = 0, tailLevel = 0;
+        uint32_t entryBase = 0, entryCount = 0;
+        std::vector<uint32_t> levelBase;  // First entry of each level up to and including the tail
+        bool probed = false;              // Size known and entries allocated
+        bool dirty = false;               // Page table needs rebuilding
+    };
+
+    // One page of one source
+    struct Entry {
+        uint32_t source;
+        uint16_t level, x, y;
+        int32_t slot = -1;          // Physical slot, -1 = not resident
+        bool loading = false;
+        uint32_t requestedFrame = 0;
+    };
+
+    struct Slot {
+        int32_t entry = -1;
+        uint32_t lastUsed = 0;  // Frame whose feedback last asked for the page
+    };
+
+    // Loader thread work: probes read a source's size, page jobs cut out one page
+    // (copies of everything the loader needs, sources may grow meanwhile)
+    struct Job {
+        uint32_t source;
+        int32_t entry = -1;  // -1 = probe
+        std::string path;
+        int level = 0, tailLevel = 0;
+        int x = 0, y = 0;
+    };
+    struct JobResult {
+        uint32_t source;
+        int32_t entry = -1;
+        uint32_t width = 0, height = 0;
+        int levels = 0;
+        std::vector<uint8_t> pixels;  // One RGBA8 slot
+        bool ok = false;
+    };
+
+    struct Readback {
+        GLuint buffer = 0;
+        GLsync fence = nullptr;
+        uint32_t stamp = 0;
+        uint32_t count = 0;
+    };
+
+    static void loaderLoop();
+    static void allocateEntries(uint32_t sourceIndex, const JobResult& result);
+    static void processFeedback(const std::vector<uint32_t>& feedback, uint32_t stamp);
+    static void request(uint32_t entry, std::vector<uint32_t>& missing);
+    static int32_t parentEntry(uint32_t entry);
+    static int32_t allocateSlot();
+    static void uploadPage(const JobResult& result);
+    static void rebuildPageTable(Source& source);
+    static void writeInfo(uint32_t material, const Source& source);
+
+    static int cacheSize;
+    static GLuint cache;
+    static GLuint pageTableBuffer, pageTable;
+    static GLuint infoBuffer, info;
+    static GLuint feedbackBuffer;
+    static std::vector<Readback> readbacks;
+    static size_t gpuBytes;
+
+    static std::vector<Source> sources;
+    static std::vector<Entry> entries;
+    static std::vector<Slot> slots;
+    static std::vector<int32_t> materialSources;  // Source per material, -1 = regular texture
+    static uint32_t frame;
+    static int residentPages;
+    static int loadsInFlight;
+    static size_t pagesUploaded, pagesDropped;
+
+    static std::thread loader;
+    static std::mutex mutex;
+    static std::condition_variable wake;
+    static std::deque<Job> jobs;
+    static std::deque<JobResult> results;
+    static bool stopping;
+};
@@ -17,6 +17,7 @@ private:
     static bool showLightingInfo;
     static bool showSceneInfo;
     static bool showCameraInfo;
+    static bool showMemoryInfo;
 
     // Performance tracking
     static float frameTime;    // Time for last frame
@@ -36,17 +37,12 @@ public:
     // Debug info printing (only prints if debug mode is on and specific category is enabled)
     static void printCameraInfo(const glm::vec3& pos, const glm::vec3& front, float yaw, float pitch);
     static void printLightingInfo(const LightingManager& lightingManager);
+    static void printMemoryInfo();
     static void printSceneInfo(const Scene& scene,
-        const std::unique_ptr<Model>& bookModel,
-        const std::unique_ptr<Model>& bookshelfModel,
-        const std::unique_ptr<Model>& bookshelf2Model,
-        const std::unique_ptr<Model>& columnModel,
-        const std::unique_ptr<Model>& floorModel,
-        const std::unique_ptr<Model>& lampModel,
-        const std::unique_ptr<Model>& portalModel,
-        const std::unique_ptr<Model>& ceilingModel,
-        const std::unique_ptr<Model>& wallModel,
-        const std::unique_ptr<Model>& torchModel);
+        const Model* bookModel,
+        const Model* bookshelfModel,
+        const Model* bookshelf2Model,
+        const Model* torchModel);
 
     // Toggle specific debug categories
     static void togglePerformanceStats();
@@ -54,4 +50,5 @@ public:
     static void toggleLightingInfo();
     static void toggleSceneInfo();
     static void toggleCameraInfo();
+    static void toggleMemoryInfo();
 };
\ No newline at end of file
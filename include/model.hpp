@@ -6,12 +6,30 @@
 
 class Model {
 public:
-    GLuint VAO, VBO;     // OpenGL objects for rendering
-    size_t vertexCount;  // Number of vertices to draw
+    GLuint VAO = 0, VBO = 0;  // OpenGL objects for rendering
+    GLuint lightmapVBO = 0;   // Second UV set at location 3 (static meshes with a baked lightmap)
+    size_t vertexCount = 0;   // Number of vertices to draw (VBO holds exactly these, reported to GpuMemory)
+    glm::vec3 boundsMin, boundsMax; // Local-space bounding box (used for culling)
 
-    // Load 3D model from OBJ file
-    Model(const std::string& path);
+    // Load 3D model from the mounted asset archive, or from the OBJ file if not packed
+    explicit Model(const std::string& path);
 
-    // Render the model (assumes shader is already active)
+    // Placeholder cube, replaced by upload() once the real mesh has been loaded
+    Model();
+
+    // Frees the VAO/VBO (models are owned by AssetRegistry)
+    ~Model();
+    Model(const Model&) = delete;
+    Model& operator=(const Model&) = delete;
+
+    // Render the model (assumes shader is active)
     void draw() const;
-};
\ No newline at end of file
+
+    // (Re)fill VAO/VBO from interleaved position(3) + normal(3) + texcoord(2) data.
+    // Buffer names stay the same, so VAOs that reference VBO keep working.
+    void upload(const float* vertices, size_t count);
+
+    // Add the lightmap UV set (2 floats per vertex, see Lightmap). Fails if the count doesn't
+    // match the uploaded mesh, e.g. while it is still the placeholder.
+    bool setLightmapCoords(const float* coords, size_t count);
+};
@@ -56,6 +56,7 @@ private:
     // Internal methods
     void generatePortalGeometry(Portal& portal);      // Create quad mesh for portal
     void cleanupPortalGeometry(Portal& portal);       // Free portal geometry
+    size_t renderTargetBytes() const;                 // Color + depth texture of one portal
     void renderAllPortalsAtDepth(
         const std::function<void(const glm::mat4&, const glm::mat4&)>& renderScene,
         const glm::vec3& cameraPos, const glm::vec3& cameraFront, const glm::vec3& cameraUp,
@@ -86,8 +87,8 @@ public:
         const glm::vec3& cameraPos, const glm::vec3& cameraFront, const glm::vec3& cameraUp,
         const glm::mat4& projection);
 
-    void renderPortalSurfaces(Shader& portalShader, const glm::mat4& view, const glm::mat4& projection,
-        const glm::vec3& cameraPos, float time);
+    // Draw the portal quads into the current view (camera and time come from the shared uniform blocks)
+    void renderPortalSurfaces(Shader& portalShader);
 
     // Player interaction
     bool checkPortalCollision(const glm::vec3& oldPos, const glm::vec3& newPos, glm::vec3& teleportPos) const;
@@ -1,15 +1,19 @@
 #pragma once
 #include <vector>
 #include <memory>
+#include <string>
 #include <GL/glew.h>
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 #include "shader.hpp"
 #include "model.hpp"
+#include "AssetRegistry.hpp"
+#include "MaterialManager.hpp"
 
 class SceneObject {
 public:
     const Model* model;
+    MaterialHandle material;  // Index into MaterialManager's table
     glm::vec3 position;
     glm::vec3 rotation;  // In radians
     glm::vec3 scale;
@@ -37,8 +41,15 @@ public:
     float floatTime = 0.0f;
     float pulseTime = 0.0f;
 
+    // Animation is evaluated in the vertex shader (AnimatedInstanceRenderer), CPU update is skipped
+    bool gpuAnimated = false;
+
+    // Static geometry with baked lighting: its rectangle of the lightmap atlas (see Lightmap)
+    bool lightmapped = false;
+    glm::vec4 lightmapScaleOffset = glm::vec4(0.0f);
+
     // Constructor
-    SceneObject(const Model* modelPtr,
+    SceneObject(const Model* modelPtr, MaterialHandle materialHandle,
         const glm::vec3& pos = glm::vec3(0.0f),
         const glm::vec3& rot = glm::vec3(0.0f),
         const glm::vec3& scl = glm::vec3(1.0f));
@@ -55,11 +66,18 @@ public:
     //void setPulsing(bool enabled, float amplitude = 0.1f, float speed = 2.0f);
 };
 
+// Group of meshes sharing one material (used by the batched renderers)
+struct DrawBatch {
+    MaterialHandle material;           // Also says whether the batch is a light source
+    std::vector<const Model*> models;  // Meshes using this material
+};
+
 class Scene {
 public:
     std::vector<SceneObject> objects;
+    std::vector<ModelRef> models;  // One reference per distinct mesh, keeps them loaded
 
-    void addObject(const Model* model,
+    void addObject(const ModelRef& model, MaterialHandle material,
         const glm::vec3& position = glm::vec3(0.0f),
         const glm::vec3& rotation = glm::vec3(0.0f),
         const glm::vec3& scale = glm::vec3(1.0f));
@@ -67,6 +85,9 @@ public:
     void update(float deltaTime);
     void draw(Shader& shader) const;
 
+    // Remove all objects and release their meshes
+    void clear();
+
     // Utility methods
     size_t getObjectCount() const { return objects.size(); }
     SceneObject& getObject(size_t index) { return objects[index]; }
@@ -1,21 +1,130 @@
 #pragma once
 #include <string>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <chrono>
 #include <gl/glew.h>
 
+// 32-bit FNV-1a of a uniform name (constexpr, so literals hash at compile time)
+constexpr uint32_t hashUniformName(const char* name, size_t length) {
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < length; i++) {
+        hash = (hash ^ static_cast<uint8_t>(name[i])) * 16777619u;
+    }
+    return hash;
+}
+
+// Uniform name reduced to its hash. Write literals as "model"_uniform; names built at runtime
+// (array elements) should be hashed once up front, not per frame.
+struct UniformName {
+    uint32_t hash;
+    constexpr UniformName(const char* name, size_t length) : hash(hashUniformName(name, length)) {}
+    explicit UniformName(const std::string& name) : hash(hashUniformName(name.data(), name.size())) {}
+};
+
+constexpr UniformName operator"" _uniform(const char* name, size_t length) {
+    return UniformName(name, length);
+}
+
+// Index into a program's uniform table, -1 = not an active uniform (setters ignore it)
+using UniformHandle = int;
+
 class Shader {
 public:
     GLuint ID;  // OpenGL shader program ID
 
-    // Constructor loads vertex and fragment shader files, compiles and links them
-    Shader(const char* vertexPath, const char* fragmentPath);
+    // Constructor loads vertex and fragment shader files and starts compiling and linking them,
+    // or loads the program binary a previous run left in shader_cache/ for the same sources and driver.
+    // defines (e.g. "#define VIRTUAL_TEXTURING\n") are inserted after the #version line of both.
+    // Nothing waits for the driver here: construct every program first and they compile side by side
+    // (on the driver's threads with KHR_parallel_shader_compile). The link result is collected on first use.
+    Shader(const char* vertexPath, const char* fragmentPath, const std::string& defines = "");
+
+    // Constructor for compute programs (single compute shader file, needs GL 4.3)
+    explicit Shader(const char* computePath);
 
     // Make this shader active for rendering
     void use() const;
 
-    // Utility functions for setting shader uniforms (shader variables)
-    void setBool(const std::string& name, bool value) const;
-    void setInt(const std::string& name, int value) const;
-    void setFloat(const std::string& name, float value) const;
-    void setVec3(const std::string& name, float x, float y, float z) const;
-    void setMat4(const std::string& name, const float* mat) const;  // Upload 4x4 matrix
+    // Wait for the link, report errors and timing, build the uniform table and store the binary.
+    // use() and getUniform() do this on first call.
+    void finishLink() const { if (!finished) completeLink(); }
+
+    // Uniform table, built from the program's active uniforms once linking has finished.
+    // Lookups are a binary search over name hashes - no strings, no glGetUniformLocation.
+    UniformHandle getUniform(UniformName name) const;
+    UniformHandle getUniform(const std::string& name) const { return getUniform(UniformName(name)); }
+
+    // Setters remember the last value sent per uniform and skip the glUniform call when it
+    // hasn't changed (uniform values are program state, so they stay valid across use() calls).
+    // The program must be current, as with plain glUniform.
+    void setBool(UniformHandle uniform, bool value) const { setInt(uniform, value ? 1 : 0); }
+    void setInt(UniformHandle uniform, int value) const;
+    void setUint(UniformHandle uniform, unsigned int value) const;
+    void setFloat(UniformHandle uniform, float value) const;
+    void setVec2(UniformHandle uniform, float x, float y) const;
+    void setIVec2(UniformHandle uniform, int x, int y) const;
+    void setVec3(UniformHandle uniform, float x, float y, float z) const;
+    void setVec4(UniformHandle uniform, float x, float y, float z, float w) const;
+    void setMat4(UniformHandle uniform, const float* mat) const;      // Upload 4x4 matrix
+    void setVec4Array(UniformHandle uniform, const float* data, GLsizei count) const;
+
+    // By name - hashed literal or runtime string (each lookup hashes the string)
+    void setBool(UniformName name, bool value) const { setBool(getUniform(name), value); }
+    void setInt(UniformName name, int value) const { setInt(getUniform(name), value); }
+    void setUint(UniformName name, unsigned int value) const { setUint(getUniform(name), value); }
+    void setFloat(UniformName name, float value) const { setFloat(getUniform(name), value); }
+    void setVec2(UniformName name, float x, float y) const { setVec2(getUniform(name), x, y); }
+    void setIVec2(UniformName name, int x, int y) const { setIVec2(getUniform(name), x, y); }
+    void setVec3(UniformName name, float x, float y, float z) const { setVec3(getUniform(name), x, y, z); }
+    void setVec4(UniformName name, float x, float y, float z, float w) const { setVec4(getUniform(name), x, y, z, w); }
+    void setMat4(UniformName name, const float* mat) const { setMat4(getUniform(name), mat); }
+    void setVec4Array(UniformName name, const float* data, GLsizei count) const {
+        setVec4Array(getUniform(name), data, count);
+    }
+    void setBool(const std::string& name, bool value) const { setBool(getUniform(name), value); }
+    void setInt(const std::string& name, int value) const { setInt(getUniform(name), value); }
+    void setFloat(const std::string& name, float value) const { setFloat(getUniform(name), value); }
+    void setVec3(const std::string& name, float x, float y, float z) const { setVec3(getUniform(name), x, y, z); }
+    void setMat4(const std::string& name, const float* mat) const { setMat4(getUniform(name), mat); }
+
+private:
+    // One name of an active uniform (array elements get an entry each). An array's bare name
+    // and its "[0]" element are the same location and share one cached value.
+    struct Uniform {
+        uint32_t hash;
+        GLint location;
+        size_t value;           // Index into values
+    };
+    struct UniformValue {
+        bool cached = false;    // bits holds what the program has
+        uint32_t bits[16];      // Last value sent (up to a mat4)
+    };
+
+    struct Stage {
+        GLenum type;
+        const char* path;
+        std::string source;
+    };
+
+    // Load the cached binary or compile and link the stages (no status queries)
+    void build(const std::vector<Stage>& stages);
+    void completeLink() const;
+    void reflectUniforms() const;
+
+    // Returns false (nothing to upload) if the uniform already holds these bytes
+    bool changed(UniformHandle uniform, const void* data, size_t bytes) const;
+
+    // Link state, completed by finishLink()
+    std::string label;                  // Source files, for log messages
+    std::string binaryPath;             // Cache file to write once linked, empty = loaded from it / no cache
+    mutable std::vector<GLuint> shaders;  // Kept until the link result is known, for their info logs
+    std::chrono::steady_clock::time_point submitTime;
+    double submitMs = 0.0;              // Spent in the constructor
+    mutable bool finished = false;
+    mutable bool linked = false;
+
+    mutable std::vector<Uniform> uniforms;  // Sorted by hash
+    mutable std::vector<UniformValue> values;
 };
@@ -1,10 +1,128 @@
 #pragma once
 #include <string>
+#include <vector>
+#include <memory>
+#include <cstdint>
 #include <gl/glew.h>
+#include "BlockCompression.hpp"
+
+// Frees pixels allocated by stb_image
+struct ImageFree {
+    void operator()(unsigned char* pixels) const;
+};
+
+// Decoded image waiting for upload. Built without any GL calls, so worker threads can fill it.
+struct DecodedImage {
+    int width = 0, height = 0, channels = 0;
+    const unsigned char* pixels = nullptr;              // Into decoded, scratch or the mapped archive
+    std::unique_ptr<unsigned char, ImageFree> decoded;  // stb_image allocation
+    std::vector<uint8_t> scratch;                       // Inflated archive entry or DDS file
+
+    // Cached images carry their whole prebuilt mip chain (levels index into pixels)
+    BlockFormat format = BlockFormat::None;
+    std::vector<ImageLevel> levels;
+};
+
+// Mip levels copied into a pixel unpack buffer by TextureStreamer (level offsets are into that buffer)
+struct StagedImage {
+    BlockFormat format = BlockFormat::None;
+    std::vector<ImageLevel> levels;  // Only the levels to upload, largest first
+    uint64_t region = 0;             // TextureStreamer ring region holding them
+};
+
+// Source images for a packed occlusion/roughness/metallic texture (R/G/B, glTF layout).
+// Channels without an image are filled with their constant, so maps don't need to exist at all.
+struct OrmSource {
+    std::string occlusion, roughness, metallic;  // Single-channel image paths, empty = constant
+    float occlusionValue = 1.0f;
+    float roughnessValue = 0.5f;
+    float metallicValue = 0.0f;
+
+    // Identity for the asset registry (same sources and constants = same texture)
+    std::string key() const;
+};
+
+// Owns one OpenGL texture object, deleted together with the wrapper
+class GpuTexture {
+public:
+    explicit GpuTexture(GLuint id) : id(id) {}
+    ~GpuTexture();
+    GpuTexture(const GpuTexture&) = delete;
+    GpuTexture& operator=(const GpuTexture&) = delete;
+
+    const GLuint id;
+
+    // GPU memory estimate (all uploaded mip levels), reported to GpuMemory
+    size_t getBytes() const { return bytes; }
+    void setBytes(size_t newBytes);
+
+    // Where the image comes from, so the memory budget can reload it at another mip level
+    std::string path;  // Image path (empty for packed ORM textures)
+    OrmSource orm;
+
+    // Residency, managed by AssetRegistry::enforceTextureBudget()
+    uint64_t lastUsedFrame = 0;  // GpuMemory frame of the last material bind
+    int droppedLevels = 0;       // Top mips left out to stay within the budget
+    size_t fullBytes = 0;        // Size with nothing dropped (known after the first full upload)
+    bool reloading = false;      // Reload at droppedLevels is queued
+
+private:
+    size_t bytes = 0;
+};
+
+// Texture quality tier = number of top mip levels skipped at upload (the cache keeps the full chain)
+enum class TextureQuality {
+    High = 0,
+    Medium = 1,  // Half resolution, quarter of the memory
+    Low = 2
+};
 
 class Texture {
 public:
     // Load texture from file path, returns OpenGL texture ID
     // flip parameter controls whether to flip texture vertically (some formats need this)
-    static GLuint load(const std::string& path, bool flip = true);
-};
\ No newline at end of file
+    static GLuint load(const std::string& path, bool flip = true, size_t* bytes = nullptr);
+
+    // Read and decode an image from the archive or disk (no GL calls).
+    // The result is a full mip chain (BCn, or RGBA8/R8 with compression off) from the cooked archive,
+    // the on-disk cache, or decoded, filtered and encoded right here and written to the cache.
+    static bool decode(const std::string& path, bool flip, DecodedImage& image);
+
+    // Same chain as RGBA8/R8 regardless of the compression setting (virtual texture pages are
+    // cut out of it texel by texel). Always flipped, like material textures.
+    static bool decodeUncompressed(const std::string& path, DecodedImage& image);
+
+    // Build a packed ORM mip chain from up to three single-channel images (no GL calls).
+    // Cached in texture_cache/ like decode(), keyed by the sources and constants.
+    static bool decodeOrm(const OrmSource& source, DecodedImage& image);
+    static GLuint loadOrm(const OrmSource& source, size_t* bytes = nullptr);
+
+    // (Re)specify an existing texture object from its prebuilt mip chain (no glGenerateMipmap).
+    // Levels above the quality tier, plus droppedLevels more, are skipped. Returns the GPU memory used.
+    static size_t upload(GLuint textureID, const DecodedImage& image, int droppedLevels = 0);
+
+    // Same from levels staged in a pixel unpack buffer: storage is (re)specified, then filled with
+    // glTexSubImage2D from the buffer, which returns without waiting for the copy.
+    static size_t uploadStaged(GLuint textureID, const StagedImage& image, GLuint pixelBuffer);
+
+    // First level of a prebuilt chain that upload() keeps (quality tier + droppedLevels, never below 4x4)
+    static size_t firstUploadLevel(const std::vector<ImageLevel>& levels, int droppedLevels);
+
+    // Enable block compression (call after glewInit - checks S3TC/RGTC/BPTC support)
+    static void configureCompression(bool enabled);
+    static bool isCompressionEnabled() { return compressionEnabled; }
+
+    // Drop top mip levels on low-memory configurations (applies to textures uploaded afterwards)
+    static void setQuality(TextureQuality quality) { Texture::quality = quality; }
+    static TextureQuality getQuality() { return quality; }
+
+    // 1x1 neutral grey texture, shown until the real image has been uploaded into it
+    static GLuint createPlaceholder();
+
+private:
+    static bool decodeCached(const std::string& path, bool flip, bool allowCompression, DecodedImage& image);
+
+    static bool compressionEnabled;
+    static bool bc7Supported;
+    static TextureQuality quality;
+};
@@ -0,0 +1,106 @@
+#version 330 core
+// Vertex shader for GPU-animated instances - rebuilds the model matrix from
+// closed-form orbit/float/spin animation instead of a per-object uniform
+layout (location = 0) in vec3 aPos;      // Vertex position
+layout (location = 1) in vec3 aNormal;   // Surface normal
+layout (location = 2) in vec2 aTexCoord; // Texture coordinates
+
+// Per-instance animation parameters (see AnimatedInstance)
+layout (location = 3) in vec4 aBasePosition;  // xyz = base position, w = flags (1 rotate, 2 float, 4 orbit)
+layout (location = 4) in vec4 aOrbit;         // xyz = orbit center, w = radius
+layout (location = 5) in vec4 aMotion;        // orbitSpeed, orbitPhase, floatAmplitude, floatSpeed
+layout (location = 6) in vec4 aSpin;          // floatPhase, rotationSpeed, base rotation x, base rotation y
+layout (location = 7) in vec4 aRotationScale; // base rotation z, scale xyz
+#ifdef PROBE_STATIC_LIGHTS
+layout (location = 8) in vec4 aProbe[7];      // 9 RGB L2 SH irradiance coefficients at the instance (InstanceProbeLighting)
+#endif
+
+out vec3 FragPos;
+out vec3 Normal;
+out vec2 TexCoord;
+flat out int MaterialLayer;
+#ifdef PROBE_STATIC_LIGHTS
+out vec3 ProbeIrradiance; // Baked irradiance for this vertex's normal
+#endif
+
+// Per-view camera (UniformBuffers, one range per view)
+layout(std140) uniform ViewData {
+    mat4 view;       // World-to-camera transformation
+    mat4 projection; // Camera-to-screen projection
+    vec3 viewPos;    // Camera position in world space
+};
+
+// Per-frame values (UniformBuffers)
+layout(std140) uniform FrameData {
+    float time;      // Seconds since startup
+};
+
+uniform float animationStart; // Time the instance phases were captured at
+uniform int materialLayer;    // Texture array layer (one material per instance group)
+
+#ifdef PROBE_STATIC_LIGHTS
+// Irradiance for a unit normal - L2 SH basis in IrradianceProbes order (low frequency, so per vertex is enough)
+vec3 probeIrradiance(vec3 n) {
+    vec3 c0 = aProbe[0].xyz;
+    vec3 c1 = vec3(aProbe[0].w, aProbe[1].xy);
+    vec3 c2 = vec3(aProbe[1].zw, aProbe[2].x);
+    vec3 c3 = aProbe[2].yzw;
+    vec3 c4 = aProbe[3].xyz;
+    vec3 c5 = vec3(aProbe[3].w, aProbe[4].xy);
+    vec3 c6 = vec3(aProbe[4].zw, aProbe[5].x);
+    vec3 c7 = aProbe[5].yzw;
+    vec3 c8 = aProbe[6].xyz;
+    vec3 e = c0 * 0.282095
+        + (c1 * n.y + c2 * n.z + c3 * n.x) * 0.488603
+        + (c4 * n.x * n.y + c5 * n.y * n.z + c7 * n.x * n.z) * 1.092548
+        + c6 * (0.315392 * (3.0 * n.z * n.z - 1.0))
+        + c8 * (0.546274 * (n.x * n.x - n.y * n.y));
+    return max(e, vec3(0.0));
+}
+#endif
+
+void main() {
+    float t = time - animationStart;
+    int flags = int(aBasePosition.w + 0.5);
+    bool rotating = (flags & 1) != 0;
+    bool floating = (flags & 2) != 0;
+    bool orbiting = (flags & 4) != 0;
+
+    vec3 position = aBasePosition.xyz;
+    float rotationY = aSpin.w;
+
+    // Same motion as SceneObject::update, evaluated from time directly
+    if (orbiting) {
+        float angle = aMotion.y + aMotion.x * t;
+        position.x = aOrbit.x + aOrbit.w * cos(angle);
+        position.z = aOrbit.z + aOrbit.w * sin(angle);
+        rotationY = angle + radians(90.0); // Face the direction of movement
+    }
+    else if (rotating) {
+        rotationY += aSpin.y * t;
+    }
+
+    if (floating) {
+        float baseY = orbiting ? aOrbit.y : aBasePosition.y;
+        position.y = baseY + sin(aSpin.x + aMotion.w * t) * aMotion.z;
+    }
+
+    // Translate * RotX * RotY * RotZ * Scale (matches SceneObject::updateModelMatrix)
+    float cx = cos(aSpin.z), sx = sin(aSpin.z);
+    float cy = cos(rotationY), sy = sin(rotationY);
+    float cz = cos(aRotationScale.x), sz = sin(aRotationScale.x);
+    mat3 rotX = mat3(1.0, 0.0, 0.0,  0.0, cx, sx,  0.0, -sx, cx);
+    mat3 rotY = mat3(cy, 0.0, -sy,  0.0, 1.0, 0.0,  sy, 0.0, cy);
+    mat3 rotZ = mat3(cz, sz, 0.0,  -sz, cz, 0.0,  0.0, 0.0, 1.0);
+    mat3 rotation = rotX * rotY * rotZ;
+    mat3 linear = rotation * mat3(aRotationScale.y, 0.0, 0.0,  0.0, aRotationScale.z, 0.0,  0.0, 0.0, aRotationScale.w);
+
+    FragPos = linear * aPos + position;
+    Normal = rotation * (aNormal / aRotationScale.yzw); // Inverse-transpose of rotation * scale
+    TexCoord = aTexCoord;
+    MaterialLayer = materialLayer;
+#ifdef PROBE_STATIC_LIGHTS
+    ProbeIrradiance = probeIrradiance(normalize(Normal));
+#endif
+    gl_Position = projection * view * vec4(FragPos, 1.0);
+}
@@ -0,0 +1,85 @@
+#version 330 core
+// Deferred light volume: shades the G-buffer pixel under the sphere with one light (added by blending)
+out vec4 FragColor;
+
+flat in vec4 PositionRange;
+flat in vec4 ColorIntensity;
+flat in vec4 Falloff;            // Attenuation, shadow atlas row (-1 = none)
+
+// Per-view camera (UniformBuffers, one range per view)
+layout(std140) uniform ViewData {
+    mat4 view;       // World-to-camera transformation
+    mat4 projection; // Camera-to-screen projection
+    vec3 viewPos;    // Camera position in world space
+};
+
+uniform sampler2D gAlbedo;               // rgb = albedo, a = occlusion
+uniform sampler2D gNormal;               // World normal * 0.5 + 0.5
+uniform sampler2D gMaterial;             // r = roughness, g = metallic
+uniform sampler2D gDepth;
+uniform mat4 inverseViewProjection;      // Depth back to world position
+
+// Point light shadows, same as standard.frag (see ShadowAtlas.hpp)
+#define MAX_SHADOWED_LIGHTS 8
+layout(std140) uniform ShadowData {
+    mat4 shadowMatrices[MAX_SHADOWED_LIGHTS * 6];
+    vec4 shadowTile;                     // xy = one face in atlas uv, zw = half a texel
+};
+uniform sampler2DShadow shadowAtlas;
+
+float pointShadow(int slot, vec3 lightPos, vec3 fragPos, vec3 norm) {
+    if (slot < 0) return 1.0;
+    float distance = length(lightPos - fragPos);
+    vec3 offsetPos = fragPos + norm * (0.01 + 0.012 * distance);
+    vec3 dir = offsetPos - lightPos;
+    vec3 axis = abs(dir);
+    int face;
+    if (axis.x >= axis.y && axis.x >= axis.z) face = dir.x > 0.0 ? 0 : 1;
+    else if (axis.y >= axis.z) face = dir.y > 0.0 ? 2 : 3;
+    else face = dir.z > 0.0 ? 4 : 5;
+
+    vec4 coord = shadowMatrices[slot * 6 + face] * vec4(offsetPos, 1.0);
+    coord.xyz /= coord.w;
+    vec2 tileMin = vec2(face, slot) * shadowTile.xy;
+    coord.xy = clamp(coord.xy, tileMin + shadowTile.zw, tileMin + shadowTile.xy - shadowTile.zw);
+    return texture(shadowAtlas, coord.xyz);
+}
+
+// Same as shadePointLight in standard.frag (range > 0 fades the light to zero there)
+vec3 shadePointLight(vec3 fragPos, vec3 position, vec3 color, float intensity, vec3 falloff, float range,
+                     vec3 norm, vec3 viewDir, vec3 albedo, float roughness) {
+    vec3 lightDir = normalize(position - fragPos);
+    float distance = length(position - fragPos);
+
+    float attenuation = intensity / (falloff.x + falloff.y * distance + falloff.z * distance * distance);
+    float edge = clamp(1.0 - pow(distance / range, 4.0), 0.0, 1.0);
+    attenuation *= edge * edge;
+
+    float diff = max(dot(norm, lightDir), 0.0);
+
+    vec3 halfwayDir = normalize(lightDir + viewDir);
+    float spec = pow(max(dot(norm, halfwayDir), 0.0), mix(32.0, 128.0, 1.0 - roughness));
+    spec *= (1.0 - roughness) * 0.5;
+
+    return (diff * albedo + spec) * color * attenuation;
+}
+
+void main() {
+    ivec2 pixel = ivec2(gl_FragCoord.xy);
+    float depth = texelFetch(gDepth, pixel, 0).r;
+
+    // World position of the surface from the depth buffer
+    vec2 ndc = gl_FragCoord.xy / vec2(textureSize(gDepth, 0)) * 2.0 - 1.0;
+    vec4 world = inverseViewProjection * vec4(ndc, depth * 2.0 - 1.0, 1.0);
+    vec3 fragPos = world.xyz / world.w;
+
+    vec3 albedo = texelFetch(gAlbedo, pixel, 0).rgb;
+    vec3 norm = normalize(texelFetch(gNormal, pixel, 0).xyz * 2.0 - 1.0);
+    float roughness = texelFetch(gMaterial, pixel, 0).r;
+    vec3 viewDir = normalize(viewPos - fragPos);
+
+    vec3 light = shadePointLight(fragPos, PositionRange.xyz, ColorIntensity.rgb, ColorIntensity.a, Falloff.xyz,
+                                 PositionRange.w, norm, viewDir, albedo, roughness) *
+                 pointShadow(int(Falloff.w), PositionRange.xyz, fragPos, norm);
+    FragColor = vec4(light, 1.0);
+}
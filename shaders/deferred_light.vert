@@ -0,0 +1,24 @@
+#version 330 core
+// Deferred light volume: unit sphere scaled to the light's range, one instance per light
+layout (location = 0) in vec3 aPos;              // Unit sphere vertex
+layout (location = 3) in vec4 aPositionRange;    // Light position, range
+layout (location = 4) in vec4 aColorIntensity;   // Light color, intensity
+layout (location = 5) in vec4 aFalloff;          // Attenuation: constant, linear, quadratic; shadow atlas row
+
+flat out vec4 PositionRange;
+flat out vec4 ColorIntensity;
+flat out vec4 Falloff;
+
+// Per-view camera (UniformBuffers, one range per view)
+layout(std140) uniform ViewData {
+    mat4 view;       // World-to-camera transformation
+    mat4 projection; // Camera-to-screen projection
+    vec3 viewPos;    // Camera position in world space
+};
+
+void main() {
+    PositionRange = aPositionRange;
+    ColorIntensity = aColorIntensity;
+    Falloff = aFalloff;
+    gl_Position = projection * view * vec4(aPositionRange.xyz + aPos * aPositionRange.w, 1.0);
+}
@@ -0,0 +1,48 @@
+#version 330 core
+// Deferred resolve: ambient + accumulated lights into the HDR scene target (PostProcess finishes it).
+// Writes the G-buffer depth so light sources and portals can be drawn forward afterwards.
+out vec4 FragColor;
+
+in vec2 TexCoord;
+
+uniform sampler2D gAlbedo;             // rgb = albedo, a = occlusion
+uniform sampler2D gDepth;
+uniform sampler2D lightAccumulation;   // Sum of the light volumes (HDR)
+uniform vec3 background;               // PostProcess::BACKGROUND
+
+// Same block as standard.frag - only the ambient terms are used here
+struct PointLight {
+    vec3 position;
+    vec3 color;
+    float intensity;
+    float constant;
+    float linear;
+    float quadratic;
+    int shadowSlot;
+};
+
+#define MAX_POINT_LIGHTS 16
+
+layout(std140) uniform LightingData {
+    PointLight pointLights[MAX_POINT_LIGHTS];
+    vec3 ambientColor;
+    float ambientStrength;
+    int numPointLights;
+};
+
+void main() {
+    ivec2 pixel = ivec2(gl_FragCoord.xy);
+    float depth = texelFetch(gDepth, pixel, 0).r;
+    gl_FragDepth = depth;
+
+    // Nothing drawn here - same clear color as the forward path
+    if (depth >= 1.0) {
+        FragColor = vec4(background, 1.0);
+        return;
+    }
+
+    vec4 albedoOcclusion = texelFetch(gAlbedo, pixel, 0);
+    vec3 result = ambientColor * ambientStrength * albedoOcclusion.rgb * albedoOcclusion.a;
+    result += texelFetch(lightAccumulation, pixel, 0).rgb;
+    FragColor = vec4(result, 1.0);
+}
@@ -0,0 +1,10 @@
+#version 330 core
+// Fullscreen triangle built from gl_VertexID (drawn with an empty vertex array, 3 vertices)
+
+out vec2 TexCoord;
+
+void main() {
+    vec2 position = vec2((gl_VertexID << 1) & 2, gl_VertexID & 2);  // (0,0), (2,0), (0,2)
+    TexCoord = position;
+    gl_Position = vec4(position * 2.0 - 1.0, 0.0, 1.0);
+}
@@ -0,0 +1,39 @@
+#version 430 core
+// Vertex shader for the GPU-driven path - same outputs as standard.vert,
+// but the model matrix comes from the object SSBO instead of a uniform
+layout (location = 0) in vec3 aPos;         // Vertex position
+layout (location = 1) in vec3 aNormal;      // Surface normal
+layout (location = 2) in vec2 aTexCoord;    // Texture coordinates
+layout (location = 3) in uint aObjectIndex; // Visible object index (per instance, written by cull.comp)
+
+out vec3 FragPos;
+out vec3 Normal;
+out vec2 TexCoord;
+flat out int MaterialLayer;
+
+struct GpuObject {
+    mat4 model;
+    vec4 localSphere;
+    uint commandIndex;
+    uint materialLayer;
+    uint pad1, pad2;
+};
+
+layout (std430, binding = 0) readonly buffer Objects { GpuObject objects[]; };
+
+// Per-view camera (UniformBuffers, one range per view)
+layout(std140) uniform ViewData {
+    mat4 view;       // World-to-camera transformation
+    mat4 projection; // Camera-to-screen projection
+    vec3 viewPos;    // Camera position in world space
+};
+
+void main() {
+    mat4 model = objects[aObjectIndex].model;
+
+    FragPos = vec3(model * vec4(aPos, 1.0));
+    Normal = mat3(transpose(inverse(model))) * aNormal;
+    TexCoord = aTexCoord;
+    MaterialLayer = int(objects[aObjectIndex].materialLayer); // Per object, so one draw can span materials
+    gl_Position = projection * view * vec4(FragPos, 1.0);
+}
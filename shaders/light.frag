@@ -4,16 +4,48 @@ out vec4 FragColor; // Output color of the fragment shader
 in vec3 FragPos; // 3D position of the fragment in world space
 in vec3 Normal; // Surface normal at the fragment (shading)
 in vec2 TexCoord; // Texture coordinates for the fragment
+flat in int MaterialLayer; // Material's layer in the texture arrays
 
-uniform vec3 viewPos; // Camera position in world space
 uniform sampler2D baseColorMap; // Base color texture for mesh
-uniform vec3 ambientColor; // ambientColor light
-uniform float ambientStrength; // Strength of ambient light
-uniform float time; // Time variable for animations 
+uniform bool useMaterialArrays; // Sample baseColorArray instead of baseColorMap
+uniform sampler2DArray baseColorArray; // Base colors, one layer per material
+// Per-view camera (UniformBuffers, one range per view)
+layout(std140) uniform ViewData {
+    mat4 view;       // World-to-camera transformation
+    mat4 projection; // Camera-to-screen projection
+    vec3 viewPos;    // Camera position in world space
+};
+
+// Per-frame values (UniformBuffers)
+layout(std140) uniform FrameData {
+    float time;      // Seconds since startup
+};
+
+// Same block as standard.frag - only the ambient terms are used here
+struct PointLight {
+    vec3 position;
+    vec3 color;
+    float intensity;
+    float constant;
+    float linear;
+    float quadratic;
+    int shadowSlot;
+};
+
+#define MAX_POINT_LIGHTS 16
+
+layout(std140) uniform LightingData {
+    PointLight pointLights[MAX_POINT_LIGHTS];
+    vec3 ambientColor;      // ambientColor light
+    float ambientStrength;  // Strength of ambient light
+    int numPointLights;
+};
 
 void main() {
     // Sample the texture
-    vec3 albedo = texture(baseColorMap, TexCoord).rgb; // Base color from texture
+    vec3 albedo = useMaterialArrays
+        ? texture(baseColorArray, vec3(TexCoord, float(MaterialLayer))).rgb
+        : texture(baseColorMap, TexCoord).rgb; // Base color from texture
     
     // Light objects should be mostly self-lit (they ARE the light sources)
     vec3 result = albedo;
@@ -21,11 +53,11 @@ void main() {
     // a bit of ambient light 
     result += ambientColor * ambientStrength * 0.5f;
     
-    // warm glow effect
-    result *= vec3(1.1f, 0.95f, 0.8f);  
-    
-    // gamma correction, without it the colors can look washed out
-    result = pow(result, vec3(1.0f/2.2f));
+    // Emit the HDR value that post.frag's tint and tone mapping bring back to this color
+    // (light sources were never tone mapped; clamped short of white, which would need infinity)
+    vec3 tint = vec3(1.1f, 0.95f, 0.8f);
+    vec3 display = min(result * tint, vec3(0.98f));
+    result = display / (1.0f - display) / tint;
     
     FragColor = vec4(result, 1.0f);
 }
\ No newline at end of file
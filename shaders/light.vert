@@ -7,10 +7,17 @@ layout (location = 2) in vec2 aTexCoord; // UV coordinates
 out vec3 FragPos;
 out vec3 Normal;
 out vec2 TexCoord;
+flat out int MaterialLayer;
+
+// Per-view camera (UniformBuffers, one range per view)
+layout(std140) uniform ViewData {
+    mat4 view;       // World-to-camera transformation
+    mat4 projection; // Camera-to-screen projection
+    vec3 viewPos;    // Camera position in world space
+};
 
 uniform mat4 model; // local -> world 
-uniform mat4 view; // world -> view (camera)
-uniform mat4 projection; // view -> clip (pespective)
+uniform int materialLayer; // texture array layer
 
 void main() {
     // Identical transformation to standard.vert
@@ -18,5 +25,6 @@ void main() {
     FragPos = vec3(model * vec4(aPos, 1.0));
     Normal = mat3(transpose(inverse(model))) * aNormal;
     TexCoord = aTexCoord;
+    MaterialLayer = materialLayer;
     gl_Position = projection * view * vec4(FragPos, 1.0);
 }
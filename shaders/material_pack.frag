@@ -0,0 +1,13 @@
+#version 330 core
+// Resamples one material texture into a mip level of a texture array layer.
+// Sources already have filtered mip chains, so each target level reads the matching source level.
+out vec4 FragColor;
+
+uniform sampler2D source;   // Base color or packed ORM texture
+uniform float lod;          // Source mip level matching the target level size
+uniform vec2 targetSize;    // Size of the level being written
+
+void main() {
+    vec2 uv = gl_FragCoord.xy / targetSize;
+    FragColor = textureLod(source, uv, lod);
+}
@@ -3,8 +3,12 @@ out vec4 FragColor;
 
 in vec2 TexCoord;  // UV coordinates from vertex shader
 
+// Per-frame values (UniformBuffers)
+layout(std140) uniform FrameData {
+    float time;      // Seconds since startup
+};
+
 uniform sampler2D portalView;      // Texture containing the rendered portal view
-uniform float time;                // Current time for animations
 uniform bool portalActive = true;  // Whether portal should render
 
 
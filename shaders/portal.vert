@@ -5,10 +5,15 @@ layout (location = 2) in vec2 aTexCoord; // UV coordinates for portal texture
 
 out vec2 TexCoord; // Pass UV to fragment shader
 
+// Per-view camera (UniformBuffers, one range per view)
+layout(std140) uniform ViewData {
+    mat4 view;       // World-to-camera transformation
+    mat4 projection; // Camera-to-screen projection
+    vec3 viewPos;    // Camera position in world space
+};
+
 // Transformation matrices
 uniform mat4 model;      // Portal positioning and orientation
-uniform mat4 view;       // Camera transformation
-uniform mat4 projection; // Projection to screen
 
 void main() {
     // Simple pass-through of texture coordinates
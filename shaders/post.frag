@@ -0,0 +1,17 @@
+#version 330 core
+// Scene resolve (PostProcess): the HDR scene to the display - warm tint, tone mapping and gamma,
+// once per pixel instead of in every lit fragment
+out vec4 FragColor;
+
+in vec2 TexCoord;
+
+uniform sampler2D hdrScene;    // Linear radiance of the main view, portals composited in
+
+void main() {
+    vec3 result = texelFetch(hdrScene, ivec2(gl_FragCoord.xy), 0).rgb;
+
+    result *= vec3(1.1, 0.95, 0.8);            // Warm color tint
+    result = result / (result + vec3(1.0));    // Tone mapping (Reinhard)
+    result = pow(result, vec3(1.0 / 2.2));     // Gamma correction (light.frag and BACKGROUND assume this curve)
+    FragColor = vec4(result, 1.0);
+}
@@ -0,0 +1,5 @@
+#version 330 core
+// Depth-only pass into a shadow atlas face (ShadowAtlas) - standard.vert or animated.vert
+// place the geometry in the face's view, polygon offset biases the depth
+void main() {
+}
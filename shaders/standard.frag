@@ -1,11 +1,29 @@
 #version 330 core
+#ifdef VIRTUAL_TEXTURING
+#extension GL_ARB_shader_storage_buffer_object : require
+#extension GL_ARB_shader_image_load_store : require
+#endif
 
+#ifdef GBUFFER
+// Deferred geometry pass (DeferredRenderer): surface attributes instead of a lit color
+layout(location = 0) out vec4 gAlbedo;            // rgb = albedo, a = occlusion
+layout(location = 1) out vec4 gNormal;            // World-space normal * 0.5 + 0.5
+layout(location = 2) out vec2 gMaterial;          // Roughness, metallic
+#else
 out vec4 FragColor;
-// Final output color written to framebuffer
+// Linear HDR radiance - PostProcess tints, tone maps and encodes it once per pixel
+#endif
 
 in vec3 FragPos;    // Fragment position in world space (from vertex shader)
 in vec3 Normal;     // Fragment normal vector (interpolated)
 in vec2 TexCoord;   // Texture coordinates for sampling material maps
+flat in int MaterialLayer; // Material's layer in the texture arrays
+#ifdef LIGHTMAP_STATIC_LIGHTS
+in vec2 LightmapCoord;     // Position in the lightmap atlas
+#endif
+#ifdef PROBE_STATIC_LIGHTS
+in vec3 ProbeIrradiance;   // Baked irradiance from the probes (animated.vert only)
+#endif
 
 // Struct defining a physically accurate point light
 struct PointLight {
@@ -15,67 +33,263 @@ struct PointLight {
     float constant;  // Attenuation: constant term
     float linear;    // Attenuation: linear term
     float quadratic; // Attenuation: quadratic term (realistic falloff)
+    int shadowSlot;  // Row in the shadow atlas, -1 = casts no shadows
 };
 
 #define MAX_POINT_LIGHTS 16 // Max number of lights supported in shader (compile-time)
 
-// Scene-wide uniforms
-uniform PointLight pointLights[MAX_POINT_LIGHTS]; // Array of all active point lights
-uniform int numPointLights;                       // Actual count of active lights
-uniform vec3 viewPos;                             // Camera position in world space
+// Per-view camera (UniformBuffers, one range per view)
+layout(std140) uniform ViewData {
+    mat4 view;       // World-to-camera transformation
+    mat4 projection; // Camera-to-screen projection
+    vec3 viewPos;    // Camera position in world space
+};
+
+// Per-frame values (UniformBuffers)
+layout(std140) uniform FrameData {
+    float time;      // Seconds since startup
+};
+
+// Scene lights, rewritten by LightingManager only when they change (std140, see LightingManager.cpp)
+layout(std140) uniform LightingData {
+    PointLight pointLights[MAX_POINT_LIGHTS];     // Array of all active point lights
+    vec3 ambientColor;                            // Ambient light color
+    float ambientStrength;                        // Ambient light intensity
+    int numPointLights;                           // Actual count of active lights
+};
+
+// Material uniforms. Which set is sampled is a compile-time feature (ShaderVariants):
+// MATERIAL_ARRAYS = the arrays, VIRTUAL_TEXTURING = the page cache for base colour, neither = the maps
 uniform sampler2D baseColorMap;                   // Albedo (diffuse) texture
-uniform sampler2D roughnessMap;                   // Roughness texture (R channel)
-uniform sampler2D metallicMap;                    // Metallic texture (R channel)
-uniform vec3 ambientColor;                        // Ambient light color
-uniform float ambientStrength;                    // Ambient light intensity
-uniform float time;                               // Time uniform (for future animation use)
+uniform sampler2D ormMap;                         // R = occlusion, G = roughness, B = metallic
+uniform sampler2DArray baseColorArray;            // Albedo, one layer per material
+uniform sampler2DArray ormArray;                  // Packed ORM, one layer per material
+
+#ifdef VIRTUAL_TEXTURING
+// Virtual texture base color (see VirtualTexture.hpp - the constants must match)
+layout(early_fragment_tests) in;                  // Hidden fragments don't request pages
+
+uniform sampler2D vtCache;                        // Physical page cache, 136x136 texel slots
+uniform usamplerBuffer vtPageTable;               // Per page: slot x | slot y << 8 | held level << 16 | resident << 24
+uniform usamplerBuffer vtInfo;                    // Per material: first page, width, height, levels | tail level << 8
+uniform uint vtFeedbackStamp;                     // Frame number written into requested pages
+uniform ivec2 vtFeedbackJitter;                   // Pixel of each 4x4 tile that reports this frame
+layout(std430) buffer VirtualFeedback { uint vtRequests[]; };
+
+const int VT_PAGE_SIZE = 128;
+const int VT_BORDER = 4;
+const int VT_SLOT_SIZE = 136;
+const ivec2 VT_TAIL_ORIGIN[7] = ivec2[7](ivec2(2, 2), ivec2(70, 2), ivec2(106, 2),
+    ivec2(2, 70), ivec2(14, 70), ivec2(22, 70), ivec2(28, 70));
+
+vec3 sampleVirtual(int material, vec2 uv) {
+    uvec4 info = texelFetch(vtInfo, material);
+    ivec2 size = ivec2(info.yz);
+
+    // Level from the unwrapped coordinates (no derivative spikes at repeat seams)
+    vec2 texels = uv * vec2(max(size, ivec2(1)));
+    vec2 dx = dFdx(texels), dy = dFdy(texels);
+    float lod = 0.5 * log2(max(max(dot(dx, dx), dot(dy, dy)), 1e-8));
+    if (size.x == 0) return vec3(0.5);            // Size not known yet
+
+    int levels = int(info.w & 0xFFu);
+    int tailLevel = int(info.w >> 8);
+    int level = clamp(int(lod + 0.5), 0, levels - 1);
+
+    // Requested page: page grids of the levels above the tail, then one tail entry
+    vec2 wrapped = fract(uv);
+    int entry = int(info.x);
+    for (int m = 0; m < min(level, tailLevel); m++) {
+        ivec2 pages = (max(size >> m, ivec2(1)) + VT_PAGE_SIZE - 1) / VT_PAGE_SIZE;
+        entry += pages.x * pages.y;
+    }
+    if (level < tailLevel) {
+        ivec2 levelSize = max(size >> level, ivec2(1));
+        ivec2 pages = (levelSize + VT_PAGE_SIZE - 1) / VT_PAGE_SIZE;
+        ivec2 page = min(ivec2(wrapped * vec2(levelSize)) / VT_PAGE_SIZE, pages - 1);
+        entry += page.y * pages.x + page.x;
+    }
+
+    if (all(equal(ivec2(gl_FragCoord.xy) & 3, vtFeedbackJitter))) {
+        vtRequests[entry] = vtFeedbackStamp;
+    }
+
+    // The page itself or its nearest resident ancestor
+    uint resolved = texelFetch(vtPageTable, entry).r;
+    if ((resolved >> 24) == 0u) return vec3(0.5);
+    ivec2 slot = ivec2(resolved & 0xFFu, (resolved >> 8) & 0xFFu);
+    int held = int((resolved >> 16) & 0xFFu);
+    vec2 texel = wrapped * vec2(max(size >> held, ivec2(1)));
+
+    vec2 inSlot;
+    if (held >= tailLevel) {
+        inSlot = vec2(VT_TAIL_ORIGIN[min(held - tailLevel, 6)]) + texel;
+    }
+    else {
+        vec2 page = floor(texel / float(VT_PAGE_SIZE));
+        inSlot = vec2(VT_BORDER) + texel - page * float(VT_PAGE_SIZE);
+    }
+    vec2 cacheTexel = vec2(slot * VT_SLOT_SIZE) + inSlot;
+    return textureLod(vtCache, cacheTexel / vec2(textureSize(vtCache, 0)), 0.0).rgb;
+}
+#endif
+
+#ifdef LIGHTMAP_STATIC_LIGHTS
+// Baked irradiance (Lightmap): ambient, the first LIGHTMAP_STATIC_LIGHTS lights with shadows and their bounce light
+uniform sampler2D lightmap;
+const int FIRST_DYNAMIC_LIGHT = LIGHTMAP_STATIC_LIGHTS;
+#elif defined(PROBE_STATIC_LIGHTS)
+const int FIRST_DYNAMIC_LIGHT = PROBE_STATIC_LIGHTS;  // Same lights as the lightmap, from the probes
+#else
+const int FIRST_DYNAMIC_LIGHT = 0;
+#endif
+
+// Point light shadows (see ShadowAtlas.hpp - MAX_SHADOWED_LIGHTS must match): six faces per
+// shadowed light side by side in one depth atlas, compared through each face's matrix
+#define MAX_SHADOWED_LIGHTS 8
+layout(std140) uniform ShadowData {
+    mat4 shadowMatrices[MAX_SHADOWED_LIGHTS * 6]; // World to atlas uv + depth, light by light
+    vec4 shadowTile;                              // xy = one face in atlas uv, zw = half a texel
+};
+uniform sampler2DShadow shadowAtlas;
+
+// 0 = shadowed, 1 = lit (bilinear 2x2 comparison). Faces in cube map order, picked by major axis.
+float pointShadow(int slot, vec3 lightPos, vec3 fragPos, vec3 norm) {
+    if (slot < 0) return 1.0;
+    float distance = length(lightPos - fragPos);
+    vec3 offsetPos = fragPos + norm * (0.01 + 0.012 * distance);  // About a texel and a half, against acne
+    vec3 dir = offsetPos - lightPos;
+    vec3 axis = abs(dir);
+    int face;
+    if (axis.x >= axis.y && axis.x >= axis.z) face = dir.x > 0.0 ? 0 : 1;
+    else if (axis.y >= axis.z) face = dir.y > 0.0 ? 2 : 3;
+    else face = dir.z > 0.0 ? 4 : 5;
+
+    vec4 coord = shadowMatrices[slot * 6 + face] * vec4(offsetPos, 1.0);
+    coord.xyz /= coord.w;
+    vec2 tileMin = vec2(face, slot) * shadowTile.xy;
+    coord.xy = clamp(coord.xy, tileMin + shadowTile.zw, tileMin + shadowTile.xy - shadowTile.zw);  // Stay in the face
+    return texture(shadowAtlas, coord.xyz);
+}
+
+#ifdef CLUSTERED_LIGHTS
+// Clustered light lists (see ClusteredLighting.hpp - the grid size must match)
+uniform samplerBuffer clusterLights;              // Per light: position + range, color + intensity, attenuation + shadow row
+uniform usamplerBuffer clusterGrid;               // Per cluster: first index, light count
+uniform usamplerBuffer clusterLightIndices;       // Light indices, cluster by cluster
+
+const int CLUSTER_TILES_X = 16;
+const int CLUSTER_TILES_Y = 9;
+const int CLUSTER_SLICES = 24;
+#endif
+
+// One point light's diffuse + specular contribution. falloff = constant, linear, quadratic;
+// range > 0 fades the light smoothly to zero there (clustered lights end at their range)
+vec3 shadePointLight(vec3 position, vec3 color, float intensity, vec3 falloff, float range,
+                     vec3 norm, vec3 viewDir, vec3 albedo, float roughness) {
+    vec3 lightDir = normalize(position - FragPos);                // Direction from fragment to light
+    float distance = length(position - FragPos);                  // Distance to light
+
+    // Attenuation factor: energy falloff over distance
+    float attenuation = intensity / (falloff.x + falloff.y * distance + falloff.z * distance * distance);
+    if (range > 0.0) {
+        float edge = clamp(1.0 - pow(distance / range, 4.0), 0.0, 1.0);
+        attenuation *= edge * edge;
+    }
+
+    // Diffuse term (Lambertian reflection): how much the surface faces the light
+    float diff = max(dot(norm, lightDir), 0.0);
+
+    // Specular term (Blinn-Phong with roughness-based shininess)
+    vec3 halfwayDir = normalize(lightDir + viewDir);              // Halfway vector between light and view
+    float spec = pow(max(dot(norm, halfwayDir), 0.0),
+                     mix(32.0, 128.0, 1.0 - roughness));          // Shininess depends on surface smoothness
+    spec *= (1.0 - roughness) * 0.5;                              // Weaken specular on rough surfaces
+
+    // Combine diffuse and specular lighting, scale by light color and attenuation
+    return (diff * albedo + spec) * color * attenuation;
+}
 
 void main() {
-    // Sample PBR material properties from textures
-    vec3 albedo = texture(baseColorMap, TexCoord).rgb;            // Surface base color
-    float roughness = texture(roughnessMap, TexCoord).r;          // Roughness controls highlight sharpness
-    float metallic = texture(metallicMap, TexCoord).r;            // (Not used directly here)
+    // Sample PBR material properties from textures (one fetch for all three ORM channels)
+    vec3 albedo;
+    vec3 orm;
+#ifdef VIRTUAL_TEXTURING
+    albedo = sampleVirtual(MaterialLayer, TexCoord);              // ORM stays a regular texture
+    orm = texture(ormMap, TexCoord).rgb;
+#elif defined(MATERIAL_ARRAYS)
+    vec3 layerCoord = vec3(TexCoord, float(MaterialLayer));
+    albedo = texture(baseColorArray, layerCoord).rgb;
+    orm = texture(ormArray, layerCoord).rgb;
+#else
+    albedo = texture(baseColorMap, TexCoord).rgb;                 // Surface base color
+    orm = texture(ormMap, TexCoord).rgb;
+#endif
+    float occlusion = orm.r;                                      // Baked cavity darkening (ambient only)
+    float roughness = orm.g;                                      // Roughness controls highlight sharpness
+    float metallic = orm.b;                                       // (Not used directly here)
 
     vec3 norm = normalize(Normal);                                // Ensure normal is unit length
+
+#ifdef GBUFFER
+    // Lighting happens later, per light volume
+    gAlbedo = vec4(albedo, occlusion);
+    gNormal = vec4(norm * 0.5 + 0.5, 1.0);
+    gMaterial = vec2(roughness, metallic);
+#else
     vec3 viewDir = normalize(viewPos - FragPos);                  // Direction to the camera (for specular reflection)
 
+#ifdef LIGHTMAP_STATIC_LIGHTS
+    // Static lighting was baked - only the moving lights are added below
+    vec3 result = texture(lightmap, LightmapCoord).rgb * albedo;
+#elif defined(PROBE_STATIC_LIGHTS)
+    // Static lighting from the probes around this instance - only the moving lights are added below
+    vec3 result = ProbeIrradiance * albedo * occlusion;
+#else
     // Start with ambient lighting contribution (soft fill light)
-    vec3 result = ambientColor * ambientStrength * albedo;
-
-    // Loop through all point lights and accumulate their contributions
-    for (int i = 0; i < numPointLights && i < MAX_POINT_LIGHTS; i++) {
-        vec3 lightDir = normalize(pointLights[i].position - FragPos); // Direction from fragment to light
-        float distance = length(pointLights[i].position - FragPos);   // Distance to light
-
-        // Attenuation factor: energy falloff over distance
-        float attenuation = pointLights[i].intensity / (
-            pointLights[i].constant +
-            pointLights[i].linear * distance +
-            pointLights[i].quadratic * distance * distance);
-
-        // Diffuse term (Lambertian reflection): how much the surface faces the light
-        float diff = max(dot(norm, lightDir), 0.0);
-
-        // Specular term (Blinn-Phong with roughness-based shininess)
-        vec3 halfwayDir = normalize(lightDir + viewDir); // Halfway vector between light and view
-        float spec = pow(max(dot(norm, halfwayDir), 0.0), 
-                         mix(32.0, 128.0, 1.0 - roughness)); // Shininess depends on surface smoothness
-        spec *= (1.0 - roughness) * 0.5; // Weaken specular on rough surfaces
-
-        // Combine diffuse and specular lighting, scale by light color and attenuation
-        vec3 lightContrib = (diff * albedo + spec) * pointLights[i].color * attenuation;
-        result += lightContrib; // Accumulate into total result
-    }
-
-    // Apply a warm color tint 
-    result *= vec3(1.1, 0.95, 0.8); 
+    vec3 result = ambientColor * ambientStrength * albedo * occlusion;
+#endif
 
-    // Apply simple tone mapping (compress HDR to LDR)
-    result = result / (result + vec3(1.0));
+#if defined(CLUSTERED_LIGHTS)
+    // Only the lights assigned to this fragment's cluster (screen tile x depth slice)
+    vec4 viewSpace = view * vec4(FragPos, 1.0);
+    vec4 clip = projection * viewSpace;
+    vec2 tileCoord = clamp(clip.xy / clip.w * 0.5 + 0.5, 0.0, 0.99999);
+    float nearPlane = projection[3][2] / (projection[2][2] - 1.0);
+    float farPlane = projection[3][2] / (projection[2][2] + 1.0);
+    int slice = int(log(max(-viewSpace.z, nearPlane) / nearPlane) / log(farPlane / nearPlane) * float(CLUSTER_SLICES));
+    ivec2 tile = ivec2(tileCoord * vec2(CLUSTER_TILES_X, CLUSTER_TILES_Y));
+    int cluster = (min(slice, CLUSTER_SLICES - 1) * CLUSTER_TILES_Y + tile.y) * CLUSTER_TILES_X + tile.x;
+    uvec2 list = texelFetch(clusterGrid, cluster).rg;             // First index, light count
 
-    // Gamma correction (convert from linear to sRGB for display)
-    result = pow(result, vec3(1.0 / 2.2));
+    for (uint n = 0u; n < list.y; n++) {
+        int light = int(texelFetch(clusterLightIndices, int(list.x + n)).r);
+        if (light < FIRST_DYNAMIC_LIGHT) continue;                // Baked
+        int index = light * 3;
+        vec4 positionRange = texelFetch(clusterLights, index);
+        vec4 colorIntensity = texelFetch(clusterLights, index + 1);
+        vec4 falloffShadow = texelFetch(clusterLights, index + 2);
+        result += shadePointLight(positionRange.xyz, colorIntensity.rgb, colorIntensity.a, falloffShadow.xyz,
+                                  positionRange.w, norm, viewDir, albedo, roughness) *
+                  pointShadow(int(falloffShadow.w), positionRange.xyz, FragPos, norm);
+    }
+#else
+    // Loop through all point lights and accumulate their contributions.
+    // Variants are built for the scene's light count, so the loop has a constant trip count
+    // and unrolls; without POINT_LIGHT_COUNT it follows numPointLights.
+#ifdef POINT_LIGHT_COUNT
+    for (int i = FIRST_DYNAMIC_LIGHT; i < POINT_LIGHT_COUNT; i++) {
+#else
+    for (int i = FIRST_DYNAMIC_LIGHT; i < numPointLights && i < MAX_POINT_LIGHTS; i++) {
+#endif
+        vec3 falloff = vec3(pointLights[i].constant, pointLights[i].linear, pointLights[i].quadratic);
+        result += shadePointLight(pointLights[i].position, pointLights[i].color, pointLights[i].intensity,
+                                  falloff, 0.0, norm, viewDir, albedo, roughness) *
+                  pointShadow(pointLights[i].shadowSlot, pointLights[i].position, FragPos, norm);
+    }
+#endif
 
-    // Output final color with full opacity
+    // Output HDR with full opacity (tint, tone mapping and gamma happen in post.frag)
     FragColor = vec4(result, 1.0);
+#endif
 }
@@ -3,16 +3,32 @@
 layout (location = 0) in vec3 aPos;      // Vertex position
 layout (location = 1) in vec3 aNormal;   // Surface normal
 layout (location = 2) in vec2 aTexCoord; // Texture coordinates
+#ifdef LIGHTMAP_STATIC_LIGHTS
+layout (location = 3) in vec2 aLightmapCoord; // Position in the mesh's lightmap layout (Model::setLightmapCoords)
+#endif
 
 // Output to fragment shader
 out vec3 FragPos;  // World position of vertex
 out vec3 Normal;   // Transformed normal
 out vec2 TexCoord; // Pass-through texture coordinates
+flat out int MaterialLayer; // Texture array layer (material handle)
+#ifdef LIGHTMAP_STATIC_LIGHTS
+out vec2 LightmapCoord; // Position in the lightmap atlas
+#endif
+
+// Per-view camera (UniformBuffers, one range per view)
+layout(std140) uniform ViewData {
+    mat4 view;       // World-to-camera transformation
+    mat4 projection; // Camera-to-screen projection
+    vec3 viewPos;    // Camera position in world space
+};
 
 // Transformation matrices (set by application)
 uniform mat4 model;      // Object-to-world transformation
-uniform mat4 view;       // World-to-camera transformation  
-uniform mat4 projection; // Camera-to-screen projection
+uniform int materialLayer; // Set per material by MaterialManager::bind
+#ifdef LIGHTMAP_STATIC_LIGHTS
+uniform vec4 lightmapScaleOffset; // This object's rectangle of the atlas (xy = scale, zw = offset)
+#endif
 
 void main() {
     // Transform vertex position to world space
@@ -24,6 +40,10 @@ void main() {
     
     // Pass texture coordinates unchanged
     TexCoord = aTexCoord;
+    MaterialLayer = materialLayer;
+#ifdef LIGHTMAP_STATIC_LIGHTS
+    LightmapCoord = aLightmapCoord * lightmapScaleOffset.xy + lightmapScaleOffset.zw;
+#endif
     
     // Transform vertex to screen space for rasterization
     gl_Position = projection * view * vec4(FragPos, 1.0);
@@ -0,0 +1,202 @@
+#include "AnimatedInstanceRenderer.hpp"
+#include "MaterialManager.hpp"
+#include "GpuMemory.hpp"
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+namespace AnimationFlags {
+    const float ROTATE = 1.0f;
+    const float FLOAT = 2.0f;
+    const float ORBIT = 4.0f;
+}
+
+AnimatedInstanceRenderer::~AnimatedInstanceRenderer() {
+    cleanup();
+}
+
+void AnimatedInstanceRenderer::initialize(const Scene& scene, const std::vector<DrawBatch>& batches, float startTime) {
+    cleanup();
+    animationStart = startTime;
+
+    for (const auto& batch : batches) {
+        // Light sources use a different fragment shader and stay on the CPU path
+        if (MaterialManager::get(batch.material).lightSource) continue;
+
+        for (const Model* model : batch.models) {
+            if (!model || model->vertexCount == 0) continue;
+
+            InstanceGroup group;
+            group.material = batch.material;
+            group.model = model;
+            size_t firstInstance = instances.size();
+
+            for (const auto& obj : scene.objects) {
+                if (!obj.gpuAnimated || obj.model != model) continue;
+
+                // Current timers become the phases, the shader advances them with (time - animationStart)
+                float flags = 0.0f;
+                if (obj.rotating) flags += AnimationFlags::ROTATE;
+                if (obj.floating) flags += AnimationFlags::FLOAT;
+                if (obj.orbiting) flags += AnimationFlags::ORBIT;
+
+                AnimatedInstance instance;
+                instance.basePosition = glm::vec4(obj.basePosition, flags);
+                instance.orbit = glm::vec4(obj.orbitCenter, obj.orbitRadius);
+                instance.motion = glm::vec4(obj.orbitSpeed, obj.orbitTime, obj.floatAmplitude, obj.floatSpeed);
+                instance.spin = glm::vec4(obj.floatTime, obj.rotationSpeed, obj.rotation.x, obj.rotation.y);
+                instance.rotationScale = glm::vec4(obj.rotation.z, obj.scale);
+                instances.push_back(instance);
+            }
+
+            group.instanceCount = static_cast<GLsizei>(instances.size() - firstInstance);
+            if (group.instanceCount == 0) continue;
+
+            // Each group gets its own VAO so instance attributes start at its first record
+            glGenVertexArrays(1, &group.VAO);
+            groups.push_back(group);
+        }
+    }
+
+    if (instances.empty()) return;
+
+    // Upload once - nothing is written to this buffer after startup
+    glGenBuffers(1, &instanceBuffer);
+    glBindBuffer(GL_ARRAY_BUFFER, instanceBuffer);
+    glBufferData(GL_ARRAY_BUFFER, instances.size() * sizeof(AnimatedInstance), instances.data(), GL_STATIC_DRAW);
+
+    // Probe lighting, rewritten each frame while a bake applies
+    probeLighting.assign(instances.size(), InstanceProbeLighting());
+    glGenBuffers(1, &probeBuffer);
+    glBindBuffer(GL_ARRAY_BUFFER, probeBuffer);
+    glBufferData(GL_ARRAY_BUFFER, probeLighting.size() * sizeof(InstanceProbeLighting), probeLighting.data(), GL_DYNAMIC_DRAW);
+    instanceBytes = instances.size() * (sizeof(AnimatedInstance) + sizeof(InstanceProbeLighting));
+    GpuMemory::allocate(GpuMemoryCategory::Buffers, instanceBytes);
+
+    size_t firstInstance = 0;
+    for (size_t g = 0; g < groups.size(); g++) {
+        glBindVertexArray(groups[g].VAO);
+
+        // Model vertex layout (same as Model's own VAO)
+        glBindBuffer(GL_ARRAY_BUFFER, groups[g].model->VBO);
+        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)0);
+        glEnableVertexAttribArray(0);
+        glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(3 * sizeof(float)));
+        glEnableVertexAttribArray(1);
+        glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(6 * sizeof(float)));
+        glEnableVertexAttribArray(2);
+
+        // Animation parameters, five vec4s per instance
+        glBindBuffer(GL_ARRAY_BUFFER, instanceBuffer);
+        for (GLuint i = 0; i < 5; i++) {
+            size_t offset = firstInstance * sizeof(AnimatedInstance) + i * sizeof(glm::vec4);
+            glVertexAttribPointer(3 + i, 4, GL_FLOAT, GL_FALSE, sizeof(AnimatedInstance), (void*)offset);
+            glVertexAttribDivisor(3 + i, 1);
+            glEnableVertexAttribArray(3 + i);
+        }
+
+        // Probe coefficients, seven vec4s per instance
+        glBindBuffer(GL_ARRAY_BUFFER, probeBuffer);
+        for (GLuint i = 0; i < 7; i++) {
+            size_t offset = firstInstance * sizeof(InstanceProbeLighting) + i * sizeof(glm::vec4);
+            glVertexAttribPointer(8 + i, 4, GL_FLOAT, GL_FALSE, sizeof(InstanceProbeLighting), (void*)offset);
+            glVertexAttribDivisor(8 + i, 1);
+            glEnableVertexAttribArray(8 + i);
+        }
+
+        firstInstance += groups[g].instanceCount;
+    }
+
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    std::cout << "GPU animation: " << instances.size() << " instances in " << groups.size() << " groups" << std::endl;
+}
+
+glm::vec3 AnimatedInstanceRenderer::instancePosition(const AnimatedInstance& instance, float time) const {
+    float t = time - animationStart;
+    int flags = static_cast<int>(instance.basePosition.w + 0.5f);
+    glm::vec3 position = glm::vec3(instance.basePosition);
+    if (flags & 4) {
+        float angle = instance.motion.y + instance.motion.x * t;
+        position.x = instance.orbit.x + instance.orbit.w * cos(angle);
+        position.z = instance.orbit.z + instance.orbit.w * sin(angle);
+    }
+    if (flags & 2) {
+        float baseY = (flags & 4) ? instance.orbit.y : instance.basePosition.y;
+        position.y = baseY + sin(instance.spin.x + instance.motion.w * t) * instance.motion.z;
+    }
+    return position;
+}
+
+void AnimatedInstanceRenderer::updateProbeLighting(const IrradianceProbes& probes, float time) {
+    if (instances.empty()) return;
+
+    for (size_t i = 0; i < instances.size(); i++) {
+        // Only the position - the probes vary far too slowly to need the rotation
+        glm::vec3 coefficients[IrradianceProbes::COEFFICIENTS];
+        probes.sample(instancePosition(instances[i], time), coefficients);
+        float* packed = &probeLighting[i].packed[0].x;
+        for (int k = 0; k < IrradianceProbes::COEFFICIENTS; k++) {
+            packed[k * 3] = coefficients[k].x;
+            packed[k * 3 + 1] = coefficients[k].y;
+            packed[k * 3 + 2] = coefficients[k].z;
+        }
+    }
+
+    glBindBuffer(GL_ARRAY_BUFFER, probeBuffer);
+    glBufferSubData(GL_ARRAY_BUFFER, 0, probeLighting.size() * sizeof(InstanceProbeLighting), probeLighting.data());
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void AnimatedInstanceRenderer::getInstanceSpheres(float time, std::vector<ShadowCaster>& spheres) const {
+    // Instances are grouped by model; a sphere around the scaled bounds covers any rotation
+    size_t first = 0;
+    for (const auto& group : groups) {
+        if (group.model->vertexCount > 0) {
+            glm::vec3 extent = glm::max(glm::abs(group.model->boundsMin), glm::abs(group.model->boundsMax));
+            for (size_t i = first; i < first + group.instanceCount; i++) {
+                const AnimatedInstance& instance = instances[i];
+                glm::vec3 scale = glm::abs(glm::vec3(instance.rotationScale.y, instance.rotationScale.z, instance.rotationScale.w));
+                float radius = glm::length(extent) * std::max(scale.x, std::max(scale.y, scale.z));
+                spheres.push_back({ instancePosition(instance, time), radius });
+            }
+        }
+        first += group.instanceCount;
+    }
+}
+
+void AnimatedInstanceRenderer::draw(Shader& shader) const {
+    shader.setFloat("animationStart"_uniform, animationStart);
+
+    for (const auto& group : groups) {
+        MaterialManager::bind(group.material, shader);
+        if (group.model->vertexCount == 0) continue;
+        glBindVertexArray(group.VAO);
+        glDrawArraysInstanced(GL_TRIANGLES, 0, static_cast<GLsizei>(group.model->vertexCount), group.instanceCount);
+    }
+    glBindVertexArray(0);
+}
+
+size_t AnimatedInstanceRenderer::getInstanceCount() const {
+    size_t count = 0;
+    for (const auto& group : groups) count += group.instanceCount;
+    return count;
+}
+
+void AnimatedInstanceRenderer::cleanup() {
+    for (auto& group : groups) {
+        if (group.VAO) glDeleteVertexArrays(1, &group.VAO);
+    }
+    groups.clear();
+
+    if (instanceBuffer) {
+        glDeleteBuffers(1, &instanceBuffer);
+        glDeleteBuffers(1, &probeBuffer);
+        instanceBuffer = probeBuffer = 0;
+        GpuMemory::release(GpuMemoryCategory::Buffers, instanceBytes);
+        instanceBytes = 0;
+    }
+    instances.clear();
+    probeLighting.clear();
+}
@@ -0,0 +1,158 @@
+#include "AssetArchive.hpp"
+#include "Compression.hpp"
+#include <iostream>
+#include <cstring>
+#include <algorithm>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// Static member definitions - archive mapping state
+const uint8_t* AssetArchive::mappedData = nullptr;
+size_t AssetArchive::mappedSize = 0;
+const ArchiveEntry* AssetArchive::entries = nullptr;
+uint32_t AssetArchive::entryCount = 0;
+void* AssetArchive::fileHandle = nullptr;
+void* AssetArchive::mappingHandle = nullptr;
+
+uint64_t AssetArchive::hashName(const std::string& name) {
+    // Normalize separators and leading "./" so "assets\\a.png" and "./assets/a.png" match
+    size_t start = (name.size() >= 2 && name[0] == '.' && (name[1] == '/' || name[1] == '\\')) ? 2 : 0;
+
+    uint64_t hash = 14695981039346656037ull;  // FNV offset basis
+    for (size_t i = start; i < name.size(); i++) {
+        char c = name[i] == '\\' ? '/' : name[i];
+        hash ^= static_cast<uint8_t>(c);
+        hash *= 1099511628211ull;             // FNV prime
+    }
+    return hash;
+}
+
+uint64_t AssetArchive::hashBytes(const uint8_t* data, size_t size) {
+    uint64_t hash = 14695981039346656037ull;
+    for (size_t i = 0; i < size; i++) {
+        hash ^= data[i];
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+bool AssetArchive::mount(const std::string& path) {
+    unmount();
+
+#ifdef _WIN32
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+        OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_RANDOM_ACCESS, nullptr);
+    if (file == INVALID_HANDLE_VALUE) return false;
+
+    LARGE_INTEGER fileSize;
+    GetFileSizeEx(file, &fileSize);
+    HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (!mapping) {
+        CloseHandle(file);
+        return false;
+    }
+
+    mappedData = static_cast<const uint8_t*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+    if (!mappedData) {
+        CloseHandle(mapping);
+        CloseHandle(file);
+        return false;
+    }
+    mappedSize = static_cast<size_t>(fileSize.QuadPart);
+    fileHandle = file;
+    mappingHandle = mapping;
+#else
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) return false;
+
+    struct stat info;
+    if (fstat(fd, &info) != 0 || info.st_size == 0) {
+        close(fd);
+        return false;
+    }
+
+    void* mapping = mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+    if (mapping == MAP_FAILED) {
+        close(fd);
+        return false;
+    }
+    mappedData = static_cast<const uint8_t*>(mapping);
+    mappedSize = static_cast<size_t>(info.st_size);
+    fileHandle = reinterpret_cast<void*>(static_cast<intptr_t>(fd));
+#endif
+
+    // Validate header and TOC bounds before trusting anything
+    const ArchiveHeader* header = reinterpret_cast<const ArchiveHeader*>(mappedData);
+    if (mappedSize < sizeof(ArchiveHeader) ||
+        std::memcmp(header->magic, ArchiveFormat::MAGIC, 4) != 0 ||
+        header->version != ArchiveFormat::VERSION ||
+        header->tocOffset + uint64_t(header->entryCount) * sizeof(ArchiveEntry) > mappedSize) {
+        std::cerr << "Invalid asset archive: " << path << std::endl;
+        unmount();
+        return false;
+    }
+
+    entries = reinterpret_cast<const ArchiveEntry*>(mappedData + header->tocOffset);
+    entryCount = header->entryCount;
+
+    std::cout << "Mounted asset archive " << path << " (" << entryCount << " entries, "
+        << mappedSize / (1024 * 1024) << " MB)" << std::endl;
+    return true;
+}
+
+void AssetArchive::unmount() {
+    if (!mappedData) return;
+
+#ifdef _WIN32
+    UnmapViewOfFile(mappedData);
+    CloseHandle(static_cast<HANDLE>(mappingHandle));
+    CloseHandle(static_cast<HANDLE>(fileHandle));
+#else
+    munmap(const_cast<uint8_t*>(mappedData), mappedSize);
+    close(static_cast<int>(reinterpret_cast<intptr_t>(fileHandle)));
+#endif
+
+    mappedData = nullptr;
+    mappedSize = 0;
+    entries = nullptr;
+    entryCount = 0;
+    fileHandle = nullptr;
+    mappingHandle = nullptr;
+}
+
+const ArchiveEntry* AssetArchive::find(const std::string& name) {
+    if (!mappedData) return nullptr;
+
+    // TOC is sorted by hash - binary search
+    uint64_t hash = hashName(name);
+    const ArchiveEntry* end = entries + entryCount;
+    const ArchiveEntry* it = std::lower_bound(entries, end, hash,
+        [](const ArchiveEntry& entry, uint64_t value) { return entry.nameHash < value; });
+
+    if (it == end || it->nameHash != hash) return nullptr;
+    if (it->offset + it->storedSize > mappedSize) return nullptr;  // Truncated archive
+    return it;
+}
+
+const uint8_t* AssetArchive::data(const ArchiveEntry& entry, std::vector<uint8_t>& scratch) {
+    const uint8_t* blob = mappedData + entry.offset;
+    if (!(entry.flags & ArchiveFlags::COMPRESSED)) {
+        return blob;  // Zero-copy
+    }
+
+    scratch.resize(static_cast<size_t>(entry.size));
+    if (!Compression::decompress(blob, static_cast<size_t>(entry.storedSize), scratch.data(), scratch.size())) {
+        std::cerr << "Corrupt compressed archive entry " << std::hex << entry.nameHash << std::dec << std::endl;
+        return nullptr;
+    }
+    return scratch.data();
+}
@@ -0,0 +1,187 @@
+#include "AssetRegistry.hpp"
+#include "AsyncLoader.hpp"
+#include "GpuMemory.hpp"
+#include <algorithm>
+#include <iostream>
+
+// Static member definitions - one pool per asset type
+AssetPool<Model> AssetRegistry::models;
+AssetPool<GpuTexture> AssetRegistry::textures;
+bool AssetRegistry::budgetWarningShown = false;
+
+namespace {
+    const uint64_t IN_USE_FRAMES = 2;          // Bound this frame or the last one
+    const uint64_t EVICT_AFTER_FRAMES = 600;   // ~10 s unbound: straight to the smallest level
+    const int MAX_DROPPED_LEVELS = 16;         // Upload clamps this to the 4x4 level
+    const size_t MIN_REDUCIBLE_BYTES = 1024;   // Nothing worth reloading below this
+    const size_t RESTORE_HEADROOM_PERCENT = 10; // Free budget kept before levels come back (no ping-pong)
+}
+
+ModelRef AssetRegistry::loadModel(const std::string& path) {
+    // Already loaded - share it
+    AssetHandle<Model> existing = models.find(path);
+    if (existing.isValid()) return ModelRef(existing);
+
+    // Streaming: placeholder cube now, the loader uploads the real mesh into it later
+    if (AsyncLoader::isRunning()) {
+        ModelRef model(models.add(path, std::make_unique<Model>()));
+        AsyncLoader::loadMesh(model, path);
+        return model;
+    }
+
+    return ModelRef(models.add(path, std::make_unique<Model>(path)));
+}
+
+TextureRef AssetRegistry::loadTexture(const std::string& path) {
+    AssetHandle<GpuTexture> existing = textures.find(path);
+    if (existing.isValid()) return TextureRef(existing);
+
+    if (AsyncLoader::isRunning()) {
+        TextureRef texture(textures.add(path, std::make_unique<GpuTexture>(Texture::createPlaceholder())));
+        texture->path = path;
+        texture->setBytes(4);
+        AsyncLoader::loadTexture(texture, path);
+        return texture;
+    }
+
+    size_t bytes = 0;
+    GLuint id = Texture::load(path, true, &bytes);
+    TextureRef texture(textures.add(path, std::make_unique<GpuTexture>(id)));
+    texture->path = path;
+    texture->setBytes(bytes);
+    return texture;
+}
+
+TextureRef AssetRegistry::loadOrmTexture(const OrmSource& source) {
+    std::string key = source.key();
+    AssetHandle<GpuTexture> existing = textures.find(key);
+    if (existing.isValid()) return TextureRef(existing);
+
+    if (AsyncLoader::isRunning()) {
+        TextureRef texture(textures.add(key, std::make_unique<GpuTexture>(Texture::createPlaceholder())));
+        texture->orm = source;
+        texture->setBytes(4);
+        AsyncLoader::loadOrmTexture(texture, source);
+        return texture;
+    }
+
+    size_t bytes = 0;
+    GLuint id = Texture::loadOrm(source, &bytes);
+    TextureRef texture(textures.add(key, std::make_unique<GpuTexture>(id)));
+    texture->orm = source;
+    texture->setBytes(bytes);
+    return texture;
+}
+
+size_t AssetRegistry::getTextureMemory() {
+    size_t total = 0;
+    textures.forEach([&](const GpuTexture& texture) { total += texture.getBytes(); });
+    return total;
+}
+
+void AssetRegistry::reloadTexture(AssetHandle<GpuTexture> handle) {
+    TextureRef texture(handle);
+    texture->reloading = true;
+    if (AsyncLoader::isRunning()) {
+        AsyncLoader::reloadTexture(texture);
+        return;
+    }
+
+    // No workers - the texture cache makes this a file read, not a PNG decode
+    DecodedImage image;
+    bool decoded = texture->path.empty() ? Texture::decodeOrm(texture->orm, image) :
+        Texture::decode(texture->path, true, image);
+    if (decoded) texture->setBytes(Texture::upload(texture->id, image, texture->droppedLevels));
+    texture->reloading = false;
+}
+
+void AssetRegistry::enforceTextureBudget() {
+    size_t budget = GpuMemory::getBudget();
+    if (budget == 0) return;
+
+    struct Candidate {
+        AssetHandle<GpuTexture> handle;
+        GpuTexture* texture;
+    };
+    std::vector<Candidate> candidates;
+    bool reloading = false;
+    textures.forEachHandle([&](AssetHandle<GpuTexture> handle, GpuTexture& texture) {
+        reloading = reloading || texture.reloading;
+        candidates.push_back({ handle, &texture });
+    });
+    if (reloading) return;  // Measure again once the previous step has landed
+
+    uint64_t frame = GpuMemory::getFrame();
+    size_t total = GpuMemory::getTotal();
+
+    if (total > budget) {
+        // Least recently bound first
+        std::sort(candidates.begin(), candidates.end(), [](const Candidate& a, const Candidate& b) {
+            return a.texture->lastUsedFrame < b.texture->lastUsedFrame;
+        });
+
+        size_t excess = total - budget, saved = 0;
+        for (const Candidate& candidate : candidates) {
+            if (saved >= excess) break;
+            GpuTexture& texture = *candidate.texture;
+            if (texture.droppedLevels >= MAX_DROPPED_LEVELS || texture.getBytes() <= MIN_REDUCIBLE_BYTES) continue;
+
+            // Each dropped level quarters the size
+            bool cold = frame - texture.lastUsedFrame >= EVICT_AFTER_FRAMES;
+            texture.droppedLevels = cold ? MAX_DROPPED_LEVELS : texture.droppedLevels + 1;
+            saved += cold ? texture.getBytes() : texture.getBytes() - texture.getBytes() / 4;
+            reloadTexture(candidate.handle);
+        }
+
+        // Everything else is fixed-size - say so once instead of silently sitting at 4x4 textures
+        if (saved == 0 && !budgetWarningShown) {
+            budgetWarningShown = true;
+            std::cerr << "GPU memory budget exceeded by " << excess / (1024 * 1024)
+                << " MB with every texture already reduced:" << std::endl;
+            GpuMemory::printReport();
+        }
+        return;
+    }
+
+    // Under budget: bring back levels of textures in use, most recently bound first, while they fit
+    size_t reserve = budget / 100 * RESTORE_HEADROOM_PERCENT;
+    if (budget - total <= reserve) return;
+    size_t headroom = budget - total - reserve;
+
+    std::sort(candidates.begin(), candidates.end(), [](const Candidate& a, const Candidate& b) {
+        return a.texture->lastUsedFrame > b.texture->lastUsedFrame;
+    });
+    for (const Candidate& candidate : candidates) {
+        GpuTexture& texture = *candidate.texture;
+        if (frame - texture.lastUsedFrame >= IN_USE_FRAMES) break;
+        if (texture.droppedLevels == 0) continue;
+
+        size_t growth = texture.fullBytes > texture.getBytes() ? texture.fullBytes - texture.getBytes() : 0;
+        if (growth > headroom) continue;
+        headroom -= growth;
+        texture.droppedLevels = 0;
+        reloadTexture(candidate.handle);
+    }
+}
+
+size_t AssetRegistry::getReducedTextureCount() {
+    size_t count = 0;
+    textures.forEach([&](const GpuTexture& texture) { if (texture.droppedLevels > 0) count++; });
+    return count;
+}
+
+size_t AssetRegistry::collectGarbage() {
+    size_t freed = models.collect() + textures.collect();
+    if (freed > 0) {
+        std::cout << "Asset registry: freed " << freed << " unreferenced assets ("
+            << models.size() << " models, " << textures.size() << " textures loaded)" << std::endl;
+    }
+    return freed;
+}
+
+void AssetRegistry::shutdown() {
+    size_t leaked = models.clear() + textures.clear();
+    if (leaked > 0) {
+        std::cerr << "Asset registry: " << leaked << " assets still referenced at shutdown" << std::endl;
+    }
+}
@@ -0,0 +1,249 @@
+#include "AsyncLoader.hpp"
+#include "AssetArchive.hpp"
+#include "model.hpp"
+#include <chrono>
+#include <iostream>
+
+// Static member definitions - worker threads and the two queues they sit between
+std::vector<std::thread> AsyncLoader::workers;
+std::mutex AsyncLoader::mutex;
+std::condition_variable AsyncLoader::wake;
+std::deque<AsyncLoader::Request> AsyncLoader::requests;
+std::deque<AsyncLoader::Result> AsyncLoader::results;
+size_t AsyncLoader::pending = 0;
+bool AsyncLoader::running = false;
+bool AsyncLoader::stopping = false;
+std::chrono::steady_clock::time_point AsyncLoader::burstStart;
+double AsyncLoader::burstDecodeMs = 0.0;
+size_t AsyncLoader::burstAssets = 0;
+
+void AsyncLoader::start(unsigned int workerCount) {
+    if (running) return;
+
+    if (workerCount == 0) {
+        unsigned int cores = std::thread::hardware_concurrency();
+        workerCount = cores > 1 ? cores - 1 : 1;
+    }
+
+    stopping = false;
+    running = true;
+    TextureStreamer::cancelStaging(false);
+    for (unsigned int i = 0; i < workerCount; i++) {
+        workers.emplace_back(workerLoop);
+    }
+    std::cout << "Asset streaming: " << workerCount << " decode threads" << std::endl;
+}
+
+void AsyncLoader::stop() {
+    if (!running) return;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wake.notify_all();
+    TextureStreamer::cancelStaging();  // Workers may be waiting for ring space
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    workers.clear();
+
+    for (const Result& result : results) {
+        if (result.isStaged) TextureStreamer::discard(result.staged);
+    }
+    requests.clear();
+    results.clear();
+    pending = 0;
+    running = false;
+}
+
+void AsyncLoader::loadTexture(const TextureRef& texture, const std::string& path, bool flip) {
+    Request request;
+    request.path = path;
+    request.texture = texture;
+    request.flip = flip;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (pending == 0) beginBurst();
+        requests.push_back(std::move(request));
+        pending++;
+    }
+    wake.notify_one();
+}
+
+void AsyncLoader::loadOrmTexture(const TextureRef& texture, const OrmSource& source) {
+    Request request;
+    request.path = source.key();
+    request.texture = texture;
+    request.packedOrm = true;
+    request.orm = source;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (pending == 0) beginBurst();
+        requests.push_back(std::move(request));
+        pending++;
+    }
+    wake.notify_one();
+}
+
+void AsyncLoader::reloadTexture(const TextureRef& texture) {
+    // Copy the source here - workers never touch the registry
+    Request request;
+    request.path = texture->path.empty() ? texture->orm.key() : texture->path;
+    request.texture = texture;
+    request.packedOrm = texture->path.empty();
+    request.orm = texture->orm;
+    request.droppedLevels = texture->droppedLevels;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (pending == 0) beginBurst();
+        requests.push_back(std::move(request));
+        pending++;
+    }
+    wake.notify_one();
+}
+
+void AsyncLoader::loadMesh(const ModelRef& model, const std::string& path) {
+    Request request;
+    request.path = path;
+    request.model = model;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (pending == 0) beginBurst();
+        requests.push_back(std::move(request));
+        pending++;
+    }
+    wake.notify_one();
+}
+
+void AsyncLoader::decode(Result& result) {
+    const Request& request = result.request;
+
+    if (request.texture) {
+        result.success = request.packedOrm ? Texture::decodeOrm(request.orm, result.image) :
+            Texture::decode(request.path, request.flip, result.image);
+
+        // Copy the mips into the pixel buffer ring here, so the GL thread only issues the transfer
+        if (result.success && TextureStreamer::stage(result.image, request.droppedLevels, result.staged)) {
+            result.isStaged = true;
+            result.image = DecodedImage();
+        }
+        return;
+    }
+
+    // Packed mesh - point straight into the mapping (or the inflated copy)
+    const ArchiveEntry* entry = AssetArchive::find(request.path);
+    if (entry && entry->type == static_cast<uint32_t>(ArchiveEntryType::Mesh)) {
+        const uint8_t* blob = AssetArchive::data(*entry, result.scratch);
+        if (blob) {
+            result.vertices = reinterpret_cast<const float*>(blob);
+            result.vertexCount = entry->width;
+            result.success = true;
+            return;
+        }
+    }
+
+    // Loose OBJ file
+    if (MeshData::loadObj(request.path, result.mesh)) {
+        result.vertices = result.mesh.vertices.data();
+        result.vertexCount = result.mesh.vertexCount();
+        result.success = true;
+    }
+}
+
+void AsyncLoader::beginBurst() {
+    burstStart = std::chrono::steady_clock::now();
+    burstDecodeMs = 0.0;
+    burstAssets = 0;
+}
+
+void AsyncLoader::workerLoop() {
+    while (true) {
+        Request request;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            wake.wait(lock, [] { return stopping || !requests.empty(); });
+            if (stopping) return;
+            request = std::move(requests.front());
+            requests.pop_front();
+        }
+
+        auto decodeStart = std::chrono::steady_clock::now();
+        Result result;
+        result.request = std::move(request);
+        decode(result);
+        result.decodeMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - decodeStart).count();
+
+        std::lock_guard<std::mutex> lock(mutex);
+        results.push_back(std::move(result));
+    }
+}
+
+size_t AsyncLoader::processUploads(double budgetMs, size_t budgetBytes) {
+    auto start = std::chrono::steady_clock::now();
+    size_t uploaded = 0;
+    size_t uploadedBytes = 0;
+    TextureStreamer::retire();
+
+    while (true) {
+        Result result;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (results.empty()) break;
+            result = std::move(results.front());
+            results.pop_front();
+        }
+
+        const Request& request = result.request;
+        if (request.texture) {
+            // Failed decodes keep their placeholder (or previous levels)
+            if (result.isStaged) {
+                request.texture->setBytes(TextureStreamer::upload(request.texture->id, result.staged));
+                uploadedBytes += request.texture->getBytes();
+            }
+            else if (result.success) {
+                request.texture->setBytes(Texture::upload(request.texture->id, result.image, request.droppedLevels));
+                uploadedBytes += request.texture->getBytes();
+            }
+            request.texture->reloading = false;
+        }
+        else if (request.model) {
+            if (result.success) {
+                request.model->upload(result.vertices, result.vertexCount);
+            }
+            else {
+                request.model->upload(nullptr, 0);  // Hide the placeholder, same as a failed synchronous load
+            }
+        }
+        uploaded++;
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            pending--;
+            burstDecodeMs += result.decodeMs;
+            burstAssets++;
+
+            // Decode time summed over workers vs. wall time shows how well loading scales with cores
+            if (pending == 0) {
+                double wallMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - burstStart).count();
+                std::cout << "Streamed " << burstAssets << " assets in " << wallMs << " ms ("
+                    << burstDecodeMs << " ms of decoding on " << workers.size() << " threads)" << std::endl;
+            }
+        }
+
+        // Big textures can take a few ms each (and a lot of transfer bandwidth) - stop once this frame's share is spent
+        double elapsedMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        if (elapsedMs >= budgetMs || uploadedBytes >= budgetBytes) break;
+    }
+
+    return uploaded;
+}
+
+bool AsyncLoader::isIdle() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return pending == 0;
+}
+
+size_t AsyncLoader::getPendingCount() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return pending;
+}
@@ -0,0 +1,374 @@
+#include "BlockCompression.hpp"
+#include "MipChain.hpp"
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+
+namespace {
+    // Principal axis of a point cloud (power iteration on the covariance matrix)
+    template <int N>
+    void principalAxis(const float points[16][4], float mean[N], float axis[N]) {
+        for (int c = 0; c < N; c++) {
+            mean[c] = 0.0f;
+            for (int i = 0; i < 16; i++) mean[c] += points[i][c];
+            mean[c] /= 16.0f;
+        }
+
+        float cov[N][N] = {};
+        for (int i = 0; i < 16; i++) {
+            for (int a = 0; a < N; a++) {
+                for (int b = 0; b < N; b++) {
+                    cov[a][b] += (points[i][a] - mean[a]) * (points[i][b] - mean[b]);
+                }
+            }
+        }
+
+        for (int c = 0; c < N; c++) axis[c] = 1.0f;
+        for (int iteration = 0; iteration < 8; iteration++) {
+            float next[N] = {};
+            for (int a = 0; a < N; a++) {
+                for (int b = 0; b < N; b++) next[a] += cov[a][b] * axis[b];
+            }
+            float length = 0.0f;
+            for (int c = 0; c < N; c++) length += next[c] * next[c];
+            if (length < 1e-12f) break;  // Flat block - any axis works
+            length = std::sqrt(length);
+            for (int c = 0; c < N; c++) axis[c] = next[c] / length;
+        }
+    }
+
+    // Endpoints = extreme projections of the block onto its principal axis
+    template <int N>
+    void fitEndpoints(const uint8_t* rgba, float low[N], float high[N]) {
+        float points[16][4];
+        for (int i = 0; i < 16; i++) {
+            for (int c = 0; c < 4; c++) points[i][c] = rgba[i * 4 + c];
+        }
+
+        float mean[N], axis[N];
+        principalAxis<N>(points, mean, axis);
+
+        float minT = 0.0f, maxT = 0.0f;
+        for (int i = 0; i < 16; i++) {
+            float t = 0.0f;
+            for (int c = 0; c < N; c++) t += (points[i][c] - mean[c]) * axis[c];
+            minT = std::min(minT, t);
+            maxT = std::max(maxT, t);
+        }
+
+        for (int c = 0; c < N; c++) {
+            low[c] = std::min(255.0f, std::max(0.0f, mean[c] + axis[c] * minT));
+            high[c] = std::min(255.0f, std::max(0.0f, mean[c] + axis[c] * maxT));
+        }
+    }
+
+    uint16_t pack565(const float color[3]) {
+        int r = static_cast<int>(color[0] * 31.0f / 255.0f + 0.5f);
+        int g = static_cast<int>(color[1] * 63.0f / 255.0f + 0.5f);
+        int b = static_cast<int>(color[2] * 31.0f / 255.0f + 0.5f);
+        return static_cast<uint16_t>((r << 11) | (g << 5) | b);
+    }
+
+    void unpack565(uint16_t packed, int color[3]) {
+        int r = (packed >> 11) & 31, g = (packed >> 5) & 63, b = packed & 31;
+        color[0] = (r << 3) | (r >> 2);
+        color[1] = (g << 2) | (g >> 4);
+        color[2] = (b << 3) | (b >> 2);
+    }
+
+    // Little-endian bit stream for BC7 blocks
+    struct BitWriter {
+        uint8_t* out;
+        int position = 0;
+
+        void write(uint32_t value, int bits) {
+            for (int i = 0; i < bits; i++, position++) {
+                if ((value >> i) & 1) out[position >> 3] |= static_cast<uint8_t>(1 << (position & 7));
+            }
+        }
+    };
+
+    const int BC7_WEIGHTS4[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+    void compressLevel(const uint8_t* rgba, uint32_t width, uint32_t height, BlockFormat format, uint8_t* out) {
+        size_t blockSize = BlockCompression::blockBytes(format);
+        uint8_t block[64];
+
+        for (uint32_t by = 0; by < (height + 3) / 4; by++) {
+            for (uint32_t bx = 0; bx < (width + 3) / 4; bx++) {
+                // Gather the 4x4 block, repeating edge pixels for partial blocks
+                for (uint32_t py = 0; py < 4; py++) {
+                    uint32_t y = std::min(by * 4 + py, height - 1);
+                    for (uint32_t px = 0; px < 4; px++) {
+                        uint32_t x = std::min(bx * 4 + px, width - 1);
+                        std::memcpy(block + (py * 4 + px) * 4, rgba + (size_t(y) * width + x) * 4, 4);
+                    }
+                }
+
+                switch (format) {
+                case BlockFormat::BC1: BlockCompression::encodeBC1(block, out); break;
+                case BlockFormat::BC3: BlockCompression::encodeBC3(block, out); break;
+                case BlockFormat::BC4: BlockCompression::encodeBC4(block, 0, out); break;
+                case BlockFormat::BC5: BlockCompression::encodeBC5(block, out); break;
+                case BlockFormat::BC7: BlockCompression::encodeBC7(block, out); break;
+                default: break;
+                }
+                out += blockSize;
+            }
+        }
+    }
+}
+
+bool BlockCompression::isCompressed(BlockFormat format) {
+    return format != BlockFormat::None && format != BlockFormat::RGBA8 && format != BlockFormat::R8;
+}
+
+size_t BlockCompression::blockBytes(BlockFormat format) {
+    return (format == BlockFormat::BC1 || format == BlockFormat::BC4) ? 8 : 16;
+}
+
+size_t BlockCompression::levelBytes(BlockFormat format, uint32_t width, uint32_t height) {
+    if (format == BlockFormat::RGBA8) return size_t(width) * height * 4;
+    if (format == BlockFormat::R8) return size_t(width) * height;
+    return size_t((width + 3) / 4) * ((height + 3) / 4) * blockBytes(format);
+}
+
+TextureUsage BlockCompression::usageFromPath(const std::string& path) {
+    std::string name = path.substr(path.find_last_of("/\\") + 1);
+    std::transform(name.begin(), name.end(), name.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+
+    const char* normalTags[] = { "normal", "_nor", "_nrm" };
+    for (const char* tag : normalTags) {
+        if (name.find(tag) != std::string::npos) return TextureUsage::Normal;
+    }
+
+    const char* singleTags[] = { "rough", "metal", "_ao", "_disp", "_h.", "_r.", "_m." };
+    for (const char* tag : singleTags) {
+        if (name.find(tag) != std::string::npos) return TextureUsage::SingleChannel;
+    }
+    return TextureUsage::Albedo;
+}
+
+BlockFormat BlockCompression::chooseFormat(TextureUsage usage, bool hasAlpha, bool allowBC7) {
+    switch (usage) {
+    case TextureUsage::SingleChannel: return BlockFormat::BC4;
+    case TextureUsage::Normal: return BlockFormat::BC5;
+    default:
+        if (!hasAlpha) return BlockFormat::BC1;
+        return allowBC7 ? BlockFormat::BC7 : BlockFormat::BC3;
+    }
+}
+
+bool BlockCompression::hasAlpha(const uint8_t* pixels, uint32_t width, uint32_t height, uint32_t channels) {
+    if (channels != 4) return false;
+    size_t count = size_t(width) * height;
+    for (size_t i = 0; i < count; i++) {
+        if (pixels[i * 4 + 3] != 255) return true;
+    }
+    return false;
+}
+
+void BlockCompression::encodeMipChain(const uint8_t* pixels, uint32_t width, uint32_t height, uint32_t channels,
+    BlockFormat format, bool gammaCorrect, std::vector<ImageLevel>& levels, std::vector<uint8_t>& out) {
+
+    // Filter once in RGBA, then encode every level from that chain
+    std::vector<uint8_t> rgba, chain;
+    std::vector<ImageLevel> chainLevels;
+    MipChain::expandToRGBA(pixels, width, height, channels, rgba);
+    MipChain::build(rgba.data(), width, height, gammaCorrect, chainLevels, chain);
+    rgba.clear();
+    rgba.shrink_to_fit();
+
+    if (format == BlockFormat::RGBA8 && out.empty()) {
+        levels.insert(levels.end(), chainLevels.begin(), chainLevels.end());
+        out.swap(chain);
+        return;
+    }
+
+    for (const ImageLevel& source : chainLevels) {
+        ImageLevel level = source;
+        level.offset = out.size();
+        level.size = levelBytes(format, level.width, level.height);
+        levels.push_back(level);
+        out.resize(out.size() + level.size, 0);
+
+        const uint8_t* src = chain.data() + source.offset;
+        uint8_t* dst = out.data() + level.offset;
+        if (format == BlockFormat::RGBA8) {
+            std::memcpy(dst, src, level.size);
+        }
+        else if (format == BlockFormat::R8) {
+            for (size_t i = 0; i < level.size; i++) dst[i] = src[i * 4];
+        }
+        else {
+            compressLevel(src, level.width, level.height, format, dst);
+        }
+    }
+}
+
+void BlockCompression::encodeBC1(const uint8_t* rgba, uint8_t* out) {
+    float low[3], high[3];
+    fitEndpoints<3>(rgba, low, high);
+
+    uint16_t color0 = pack565(high), color1 = pack565(low);
+    uint32_t indices = 0;
+
+    if (color0 != color1) {
+        // color0 > color1 selects the 4-colour (no transparency) mode
+        if (color0 < color1) std::swap(color0, color1);
+
+        int palette[4][3];
+        unpack565(color0, palette[0]);
+        unpack565(color1, palette[1]);
+        for (int c = 0; c < 3; c++) {
+            palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+            palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+        }
+
+        for (int i = 0; i < 16; i++) {
+            int best = 0, bestError = 1 << 30;
+            for (int p = 0; p < 4; p++) {
+                int error = 0;
+                for (int c = 0; c < 3; c++) {
+                    int d = rgba[i * 4 + c] - palette[p][c];
+                    error += d * d;
+                }
+                if (error < bestError) {
+                    bestError = error;
+                    best = p;
+                }
+            }
+            indices |= static_cast<uint32_t>(best) << (i * 2);
+        }
+    }
+
+    out[0] = static_cast<uint8_t>(color0 & 0xFF);
+    out[1] = static_cast<uint8_t>(color0 >> 8);
+    out[2] = static_cast<uint8_t>(color1 & 0xFF);
+    out[3] = static_cast<uint8_t>(color1 >> 8);
+    std::memcpy(out + 4, &indices, 4);
+}
+
+void BlockCompression::encodeBC4(const uint8_t* rgba, int channel, uint8_t* out) {
+    int minValue = 255, maxValue = 0;
+    for (int i = 0; i < 16; i++) {
+        minValue = std::min(minValue, static_cast<int>(rgba[i * 4 + channel]));
+        maxValue = std::max(maxValue, static_cast<int>(rgba[i * 4 + channel]));
+    }
+
+    out[0] = static_cast<uint8_t>(maxValue);
+    out[1] = static_cast<uint8_t>(minValue);
+    uint64_t indices = 0;
+
+    if (maxValue != minValue) {
+        // red0 > red1: eight-value mode (index 0 = red0, 1 = red1, 2-7 interpolated)
+        int palette[8] = { maxValue, minValue };
+        for (int p = 2; p < 8; p++) {
+            palette[p] = ((8 - p) * maxValue + (p - 1) * minValue) / 7;
+        }
+
+        for (int i = 0; i < 16; i++) {
+            int value = rgba[i * 4 + channel];
+            int best = 0, bestError = 1 << 30;
+            for (int p = 0; p < 8; p++) {
+                int error = std::abs(value - palette[p]);
+                if (error < bestError) {
+                    bestError = error;
+                    best = p;
+                }
+            }
+            indices |= static_cast<uint64_t>(best) << (i * 3);
+        }
+    }
+
+    for (int b = 0; b < 6; b++) {
+        out[2 + b] = static_cast<uint8_t>(indices >> (b * 8));
+    }
+}
+
+void BlockCompression::encodeBC3(const uint8_t* rgba, uint8_t* out) {
+    encodeBC4(rgba, 3, out);  // Alpha block has the same layout as BC4
+    encodeBC1(rgba, out + 8);
+}
+
+void BlockCompression::encodeBC5(const uint8_t* rgba, uint8_t* out) {
+    encodeBC4(rgba, 0, out);
+    encodeBC4(rgba, 1, out + 8);
+}
+
+void BlockCompression::encodeBC7(const uint8_t* rgba, uint8_t* out) {
+    // Mode 6: one subset, RGBA 7-bit endpoints + one p-bit each, 4-bit indices
+    float low[4], high[4];
+    fitEndpoints<4>(rgba, low, high);
+
+    int bestQuantized[2][4] = {}, bestPBits[2] = {}, bestIndices[16] = {};
+    int bestError = -1;
+
+    // Try every p-bit combination and keep the one with the lowest error
+    for (int pbits = 0; pbits < 4; pbits++) {
+        int p[2] = { pbits & 1, pbits >> 1 };
+        int quantized[2][4], endpoints[2][4];
+        const float* source[2] = { low, high };
+        for (int e = 0; e < 2; e++) {
+            for (int c = 0; c < 4; c++) {
+                int q = static_cast<int>((source[e][c] - p[e]) / 2.0f + 0.5f);
+                quantized[e][c] = std::min(127, std::max(0, q));
+                endpoints[e][c] = (quantized[e][c] << 1) | p[e];
+            }
+        }
+
+        int palette[16][4];
+        for (int w = 0; w < 16; w++) {
+            for (int c = 0; c < 4; c++) {
+                palette[w][c] = ((64 - BC7_WEIGHTS4[w]) * endpoints[0][c] + BC7_WEIGHTS4[w] * endpoints[1][c] + 32) >> 6;
+            }
+        }
+
+        int indices[16], totalError = 0;
+        for (int i = 0; i < 16; i++) {
+            int best = 0, bestPixelError = 1 << 30;
+            for (int w = 0; w < 16; w++) {
+                int error = 0;
+                for (int c = 0; c < 4; c++) {
+                    int d = rgba[i * 4 + c] - palette[w][c];
+                    error += d * d;
+                }
+                if (error < bestPixelError) {
+                    bestPixelError = error;
+                    best = w;
+                }
+            }
+            indices[i] = best;
+            totalError += bestPixelError;
+        }
+
+        if (bestError < 0 || totalError < bestError) {
+            bestError = totalError;
+            std::memcpy(bestQuantized, quantized, sizeof(quantized));
+            std::memcpy(bestPBits, p, sizeof(p));
+            std::memcpy(bestIndices, indices, sizeof(indices));
+        }
+    }
+
+    // The anchor (pixel 0) index is stored with its top bit implied 0 - swap endpoints if needed
+    if (bestIndices[0] & 8) {
+        for (int c = 0; c < 4; c++) std::swap(bestQuantized[0][c], bestQuantized[1][c]);
+        std::swap(bestPBits[0], bestPBits[1]);
+        for (int i = 0; i < 16; i++) bestIndices[i] = 15 - bestIndices[i];
+    }
+
+    std::memset(out, 0, 16);
+    BitWriter writer{ out };
+    writer.write(1 << 6, 7);  // Mode 6
+    for (int c = 0; c < 4; c++) {
+        writer.write(bestQuantized[0][c], 7);
+        writer.write(bestQuantized[1][c], 7);
+    }
+    writer.write(bestPBits[0], 1);
+    writer.write(bestPBits[1], 1);
+    for (int i = 0; i < 16; i++) {
+        writer.write(bestIndices[i], i == 0 ? 3 : 4);
+    }
+}
@@ -0,0 +1,237 @@
+#include "ClusteredLighting.hpp"
+#include "LightingManager.hpp"
+#include "GpuMemory.hpp"
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+// Static member definitions - light, grid and index buffers and the CPU-side lists
+GLuint ClusteredLighting::lightBuffer = 0;
+GLuint ClusteredLighting::lightTexture = 0;
+GLuint ClusteredLighting::gridBuffer = 0;
+GLuint ClusteredLighting::gridTexture = 0;
+GLuint ClusteredLighting::indexBuffer = 0;
+GLuint ClusteredLighting::indexTexture = 0;
+size_t ClusteredLighting::indexCapacity = 0;
+uint64_t ClusteredLighting::uploadedVersion = 0;
+std::vector<ClusteredLighting::LightBounds> ClusteredLighting::lights;
+std::vector<glm::vec4> ClusteredLighting::lightData;
+std::vector<ClusteredLighting::LightBox> ClusteredLighting::boxes;
+std::vector<uint32_t> ClusteredLighting::grid;
+std::vector<uint16_t> ClusteredLighting::indices;
+size_t ClusteredLighting::lastIndexCount = 0;
+uint32_t ClusteredLighting::lastMaxPerCluster = 0;
+
+namespace {
+    const GLint LIGHTS_UNIT = 7;   // After the virtual texture units (4-6)
+    const GLint GRID_UNIT = 8;
+    const GLint INDEX_UNIT = 9;
+
+    const size_t LIGHT_BYTES = 3 * 4 * sizeof(float);
+    const size_t GRID_BYTES = ClusteredLighting::CLUSTER_COUNT * 2 * sizeof(uint32_t);
+
+    GLuint createBufferTexture(GLuint buffer, GLenum format) {
+        GLuint texture = 0;
+        glGenTextures(1, &texture);
+        glBindTexture(GL_TEXTURE_BUFFER, texture);
+        glTexBuffer(GL_TEXTURE_BUFFER, format, buffer);
+        glBindTexture(GL_TEXTURE_BUFFER, 0);
+        return texture;
+    }
+
+    // Screen tile range covered by [minNdc, maxNdc], false if it's entirely off screen
+    bool tileRange(float minNdc, float maxNdc, int tiles, uint8_t& first, uint8_t& last) {
+        if (maxNdc < -1.0f || minNdc > 1.0f) return false;
+        int a = static_cast<int>(std::floor((minNdc * 0.5f + 0.5f) * tiles));
+        int b = static_cast<int>(std::floor((maxNdc * 0.5f + 0.5f) * tiles));
+        first = static_cast<uint8_t>(std::max(0, std::min(a, tiles - 1)));
+        last = static_cast<uint8_t>(std::max(0, std::min(b, tiles - 1)));
+        return true;
+    }
+}
+
+bool ClusteredLighting::initialize() {
+    if (gridBuffer) return true;
+
+    glGenBuffers(1, &lightBuffer);
+    glBindBuffer(GL_TEXTURE_BUFFER, lightBuffer);
+    glBufferData(GL_TEXTURE_BUFFER, MAX_LIGHTS * LIGHT_BYTES, nullptr, GL_DYNAMIC_DRAW);
+    glGenBuffers(1, &gridBuffer);
+    glBindBuffer(GL_TEXTURE_BUFFER, gridBuffer);
+    glBufferData(GL_TEXTURE_BUFFER, GRID_BYTES, nullptr, GL_STREAM_DRAW);
+    glBindBuffer(GL_TEXTURE_BUFFER, 0);
+    GpuMemory::allocate(GpuMemoryCategory::Buffers, MAX_LIGHTS * LIGHT_BYTES + GRID_BYTES);
+
+    lightTexture = createBufferTexture(lightBuffer, GL_RGBA32F);
+    gridTexture = createBufferTexture(gridBuffer, GL_RG32UI);
+    growIndexBuffer(16 * 1024);
+
+    grid.resize(CLUSTER_COUNT * 2);
+    std::cout << "Clustered lighting: " << TILES_X << "x" << TILES_Y << "x" << SLICES << " clusters, up to "
+        << MAX_LIGHTS << " lights" << std::endl;
+    return true;
+}
+
+void ClusteredLighting::shutdown() {
+    if (!gridBuffer) return;
+    GLuint textures[] = { lightTexture, gridTexture, indexTexture };
+    GLuint buffers[] = { lightBuffer, gridBuffer, indexBuffer };
+    glDeleteTextures(3, textures);
+    glDeleteBuffers(3, buffers);
+    GpuMemory::release(GpuMemoryCategory::Buffers, MAX_LIGHTS * LIGHT_BYTES + GRID_BYTES + indexCapacity * sizeof(uint16_t));
+    lightBuffer = lightTexture = gridBuffer = gridTexture = indexBuffer = indexTexture = 0;
+    indexCapacity = 0;
+    uploadedVersion = 0;
+}
+
+void ClusteredLighting::growIndexBuffer(size_t count) {
+    if (count <= indexCapacity) return;
+    size_t capacity = std::max(count, indexCapacity * 2);
+    if (!indexBuffer) glGenBuffers(1, &indexBuffer);
+    glBindBuffer(GL_TEXTURE_BUFFER, indexBuffer);
+    glBufferData(GL_TEXTURE_BUFFER, capacity * sizeof(uint16_t), nullptr, GL_STREAM_DRAW);
+    glBindBuffer(GL_TEXTURE_BUFFER, 0);
+    if (!indexTexture) indexTexture = createBufferTexture(indexBuffer, GL_R16UI);
+
+    GpuMemory::release(GpuMemoryCategory::Buffers, indexCapacity * sizeof(uint16_t));
+    GpuMemory::allocate(GpuMemoryCategory::Buffers, capacity * sizeof(uint16_t));
+    indexCapacity = capacity;
+}
+
+void ClusteredLighting::setupSamplers(const Shader& shader) {
+    if (!gridBuffer) return;
+    shader.use();
+    shader.setInt("clusterLights"_uniform, LIGHTS_UNIT);
+    shader.setInt("clusterGrid"_uniform, GRID_UNIT);
+    shader.setInt("clusterLightIndices"_uniform, INDEX_UNIT);
+}
+
+void ClusteredLighting::updateLights(const LightingManager& lighting) {
+    if (!gridBuffer || uploadedVersion == lighting.getVersion()) return;
+    uploadedVersion = lighting.getVersion();
+
+    size_t count = std::min(lighting.pointLights.size(), static_cast<size_t>(MAX_LIGHTS));
+    lights.resize(count);
+    lightData.resize(count * 3);
+    const std::vector<int>& shadowSlots = lighting.getShadowSlots();
+    for (size_t i = 0; i < count; i++) {
+        const PointLight& light = lighting.pointLights[i];
+        lights[i].position = light.position;
+        lights[i].range = light.getRange();
+        lightData[i * 3 + 0] = glm::vec4(light.position, lights[i].range);
+        lightData[i * 3 + 1] = glm::vec4(light.color, light.intensity);
+        lightData[i * 3 + 2] = glm::vec4(light.constant, light.linear, light.quadratic, static_cast<float>(shadowSlots[i]));
+    }
+
+    if (count > 0) {
+        glBindBuffer(GL_TEXTURE_BUFFER, lightBuffer);
+        glBufferSubData(GL_TEXTURE_BUFFER, 0, count * LIGHT_BYTES, lightData.data());
+        glBindBuffer(GL_TEXTURE_BUFFER, 0);
+    }
+}
+
+void ClusteredLighting::buildView(const glm::mat4& view, const glm::mat4& projection) {
+    if (!gridBuffer) return;
+
+    // Clip planes of the (glm::perspective) projection, same as standard.frag derives them
+    float nearPlane = projection[3][2] / (projection[2][2] - 1.0f);
+    float farPlane = projection[3][2] / (projection[2][2] + 1.0f);
+    float sliceScale = static_cast<float>(SLICES) / std::log(farPlane / nearPlane);
+    auto sliceOf = [&](float depth) {
+        int slice = static_cast<int>(std::log(depth / nearPlane) * sliceScale);
+        return static_cast<uint8_t>(std::max(0, std::min(slice, SLICES - 1)));
+    };
+
+    // Cluster box of every light's range sphere. Tile bounds are the extremes of x/depth over the
+    // sphere's view-space box - conservative, but exact enough at the 16x9 tile size.
+    boxes.clear();
+    std::fill(grid.begin(), grid.end(), 0u);
+    for (size_t i = 0; i < lights.size(); i++) {
+        float range = lights[i].range;
+        if (range <= 0.0f) continue;
+        glm::vec3 center = glm::vec3(view * glm::vec4(lights[i].position, 1.0f));
+        float depth = -center.z;
+        if (depth + range < nearPlane || depth - range > farPlane) continue;
+
+        LightBox box;
+        box.light = static_cast<uint16_t>(i);
+        float minDepth = std::max(depth - range, nearPlane);
+        float maxDepth = std::min(depth + range, farPlane);
+        box.s0 = sliceOf(minDepth);
+        box.s1 = sliceOf(maxDepth);
+
+        if (depth - range <= nearPlane) {
+            // Sphere reaches the camera plane - it can cover any tile
+            box.x0 = box.y0 = 0;
+            box.x1 = TILES_X - 1;
+            box.y1 = TILES_Y - 1;
+        }
+        else {
+            float xs[4] = { (center.x - range) / minDepth, (center.x - range) / maxDepth,
+                (center.x + range) / minDepth, (center.x + range) / maxDepth };
+            float ys[4] = { (center.y - range) / minDepth, (center.y - range) / maxDepth,
+                (center.y + range) / minDepth, (center.y + range) / maxDepth };
+            float minX = *std::min_element(xs, xs + 4) * projection[0][0];
+            float maxX = *std::max_element(xs, xs + 4) * projection[0][0];
+            float minY = *std::min_element(ys, ys + 4) * projection[1][1];
+            float maxY = *std::max_element(ys, ys + 4) * projection[1][1];
+            if (!tileRange(minX, maxX, TILES_X, box.x0, box.x1)) continue;
+            if (!tileRange(minY, maxY, TILES_Y, box.y0, box.y1)) continue;
+        }
+        boxes.push_back(box);
+
+        for (int s = box.s0; s <= box.s1; s++) {
+            for (int y = box.y0; y <= box.y1; y++) {
+                for (int x = box.x0; x <= box.x1; x++) grid[((s * TILES_Y + y) * TILES_X + x) * 2 + 1]++;
+            }
+        }
+    }
+
+    // Offsets from the counts, then fill the lists (counts are rebuilt as write cursors)
+    uint32_t total = 0;
+    lastMaxPerCluster = 0;
+    for (int c = 0; c < CLUSTER_COUNT; c++) {
+        uint32_t count = grid[c * 2 + 1];
+        grid[c * 2] = total;
+        grid[c * 2 + 1] = 0;
+        total += count;
+        lastMaxPerCluster = std::max(lastMaxPerCluster, count);
+    }
+    indices.resize(total);
+    for (const LightBox& box : boxes) {
+        for (int s = box.s0; s <= box.s1; s++) {
+            for (int y = box.y0; y <= box.y1; y++) {
+                for (int x = box.x0; x <= box.x1; x++) {
+                    uint32_t* cluster = &grid[((s * TILES_Y + y) * TILES_X + x) * 2];
+                    indices[cluster[0] + cluster[1]++] = box.light;
+                }
+            }
+        }
+    }
+    lastIndexCount = total;
+
+    // Orphan and refill - earlier views of this frame may still be reading the old contents
+    growIndexBuffer(total);
+    glBindBuffer(GL_TEXTURE_BUFFER, gridBuffer);
+    glBufferData(GL_TEXTURE_BUFFER, GRID_BYTES, grid.data(), GL_STREAM_DRAW);
+    if (total > 0) {
+        glBindBuffer(GL_TEXTURE_BUFFER, indexBuffer);
+        glBufferData(GL_TEXTURE_BUFFER, indexCapacity * sizeof(uint16_t), nullptr, GL_STREAM_DRAW);
+        glBufferSubData(GL_TEXTURE_BUFFER, 0, total * sizeof(uint16_t), indices.data());
+    }
+    glBindBuffer(GL_TEXTURE_BUFFER, 0);
+
+    glActiveTexture(GL_TEXTURE0 + LIGHTS_UNIT);
+    glBindTexture(GL_TEXTURE_BUFFER, lightTexture);
+    glActiveTexture(GL_TEXTURE0 + GRID_UNIT);
+    glBindTexture(GL_TEXTURE_BUFFER, gridTexture);
+    glActiveTexture(GL_TEXTURE0 + INDEX_UNIT);
+    glBindTexture(GL_TEXTURE_BUFFER, indexTexture);
+    glActiveTexture(GL_TEXTURE0);
+}
+
+void ClusteredLighting::printStats() {
+    if (!gridBuffer) return;
+    std::cout << "Clustered lights: " << lights.size() << ", last view " << lastIndexCount
+        << " assignments, at most " << lastMaxPerCluster << " per cluster" << std::endl;
+}
@@ -0,0 +1,142 @@
+#include "Compression.hpp"
+#include <cstring>
+
+// Stream format (same idea as an LZ4 block):
+//   token: high nibble = literal count, low nibble = match length - MIN_MATCH
+//   [extra literal count bytes] literals [2-byte offset] [extra match length bytes]
+// A nibble of 15 means "add the following bytes until one is < 255".
+// The last sequence only carries literals.
+namespace {
+    const size_t MIN_MATCH = 4;
+    const size_t HASH_BITS = 16;
+    const size_t MAX_OFFSET = 65535;
+    const size_t LAST_LITERALS = 5;  // Trailing bytes always emitted as literals
+
+    uint32_t read32(const uint8_t* p) {
+        uint32_t value;
+        std::memcpy(&value, p, sizeof(value));
+        return value;
+    }
+
+    uint32_t hash4(uint32_t sequence) {
+        return (sequence * 2654435761u) >> (32 - HASH_BITS);
+    }
+
+    void writeLength(std::vector<uint8_t>& out, size_t length) {
+        while (length >= 255) {
+            out.push_back(255);
+            length -= 255;
+        }
+        out.push_back(static_cast<uint8_t>(length));
+    }
+
+    void emitSequence(std::vector<uint8_t>& out, const uint8_t* literals, size_t literalCount,
+        size_t offset, size_t matchLength) {
+        size_t matchCode = matchLength ? matchLength - MIN_MATCH : 0;
+        uint8_t token = static_cast<uint8_t>((literalCount < 15 ? literalCount : 15) << 4);
+        if (matchLength) token |= static_cast<uint8_t>(matchCode < 15 ? matchCode : 15);
+        out.push_back(token);
+
+        if (literalCount >= 15) writeLength(out, literalCount - 15);
+        out.insert(out.end(), literals, literals + literalCount);
+
+        if (matchLength) {
+            out.push_back(static_cast<uint8_t>(offset & 0xFF));
+            out.push_back(static_cast<uint8_t>(offset >> 8));
+            if (matchCode >= 15) writeLength(out, matchCode - 15);
+        }
+    }
+}
+
+size_t Compression::compress(const uint8_t* src, size_t size, std::vector<uint8_t>& out) {
+    out.clear();
+    out.reserve(size / 2 + 16);
+
+    std::vector<uint32_t> table(size_t(1) << HASH_BITS, 0);  // Last position + 1 of each 4-byte hash
+    size_t anchor = 0;  // Start of pending literals
+    size_t pos = 0;
+
+    if (size > MIN_MATCH + LAST_LITERALS) {
+        size_t matchLimit = size - LAST_LITERALS;
+
+        while (pos + MIN_MATCH <= matchLimit) {
+            uint32_t sequence = read32(src + pos);
+            uint32_t& slot = table[hash4(sequence)];
+            size_t candidate = slot;
+            slot = static_cast<uint32_t>(pos + 1);
+
+            if (candidate == 0 || pos - (candidate - 1) > MAX_OFFSET || read32(src + candidate - 1) != sequence) {
+                pos++;
+                continue;
+            }
+            candidate--;
+
+            // Extend the match forward
+            size_t length = MIN_MATCH;
+            while (pos + length < matchLimit && src[candidate + length] == src[pos + length]) {
+                length++;
+            }
+
+            emitSequence(out, src + anchor, pos - anchor, pos - candidate, length);
+            pos += length;
+            anchor = pos;
+        }
+    }
+
+    // Remaining bytes as a literal-only sequence
+    emitSequence(out, src + anchor, size - anchor, 0, 0);
+    return out.size();
+}
+
+bool Compression::decompress(const uint8_t* src, size_t size, uint8_t* dst, size_t rawSize) {
+    const uint8_t* in = src;
+    const uint8_t* inEnd = src + size;
+    size_t outPos = 0;
+
+    while (in < inEnd) {
+        uint8_t token = *in++;
+
+        // Literals
+        size_t literalCount = token >> 4;
+        if (literalCount == 15) {
+            uint8_t extra;
+            do {
+                if (in >= inEnd) return false;
+                extra = *in++;
+                literalCount += extra;
+            } while (extra == 255);
+        }
+        if (literalCount > static_cast<size_t>(inEnd - in) || literalCount > rawSize - outPos) return false;
+        std::memcpy(dst + outPos, in, literalCount);
+        in += literalCount;
+        outPos += literalCount;
+
+        if (in >= inEnd) break;  // Final literal-only sequence
+
+        // Match
+        if (inEnd - in < 2) return false;
+        size_t offset = in[0] | (static_cast<size_t>(in[1]) << 8);
+        in += 2;
+        size_t length = (token & 0x0F);
+        if (length == 15) {
+            uint8_t extra;
+            do {
+                if (in >= inEnd) return false;
+                extra = *in++;
+                length += extra;
+            } while (extra == 255);
+        }
+        length += MIN_MATCH;
+
+        if (offset == 0 || offset > outPos || length > rawSize - outPos) return false;
+
+        // Byte copy - matches may overlap their own output
+        const uint8_t* match = dst + outPos - offset;
+        for (size_t i = 0; i < length; i++) {
+            dst[outPos + i] = match[i];
+        }
+        outPos += length;
+    }
+
+    return outPos == rawSize;
+}
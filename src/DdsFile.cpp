@@ -0,0 +1,155 @@
+#include "DdsFile.hpp"
+#include <algorithm>
+#include <cstring>
+
+namespace {
+    struct DdsPixelFormat {
+        uint32_t size, flags, fourCC, rgbBitCount, rMask, gMask, bMask, aMask;
+    };
+
+    struct DdsHeader {
+        uint32_t size, flags, height, width, pitchOrLinearSize, depth, mipMapCount;
+        uint32_t reserved1[11];
+        DdsPixelFormat pixelFormat;
+        uint32_t caps, caps2, caps3, caps4, reserved2;
+    };
+
+    struct DdsHeaderDX10 {
+        uint32_t dxgiFormat, resourceDimension, miscFlag, arraySize, miscFlags2;
+    };
+
+    static_assert(sizeof(DdsHeader) == 124, "DDS header must be 124 bytes");
+
+    const uint32_t DDS_MAGIC = 0x20534444;  // "DDS "
+    const uint32_t DDSD_CAPS = 0x1, DDSD_HEIGHT = 0x2, DDSD_WIDTH = 0x4, DDSD_PITCH = 0x8, DDSD_PIXELFORMAT = 0x1000;
+    const uint32_t DDSD_MIPMAPCOUNT = 0x20000, DDSD_LINEARSIZE = 0x80000;
+    const uint32_t DDPF_FOURCC = 0x4;
+    const uint32_t DDSCAPS_COMPLEX = 0x8, DDSCAPS_TEXTURE = 0x1000, DDSCAPS_MIPMAP = 0x400000;
+    const uint32_t DIMENSION_TEXTURE2D = 3;
+
+    uint32_t fourCC(const char* code) {
+        return uint32_t(uint8_t(code[0])) | (uint32_t(uint8_t(code[1])) << 8) |
+            (uint32_t(uint8_t(code[2])) << 16) | (uint32_t(uint8_t(code[3])) << 24);
+    }
+
+    // DXGI_FORMAT values for the UNORM formats
+    uint32_t toDxgi(BlockFormat format) {
+        switch (format) {
+        case BlockFormat::RGBA8: return 28;
+        case BlockFormat::R8: return 61;
+        case BlockFormat::BC1: return 71;
+        case BlockFormat::BC3: return 77;
+        case BlockFormat::BC4: return 80;
+        case BlockFormat::BC5: return 83;
+        case BlockFormat::BC7: return 98;
+        default: return 0;
+        }
+    }
+
+    BlockFormat fromDxgi(uint32_t dxgi) {
+        switch (dxgi) {
+        case 28: case 29: return BlockFormat::RGBA8;
+        case 61: return BlockFormat::R8;
+        case 70: case 71: case 72: return BlockFormat::BC1;
+        case 76: case 77: case 78: return BlockFormat::BC3;
+        case 79: case 80: return BlockFormat::BC4;
+        case 82: case 83: return BlockFormat::BC5;
+        case 97: case 98: case 99: return BlockFormat::BC7;
+        default: return BlockFormat::None;
+        }
+    }
+}
+
+void DdsFile::serialize(BlockFormat format, const std::vector<ImageLevel>& levels, const uint8_t* data,
+    std::vector<uint8_t>& out) {
+    DdsHeader header{};
+    header.size = sizeof(DdsHeader);
+    header.flags = DDSD_CAPS | DDSD_HEIGHT | DDSD_WIDTH | DDSD_PIXELFORMAT | DDSD_MIPMAPCOUNT;
+    header.width = levels.empty() ? 0 : levels[0].width;
+    header.height = levels.empty() ? 0 : levels[0].height;
+    if (BlockCompression::isCompressed(format)) {
+        header.flags |= DDSD_LINEARSIZE;
+        header.pitchOrLinearSize = levels.empty() ? 0 : static_cast<uint32_t>(levels[0].size);
+    }
+    else {
+        header.flags |= DDSD_PITCH;  // Bytes per row of level 0
+        header.pitchOrLinearSize = static_cast<uint32_t>(BlockCompression::levelBytes(format, header.width, 1));
+    }
+    header.mipMapCount = static_cast<uint32_t>(levels.size());
+    header.pixelFormat.size = sizeof(DdsPixelFormat);
+    header.pixelFormat.flags = DDPF_FOURCC;
+    header.pixelFormat.fourCC = fourCC("DX10");
+    header.caps = DDSCAPS_TEXTURE | DDSCAPS_MIPMAP | DDSCAPS_COMPLEX;
+
+    DdsHeaderDX10 dx10{};
+    dx10.dxgiFormat = toDxgi(format);
+    dx10.resourceDimension = DIMENSION_TEXTURE2D;
+    dx10.arraySize = 1;
+
+    size_t payloadSize = 0;
+    for (const auto& level : levels) payloadSize += level.size;
+
+    out.resize(4 + sizeof(header) + sizeof(dx10) + payloadSize);
+    uint8_t* cursor = out.data();
+    std::memcpy(cursor, &DDS_MAGIC, 4);
+    std::memcpy(cursor + 4, &header, sizeof(header));
+    std::memcpy(cursor + 4 + sizeof(header), &dx10, sizeof(dx10));
+    cursor += 4 + sizeof(header) + sizeof(dx10);
+
+    // Levels are written back to back, level 0 first
+    for (const auto& level : levels) {
+        std::memcpy(cursor, data + level.offset, level.size);
+        cursor += level.size;
+    }
+}
+
+bool DdsFile::parse(const uint8_t* file, size_t size, BlockFormat& format, std::vector<ImageLevel>& levels,
+    const uint8_t*& payload) {
+    uint32_t magic;
+    DdsHeader header;
+    if (size < 4 + sizeof(header)) return false;
+    std::memcpy(&magic, file, 4);
+    std::memcpy(&header, file + 4, sizeof(header));
+    if (magic != DDS_MAGIC || header.size != sizeof(DdsHeader)) return false;
+
+    size_t headerBytes = 4 + sizeof(header);
+    format = BlockFormat::None;
+    if (!(header.pixelFormat.flags & DDPF_FOURCC)) return false;  // Legacy bitmask formats aren't used here
+
+    uint32_t code = header.pixelFormat.fourCC;
+    if (code == fourCC("DX10")) {
+        DdsHeaderDX10 dx10;
+        if (size < headerBytes + sizeof(dx10)) return false;
+        std::memcpy(&dx10, file + headerBytes, sizeof(dx10));
+        if (dx10.resourceDimension != DIMENSION_TEXTURE2D || dx10.arraySize > 1) return false;
+        format = fromDxgi(dx10.dxgiFormat);
+        headerBytes += sizeof(dx10);
+    }
+    else if (code == fourCC("DXT1")) format = BlockFormat::BC1;
+    else if (code == fourCC("DXT5")) format = BlockFormat::BC3;
+    else if (code == fourCC("ATI1") || code == fourCC("BC4U")) format = BlockFormat::BC4;
+    else if (code == fourCC("ATI2") || code == fourCC("BC5U")) format = BlockFormat::BC5;
+    if (format == BlockFormat::None) return false;
+
+    // Rebuild the level table and check it fits in the file
+    uint32_t width = header.width, height = header.height;
+    uint32_t mipCount = (header.flags & DDSD_MIPMAPCOUNT) ? std::max(1u, header.mipMapCount) : 1;
+    size_t offset = 0;
+    levels.clear();
+    for (uint32_t i = 0; i < mipCount; i++) {
+        ImageLevel level;
+        level.width = width;
+        level.height = height;
+        level.offset = offset;
+        level.size = BlockCompression::levelBytes(format, width, height);
+        offset += level.size;
+        levels.push_back(level);
+
+        width = std::max(1u, width / 2);
+        height = std::max(1u, height / 2);
+    }
+    if (headerBytes + offset > size) return false;
+
+    payload = file + headerBytes;
+    return true;
+}
@@ -0,0 +1,287 @@
+#include "DeferredRenderer.hpp"
+#include "LightingManager.hpp"
+#include "GpuMemory.hpp"
+#include "ShadowAtlas.hpp"
+#include "PostProcess.hpp"
+#include <iostream>
+#include <cmath>
+
+namespace {
+    // G-buffer texture units in the light and resolve passes
+    const GLint ALBEDO_UNIT = 0;
+    const GLint NORMAL_UNIT = 1;
+    const GLint MATERIAL_UNIT = 2;
+    const GLint DEPTH_UNIT = 3;
+    const GLint ACCUMULATION_UNIT = 4;
+
+    const int SPHERE_SEGMENTS = 16;  // Around
+    const int SPHERE_RINGS = 8;      // Pole to pole
+
+    GLuint createTarget(GLenum internalFormat, GLenum format, GLenum type, int width, int height) {
+        GLuint texture = 0;
+        glGenTextures(1, &texture);
+        glBindTexture(GL_TEXTURE_2D, texture);
+        glTexImage2D(GL_TEXTURE_2D, 0, internalFormat, width, height, 0, format, type, nullptr);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        return texture;
+    }
+
+    void bindTexture(GLint unit, GLuint texture) {
+        glActiveTexture(GL_TEXTURE0 + unit);
+        glBindTexture(GL_TEXTURE_2D, texture);
+    }
+}
+
+DeferredRenderer::~DeferredRenderer() {
+    cleanup();
+}
+
+bool DeferredRenderer::initialize() {
+    if (sphereVAO) return true;
+
+    lightShader = std::make_unique<Shader>("shaders/deferred_light.vert", "shaders/deferred_light.frag");
+    resolveShader = std::make_unique<Shader>("shaders/fullscreen.vert", "shaders/deferred_resolve.frag");
+
+    // Unit sphere, pushed out so its flat faces still enclose the true sphere
+    float scale = 1.0f / std::cos(3.14159265f / SPHERE_SEGMENTS) / std::cos(3.14159265f / (2 * SPHERE_RINGS));
+    std::vector<float> vertices;
+    for (int ring = 0; ring <= SPHERE_RINGS; ring++) {
+        float theta = 3.14159265f * ring / SPHERE_RINGS;
+        for (int segment = 0; segment <= SPHERE_SEGMENTS; segment++) {
+            float phi = 2.0f * 3.14159265f * segment / SPHERE_SEGMENTS;
+            vertices.push_back(scale * std::sin(theta) * std::cos(phi));
+            vertices.push_back(scale * std::cos(theta));
+            vertices.push_back(scale * std::sin(theta) * std::sin(phi));
+        }
+    }
+    std::vector<unsigned int> indices;
+    for (int ring = 0; ring < SPHERE_RINGS; ring++) {
+        for (int segment = 0; segment < SPHERE_SEGMENTS; segment++) {
+            unsigned int a = ring * (SPHERE_SEGMENTS + 1) + segment;
+            unsigned int b = a + SPHERE_SEGMENTS + 1;
+            indices.insert(indices.end(), { a, b, a + 1, a + 1, b, b + 1 });
+        }
+    }
+    sphereIndexCount = static_cast<GLsizei>(indices.size());
+
+    glGenVertexArrays(1, &sphereVAO);
+    glGenBuffers(1, &sphereVBO);
+    glGenBuffers(1, &sphereEBO);
+    glGenBuffers(1, &instanceBuffer);
+    glBindVertexArray(sphereVAO);
+    glBindBuffer(GL_ARRAY_BUFFER, sphereVBO);
+    glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(float), vertices.data(), GL_STATIC_DRAW);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
+    glEnableVertexAttribArray(0);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, sphereEBO);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), indices.data(), GL_STATIC_DRAW);
+
+    // One LightInstance per light (locations 3-5 in deferred_light.vert)
+    glBindBuffer(GL_ARRAY_BUFFER, instanceBuffer);
+    for (GLuint i = 0; i < 3; i++) {
+        glVertexAttribPointer(3 + i, 4, GL_FLOAT, GL_FALSE, sizeof(LightInstance), (void*)(i * sizeof(glm::vec4)));
+        glEnableVertexAttribArray(3 + i);
+        glVertexAttribDivisor(3 + i, 1);
+    }
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    GpuMemory::allocate(GpuMemoryCategory::Buffers, vertices.size() * sizeof(float) + indices.size() * sizeof(unsigned int));
+
+    glGenVertexArrays(1, &fullscreenVAO);
+
+    std::cout << "Deferred renderer ready" << std::endl;
+    return true;
+}
+
+void DeferredRenderer::cleanup() {
+    destroyTargets();
+    if (sphereVAO) {
+        glDeleteVertexArrays(1, &sphereVAO);
+        glDeleteBuffers(1, &sphereVBO);
+        glDeleteBuffers(1, &sphereEBO);
+        glDeleteBuffers(1, &instanceBuffer);
+        glDeleteVertexArrays(1, &fullscreenVAO);
+        GpuMemory::release(GpuMemoryCategory::Buffers,
+            (SPHERE_RINGS + 1) * (SPHERE_SEGMENTS + 1) * 3 * sizeof(float) +
+            SPHERE_RINGS * SPHERE_SEGMENTS * 6 * sizeof(unsigned int) + instanceCapacity * sizeof(LightInstance));
+        sphereVAO = sphereVBO = sphereEBO = instanceBuffer = fullscreenVAO = 0;
+        instanceCapacity = 0;
+        uploadedVersion = 0;
+    }
+    if (lightShader) glDeleteProgram(lightShader->ID);
+    if (resolveShader) glDeleteProgram(resolveShader->ID);
+    lightShader.reset();
+    resolveShader.reset();
+    samplersSet = false;
+}
+
+void DeferredRenderer::createTargets(int newWidth, int newHeight) {
+    destroyTargets();
+    width = newWidth;
+    height = newHeight;
+
+    albedoTexture = createTarget(GL_RGBA8, GL_RGBA, GL_UNSIGNED_BYTE, width, height);
+    normalTexture = createTarget(GL_RGB10_A2, GL_RGBA, GL_UNSIGNED_INT_2_10_10_10_REV, width, height);
+    materialTexture = createTarget(GL_RG8, GL_RG, GL_UNSIGNED_BYTE, width, height);
+    depthTexture = createTarget(GL_DEPTH24_STENCIL8, GL_DEPTH_STENCIL, GL_UNSIGNED_INT_24_8, width, height);
+    accumulationTexture = createTarget(GL_RGBA16F, GL_RGBA, GL_HALF_FLOAT, width, height);
+
+    glGenFramebuffers(1, &gBuffer);
+    glBindFramebuffer(GL_FRAMEBUFFER, gBuffer);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, albedoTexture, 0);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT1, GL_TEXTURE_2D, normalTexture, 0);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT2, GL_TEXTURE_2D, materialTexture, 0);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_TEXTURE_2D, depthTexture, 0);
+    const GLenum drawBuffers[] = { GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1, GL_COLOR_ATTACHMENT2 };
+    glDrawBuffers(3, drawBuffers);
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+        std::cerr << "G-buffer framebuffer not complete!" << std::endl;
+    }
+
+    glGenRenderbuffers(1, &lightDepth);
+    glBindRenderbuffer(GL_RENDERBUFFER, lightDepth);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, width, height);
+    glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+    glGenFramebuffers(1, &lightBuffer);
+    glBindFramebuffer(GL_FRAMEBUFFER, lightBuffer);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, accumulationTexture, 0);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, lightDepth);
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+        std::cerr << "Light accumulation framebuffer not complete!" << std::endl;
+    }
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+    // albedo 4 + normal 4 + material 2 + depth 4 + accumulation 8 + depth copy 4
+    targetBytes = static_cast<size_t>(width) * height * 26;
+    GpuMemory::allocate(GpuMemoryCategory::RenderTargets, targetBytes);
+    std::cout << "G-buffer: " << width << "x" << height << std::endl;
+}
+
+void DeferredRenderer::destroyTargets() {
+    if (!gBuffer) return;
+    GLuint textures[] = { albedoTexture, normalTexture, materialTexture, depthTexture, accumulationTexture };
+    glDeleteTextures(5, textures);
+    glDeleteRenderbuffers(1, &lightDepth);
+    glDeleteFramebuffers(1, &gBuffer);
+    glDeleteFramebuffers(1, &lightBuffer);
+    GpuMemory::release(GpuMemoryCategory::RenderTargets, targetBytes);
+    gBuffer = lightBuffer = lightDepth = 0;
+    albedoTexture = normalTexture = materialTexture = depthTexture = accumulationTexture = 0;
+    targetBytes = 0;
+    width = height = 0;
+}
+
+void DeferredRenderer::updateLights(const LightingManager& lighting) {
+    if (!sphereVAO || uploadedVersion == lighting.getVersion()) return;
+    uploadedVersion = lighting.getVersion();
+
+    instances.clear();
+    const std::vector<int>& shadowSlots = lighting.getShadowSlots();
+    for (size_t i = 0; i < lighting.pointLights.size(); i++) {
+        const PointLight& light = lighting.pointLights[i];
+        float range = light.getRange();
+        if (range <= 0.0f) continue;  // Never reaches the cutoff
+        LightInstance instance;
+        instance.positionRange = glm::vec4(light.position, range);
+        instance.colorIntensity = glm::vec4(light.color, light.intensity);
+        instance.falloff = glm::vec4(light.constant, light.linear, light.quadratic, static_cast<float>(shadowSlots[i]));
+        instances.push_back(instance);
+    }
+    lightCount = static_cast<GLsizei>(instances.size());
+
+    glBindBuffer(GL_ARRAY_BUFFER, instanceBuffer);
+    if (instances.size() > instanceCapacity) {
+        GpuMemory::release(GpuMemoryCategory::Buffers, instanceCapacity * sizeof(LightInstance));
+        instanceCapacity = instances.size();
+        glBufferData(GL_ARRAY_BUFFER, instanceCapacity * sizeof(LightInstance), instances.data(), GL_DYNAMIC_DRAW);
+        GpuMemory::allocate(GpuMemoryCategory::Buffers, instanceCapacity * sizeof(LightInstance));
+    }
+    else if (!instances.empty()) {
+        glBufferSubData(GL_ARRAY_BUFFER, 0, instances.size() * sizeof(LightInstance), instances.data());
+    }
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void DeferredRenderer::beginGeometry(int targetWidth, int targetHeight) {
+    if (targetWidth != width || targetHeight != height) createTargets(targetWidth, targetHeight);
+
+    glBindFramebuffer(GL_FRAMEBUFFER, gBuffer);
+    glViewport(0, 0, width, height);
+    glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+}
+
+void DeferredRenderer::resolve(const glm::mat4& view, const glm::mat4& projection, GLuint targetFramebuffer) {
+    if (!samplersSet) {
+        // Sampler units are program state (set on first use, so startup doesn't wait for the link)
+        samplersSet = true;
+        lightShader->use();
+        lightShader->setInt("gAlbedo"_uniform, ALBEDO_UNIT);
+        lightShader->setInt("gNormal"_uniform, NORMAL_UNIT);
+        lightShader->setInt("gMaterial"_uniform, MATERIAL_UNIT);
+        lightShader->setInt("gDepth"_uniform, DEPTH_UNIT);
+        ShadowAtlas::setupSamplers(*lightShader);  // Atlas itself is bound per view (beginView)
+        resolveShader->use();
+        resolveShader->setInt("gAlbedo"_uniform, ALBEDO_UNIT);
+        resolveShader->setInt("gDepth"_uniform, DEPTH_UNIT);
+        resolveShader->setInt("lightAccumulation"_uniform, ACCUMULATION_UNIT);
+        resolveShader->setVec3("background"_uniform, PostProcess::BACKGROUND.r, PostProcess::BACKGROUND.g, PostProcess::BACKGROUND.b);
+    }
+    GLboolean cullWasEnabled = glIsEnabled(GL_CULL_FACE);
+
+    // Depth copy for the volume test, then an empty accumulation target
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, gBuffer);
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, lightBuffer);
+    glBlitFramebuffer(0, 0, width, height, 0, 0, width, height, GL_DEPTH_BUFFER_BIT, GL_NEAREST);
+    glBindFramebuffer(GL_FRAMEBUFFER, lightBuffer);
+    glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+    glClear(GL_COLOR_BUFFER_BIT);
+
+    bindTexture(ALBEDO_UNIT, albedoTexture);
+    bindTexture(NORMAL_UNIT, normalTexture);
+    bindTexture(MATERIAL_UNIT, materialTexture);
+    bindTexture(DEPTH_UNIT, depthTexture);
+
+    // Light volumes: back faces that lie behind the scene surface cover exactly the pixels
+    // within range (also with the camera inside the sphere); each adds its light
+    if (lightCount > 0) {
+        glEnable(GL_CULL_FACE);
+        glCullFace(GL_FRONT);
+        glEnable(GL_DEPTH_TEST);
+        glDepthFunc(GL_GEQUAL);
+        glDepthMask(GL_FALSE);
+        glEnable(GL_BLEND);
+        glBlendFunc(GL_ONE, GL_ONE);
+
+        lightShader->use();
+        glm::mat4 inverseViewProjection = glm::inverse(projection * view);
+        lightShader->setMat4("inverseViewProjection"_uniform, &inverseViewProjection[0][0]);
+        glBindVertexArray(sphereVAO);
+        glDrawElementsInstanced(GL_TRIANGLES, sphereIndexCount, GL_UNSIGNED_INT, 0, lightCount);
+        glBindVertexArray(0);
+
+        glDisable(GL_BLEND);
+        glCullFace(GL_BACK);
+        glDepthMask(GL_TRUE);
+        glDepthFunc(GL_LESS);
+    }
+
+    // Ambient + lights into the target, with the scene depth for forward passes
+    glBindFramebuffer(GL_FRAMEBUFFER, targetFramebuffer);
+    bindTexture(ACCUMULATION_UNIT, accumulationTexture);
+    glDisable(GL_CULL_FACE);
+    glEnable(GL_DEPTH_TEST);
+    glDepthFunc(GL_ALWAYS);
+    resolveShader->use();
+    glBindVertexArray(fullscreenVAO);
+    glDrawArrays(GL_TRIANGLES, 0, 3);
+    glBindVertexArray(0);
+    glDepthFunc(GL_LESS);
+    glActiveTexture(GL_TEXTURE0);
+
+    if (cullWasEnabled) glEnable(GL_CULL_FACE);
+}
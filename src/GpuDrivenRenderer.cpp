@@ -0,0 +1,255 @@
+#include "GpuDrivenRenderer.hpp"
+#include "MaterialManager.hpp"
+#include "GpuMemory.hpp"
+#include <iostream>
+#include <algorithm>
+
+namespace GpuDrivenConstants {
+    const GLuint CULL_GROUP_SIZE = 64;  // Must match local_size_x in cull.comp
+    const GLuint OBJECT_BINDING = 0;    // SSBO binding points (see cull.comp / indirect.vert)
+    const GLuint COMMAND_BINDING = 1;
+    const GLuint VISIBLE_BINDING = 2;
+}
+
+GpuDrivenRenderer::~GpuDrivenRenderer() {
+    cleanup();
+}
+
+bool GpuDrivenRenderer::isSupported() {
+    return GLEW_VERSION_4_3 != 0;
+}
+
+bool GpuDrivenRenderer::initialize(const Scene& scene, const std::vector<DrawBatch>& batches) {
+    cleanup();
+
+    if (!isSupported()) {
+        std::cout << "GPU-driven rendering needs OpenGL 4.3, staying on the CPU path" << std::endl;
+        return false;
+    }
+
+    // Lay out one indirect command per mesh, meshes grouped by material.
+    // Standard materials come first so they form one contiguous range of commands.
+    std::vector<DrawArraysIndirectCommand> commands;
+    std::vector<const Model*> commandModels;
+    GLuint firstVertex = 0;
+
+    for (int pass = 0; pass < 2; pass++) {
+        bool lightPass = pass == 1;
+        if (lightPass) lightFirstCommand = static_cast<GLsizei>(commands.size());
+
+        for (const auto& batch : batches) {
+            bool lightSource = MaterialManager::get(batch.material).lightSource;
+            if (lightSource != lightPass) continue;
+
+            BatchRange range{ batch.material, lightSource, static_cast<GLuint>(commands.size()), 0 };
+            for (const Model* model : batch.models) {
+                if (!model || model->vertexCount == 0) continue;  // Failed loads have no buffers
+                commands.push_back({ static_cast<GLuint>(model->vertexCount), 0, firstVertex, 0 });
+                commandModels.push_back(model);
+                firstVertex += static_cast<GLuint>(model->vertexCount);
+                range.commandCount++;
+            }
+            if (range.commandCount > 0) batchRanges.push_back(range);
+        }
+    }
+    commandCount = static_cast<GLsizei>(commands.size());
+
+    if (commands.empty()) return false;
+
+    // Collect scene objects drawn by this path, counting instances per mesh
+    std::vector<GLuint> instancesPerCommand(commands.size(), 0);
+    for (size_t i = 0; i < scene.objects.size(); i++) {
+        const SceneObject& obj = scene.objects[i];
+        if (obj.gpuAnimated) continue;  // Drawn by AnimatedInstanceRenderer
+
+        auto it = std::find(commandModels.begin(), commandModels.end(), obj.model);
+        if (it == commandModels.end()) continue;
+
+        GLuint commandIndex = static_cast<GLuint>(it - commandModels.begin());
+        glm::vec3 center = (obj.model->boundsMin + obj.model->boundsMax) * 0.5f;
+        float radius = glm::length(obj.model->boundsMax - center);
+
+        GpuObject gpuObject{};
+        gpuObject.model = obj.modelMatrix;
+        gpuObject.localSphere = glm::vec4(center, radius);
+        gpuObject.commandIndex = commandIndex;
+        gpuObject.materialLayer = obj.material;
+        objects.push_back(gpuObject);
+        sceneIndices.push_back(i);
+        instancesPerCommand[commandIndex]++;
+    }
+
+    if (objects.empty()) return false;
+
+    // Reserve a contiguous slice of the visible list for every mesh
+    GLuint baseInstance = 0;
+    for (size_t i = 0; i < commands.size(); i++) {
+        commands[i].baseInstance = baseInstance;
+        baseInstance += instancesPerCommand[i];
+    }
+
+    // Merge all mesh vertex data into a single VBO (GPU-side copies, no readback)
+    glGenBuffers(1, &vertexBuffer);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, vertexBuffer);
+    glBufferData(GL_COPY_WRITE_BUFFER, firstVertex * 8 * sizeof(float), nullptr, GL_STATIC_DRAW);
+    for (size_t i = 0; i < commandModels.size(); i++) {
+        glBindBuffer(GL_COPY_READ_BUFFER, commandModels[i]->VBO);
+        glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0,
+            commands[i].first * 8 * sizeof(float), commands[i].count * 8 * sizeof(float));
+    }
+
+    // Object SSBO - long-lived, only transforms are streamed into it each frame
+    glGenBuffers(1, &objectBuffer);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, objectBuffer);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, objects.size() * sizeof(GpuObject), objects.data(), GL_DYNAMIC_DRAW);
+
+    // Indirect commands plus a pristine copy used to reset instance counts per view
+    commandBytes = commands.size() * sizeof(DrawArraysIndirectCommand);
+    glGenBuffers(1, &commandBuffer);
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, commandBuffer);
+    glBufferData(GL_DRAW_INDIRECT_BUFFER, commandBytes, commands.data(), GL_DYNAMIC_COPY);
+
+    glGenBuffers(1, &commandTemplate);
+    glBindBuffer(GL_COPY_READ_BUFFER, commandTemplate);
+    glBufferData(GL_COPY_READ_BUFFER, commandBytes, commands.data(), GL_STATIC_DRAW);
+
+    glGenBuffers(1, &visibleBuffer);
+    glBindBuffer(GL_ARRAY_BUFFER, visibleBuffer);
+    glBufferData(GL_ARRAY_BUFFER, objects.size() * sizeof(GLuint), nullptr, GL_DYNAMIC_COPY);
+
+    meshBytes = firstVertex * 8 * sizeof(float);
+    bufferBytes = objects.size() * (sizeof(GpuObject) + sizeof(GLuint)) + 2 * static_cast<size_t>(commandBytes);
+    GpuMemory::allocate(GpuMemoryCategory::Meshes, meshBytes);
+    GpuMemory::allocate(GpuMemoryCategory::Buffers, bufferBytes);
+
+    // Same vertex layout as Model, plus the visible object index as an instanced attribute
+    glGenVertexArrays(1, &VAO);
+    glBindVertexArray(VAO);
+
+    glBindBuffer(GL_ARRAY_BUFFER, vertexBuffer);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)0);
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(3 * sizeof(float)));
+    glEnableVertexAttribArray(1);
+    glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(6 * sizeof(float)));
+    glEnableVertexAttribArray(2);
+
+    // baseInstance offsets this attribute, so each mesh reads its own slice of the visible list
+    glBindBuffer(GL_ARRAY_BUFFER, visibleBuffer);
+    glVertexAttribIPointer(3, 1, GL_UNSIGNED_INT, sizeof(GLuint), (void*)0);
+    glVertexAttribDivisor(3, 1);
+    glEnableVertexAttribArray(3);
+
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    cullShader = std::make_unique<Shader>("shaders/cull.comp");
+
+    initialized = true;
+    std::cout << "GPU-driven renderer: " << objects.size() << " objects, "
+        << commands.size() << " meshes, " << batchRanges.size() << " materials" << std::endl;
+    return true;
+}
+
+void GpuDrivenRenderer::updateTransforms(const Scene& scene) {
+    if (!initialized) return;
+
+    // Only the matrix part changes, but objects are small enough to send in one go
+    for (size_t i = 0; i < objects.size(); i++) {
+        objects[i].model = scene.objects[sceneIndices[i]].modelMatrix;
+    }
+
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, objectBuffer);
+    glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, objects.size() * sizeof(GpuObject), objects.data());
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+}
+
+void GpuDrivenRenderer::cull(const glm::mat4& view, const glm::mat4& projection) {
+    if (!initialized) return;
+
+    // Extract frustum planes from the combined matrix (Gribb/Hartmann)
+    glm::mat4 m = glm::transpose(projection * view);
+    glm::vec4 planes[6] = {
+        m[3] + m[0], m[3] - m[0],  // left, right
+        m[3] + m[1], m[3] - m[1],  // bottom, top
+        m[3] + m[2], m[3] - m[2]   // near, far
+    };
+    for (auto& plane : planes) {
+        plane /= glm::length(glm::vec3(plane));
+    }
+
+    // Reset instance counts from the template
+    glBindBuffer(GL_COPY_READ_BUFFER, commandTemplate);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, commandBuffer);
+    glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, commandBytes);
+
+    cullShader->use();
+    cullShader->setVec4Array("frustumPlanes"_uniform, &planes[0][0], 6);
+    cullShader->setUint("objectCount"_uniform, static_cast<GLuint>(objects.size()));
+
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, GpuDrivenConstants::OBJECT_BINDING, objectBuffer);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, GpuDrivenConstants::COMMAND_BINDING, commandBuffer);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, GpuDrivenConstants::VISIBLE_BINDING, visibleBuffer);
+
+    GLuint groups = (static_cast<GLuint>(objects.size()) + GpuDrivenConstants::CULL_GROUP_SIZE - 1) / GpuDrivenConstants::CULL_GROUP_SIZE;
+    glDispatchCompute(groups, 1, 1);
+
+    // Commands and visible indices are consumed by the draw that follows
+    glMemoryBarrier(GL_COMMAND_BARRIER_BIT | GL_VERTEX_ATTRIB_ARRAY_BARRIER_BIT | GL_SHADER_STORAGE_BARRIER_BIT);
+}
+
+void GpuDrivenRenderer::drawBatches(const Shader& shader, bool lightSources) const {
+    if (!initialized) return;
+
+    // Vertex shader fetches transforms from the object SSBO
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, GpuDrivenConstants::OBJECT_BINDING, objectBuffer);
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, commandBuffer);
+    glBindVertexArray(VAO);
+
+    if (MaterialManager::getBackend() == MaterialBackend::TextureArrays) {
+        // Layers come from the object SSBO, so every material shares one multi-draw
+        GLsizei first = lightSources ? lightFirstCommand : 0;
+        GLsizei count = lightSources ? commandCount - lightFirstCommand : lightFirstCommand;
+        if (count > 0) {
+            MaterialManager::bind(batchRanges.front().material, shader);  // Binds the arrays
+            glMultiDrawArraysIndirect(GL_TRIANGLES, (void*)(first * sizeof(DrawArraysIndirectCommand)), count, 0);
+        }
+        glBindVertexArray(0);
+        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+        return;
+    }
+
+    for (const auto& range : batchRanges) {
+        if (range.lightSource != lightSources) continue;
+
+        MaterialManager::bind(range.material, shader);
+        glMultiDrawArraysIndirect(GL_TRIANGLES,
+            (void*)(range.firstCommand * sizeof(DrawArraysIndirectCommand)),
+            range.commandCount, 0);
+    }
+
+    glBindVertexArray(0);
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+}
+
+void GpuDrivenRenderer::cleanup() {
+    GpuMemory::release(GpuMemoryCategory::Meshes, meshBytes);
+    GpuMemory::release(GpuMemoryCategory::Buffers, bufferBytes);
+    meshBytes = bufferBytes = 0;
+
+    if (VAO) glDeleteVertexArrays(1, &VAO);
+    GLuint buffers[] = { vertexBuffer, objectBuffer, commandBuffer, commandTemplate, visibleBuffer };
+    for (GLuint buffer : buffers) {
+        if (buffer) glDeleteBuffers(1, &buffer);
+    }
+    if (cullShader) glDeleteProgram(cullShader->ID);
+
+    VAO = vertexBuffer = objectBuffer = commandBuffer = commandTemplate = visibleBuffer = 0;
+    commandBytes = 0;
+    lightFirstCommand = commandCount = 0;
+    cullShader.reset();
+    batchRanges.clear();
+    sceneIndices.clear();
+    objects.clear();
+    initialized = false;
+}
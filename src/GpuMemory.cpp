@@ -0,0 +1,95 @@
+#include "GpuMemory.hpp"
+#include <algorithm>
+#include <iomanip>
+#include <iostream>
+
+#ifndef GL_GPU_MEMORY_INFO_DEDICATED_VIDMEM_NVX
+#define GL_GPU_MEMORY_INFO_DEDICATED_VIDMEM_NVX 0x9047
+#endif
+#ifndef GL_TEXTURE_FREE_MEMORY_ATI
+#define GL_TEXTURE_FREE_MEMORY_ATI 0x87FC
+#endif
+
+// Static member definitions - counters, budget and the LRU frame clock
+size_t GpuMemory::used[static_cast<int>(GpuMemoryCategory::Count)] = {};
+size_t GpuMemory::peak = 0;
+size_t GpuMemory::budget = 0;
+uint64_t GpuMemory::frame = 0;
+
+namespace {
+    double megabytes(size_t bytes) {
+        return static_cast<double>(bytes) / (1024.0 * 1024.0);
+    }
+}
+
+void GpuMemory::allocate(GpuMemoryCategory category, size_t bytes) {
+    used[static_cast<int>(category)] += bytes;
+    peak = std::max(peak, getTotal());
+}
+
+void GpuMemory::release(GpuMemoryCategory category, size_t bytes) {
+    size_t& counter = used[static_cast<int>(category)];
+    counter -= std::min(counter, bytes);
+}
+
+size_t GpuMemory::getTotal() {
+    size_t total = 0;
+    for (size_t bytes : used) total += bytes;
+    return total;
+}
+
+const char* GpuMemory::getCategoryName(GpuMemoryCategory category) {
+    switch (category) {
+    case GpuMemoryCategory::Textures: return "Textures";
+    case GpuMemoryCategory::MaterialArrays: return "Material arrays";
+    case GpuMemoryCategory::VirtualTextures: return "Virtual textures";
+    case GpuMemoryCategory::RenderTargets: return "Render targets";
+    case GpuMemoryCategory::Meshes: return "Meshes";
+    case GpuMemoryCategory::Buffers: return "Buffers";
+    default: return "?";
+    }
+}
+
+void GpuMemory::detectBudget() {
+    // Both report kilobytes. ATI only has free memory, which is close to total this early on.
+    GLint kilobytes[4] = {};
+    if (GLEW_NVX_gpu_memory_info) {
+        glGetIntegerv(GL_GPU_MEMORY_INFO_DEDICATED_VIDMEM_NVX, kilobytes);
+    }
+    else if (GLEW_ATI_meminfo) {
+        glGetIntegerv(GL_TEXTURE_FREE_MEMORY_ATI, kilobytes);
+    }
+
+    if (kilobytes[0] <= 0) {
+        std::cout << "GPU memory budget: unlimited (driver doesn't report video memory)" << std::endl;
+        return;
+    }
+    budget = static_cast<size_t>(kilobytes[0]) * 1024 / 10 * 8;
+    std::cout << "GPU memory budget: " << static_cast<size_t>(megabytes(budget)) << " MB (80% of "
+        << kilobytes[0] / 1024 << " MB video memory)" << std::endl;
+}
+
+size_t GpuMemory::imageBytes(GLsizei width, GLsizei height, GLenum internalFormat) {
+    size_t texelBytes = 4;
+    switch (internalFormat) {
+    case GL_R8: texelBytes = 1; break;
+    case GL_RG8: texelBytes = 2; break;
+    case GL_RGB8: texelBytes = 3; break;  // Usually padded to 4 by the driver, but that's its business
+    case GL_RGBA16F: case GL_DEPTH32F_STENCIL8: texelBytes = 8; break;
+    case GL_RGBA32F: texelBytes = 16; break;
+    default: break;  // RGBA8, R11F_G11F_B10F, R32F, DEPTH24(+STENCIL8), DEPTH32F
+    }
+    return size_t(width) * size_t(height) * texelBytes;
+}
+
+void GpuMemory::printReport() {
+    std::cout << std::fixed << std::setprecision(1);
+    for (int i = 0; i < static_cast<int>(GpuMemoryCategory::Count); i++) {
+        std::cout << "  " << std::left << std::setw(16) << getCategoryName(static_cast<GpuMemoryCategory>(i))
+            << std::right << std::setw(9) << megabytes(used[i]) << " MB" << std::endl;
+    }
+    std::cout << "  " << std::left << std::setw(16) << "Total" << std::right << std::setw(9)
+        << megabytes(getTotal()) << " MB (peak " << megabytes(peak) << " MB, budget ";
+    if (budget) std::cout << megabytes(budget) << " MB)" << std::endl;
+    else std::cout << "unlimited)" << std::endl;
+}
@@ -0,0 +1,118 @@
+#include "LightAnimator.hpp"
+#include "LightingManager.hpp"
+#include "scene.hpp"
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define LIGHTANIMATOR_SSE2 1
+#include <emmintrin.h>
+#endif
+
+namespace {
+    const size_t LANES = 4;  // Lights per SSE step; the track columns are padded to this
+
+#ifdef LIGHTANIMATOR_SSE2
+    // sin(x) for four x at once: wrapped to [-pi, pi], a parabola, refined once (error about 0.001)
+    inline __m128 sin4(__m128 x) {
+        const __m128 signMask = _mm_set1_ps(-0.0f);
+        __m128 turns = _mm_cvtepi32_ps(_mm_cvtps_epi32(_mm_mul_ps(x, _mm_set1_ps(0.15915494f))));
+        x = _mm_sub_ps(x, _mm_mul_ps(turns, _mm_set1_ps(6.28318531f)));
+        __m128 y = _mm_mul_ps(x, _mm_sub_ps(_mm_set1_ps(1.27323954f), _mm_mul_ps(_mm_set1_ps(0.40528473f), _mm_andnot_ps(signMask, x))));
+        return _mm_add_ps(y, _mm_mul_ps(_mm_set1_ps(0.225f), _mm_sub_ps(_mm_mul_ps(y, _mm_andnot_ps(signMask, y)), y)));
+    }
+#endif
+
+    bool animatable(const LightingManager& lighting, int light) {
+        if (light < 0 || light >= static_cast<int>(lighting.pointLights.size())) {
+            std::cerr << "LightAnimator: no light " << light << std::endl;
+            return false;
+        }
+        if (lighting.pointLights[light].isStatic) {
+            std::cerr << "LightAnimator: light " << light << " is static (baked), not animated" << std::endl;
+            return false;
+        }
+        return true;
+    }
+}
+
+bool LightAnimator::animate(const LightingManager& lighting, int light, const LightTrack& track) {
+    if (!animatable(lighting, light)) return false;
+
+    size_t index = lights.size();
+    lights.push_back(light);
+    size_t padded = (lights.size() + LANES - 1) / LANES * LANES;
+    for (std::vector<float>* column : { &flickerAmount, &flickerSpeed, &curveAmount, &curveSpeed, &phase, &factors }) {
+        column->resize(padded, 0.0f);
+    }
+    flickerAmount[index] = track.flickerAmount;
+    flickerSpeed[index] = track.flickerSpeed;
+    curveAmount[index] = track.curveAmount;
+    curveSpeed[index] = track.curveSpeed;
+    phase[index] = track.phase;
+    return true;
+}
+
+bool LightAnimator::attach(const LightingManager& lighting, int light, const Scene& scene, size_t object, const glm::vec3& offset) {
+    if (!animatable(lighting, light)) return false;
+    if (object >= scene.objects.size()) {
+        std::cerr << "LightAnimator: no scene object " << object << " to attach light " << light << " to" << std::endl;
+        return false;
+    }
+    attachedLights.push_back(light);
+    attachedObjects.push_back(object);
+    attachedOffsets.push_back(offset);
+    return true;
+}
+
+void LightAnimator::clear() {
+    lights.clear();
+    for (std::vector<float>* column : { &flickerAmount, &flickerSpeed, &curveAmount, &curveSpeed, &phase, &factors }) {
+        column->clear();
+    }
+    attachedLights.clear();
+    attachedObjects.clear();
+    attachedOffsets.clear();
+}
+
+void LightAnimator::update(float time, const Scene& scene, LightingManager& lighting) {
+    if (lights.empty() && attachedLights.empty()) return;
+
+    // Intensity multipliers, four lights per step (padding lanes have zero amounts)
+#ifdef LIGHTANIMATOR_SSE2
+    const __m128 t = _mm_set1_ps(time);
+    const __m128 one = _mm_set1_ps(1.0f);
+    for (size_t i = 0; i < factors.size(); i += LANES) {
+        __m128 offset = _mm_loadu_ps(&phase[i]);
+        __m128 angle = _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(&flickerSpeed[i]), t), offset);
+        __m128 wave = _mm_mul_ps(_mm_set1_ps(0.5f), sin4(angle));
+        wave = _mm_add_ps(wave, _mm_mul_ps(_mm_set1_ps(0.3f), sin4(_mm_mul_ps(angle, _mm_set1_ps(2.31f)))));
+        wave = _mm_add_ps(wave, _mm_mul_ps(_mm_set1_ps(0.2f), sin4(_mm_mul_ps(angle, _mm_set1_ps(4.79f)))));
+        __m128 flicker = _mm_add_ps(one, _mm_mul_ps(_mm_loadu_ps(&flickerAmount[i]), wave));
+
+        __m128 swell = sin4(_mm_add_ps(_mm_mul_ps(_mm_loadu_ps(&curveSpeed[i]), t), offset));
+        __m128 curve = _mm_add_ps(one, _mm_mul_ps(_mm_loadu_ps(&curveAmount[i]), swell));
+        _mm_storeu_ps(&factors[i], _mm_max_ps(_mm_mul_ps(flicker, curve), _mm_setzero_ps()));
+    }
+#else
+    for (size_t i = 0; i < factors.size(); i++) {
+        float angle = flickerSpeed[i] * time + phase[i];
+        float wave = 0.5f * std::sin(angle) + 0.3f * std::sin(angle * 2.31f) + 0.2f * std::sin(angle * 4.79f);
+        float flicker = 1.0f + flickerAmount[i] * wave;
+        float curve = 1.0f + curveAmount[i] * std::sin(curveSpeed[i] * time + phase[i]);
+        factors[i] = std::max(flicker * curve, 0.0f);
+    }
+#endif
+
+    // Into the lights (baseIntensity follows the torch controls and drama mode)
+    PointLight* pointLights = lighting.pointLights.data();
+    for (size_t i = 0; i < lights.size(); i++) {
+        PointLight& light = pointLights[lights[i]];
+        light.intensity = light.baseIntensity * factors[i];
+    }
+    for (size_t i = 0; i < attachedLights.size(); i++) {
+        pointLights[attachedLights[i]].position = glm::vec3(scene.objects[attachedObjects[i]].modelMatrix * glm::vec4(attachedOffsets[i], 1.0f));
+    }
+    lighting.markAnimated();
+}
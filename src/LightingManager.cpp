@@ -2,9 +2,43 @@
 #include <cmath>
 #include <iostream>
 #include <algorithm>
+#include "UniformBuffers.hpp"
+#include "GpuMemory.hpp"
+
+namespace {
+    // std140 mirror of the LightingData block (standard.frag / light.frag). The shader struct
+    // (vec3, vec3, 4 floats, int) lays out as 48 bytes: position padded to 16, the rest packed after color.
+    struct GpuPointLight {
+        glm::vec3 position;
+        float pad0;
+        glm::vec3 color;
+        float intensity;
+        float constant, linear, quadratic;
+        int shadowSlot;  // ShadowAtlas row, -1 = unshadowed
+    };
+
+    struct LightingData {
+        GpuPointLight pointLights[LightingManager::MAX_POINT_LIGHTS];
+        glm::vec3 ambientColor;
+        float ambientStrength;
+        int numPointLights;
+        int pad[3];
+    };
+    static_assert(sizeof(GpuPointLight) == 48, "GpuPointLight must match the std140 PointLight struct");
+}
+
+float PointLight::getRange() const {
+    // intensity / (constant + linear*d + quadratic*d^2) = cutoff, solved for d
+    float brightest = intensity * std::max(color.r, std::max(color.g, color.b));
+    float c = constant - brightest / LightingManager::LIGHT_CUTOFF;
+    if (c >= 0.0f) return 0.0f;  // Never reaches the cutoff
+    if (quadratic <= 0.0f) return linear > 0.0f ? -c / linear : 1e4f;
+    return (-linear + std::sqrt(linear * linear - 4.0f * quadratic * c)) / (2.0f * quadratic);
+}
 
 void LightingManager::addPointLight(const PointLight& light) {
     pointLights.push_back(light);
+    markDirty();
 }
 
 void LightingManager::setupLibraryLighting(float roomRadius, float roomHeight) {
@@ -23,6 +57,8 @@ void LightingManager::setupLibraryLighting(float roomRadius, float roomHeight) {
         2.2f,                                  // Good intensity for warmth
         1.0f, 0.09f, 0.032f                   // Attenuation: constant, linear, quadratic
     );
+    centralLamp.isStatic = true;              // Hangs still - baked with --bake-lightmaps
+    centralLamp.castsShadows = true;          // Books and torches shadow it (the bake covers the room)
     addPointLight(centralLamp);
 
     // TORCH LIGHTS - Four moving flame lights
@@ -41,43 +77,92 @@ void LightingManager::setupLibraryLighting(float roomRadius, float roomHeight) {
             2.0f,                                   // Good intensity for cozy feel
             1.0f, 0.18f, 0.15f                     // Wider spread than central lamp
         );
+        torchLight.castsShadows = true;
         addPointLight(torchLight);
     }
 
+    sceneLights = pointLights.size();
+    markDirty();
     std::cout << "Total lights: " << pointLights.size() << std::endl;
 }
 
-void LightingManager::updateTorchPositions(const std::vector<glm::vec3>& torchPositions) {
-    // Sync light positions with animated torch objects (skip index 0 which is the central lamp)
-    int torchesUpdated = 0;
-    for (int i = 0; i < torchPositions.size() && (i + 1) < pointLights.size(); i++) {
-        pointLights[i + 1].position = torchPositions[i];  // Update torch light position
-        torchesUpdated++;
+void LightingManager::addTorchWing(int count, float roomRadius, float roomHeight) {
+    // Sconces spread over the walls on a golden-angle spiral, dim and short-ranged (~1 m),
+    // so any one surface is lit by a handful of them
+    const float goldenAngle = 2.39996323f;
+    for (int i = 0; i < count; i++) {
+        float angle = goldenAngle * static_cast<float>(i);
+        float height = 0.4f + (roomHeight - 0.8f) * (static_cast<float>(i) + 0.5f) / static_cast<float>(count);
+        glm::vec3 position(0.95f * roomRadius * cos(angle), height, 0.95f * roomRadius * sin(angle));
+        addPointLight(PointLight(position, glm::vec3(1.0f, 0.55f, 0.2f), 0.3f, 1.0f, 1.0f, 4.0f));
     }
+    std::cout << "Torch wing: " << count << " lights, total " << pointLights.size() << std::endl;
 }
 
-void LightingManager::bindToShader(Shader& shader) const {
-    // Send ambient lighting to shader
-    shader.setVec3("ambientColor", ambientColor.x, ambientColor.y, ambientColor.z);
-    shader.setFloat("ambientStrength", ambientStrength);
-
-    // Send number of lights (clamped to shader maximum)
-    int numPointLights = std::min(static_cast<int>(pointLights.size()), 32);
-    shader.setInt("numPointLights", numPointLights);
-
-    // Send each point light's properties to shader array
-    for (int i = 0; i < numPointLights; i++) {
-        std::string base = "pointLights[" + std::to_string(i) + "]";
-        const auto& light = pointLights[i];
-
-        // Upload light properties
-        shader.setVec3(base + ".position", light.position.x, light.position.y, light.position.z);
-        shader.setVec3(base + ".color", light.color.x, light.color.y, light.color.z);
-        shader.setFloat(base + ".intensity", light.intensity);
-        shader.setFloat(base + ".constant", light.constant);    // Distance attenuation factors
-        shader.setFloat(base + ".linear", light.linear);
-        shader.setFloat(base + ".quadratic", light.quadratic);
+int LightingManager::getStaticLightCount() const {
+    // Static lights come first, so shaders skip them by index
+    int count = 0;
+    while (count < static_cast<int>(pointLights.size()) && pointLights[count].isStatic) count++;
+    return count;
+}
+
+const std::vector<int>& LightingManager::getShadowSlots() const {
+    // Rows go to the shadowed lights in order, among the lights the shaders see
+    // (recomputed only when the setup changed - animation doesn't move rows)
+    if (slotsVersion == setupVersion) return shadowSlots;
+    slotsVersion = setupVersion;
+    shadowSlots.assign(pointLights.size(), -1);
+    if (!shadows) return shadowSlots;
+    int next = 0;
+    for (int i = 0; i < getActiveLightCount() && next < MAX_SHADOWED_LIGHTS; i++) {
+        if (pointLights[i].castsShadows) shadowSlots[i] = next++;
     }
+    return shadowSlots;
+}
+
+void LightingManager::updateUniformBuffer() {
+    if (!uniformBuffer) {
+        glGenBuffers(1, &uniformBuffer);
+        glBindBuffer(GL_UNIFORM_BUFFER, uniformBuffer);
+        glBufferData(GL_UNIFORM_BUFFER, sizeof(LightingData), nullptr, GL_DYNAMIC_DRAW);
+        GpuMemory::allocate(GpuMemoryCategory::Buffers, sizeof(LightingData));
+    }
+
+    // Rewritten only when something changed since the last upload
+    if (uploadedVersion != version) {
+        LightingData data = {};
+        data.ambientColor = ambientColor;
+        data.ambientStrength = ambientStrength;
+        data.numPointLights = getActiveLightCount();
+        const std::vector<int>& slots = getShadowSlots();
+        for (int i = 0; i < data.numPointLights; i++) {
+            const PointLight& light = pointLights[i];
+            GpuPointLight& gpu = data.pointLights[i];
+            gpu.position = light.position;
+            gpu.color = light.color;
+            gpu.intensity = light.intensity;
+            gpu.constant = light.constant;    // Distance attenuation factors
+            gpu.linear = light.linear;
+            gpu.quadratic = light.quadratic;
+            gpu.shadowSlot = slots[i];
+        }
+
+        glBindBuffer(GL_UNIFORM_BUFFER, uniformBuffer);
+        glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(data), &data);
+        glBindBuffer(GL_UNIFORM_BUFFER, 0);
+        uploadedVersion = version;
+    }
+
+    // Binding is context state, but other code may reuse the binding point
+    glBindBufferBase(GL_UNIFORM_BUFFER, UniformBuffers::LIGHTING_BINDING, uniformBuffer);
+}
+
+void LightingManager::cleanup() {
+    if (!uniformBuffer) return;
+    glDeleteBuffers(1, &uniformBuffer);
+    GpuMemory::release(GpuMemoryCategory::Buffers, sizeof(LightingData));
+    uniformBuffer = 0;
+    uploadedVersion = 0;
 }
 
 void LightingManager::setDramaticMode(bool enabled) {
@@ -92,7 +177,7 @@ void LightingManager::setDramaticMode(bool enabled) {
         }
 
         // Make torches warmer and brighter
-        for (int i = 1; i < pointLights.size(); i++) {
+        for (size_t i = 1; i < sceneLights; i++) {
             pointLights[i].color = glm::vec3(1.0f, 0.7f, 0.3f);  // Warmer orange
             pointLights[i].baseIntensity = 2.8f;
             pointLights[i].intensity = 2.8f;
@@ -113,7 +198,7 @@ void LightingManager::setDramaticMode(bool enabled) {
         }
 
         // Reset torches to normal
-        for (int i = 1; i < pointLights.size(); i++) {
+        for (size_t i = 1; i < sceneLights; i++) {
             pointLights[i].color = glm::vec3(1.0f, 0.6f, 0.2f);
             pointLights[i].baseIntensity = 2.0f;
             pointLights[i].intensity = 2.0f;
@@ -123,6 +208,7 @@ void LightingManager::setDramaticMode(bool enabled) {
         ambientColor = glm::vec3(0.025f, 0.015f, 0.008f);
         ambientStrength = 0.12f;
     }
+    markDirty();
 }
 
 void LightingManager::setTorchIntensity(float intensity) {
@@ -132,10 +218,11 @@ void LightingManager::setTorchIntensity(float intensity) {
     std::cout << "Setting torch intensity to " << intensity << std::endl;
 
     // Update all torch lights (skip central lamp at index 0)
-    for (int i = 1; i < pointLights.size(); i++) {
+    for (size_t i = 1; i < sceneLights; i++) {
         pointLights[i].baseIntensity = intensity;
         pointLights[i].intensity = intensity;
     }
+    markDirty();
 }
 
 void LightingManager::setGlobalLightIntensity(float multiplier) {
@@ -146,23 +233,27 @@ void LightingManager::setGlobalLightIntensity(float multiplier) {
         float newIntensity = light.baseIntensity * multiplier;
         light.intensity = std::max(0.5f, std::min(newIntensity, 6.0f));  // Final clamp
     }
+    markDirty();
 }
 
 void LightingManager::setAmbientDarkness(float darkness) {
     // Adjust ambient strength based on darkness level
     float baseStrength = 0.12f;
     ambientStrength = std::max(0.02f, std::min(0.25f, baseStrength - darkness * 0.1f));
+    markDirty();
 }
 
 void LightingManager::setAmbientColor(const glm::vec3& color, float strength) {
     ambientColor = color;
     ambientStrength = std::max(0.02f, std::min(strength, 0.3f));  // Clamp strength
+    markDirty();
 }
 
 void LightingManager::updatePointLightColor(int lightIndex, const glm::vec3& color) {
     // Change specific light color (bounds checking)
     if (lightIndex >= 0 && lightIndex < pointLights.size()) {
         pointLights[lightIndex].color = color;
+        markDirty();
     }
 }
 
@@ -172,5 +263,6 @@ void LightingManager::updatePointLightIntensity(int lightIndex, float intensity)
         intensity = std::max(0.5f, std::min(intensity, 6.0f));  // Clamp
         pointLights[lightIndex].baseIntensity = intensity;
         pointLights[lightIndex].intensity = intensity;
+        markDirty();
     }
 }
\ No newline at end of file
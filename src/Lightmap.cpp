@@ -0,0 +1,136 @@
+#include "Lightmap.hpp"
+#include "LightingManager.hpp"
+#include "GpuMemory.hpp"
+#include "scene.hpp"
+#include <iostream>
+
+// Static member definitions - atlas texture and what the bake was made for
+const char* const Lightmap::FILE_PATH = "library.lmap";
+GLuint Lightmap::texture = 0;
+size_t Lightmap::textureBytes = 0;
+LightmapData Lightmap::data;
+bool Lightmap::attached = false;
+bool Lightmap::active = false;
+int Lightmap::staticLightCount = 0;
+uint64_t Lightmap::checkedVersion = 0;
+
+namespace {
+    const GLint LIGHTMAP_UNIT = 10;  // After the cluster buffers (7-9)
+}
+
+bool Lightmap::load(const std::string& path) {
+    if (!data.load(path)) {
+        std::cout << "No lightmap (" << path << "), static lights stay dynamic - bake with --bake-lightmaps" << std::endl;
+        return false;
+    }
+
+    // Linear irradiance, filtered but without mips (they would blend neighbouring charts)
+    glGenTextures(1, &texture);
+    glBindTexture(GL_TEXTURE_2D, texture);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA16F, data.width, data.height, 0, GL_RGBA, GL_HALF_FLOAT, data.texels.data());
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    textureBytes = size_t(data.width) * data.height * 4 * sizeof(uint16_t);
+    GpuMemory::allocate(GpuMemoryCategory::Textures, textureBytes);
+    data.texels.clear();
+    data.texels.shrink_to_fit();
+    std::cout << "Lightmap: " << data.width << "x" << data.height << " atlas, "
+        << data.instances.size() << " static objects, " << data.probes.valid.size() << " probes" << std::endl;
+    return true;
+}
+
+void Lightmap::shutdown() {
+    if (texture) {
+        glDeleteTextures(1, &texture);
+        GpuMemory::release(GpuMemoryCategory::Textures, textureBytes);
+    }
+    texture = 0;
+    textureBytes = 0;
+    data = LightmapData();
+    attached = active = false;
+    checkedVersion = 0;
+}
+
+bool Lightmap::attach(Scene& scene) {
+    if (!texture || attached) return attached;
+
+    // Same meshes and placements as at bake time (vertex counts and exact model matrices).
+    // Meshes the baker couldn't load have no coordinates and stay dynamically lit.
+    bool matches = scene.objects.size() >= data.instances.size();
+    std::vector<uint32_t> vertexCounts, instanceMeshes;
+    std::vector<glm::mat4> transforms;
+    for (const LightmapData::Mesh& mesh : data.meshes) vertexCounts.push_back(mesh.vertexCount);
+    for (size_t i = 0; matches && i < data.instances.size(); i++) {
+        const SceneObject& object = scene.objects[i];
+        const LightmapData::Mesh& mesh = data.meshes[data.instances[i].mesh];
+        matches = mesh.coords.empty() || object.model->vertexCount == mesh.vertexCount;
+        instanceMeshes.push_back(data.instances[i].mesh);
+        transforms.push_back(object.modelMatrix);
+    }
+    if (!matches || LightmapBaker::layoutSignature(vertexCounts, instanceMeshes, transforms) != data.layoutSignature) {
+        std::cout << "Lightmap was baked for another layout, rebake with --bake-lightmaps" << std::endl;
+        shutdown();
+        return false;
+    }
+
+    // Coordinates once per mesh, the atlas rectangle per object
+    for (size_t i = 0; i < data.instances.size(); i++) {
+        SceneObject& object = scene.objects[i];
+        const LightmapData::Instance& instance = data.instances[i];
+        const LightmapData::Mesh& mesh = data.meshes[instance.mesh];
+        if (mesh.coords.empty()) continue;
+        if (!object.model->lightmapVBO) {
+            for (const ModelRef& model : scene.models) {
+                if (model.get() == object.model) model->setLightmapCoords(mesh.coords.data(), mesh.vertexCount);
+            }
+        }
+        object.lightmapped = object.model->lightmapVBO != 0;
+        object.lightmapScaleOffset = instance.scaleOffset;
+    }
+    data.meshes.clear();
+    attached = true;
+    checkedVersion = 0;
+    return true;
+}
+
+std::vector<BakeLight> Lightmap::bakeLights(const LightingManager& lightingManager) {
+    std::vector<BakeLight> lights;
+    for (int i = 0; i < lightingManager.getStaticLightCount(); i++) {
+        const PointLight& light = lightingManager.pointLights[i];
+        lights.push_back({ light.position, light.color, light.intensity, light.constant, light.linear, light.quadratic });
+    }
+    return lights;
+}
+
+glm::vec3 Lightmap::bakeAmbient(const LightingManager& lightingManager) {
+    return lightingManager.ambientColor * lightingManager.ambientStrength;
+}
+
+void Lightmap::updateLights(const LightingManager& lightingManager) {
+    if (!attached || checkedVersion == lightingManager.getSetupVersion()) return;
+    checkedVersion = lightingManager.getSetupVersion();  // Animation never touches the static lights
+
+    bool wasActive = active;
+    staticLightCount = lightingManager.getStaticLightCount();
+    active = staticLightCount <= LightingManager::MAX_POINT_LIGHTS &&
+        LightmapBaker::lightSignature(bakeLights(lightingManager), bakeAmbient(lightingManager)) == data.lightSignature;
+    if (active != wasActive) {
+        std::cout << "Lightmap " << (active ? "in use" : "doesn't match the static lights, lighting them dynamically") << std::endl;
+    }
+}
+
+void Lightmap::setupSamplers(const Shader& shader) {
+    shader.use();
+    shader.setInt("lightmap"_uniform, LIGHTMAP_UNIT);
+}
+
+void Lightmap::bindTexture() {
+    if (!active) return;
+    glActiveTexture(GL_TEXTURE0 + LIGHTMAP_UNIT);
+    glBindTexture(GL_TEXTURE_2D, texture);
+    glActiveTexture(GL_TEXTURE0);
+}
@@ -0,0 +1,1092 @@
+#include "LightmapBaker.hpp"
+#include "AssetArchive.hpp"
+#include <glm/gtc/packing.hpp>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <numeric>
+#include <thread>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define LIGHTMAP_SSE2 1
+#include <emmintrin.h>
+#endif
+
+namespace {
+    const uint32_t FILE_MAGIC = 0x50414D4C;     // "LMAP"
+    const uint32_t FILE_VERSION = 2;            // Bump when the file layout changes
+    const float CHART_NORMAL_COS = 0.85f;       // Triangles join a chart within ~32 degrees of its first one
+    const int CHART_PADDING = 1;                // Texels around every chart, filled by dilation (bilinear footprint)
+    const float SURFACE_OFFSET = 1e-3f;         // Ray origins are pushed this far off the surface
+    const uint32_t NO_TRIANGLE = 0xFFFFFFFFu;
+    const float PROBE_BACKFACE_LIMIT = 0.25f;   // A probe seeing more back faces than this is inside geometry
+
+    // ---- Unwrapping ----
+
+    // A mesh's UV2 layout in texels at the bake density (per vertex, flattened like MeshData)
+    struct MeshLayout {
+        glm::ivec2 size = glm::ivec2(0);
+        std::vector<glm::vec2> texelCoords;
+    };
+
+    struct Chart {
+        std::vector<uint32_t> triangles;
+        glm::vec3 axisU, axisV;
+        glm::vec2 min, max;         // Projected bounds in meters
+        glm::ivec2 size, origin;    // Texels including padding, position in the layout
+    };
+
+    // Row-by-row shelf packing of rectangles into a given width, tallest first.
+    // Returns the height used; order ties break on index so the layout is reproducible.
+    int packShelves(const std::vector<glm::ivec2>& sizes, int width, std::vector<glm::ivec2>& origins) {
+        std::vector<uint32_t> order(sizes.size());
+        std::iota(order.begin(), order.end(), 0u);
+        std::sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) {
+            if (sizes[a].y != sizes[b].y) return sizes[a].y > sizes[b].y;
+            if (sizes[a].x != sizes[b].x) return sizes[a].x > sizes[b].x;
+            return a < b;
+            });
+
+        origins.assign(sizes.size(), glm::ivec2(0));
+        int x = 0, y = 0, shelfHeight = 0;
+        for (uint32_t index : order) {
+            if (x > 0 && x + sizes[index].x > width) {
+                x = 0;
+                y += shelfHeight;
+                shelfHeight = 0;
+            }
+            origins[index] = glm::ivec2(x, y);
+            x += sizes[index].x;
+            shelfHeight = std::max(shelfHeight, sizes[index].y);
+        }
+        return y + shelfHeight;
+    }
+
+    // Same id for every vertex at exactly the same position (flattened meshes repeat shared corners)
+    std::vector<uint32_t> weldPositions(const MeshData& mesh) {
+        size_t count = mesh.vertexCount();
+        const float* v = mesh.vertices.data();
+        std::vector<uint32_t> order(count);
+        std::iota(order.begin(), order.end(), 0u);
+        std::sort(order.begin(), order.end(), [v](uint32_t a, uint32_t b) {
+            for (int c = 0; c < 3; c++) {
+                if (v[a * 8 + c] != v[b * 8 + c]) return v[a * 8 + c] < v[b * 8 + c];
+            }
+            return a < b;
+            });
+
+        std::vector<uint32_t> ids(count);
+        uint32_t id = 0;
+        for (size_t i = 0; i < count; i++) {
+            if (i > 0 && std::memcmp(&v[order[i] * 8], &v[order[i - 1] * 8], 3 * sizeof(float)) != 0) id++;
+            ids[order[i]] = id;
+        }
+        return ids;
+    }
+
+    // Cut the mesh into charts of edge-connected triangles facing roughly the same way, project each
+    // onto its plane (in the space of linear, the instance's scale and rotation) and pack them
+    MeshLayout unwrapMesh(const MeshData& mesh, const glm::mat3& linear, float texelsPerMeter) {
+        MeshLayout layout;
+        size_t triangleCount = mesh.vertexCount() / 3;
+        if (triangleCount == 0) return layout;
+
+        std::vector<glm::vec3> positions(triangleCount * 3);
+        std::vector<glm::vec3> faceNormals(triangleCount);
+        for (size_t t = 0; t < triangleCount; t++) {
+            for (int k = 0; k < 3; k++) {
+                const float* p = &mesh.vertices[(t * 3 + k) * 8];
+                positions[t * 3 + k] = linear * glm::vec3(p[0], p[1], p[2]);
+            }
+            glm::vec3 n = glm::cross(positions[t * 3 + 1] - positions[t * 3], positions[t * 3 + 2] - positions[t * 3]);
+            float length = glm::length(n);
+            faceNormals[t] = length > 1e-12f ? n / length : glm::vec3(0.0f);
+        }
+
+        // Triangles sharing an edge (welded corners)
+        std::vector<uint32_t> ids = weldPositions(mesh);
+        std::vector<std::pair<uint64_t, uint32_t>> edges;
+        edges.reserve(triangleCount * 3);
+        for (uint32_t t = 0; t < triangleCount; t++) {
+            for (int k = 0; k < 3; k++) {
+                uint64_t a = ids[t * 3 + k], b = ids[t * 3 + (k + 1) % 3];
+                if (a == b) continue;
+                edges.emplace_back(std::min(a, b) << 32 | std::max(a, b), t);
+            }
+        }
+        std::sort(edges.begin(), edges.end());
+        std::vector<std::vector<uint32_t>> neighbours(triangleCount);
+        for (size_t first = 0; first < edges.size();) {
+            size_t last = first;
+            while (last < edges.size() && edges[last].first == edges[first].first) last++;
+            for (size_t i = first; i < last; i++) {
+                for (size_t j = first; j < last; j++) {
+                    if (i != j) neighbours[edges[i].second].push_back(edges[j].second);
+                }
+            }
+            first = last;
+        }
+
+        // Grow charts from the lowest unassigned triangle
+        std::vector<Chart> charts;
+        std::vector<int32_t> chartOf(triangleCount, -1);
+        std::vector<uint32_t> queue;
+        for (uint32_t seed = 0; seed < triangleCount; seed++) {
+            if (chartOf[seed] >= 0) continue;
+            Chart chart;
+            glm::vec3 normal = faceNormals[seed] != glm::vec3(0.0f) ? faceNormals[seed] : glm::vec3(0.0f, 1.0f, 0.0f);
+            chartOf[seed] = static_cast<int32_t>(charts.size());
+            queue.assign(1, seed);
+            for (size_t head = 0; head < queue.size(); head++) {
+                uint32_t t = queue[head];
+                chart.triangles.push_back(t);
+                for (uint32_t next : neighbours[t]) {
+                    if (chartOf[next] >= 0) continue;
+                    bool degenerate = faceNormals[next] == glm::vec3(0.0f);
+                    if (!degenerate && glm::dot(faceNormals[next], normal) < CHART_NORMAL_COS) continue;
+                    chartOf[next] = chartOf[seed];
+                    queue.push_back(next);
+                }
+            }
+
+            // Plane axes and projected bounds
+            glm::vec3 reference = std::abs(normal.y) < 0.9f ? glm::vec3(0.0f, 1.0f, 0.0f) : glm::vec3(1.0f, 0.0f, 0.0f);
+            chart.axisU = glm::normalize(glm::cross(reference, normal));
+            chart.axisV = glm::cross(normal, chart.axisU);
+            chart.min = glm::vec2(1e30f);
+            chart.max = glm::vec2(-1e30f);
+            for (uint32_t t : chart.triangles) {
+                for (int k = 0; k < 3; k++) {
+                    glm::vec2 p(glm::dot(positions[t * 3 + k], chart.axisU), glm::dot(positions[t * 3 + k], chart.axisV));
+                    chart.min = glm::min(chart.min, p);
+                    chart.max = glm::max(chart.max, p);
+                }
+            }
+            glm::vec2 extent = (chart.max - chart.min) * texelsPerMeter;
+            chart.size = glm::ivec2(static_cast<int>(std::ceil(extent.x)), static_cast<int>(std::ceil(extent.y)));
+            chart.size = glm::max(chart.size, glm::ivec2(1)) + 2 * CHART_PADDING;
+            charts.push_back(std::move(chart));
+        }
+
+        // Pack into a roughly square layout
+        std::vector<glm::ivec2> sizes(charts.size());
+        double area = 0.0;
+        int widest = 0;
+        for (size_t c = 0; c < charts.size(); c++) {
+            sizes[c] = charts[c].size;
+            area += double(sizes[c].x) * sizes[c].y;
+            widest = std::max(widest, sizes[c].x);
+        }
+        int width = std::max(widest, static_cast<int>(std::ceil(std::sqrt(area) * 1.1)));
+        std::vector<glm::ivec2> origins;
+        layout.size = glm::ivec2(width, packShelves(sizes, width, origins));
+
+        layout.texelCoords.resize(triangleCount * 3);
+        for (size_t c = 0; c < charts.size(); c++) {
+            const Chart& chart = charts[c];
+            glm::vec2 origin = glm::vec2(origins[c] + CHART_PADDING);
+            for (uint32_t t : chart.triangles) {
+                for (int k = 0; k < 3; k++) {
+                    glm::vec2 p(glm::dot(positions[t * 3 + k], chart.axisU), glm::dot(positions[t * 3 + k], chart.axisV));
+                    layout.texelCoords[t * 3 + k] = origin + (p - chart.min) * texelsPerMeter;
+                }
+            }
+        }
+        return layout;
+    }
+
+    // ---- Ray tracing ----
+
+    // Four triangles tested against one ray at once (structure of arrays, one SSE lane each)
+    struct TrianglePacket {
+        float v0[3][4];
+        float e1[3][4];
+        float e2[3][4];
+        uint32_t triangle[4];  // World triangle, NO_TRIANGLE = empty lane (zero edges never hit)
+    };
+
+    struct BvhNode {
+        glm::vec3 min;
+        uint32_t index;  // Leaf: packet, inner: second child (first child follows the node)
+        glm::vec3 max;
+        uint32_t leaf;
+    };
+
+    struct Hit {
+        float t;
+        uint32_t triangle;
+    };
+
+    // Every static triangle in world space
+    class BakeScene {
+    public:
+        std::vector<glm::vec3> vertices;      // 3 per triangle
+        std::vector<glm::vec3> frontNormals;  // Per triangle, from the mesh's vertex normals (winding isn't reliable)
+        std::vector<uint32_t> instanceOf;     // Per triangle
+
+        void build() {
+            size_t count = instanceOf.size();
+            std::vector<uint32_t> triangles(count);
+            std::iota(triangles.begin(), triangles.end(), 0u);
+            centroids.resize(count);
+            for (size_t t = 0; t < count; t++) {
+                centroids[t] = (vertices[t * 3] + vertices[t * 3 + 1] + vertices[t * 3 + 2]) / 3.0f;
+            }
+            nodes.reserve(count / 2 + 1);
+            if (count > 0) buildNode(triangles, 0, count);
+        }
+
+        // Closest hit closer than tMax
+        bool intersect(const glm::vec3& origin, const glm::vec3& direction, float tMax, Hit& hit) const {
+            return traverse(origin, direction, tMax, false, hit);
+        }
+
+        // Anything closer than tMax
+        bool occluded(const glm::vec3& origin, const glm::vec3& direction, float tMax) const {
+            Hit hit;
+            return traverse(origin, direction, tMax, true, hit);
+        }
+
+        glm::vec3 faceNormal(uint32_t triangle) const {
+            const glm::vec3* v = &vertices[triangle * 3];
+            glm::vec3 n = glm::cross(v[1] - v[0], v[2] - v[0]);
+            float length = glm::length(n);
+            return length > 1e-12f ? n / length : glm::vec3(0.0f, 1.0f, 0.0f);
+        }
+
+        // Ray hits the side the mesh's normals point away from
+        bool isBackFace(uint32_t triangle, const glm::vec3& direction) const {
+            return glm::dot(frontNormals[triangle], direction) > 0.0f;
+        }
+
+        size_t getNodeCount() const { return nodes.size(); }
+
+    private:
+        std::vector<BvhNode> nodes;
+        std::vector<TrianglePacket> packets;
+        std::vector<glm::vec3> centroids;
+
+        // Top-down build down to one packet (up to four triangles) per leaf
+        void buildNode(std::vector<uint32_t>& triangles, size_t begin, size_t end) {
+            size_t nodeIndex = nodes.size();
+            nodes.push_back(BvhNode());
+            glm::vec3 boundsMin(1e30f), boundsMax(-1e30f), centroidMin(1e30f), centroidMax(-1e30f);
+            for (size_t i = begin; i < end; i++) {
+                uint32_t t = triangles[i];
+                for (int k = 0; k < 3; k++) {
+                    boundsMin = glm::min(boundsMin, vertices[t * 3 + k]);
+                    boundsMax = glm::max(boundsMax, vertices[t * 3 + k]);
+                }
+                centroidMin = glm::min(centroidMin, centroids[t]);
+                centroidMax = glm::max(centroidMax, centroids[t]);
+            }
+            nodes[nodeIndex].min = boundsMin;
+            nodes[nodeIndex].max = boundsMax;
+
+            if (end - begin <= 4) {
+                TrianglePacket packet = {};
+                for (int lane = 0; lane < 4; lane++) {
+                    packet.triangle[lane] = NO_TRIANGLE;
+                    if (begin + lane >= end) continue;
+                    uint32_t t = triangles[begin + lane];
+                    glm::vec3 e1 = vertices[t * 3 + 1] - vertices[t * 3];
+                    glm::vec3 e2 = vertices[t * 3 + 2] - vertices[t * 3];
+                    for (int c = 0; c < 3; c++) {
+                        packet.v0[c][lane] = vertices[t * 3][c];
+                        packet.e1[c][lane] = e1[c];
+                        packet.e2[c][lane] = e2[c];
+                    }
+                    packet.triangle[lane] = t;
+                }
+                nodes[nodeIndex].leaf = 1;
+                nodes[nodeIndex].index = static_cast<uint32_t>(packets.size());
+                packets.push_back(packet);
+                return;
+            }
+
+            // Binned surface area heuristic: the large wall and floor triangles overlap everything,
+            // a plain median split would put them in boxes most rays have to enter
+            const int BINS = 12;
+            float bestCost = 1e30f;
+            int bestAxis = -1, bestSplit = 0;
+            for (int axis = 0; axis < 3; axis++) {
+                float extent = centroidMax[axis] - centroidMin[axis];
+                if (extent <= 0.0f) continue;
+                glm::vec3 binMin[BINS], binMax[BINS];
+                int binCount[BINS] = {};
+                for (int b = 0; b < BINS; b++) {
+                    binMin[b] = glm::vec3(1e30f);
+                    binMax[b] = glm::vec3(-1e30f);
+                }
+                for (size_t i = begin; i < end; i++) {
+                    uint32_t t = triangles[i];
+                    int b = std::min(BINS - 1, static_cast<int>((centroids[t][axis] - centroidMin[axis]) / extent * BINS));
+                    binCount[b]++;
+                    for (int k = 0; k < 3; k++) {
+                        binMin[b] = glm::min(binMin[b], vertices[t * 3 + k]);
+                        binMax[b] = glm::max(binMax[b], vertices[t * 3 + k]);
+                    }
+                }
+
+                // Cost of splitting after bin s: area x count on both sides
+                float leftArea[BINS], rightArea[BINS];
+                int leftCount[BINS], rightCount[BINS];
+                glm::vec3 low(1e30f), high(-1e30f);
+                int count = 0;
+                for (int b = 0; b < BINS; b++) {
+                    count += binCount[b];
+                    if (binCount[b]) {
+                        low = glm::min(low, binMin[b]);
+                        high = glm::max(high, binMax[b]);
+                    }
+                    glm::vec3 size = glm::max(high - low, glm::vec3(0.0f));
+                    leftArea[b] = size.x * size.y + size.y * size.z + size.z * size.x;
+                    leftCount[b] = count;
+                }
+                low = glm::vec3(1e30f);
+                high = glm::vec3(-1e30f);
+                count = 0;
+                for (int b = BINS - 1; b > 0; b--) {
+                    count += binCount[b];
+                    if (binCount[b]) {
+                        low = glm::min(low, binMin[b]);
+                        high = glm::max(high, binMax[b]);
+                    }
+                    glm::vec3 size = glm::max(high - low, glm::vec3(0.0f));
+                    rightArea[b - 1] = size.x * size.y + size.y * size.z + size.z * size.x;
+                    rightCount[b - 1] = count;
+                }
+                for (int s = 0; s < BINS - 1; s++) {
+                    if (leftCount[s] == 0 || rightCount[s] == 0) continue;
+                    float cost = leftArea[s] * leftCount[s] + rightArea[s] * rightCount[s];
+                    if (cost < bestCost) {
+                        bestCost = cost;
+                        bestAxis = axis;
+                        bestSplit = s;
+                    }
+                }
+            }
+
+            size_t middle = begin + (end - begin) / 2;
+            if (bestAxis >= 0) {
+                float extent = centroidMax[bestAxis] - centroidMin[bestAxis];
+                auto split = std::partition(triangles.begin() + begin, triangles.begin() + end,
+                    [&](uint32_t t) {
+                        int b = std::min(BINS - 1, static_cast<int>((centroids[t][bestAxis] - centroidMin[bestAxis]) / extent * BINS));
+                        return b <= bestSplit;
+                    });
+                middle = static_cast<size_t>(split - triangles.begin());
+            }
+            else {
+                // Every centroid in one spot - any halving will do
+                std::sort(triangles.begin() + begin, triangles.begin() + end);
+            }
+
+            buildNode(triangles, begin, middle);
+            nodes[nodeIndex].leaf = 0;
+            nodes[nodeIndex].index = static_cast<uint32_t>(nodes.size());
+            buildNode(triangles, middle, end);
+        }
+
+        // Entry distance of the ray into a node's box, or a negative value if it misses within tMax
+        static float enterBox(const BvhNode& node, const glm::vec3& origin, const glm::vec3& inverse, float tMax) {
+            glm::vec3 t0 = (node.min - origin) * inverse;
+            glm::vec3 t1 = (node.max - origin) * inverse;
+            glm::vec3 tNear = glm::min(t0, t1), tFar = glm::max(t0, t1);
+            float enter = std::max(std::max(tNear.x, tNear.y), std::max(tNear.z, 0.0f));
+            float exit = std::min(std::min(tFar.x, tFar.y), std::min(tFar.z, tMax));
+            return enter <= exit ? enter : -1.0f;
+        }
+
+        // Moller-Trumbore against the packet's four triangles (two-sided, like the renderer).
+        // Returns the lane of the closest hit before tMax, or -1.
+        static int intersectPacket(const TrianglePacket& packet, const glm::vec3& origin, const glm::vec3& direction,
+            float tMax, float& tHit) {
+            float t[4];
+            int hitMask = 0;
+#ifdef LIGHTMAP_SSE2
+            const __m128 ox = _mm_set1_ps(origin.x), oy = _mm_set1_ps(origin.y), oz = _mm_set1_ps(origin.z);
+            const __m128 dx = _mm_set1_ps(direction.x), dy = _mm_set1_ps(direction.y), dz = _mm_set1_ps(direction.z);
+            const __m128 e1x = _mm_loadu_ps(packet.e1[0]), e1y = _mm_loadu_ps(packet.e1[1]), e1z = _mm_loadu_ps(packet.e1[2]);
+            const __m128 e2x = _mm_loadu_ps(packet.e2[0]), e2y = _mm_loadu_ps(packet.e2[1]), e2z = _mm_loadu_ps(packet.e2[2]);
+
+            // p = d x e2, det = e1 . p
+            __m128 px = _mm_sub_ps(_mm_mul_ps(dy, e2z), _mm_mul_ps(dz, e2y));
+            __m128 py = _mm_sub_ps(_mm_mul_ps(dz, e2x), _mm_mul_ps(dx, e2z));
+            __m128 pz = _mm_sub_ps(_mm_mul_ps(dx, e2y), _mm_mul_ps(dy, e2x));
+            __m128 det = _mm_add_ps(_mm_add_ps(_mm_mul_ps(e1x, px), _mm_mul_ps(e1y, py)), _mm_mul_ps(e1z, pz));
+            __m128 absDet = _mm_andnot_ps(_mm_set1_ps(-0.0f), det);
+            __m128 valid = _mm_cmpgt_ps(absDet, _mm_set1_ps(1e-12f));
+            __m128 inverse = _mm_div_ps(_mm_set1_ps(1.0f), _mm_or_ps(det, _mm_andnot_ps(valid, _mm_set1_ps(1.0f))));
+
+            // u from s = o - v0, v and t from q = s x e1
+            __m128 sx = _mm_sub_ps(ox, _mm_loadu_ps(packet.v0[0]));
+            __m128 sy = _mm_sub_ps(oy, _mm_loadu_ps(packet.v0[1]));
+            __m128 sz = _mm_sub_ps(oz, _mm_loadu_ps(packet.v0[2]));
+            __m128 u = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(sx, px), _mm_mul_ps(sy, py)), _mm_mul_ps(sz, pz)), inverse);
+            __m128 qx = _mm_sub_ps(_mm_mul_ps(sy, e1z), _mm_mul_ps(sz, e1y));
+            __m128 qy = _mm_sub_ps(_mm_mul_ps(sz, e1x), _mm_mul_ps(sx, e1z));
+            __m128 qz = _mm_sub_ps(_mm_mul_ps(sx, e1y), _mm_mul_ps(sy, e1x));
+            __m128 v = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, qx), _mm_mul_ps(dy, qy)), _mm_mul_ps(dz, qz)), inverse);
+            __m128 distance = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(e2x, qx), _mm_mul_ps(e2y, qy)), _mm_mul_ps(e2z, qz)), inverse);
+
+            const __m128 zero = _mm_setzero_ps();
+            valid = _mm_and_ps(valid, _mm_cmpge_ps(u, zero));
+            valid = _mm_and_ps(valid, _mm_cmpge_ps(v, zero));
+            valid = _mm_and_ps(valid, _mm_cmple_ps(_mm_add_ps(u, v), _mm_set1_ps(1.0f)));
+            valid = _mm_and_ps(valid, _mm_cmpgt_ps(distance, zero));
+            valid = _mm_and_ps(valid, _mm_cmplt_ps(distance, _mm_set1_ps(tMax)));
+            hitMask = _mm_movemask_ps(valid);
+            if (!hitMask) return -1;
+            _mm_storeu_ps(t, distance);
+#else
+            for (int lane = 0; lane < 4; lane++) {
+                glm::vec3 e1(packet.e1[0][lane], packet.e1[1][lane], packet.e1[2][lane]);
+                glm::vec3 e2(packet.e2[0][lane], packet.e2[1][lane], packet.e2[2][lane]);
+                glm::vec3 p = glm::cross(direction, e2);
+                float det = glm::dot(e1, p);
+                if (std::abs(det) <= 1e-12f) continue;
+                float inverse = 1.0f / det;
+                glm::vec3 s = origin - glm::vec3(packet.v0[0][lane], packet.v0[1][lane], packet.v0[2][lane]);
+                float u = glm::dot(s, p) * inverse;
+                glm::vec3 q = glm::cross(s, e1);
+                float v = glm::dot(direction, q) * inverse;
+                t[lane] = glm::dot(e2, q) * inverse;
+                if (u >= 0.0f && v >= 0.0f && u + v <= 1.0f && t[lane] > 0.0f && t[lane] < tMax) hitMask |= 1 << lane;
+            }
+            if (!hitMask) return -1;
+#endif
+            int closest = -1;
+            for (int lane = 0; lane < 4; lane++) {
+                if ((hitMask & (1 << lane)) && (closest < 0 || t[lane] < t[closest])) closest = lane;
+            }
+            tHit = t[closest];
+            return closest;
+        }
+
+        bool traverse(const glm::vec3& origin, const glm::vec3& direction, float tMax, bool anyHit, Hit& hit) const {
+            if (nodes.empty()) return false;
+            glm::vec3 inverse;
+            for (int c = 0; c < 3; c++) {
+                inverse[c] = 1.0f / (std::abs(direction[c]) > 1e-12f ? direction[c] : (direction[c] < 0.0f ? -1e-12f : 1e-12f));
+            }
+
+            bool found = false;
+            uint32_t stack[64];
+            int depth = 0;
+            if (enterBox(nodes[0], origin, inverse, tMax) < 0.0f) return false;
+            stack[depth++] = 0;
+            while (depth > 0) {
+                const BvhNode& node = nodes[stack[--depth]];
+                if (node.leaf) {
+                    const TrianglePacket& packet = packets[node.index];
+                    float t;
+                    int lane = intersectPacket(packet, origin, direction, tMax, t);
+                    if (lane < 0) continue;
+                    found = true;
+                    hit.t = tMax = t;
+                    hit.triangle = packet.triangle[lane];
+                    if (anyHit) return true;
+                    continue;
+                }
+
+                // Nearer child on top of the stack, children behind the closest hit skipped
+                uint32_t first = static_cast<uint32_t>(&node - nodes.data()) + 1, second = node.index;
+                float enterFirst = enterBox(nodes[first], origin, inverse, tMax);
+                float enterSecond = enterBox(nodes[second], origin, inverse, tMax);
+                if (enterFirst >= 0.0f && enterSecond >= 0.0f && enterSecond < enterFirst) {
+                    std::swap(first, second);
+                    std::swap(enterFirst, enterSecond);
+                }
+                if (enterSecond >= 0.0f) stack[depth++] = second;
+                if (enterFirst >= 0.0f) stack[depth++] = first;
+            }
+            return found;
+        }
+    };
+
+    // ---- Sampling ----
+
+    // Integer hash (lowbias32) - seeds each texel's sequence from its index alone
+    uint32_t hashInteger(uint32_t x) {
+        x ^= x >> 16;
+        x *= 0x7feb352du;
+        x ^= x >> 15;
+        x *= 0x846ca68bu;
+        x ^= x >> 16;
+        return x;
+    }
+
+    float radicalInverse(uint32_t bits) {
+        bits = (bits << 16) | (bits >> 16);
+        bits = ((bits & 0x55555555u) << 1) | ((bits & 0xAAAAAAAAu) >> 1);
+        bits = ((bits & 0x33333333u) << 2) | ((bits & 0xCCCCCCCCu) >> 2);
+        bits = ((bits & 0x0F0F0F0Fu) << 4) | ((bits & 0xF0F0F0F0u) >> 4);
+        bits = ((bits & 0x00FF00FFu) << 8) | ((bits & 0xFF00FF00u) >> 8);
+        return static_cast<float>(bits) * 2.3283064365386963e-10f;
+    }
+
+    // Cosine-weighted direction around normal from a 2D sample in [0,1)
+    glm::vec3 cosineDirection(const glm::vec3& normal, float r1, float r2) {
+        float sign = normal.z >= 0.0f ? 1.0f : -1.0f;
+        float a = -1.0f / (sign + normal.z);
+        float b = normal.x * normal.y * a;
+        glm::vec3 tangent(1.0f + sign * normal.x * normal.x * a, sign * b, -sign * normal.x);
+        glm::vec3 bitangent(b, sign + normal.y * normal.y * a, -normal.y);
+
+        float radius = std::sqrt(r1);
+        float phi = 6.28318530718f * r2;
+        return glm::normalize(tangent * (radius * std::cos(phi)) + bitangent * (radius * std::sin(phi))
+            + normal * std::sqrt(std::max(0.0f, 1.0f - r1)));
+    }
+
+    // Irradiance from the static lights at a point, with shadow rays (standard.frag's diffuse term without albedo)
+    glm::vec3 directLight(const BakeScene& scene, const std::vector<BakeLight>& lights,
+        const glm::vec3& position, const glm::vec3& normal) {
+        glm::vec3 result(0.0f);
+        glm::vec3 origin = position + normal * SURFACE_OFFSET;
+        for (const BakeLight& light : lights) {
+            glm::vec3 toLight = light.position - position;
+            float distance = glm::length(toLight);
+            if (distance <= SURFACE_OFFSET) continue;
+            glm::vec3 direction = toLight / distance;
+            float cosine = glm::dot(normal, direction);
+            if (cosine <= 0.0f) continue;
+            if (scene.occluded(origin, direction, distance - SURFACE_OFFSET)) continue;
+            float attenuation = light.intensity / (light.constant + light.linear * distance + light.quadratic * distance * distance);
+            result += light.color * (attenuation * cosine);
+        }
+        return result;
+    }
+
+    // Atlas texel to bake: a point on one triangle of one instance
+    struct TexelSurface {
+        uint32_t texel;
+        uint32_t instance;
+        uint32_t triangle;  // Within the instance's mesh
+        glm::vec2 barycentric;
+    };
+
+    // Run work(index, rays) for every index on every core, in chunks, printing progress.
+    // Returns the number of rays the work reported.
+    template <typename Work>
+    uint64_t parallelFor(size_t count, unsigned int threadCount, const Work& work) {
+        const size_t CHUNK = 64;
+        std::atomic<size_t> nextChunk(0);
+        std::atomic<uint64_t> rayCount(0);
+        std::mutex doneMutex;
+        std::condition_variable doneSignal;
+        unsigned int running = threadCount;
+        auto worker = [&]() {
+            uint64_t rays = 0;
+            for (;;) {
+                size_t first = nextChunk.fetch_add(CHUNK);
+                if (first >= count) break;
+                size_t last = std::min(first + CHUNK, count);
+                for (size_t i = first; i < last; i++) work(i, rays);
+            }
+            rayCount += rays;
+            std::lock_guard<std::mutex> lock(doneMutex);
+            if (--running == 0) doneSignal.notify_one();
+        };
+
+        std::vector<std::thread> threads;
+        for (unsigned int i = 0; i < threadCount; i++) threads.emplace_back(worker);
+
+        // Progress while the workers run - woken as soon as the last one finishes
+        size_t reported = 0;
+        std::unique_lock<std::mutex> lock(doneMutex);
+        while (!doneSignal.wait_for(lock, std::chrono::milliseconds(500), [&]() { return running == 0; })) {
+            size_t percent = std::min(nextChunk.load(), count) * 100 / std::max<size_t>(count, 1);
+            if (percent >= reported + 10) {
+                reported = percent - percent % 10;
+                std::cout << "  " << reported << "%" << std::endl;
+            }
+        }
+        lock.unlock();
+        for (auto& thread : threads) thread.join();
+        return rayCount.load();
+    }
+
+    // ---- Irradiance probes ----
+
+    // Real L2 spherical harmonics basis for a unit direction (standard.frag's probe order)
+    void shBasis(const glm::vec3& d, float basis[IrradianceProbes::COEFFICIENTS]) {
+        basis[0] = 0.282095f;
+        basis[1] = 0.488603f * d.y;
+        basis[2] = 0.488603f * d.z;
+        basis[3] = 0.488603f * d.x;
+        basis[4] = 1.092548f * d.x * d.y;
+        basis[5] = 1.092548f * d.y * d.z;
+        basis[6] = 0.315392f * (3.0f * d.z * d.z - 1.0f);
+        basis[7] = 1.092548f * d.x * d.z;
+        basis[8] = 0.546274f * (d.x * d.x - d.y * d.y);
+    }
+
+    // Clamped cosine lobe per band (Ramamoorthi & Hanrahan) - turns radiance coefficients into irradiance
+    const float COSINE_LOBE[IrradianceProbes::COEFFICIENTS] = {
+        3.141593f, 2.094395f, 2.094395f, 2.094395f, 0.785398f, 0.785398f, 0.785398f, 0.785398f, 0.785398f
+    };
+
+    // Uniform direction on the sphere from a 2D sample in [0,1)
+    glm::vec3 sphereDirection(float r1, float r2) {
+        float z = 1.0f - 2.0f * r1;
+        float radius = std::sqrt(std::max(0.0f, 1.0f - z * z));
+        float phi = 6.28318530718f * r2;
+        return glm::vec3(radius * std::cos(phi), radius * std::sin(phi), z);
+    }
+
+    // One probe per grid point over the scene's bounds. Point lights are projected as the
+    // directions they arrive from; the rays gather what lit surfaces reflect and the ambient
+    // light of open directions, in the same units as the lightmap texels.
+    uint64_t bakeProbes(const BakeScene& scene, const std::vector<BakeInstance>& instances,
+        const std::vector<BakeLight>& lights, const glm::vec3& ambient, const BakeSettings& settings,
+        unsigned int threadCount, IrradianceProbes& probes) {
+        const int N = IrradianceProbes::COEFFICIENTS;
+        glm::vec3 low(1e30f), high(-1e30f);
+        for (const glm::vec3& vertex : scene.vertices) {
+            low = glm::min(low, vertex);
+            high = glm::max(high, vertex);
+        }
+
+        probes = IrradianceProbes();
+        probes.spacing = std::max(settings.probeSpacing, 0.1f);
+        probes.size = glm::uvec3(glm::ceil((high - low) / probes.spacing)) + 1u;
+        probes.origin = (low + high) * 0.5f - glm::vec3(probes.size - 1u) * (probes.spacing * 0.5f);
+        size_t count = size_t(probes.size.x) * probes.size.y * probes.size.z;
+        probes.coefficients.assign(count * N, glm::vec3(0.0f));
+        probes.valid.assign(count, 0);
+
+        const int samples = std::max(settings.probeSamples, 1);
+        std::cout << "Probes: " << probes.size.x << "x" << probes.size.y << "x" << probes.size.z
+            << " every " << probes.spacing << " m" << std::endl;
+
+        return parallelFor(count, threadCount, [&](size_t p, uint64_t& rays) {
+            glm::uvec3 cell(p % probes.size.x, (p / probes.size.x) % probes.size.y, p / (size_t(probes.size.x) * probes.size.y));
+            glm::vec3 position = probes.origin + glm::vec3(cell) * probes.spacing;
+            glm::vec3* out = &probes.coefficients[p * N];
+            float basis[N];
+
+            for (const BakeLight& light : lights) {
+                glm::vec3 toLight = light.position - position;
+                float distance = glm::length(toLight);
+                if (distance <= SURFACE_OFFSET) continue;
+                glm::vec3 direction = toLight / distance;
+                rays++;
+                if (scene.occluded(position, direction, distance - SURFACE_OFFSET)) continue;
+                float attenuation = light.intensity / (light.constant + light.linear * distance + light.quadratic * distance * distance);
+                shBasis(direction, basis);
+                for (int k = 0; k < N; k++) out[k] += light.color * (attenuation * COSINE_LOBE[k] * basis[k]);
+            }
+
+            // Monte Carlo projection: 4 pi / samples per ray, over pi for radiance -> irradiance
+            uint32_t seed = hashInteger(static_cast<uint32_t>(p));
+            float rotateU = (seed & 0xFFFFu) / 65536.0f, rotateV = (seed >> 16) / 65536.0f;
+            float weight = 4.0f / static_cast<float>(samples);
+            int backFaces = 0;
+            for (int i = 0; i < samples; i++) {
+                float r1 = std::fmod((i + 0.5f) / samples + rotateU, 1.0f);
+                float r2 = std::fmod(radicalInverse(static_cast<uint32_t>(i)) + rotateV, 1.0f);
+                glm::vec3 direction = sphereDirection(r1, r2);
+
+                Hit hit;
+                rays++;
+                glm::vec3 radiance = ambient;
+                if (scene.intersect(position, direction, 1e30f, hit)) {
+                    if (hit.t <= settings.occlusionDistance) radiance = glm::vec3(0.0f);
+                    if (scene.isBackFace(hit.triangle, direction)) {
+                        backFaces++;
+                        radiance = glm::vec3(0.0f);
+                    }
+                    else {
+                        glm::vec3 hitNormal = scene.faceNormal(hit.triangle);
+                        if (glm::dot(hitNormal, direction) > 0.0f) hitNormal = -hitNormal;
+                        glm::vec3 hitPosition = position + direction * hit.t;
+                        radiance += instances[scene.instanceOf[hit.triangle]].albedo * directLight(scene, lights, hitPosition, hitNormal);
+                        rays += lights.size();
+                    }
+                }
+                shBasis(direction, basis);
+                for (int k = 0; k < N; k++) out[k] += radiance * (weight * COSINE_LOBE[k] / 3.141593f * basis[k]);
+            }
+            probes.valid[p] = backFaces <= PROBE_BACKFACE_LIMIT * samples ? 1 : 0;
+            });
+    }
+
+    uint64_t hashValues(const void* data, size_t bytes, uint64_t seed) {
+        std::vector<uint8_t> buffer(sizeof(seed) + bytes);
+        std::memcpy(buffer.data(), &seed, sizeof(seed));
+        std::memcpy(buffer.data() + sizeof(seed), data, bytes);
+        return AssetArchive::hashBytes(buffer.data(), buffer.size());
+    }
+}
+
+uint64_t LightmapBaker::layoutSignature(const std::vector<uint32_t>& meshVertexCounts,
+    const std::vector<uint32_t>& instanceMeshes, const std::vector<glm::mat4>& instanceTransforms) {
+    uint64_t signature = hashValues(meshVertexCounts.data(), meshVertexCounts.size() * sizeof(uint32_t), FILE_VERSION);
+    signature = hashValues(instanceMeshes.data(), instanceMeshes.size() * sizeof(uint32_t), signature);
+    return hashValues(instanceTransforms.data(), instanceTransforms.size() * sizeof(glm::mat4), signature);
+}
+
+uint64_t LightmapBaker::layoutSignature(const std::vector<BakeMesh>& meshes, const std::vector<BakeInstance>& instances) {
+    std::vector<uint32_t> vertexCounts, instanceMeshes;
+    std::vector<glm::mat4> transforms;
+    for (const BakeMesh& mesh : meshes) vertexCounts.push_back(static_cast<uint32_t>(mesh.data.vertexCount()));
+    for (const BakeInstance& instance : instances) {
+        instanceMeshes.push_back(instance.mesh);
+        transforms.push_back(instance.transform);
+    }
+    return layoutSignature(vertexCounts, instanceMeshes, transforms);
+}
+
+uint64_t LightmapBaker::lightSignature(const std::vector<BakeLight>& lights, const glm::vec3& ambient) {
+    uint64_t signature = hashValues(lights.data(), lights.size() * sizeof(BakeLight), FILE_VERSION);
+    return hashValues(&ambient, sizeof(ambient), signature);
+}
+
+void IrradianceProbes::sample(const glm::vec3& position, glm::vec3 out[COEFFICIENTS]) const {
+    for (int k = 0; k < COEFFICIENTS; k++) out[k] = glm::vec3(0.0f);
+    if (empty()) return;
+
+    glm::vec3 cell = glm::clamp((position - origin) / spacing, glm::vec3(0.0f), glm::vec3(size - 1u));
+    glm::uvec3 base = glm::min(glm::uvec3(cell), size - 1u);
+    glm::uvec3 next = glm::min(base + 1u, size - 1u);
+    glm::vec3 f = cell - glm::vec3(base);
+
+    // Invalid probes are left out and the rest renormalised; if all 8 are invalid use them anyway
+    for (int pass = 0; pass < 2; pass++) {
+        float total = 0.0f;
+        for (int corner = 0; corner < 8; corner++) {
+            glm::uvec3 c((corner & 1) ? next.x : base.x, (corner & 2) ? next.y : base.y, (corner & 4) ? next.z : base.z);
+            float w = ((corner & 1) ? f.x : 1.0f - f.x) * ((corner & 2) ? f.y : 1.0f - f.y) * ((corner & 4) ? f.z : 1.0f - f.z);
+            size_t index = (size_t(c.z) * size.y + c.y) * size.x + c.x;
+            if (pass == 0 && !valid[index]) continue;
+            for (int k = 0; k < COEFFICIENTS; k++) out[k] += coefficients[index * COEFFICIENTS + k] * w;
+            total += w;
+        }
+        if (total > 1e-4f) {
+            for (int k = 0; k < COEFFICIENTS; k++) out[k] /= total;
+            return;
+        }
+        for (int k = 0; k < COEFFICIENTS; k++) out[k] = glm::vec3(0.0f);
+    }
+}
+
+glm::vec3 IrradianceProbes::evaluate(const glm::vec3 coefficients[COEFFICIENTS], const glm::vec3& normal) {
+    float basis[COEFFICIENTS];
+    shBasis(normal, basis);
+    glm::vec3 result(0.0f);
+    for (int k = 0; k < COEFFICIENTS; k++) result += coefficients[k] * basis[k];
+    return glm::max(result, glm::vec3(0.0f));
+}
+
+bool LightmapBaker::bake(const std::vector<BakeMesh>& meshes, const std::vector<BakeInstance>& instances,
+    const std::vector<BakeLight>& lights, const glm::vec3& ambient, const BakeSettings& settings, LightmapData& out) {
+    auto start = std::chrono::steady_clock::now();
+    const int atlasSize = static_cast<int>(settings.atlasSize);
+
+    // Unwrap every used mesh (in the space of its first instance) and give each instance a copy
+    // of its layout in the atlas, lowering the density until they all fit
+    std::vector<MeshLayout> layouts;
+    std::vector<glm::ivec2> instanceOrigins;
+    float density = settings.texelsPerMeter;
+    for (int attempt = 0;; attempt++) {
+        layouts.assign(meshes.size(), MeshLayout());
+        std::vector<bool> unwrapped(meshes.size(), false);
+        for (const BakeInstance& instance : instances) {
+            if (unwrapped[instance.mesh]) continue;
+            unwrapped[instance.mesh] = true;
+            layouts[instance.mesh] = unwrapMesh(meshes[instance.mesh].data, glm::mat3(instance.transform), density);
+        }
+
+        std::vector<glm::ivec2> sizes;
+        bool fits = true;
+        for (const BakeInstance& instance : instances) {
+            sizes.push_back(layouts[instance.mesh].size);
+            if (sizes.back().x > atlasSize) fits = false;
+        }
+        if (fits && packShelves(sizes, atlasSize, instanceOrigins) <= atlasSize) break;
+        if (attempt == 30) {
+            std::cerr << "Lightmap: static geometry doesn't fit a " << atlasSize << "x" << atlasSize << " atlas" << std::endl;
+            return false;
+        }
+        density *= 0.85f;
+    }
+
+    out = LightmapData();
+    out.width = out.height = settings.atlasSize;
+    for (size_t m = 0; m < meshes.size(); m++) {
+        LightmapData::Mesh mesh;
+        mesh.path = meshes[m].path;
+        mesh.vertexCount = static_cast<uint32_t>(meshes[m].data.vertexCount());
+        if (layouts[m].size.x > 0) {
+            glm::vec2 size = glm::vec2(layouts[m].size);
+            for (const glm::vec2& coord : layouts[m].texelCoords) {
+                mesh.coords.push_back(coord.x / size.x);
+                mesh.coords.push_back(coord.y / size.y);
+            }
+        }
+        out.meshes.push_back(std::move(mesh));
+    }
+    for (size_t i = 0; i < instances.size(); i++) {
+        LightmapData::Instance instance;
+        instance.mesh = instances[i].mesh;
+        glm::vec2 size = glm::vec2(layouts[instance.mesh].size) / static_cast<float>(atlasSize);
+        instance.scaleOffset = glm::vec4(size, glm::vec2(instanceOrigins[i]) / static_cast<float>(atlasSize));
+        out.instances.push_back(instance);
+    }
+    out.layoutSignature = layoutSignature(meshes, instances);
+    out.lightSignature = lightSignature(lights, ambient);
+
+    // Static triangles in world space for the rays
+    BakeScene scene;
+    for (uint32_t i = 0; i < instances.size(); i++) {
+        const MeshData& mesh = meshes[instances[i].mesh].data;
+        glm::mat3 normalMatrix = glm::transpose(glm::inverse(glm::mat3(instances[i].transform)));
+        for (size_t v = 0; v + 2 < mesh.vertexCount(); v += 3) {
+            glm::vec3 front(0.0f);
+            for (int k = 0; k < 3; k++) {
+                const float* p = &mesh.vertices[(v + k) * 8];
+                scene.vertices.push_back(glm::vec3(instances[i].transform * glm::vec4(p[0], p[1], p[2], 1.0f)));
+                front += normalMatrix * glm::vec3(p[3], p[4], p[5]);
+            }
+            scene.frontNormals.push_back(front);
+            scene.instanceOf.push_back(i);
+        }
+    }
+    scene.build();
+
+    // Which surface point every atlas texel centre lands on (later triangles win overlaps)
+    std::vector<TexelSurface> surfaces;
+    std::vector<uint32_t> surfaceOf(size_t(atlasSize) * atlasSize, NO_TRIANGLE);
+    for (uint32_t i = 0; i < instances.size(); i++) {
+        const MeshLayout& layout = layouts[instances[i].mesh];
+        glm::vec2 origin = glm::vec2(instanceOrigins[i]);
+        for (uint32_t t = 0; t * 3 + 2 < layout.texelCoords.size(); t++) {
+            glm::vec2 a = layout.texelCoords[t * 3] + origin;
+            glm::vec2 b = layout.texelCoords[t * 3 + 1] + origin;
+            glm::vec2 c = layout.texelCoords[t * 3 + 2] + origin;
+            float area = (b.x - a.x) * (c.y - a.y) - (c.x - a.x) * (b.y - a.y);
+            if (std::abs(area) < 1e-12f) continue;
+
+            glm::ivec2 low = glm::max(glm::ivec2(glm::floor(glm::min(a, glm::min(b, c)))), glm::ivec2(0));
+            glm::ivec2 high = glm::min(glm::ivec2(glm::ceil(glm::max(a, glm::max(b, c)))), glm::ivec2(atlasSize - 1));
+            for (int y = low.y; y <= high.y; y++) {
+                for (int x = low.x; x <= high.x; x++) {
+                    glm::vec2 p(x + 0.5f, y + 0.5f);
+                    float w1 = ((p.x - a.x) * (c.y - a.y) - (c.x - a.x) * (p.y - a.y)) / area;
+                    float w2 = ((b.x - a.x) * (p.y - a.y) - (p.x - a.x) * (b.y - a.y)) / area;
+                    if (w1 < -1e-4f || w2 < -1e-4f || w1 + w2 > 1.0f + 1e-4f) continue;
+
+                    uint32_t texel = static_cast<uint32_t>(y * atlasSize + x);
+                    if (surfaceOf[texel] == NO_TRIANGLE) {
+                        surfaceOf[texel] = static_cast<uint32_t>(surfaces.size());
+                        surfaces.push_back(TexelSurface());
+                    }
+                    TexelSurface& surface = surfaces[surfaceOf[texel]];
+                    surface.texel = texel;
+                    surface.instance = i;
+                    surface.triangle = t;
+                    surface.barycentric = glm::vec2(w1, w2);
+                }
+            }
+        }
+    }
+
+    std::cout << "Lightmap: " << instances.size() << " instances, " << scene.instanceOf.size() << " triangles, "
+        << surfaces.size() << " texels at " << density << " texels/m" << std::endl;
+
+    // Trace texels in chunks on every core. Each texel only reads shared data and its own
+    // sample sequence, so scheduling can't change the result.
+    unsigned int threadCount = settings.threads ? settings.threads : std::max(1u, std::thread::hardware_concurrency());
+    std::vector<glm::vec3> irradiance(surfaces.size());
+    const int samples = std::max(settings.indirectSamples, 1);
+    uint64_t rayCount = parallelFor(surfaces.size(), threadCount, [&](size_t s, uint64_t& rays) {
+        const TexelSurface& surface = surfaces[s];
+        const BakeInstance& instance = instances[surface.instance];
+        const MeshData& mesh = meshes[instance.mesh].data;
+        const float* v[3] = {
+            &mesh.vertices[(surface.triangle * 3) * 8],
+            &mesh.vertices[(surface.triangle * 3 + 1) * 8],
+            &mesh.vertices[(surface.triangle * 3 + 2) * 8]
+        };
+        float w[3] = { 1.0f - surface.barycentric.x - surface.barycentric.y, surface.barycentric.x, surface.barycentric.y };
+
+        glm::vec3 localPosition(0.0f), localNormal(0.0f);
+        for (int k = 0; k < 3; k++) {
+            localPosition += w[k] * glm::vec3(v[k][0], v[k][1], v[k][2]);
+            localNormal += w[k] * glm::vec3(v[k][3], v[k][4], v[k][5]);
+        }
+        glm::vec3 position = glm::vec3(instance.transform * glm::vec4(localPosition, 1.0f));
+        glm::vec3 normal = glm::mat3(glm::transpose(glm::inverse(instance.transform))) * localNormal;
+        if (glm::dot(normal, normal) < 1e-12f) {
+            glm::vec3 a = glm::vec3(instance.transform * glm::vec4(v[0][0], v[0][1], v[0][2], 1.0f));
+            glm::vec3 b = glm::vec3(instance.transform * glm::vec4(v[1][0], v[1][1], v[1][2], 1.0f));
+            glm::vec3 c = glm::vec3(instance.transform * glm::vec4(v[2][0], v[2][1], v[2][2], 1.0f));
+            normal = glm::cross(b - a, c - a);
+            if (glm::dot(normal, normal) < 1e-24f) normal = glm::vec3(0.0f, 1.0f, 0.0f);
+        }
+        normal = glm::normalize(normal);
+
+        glm::vec3 direct = directLight(scene, lights, position, normal);
+        rays += lights.size();
+
+        // One bounce and ambient occlusion from the same cosine-weighted rays
+        // (Hammersley points, rotated per texel)
+        glm::vec3 origin = position + normal * SURFACE_OFFSET;
+        uint32_t seed = hashInteger(surface.texel);
+        float rotateU = (seed & 0xFFFFu) / 65536.0f, rotateV = (seed >> 16) / 65536.0f;
+        glm::vec3 bounce(0.0f);
+        int open = 0;
+        for (int i = 0; i < samples; i++) {
+            float r1 = std::fmod((i + 0.5f) / samples + rotateU, 1.0f);
+            float r2 = std::fmod(radicalInverse(static_cast<uint32_t>(i)) + rotateV, 1.0f);
+            glm::vec3 direction = cosineDirection(normal, r1, r2);
+
+            Hit hit;
+            rays++;
+            if (!scene.intersect(origin, direction, 1e30f, hit)) {
+                open++;
+                continue;
+            }
+            if (hit.t > settings.occlusionDistance) open++;
+
+            // Lambertian surface seen: its albedo times the light reaching it (two-sided)
+            glm::vec3 hitNormal = scene.faceNormal(hit.triangle);
+            if (glm::dot(hitNormal, direction) > 0.0f) hitNormal = -hitNormal;
+            glm::vec3 hitPosition = origin + direction * hit.t;
+            bounce += instances[scene.instanceOf[hit.triangle]].albedo * directLight(scene, lights, hitPosition, hitNormal);
+            rays += lights.size();
+        }
+
+        irradiance[s] = direct + bounce / static_cast<float>(samples)
+            + ambient * (static_cast<float>(open) / static_cast<float>(samples));
+        });
+
+    // Probes against the same scene: the static lights as seen from the probe, plus the
+    // bounce and ambient light arriving from every direction
+    if (!scene.instanceOf.empty()) rayCount += bakeProbes(scene, instances, lights, ambient, settings, threadCount, out.probes);
+
+    // Atlas texels, then grow every chart by its padding so bilinear filtering never reads
+    // an unbaked texel (each pass only reads the previous one - order independent)
+    std::vector<glm::vec4> atlas(size_t(atlasSize) * atlasSize, glm::vec4(0.0f));
+    for (size_t s = 0; s < surfaces.size(); s++) {
+        atlas[surfaces[s].texel] = glm::vec4(irradiance[s], 1.0f);
+    }
+    for (int pass = 0; pass < CHART_PADDING + 1; pass++) {
+        std::vector<glm::vec4> grown = atlas;
+        for (int y = 0; y < atlasSize; y++) {
+            for (int x = 0; x < atlasSize; x++) {
+                if (atlas[y * atlasSize + x].a > 0.0f) continue;
+                glm::vec3 sum(0.0f);
+                int count = 0;
+                for (int ny = std::max(y - 1, 0); ny <= std::min(y + 1, atlasSize - 1); ny++) {
+                    for (int nx = std::max(x - 1, 0); nx <= std::min(x + 1, atlasSize - 1); nx++) {
+                        const glm::vec4& neighbour = atlas[ny * atlasSize + nx];
+                        if (neighbour.a > 0.0f) {
+                            sum += glm::vec3(neighbour);
+                            count++;
+                        }
+                    }
+                }
+                if (count > 0) grown[y * atlasSize + x] = glm::vec4(sum / static_cast<float>(count), 0.5f);
+            }
+        }
+        atlas.swap(grown);
+    }
+
+    out.texels.resize(atlas.size() * 4);
+    for (size_t i = 0; i < atlas.size(); i++) {
+        for (int c = 0; c < 3; c++) out.texels[i * 4 + c] = glm::packHalf1x16(atlas[i][c]);
+        out.texels[i * 4 + 3] = glm::packHalf1x16(atlas[i].a >= 1.0f ? 1.0f : 0.0f);
+    }
+
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::cout << "Lightmap baked in " << seconds << " s on " << threadCount << " threads ("
+        << rayCount / 1000000.0 / std::max(seconds, 1e-3) << " Mrays/s, "
+        << scene.getNodeCount() << " BVH nodes)" << std::endl;
+    return true;
+}
+
+// File: magic, version, size, signatures, meshes (path, vertex count, coords), instances, texels, probes
+bool LightmapData::save(const std::string& path) const {
+    std::ofstream file(path, std::ios::binary);
+    if (!file) {
+        std::cerr << "Failed to write " << path << std::endl;
+        return false;
+    }
+    auto put = [&file](const void* data, size_t bytes) { file.write(reinterpret_cast<const char*>(data), bytes); };
+    const uint32_t header[6] = { FILE_MAGIC, FILE_VERSION, width, height,
+        static_cast<uint32_t>(meshes.size()), static_cast<uint32_t>(instances.size()) };
+    put(header, sizeof(header));
+    put(&layoutSignature, sizeof(layoutSignature));
+    put(&lightSignature, sizeof(lightSignature));
+    for (const Mesh& mesh : meshes) {
+        uint32_t sizes[3] = { static_cast<uint32_t>(mesh.path.size()), mesh.vertexCount, static_cast<uint32_t>(mesh.coords.size()) };
+        put(sizes, sizeof(sizes));
+        put(mesh.path.data(), mesh.path.size());
+        put(mesh.coords.data(), mesh.coords.size() * sizeof(float));
+    }
+    for (const Instance& instance : instances) {
+        put(&instance.mesh, sizeof(instance.mesh));
+        put(&instance.scaleOffset, sizeof(instance.scaleOffset));
+    }
+    put(texels.data(), texels.size() * sizeof(uint16_t));
+    put(&probes.origin, sizeof(probes.origin));
+    put(&probes.spacing, sizeof(probes.spacing));
+    put(&probes.size, sizeof(probes.size));
+    put(probes.coefficients.data(), probes.coefficients.size() * sizeof(glm::vec3));
+    put(probes.valid.data(), probes.valid.size());
+    if (!file) {
+        std::cerr << "Failed to write " << path << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool LightmapData::load(const std::string& path) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) return false;
+    auto get = [&file](void* data, size_t bytes) { file.read(reinterpret_cast<char*>(data), bytes); return bool(file); };
+
+    uint32_t header[6] = {};
+    if (!get(header, sizeof(header)) || header[0] != FILE_MAGIC || header[1] != FILE_VERSION) return false;
+    width = header[2];
+    height = header[3];
+    if (width == 0 || height == 0 || width > 16384 || height > 16384) return false;
+    get(&layoutSignature, sizeof(layoutSignature));
+    get(&lightSignature, sizeof(lightSignature));
+
+    meshes.assign(header[4], Mesh());
+    for (Mesh& mesh : meshes) {
+        uint32_t sizes[3] = {};
+        if (!get(sizes, sizeof(sizes)) || sizes[0] > 4096 || (sizes[2] != 0 && sizes[2] != sizes[1] * 2)) return false;
+        mesh.path.resize(sizes[0]);
+        mesh.vertexCount = sizes[1];
+        mesh.coords.resize(sizes[2]);
+        if (!get(&mesh.path[0], sizes[0]) || !get(mesh.coords.data(), sizes[2] * sizeof(float))) return false;
+    }
+    instances.assign(header[5], Instance());
+    for (Instance& instance : instances) {
+        if (!get(&instance.mesh, sizeof(instance.mesh)) || !get(&instance.scaleOffset, sizeof(instance.scaleOffset))) return false;
+        if (instance.mesh >= meshes.size()) return false;
+    }
+    texels.resize(size_t(width) * height * 4);
+    if (!get(texels.data(), texels.size() * sizeof(uint16_t))) return false;
+
+    probes = IrradianceProbes();
+    if (!get(&probes.origin, sizeof(probes.origin)) || !get(&probes.spacing, sizeof(probes.spacing)) ||
+        !get(&probes.size, sizeof(probes.size))) return false;
+    size_t probeCount = size_t(probes.size.x) * probes.size.y * probes.size.z;
+    if (probeCount > (1u << 20)) return false;
+    probes.coefficients.resize(probeCount * IrradianceProbes::COEFFICIENTS);
+    probes.valid.resize(probeCount);
+    return get(probes.coefficients.data(), probes.coefficients.size() * sizeof(glm::vec3)) &&
+        get(probes.valid.data(), probes.valid.size());
+}
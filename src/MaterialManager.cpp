@@ -0,0 +1,241 @@
+#include "MaterialManager.hpp"
+#include "TextureManager.hpp"
+#include "GpuMemory.hpp"
+#include "VirtualTexture.hpp"
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+// Static member definitions - material table, backend state and the currently bound entry
+std::vector<Material> MaterialManager::materials;
+MaterialHandle MaterialManager::bound = INVALID_MATERIAL;
+GLuint MaterialManager::boundProgram = 0;
+bool MaterialManager::viewTexturesBound = false;
+MaterialBackend MaterialManager::backend = MaterialBackend::BoundTextures;
+GLuint MaterialManager::baseColorArray = 0;
+GLuint MaterialManager::ormArray = 0;
+size_t MaterialManager::arrayBytes = 0;
+
+namespace {
+    const GLint BASE_COLOR_ARRAY_UNIT = 2;  // Separate units - a unit can't serve 2D and 2D array samplers at once
+    const GLint ORM_ARRAY_UNIT = 3;
+
+    // Mip level of source whose size matches targetSize (sources carry full mip chains)
+    float matchingLod(GLuint texture, GLsizei targetSize) {
+        GLint width = 1, height = 1;
+        glBindTexture(GL_TEXTURE_2D, texture);
+        glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_WIDTH, &width);
+        glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_HEIGHT, &height);
+        float ratio = static_cast<float>(std::max(width, height)) / static_cast<float>(targetSize);
+        return std::max(0.0f, std::log2(ratio));
+    }
+}
+
+MaterialHandle MaterialManager::create(const std::string& name, const std::string& baseColor,
+    const std::string& orm, bool lightSource) {
+    Material material;
+    material.name = name;
+    material.baseColor = TextureManager::getTexture(baseColor);
+    material.orm = TextureManager::getTexture(orm);
+    material.baseColorTexture = TextureManager::getTextureRef(baseColor);
+    material.ormTexture = TextureManager::getTextureRef(orm);
+    material.lightSource = lightSource;
+
+    materials.push_back(material);
+    MaterialHandle handle = static_cast<MaterialHandle>(materials.size() - 1);
+
+    // Light sources keep their texture (light.frag has no virtual texture path)
+    if (!lightSource && material.baseColorTexture) {
+        VirtualTexture::addMaterial(handle, material.baseColorTexture->path);
+    }
+    return handle;
+}
+
+void MaterialManager::setupSamplers(const Shader& shader) {
+    // Sampler uniforms are program state, so they only need setting once
+    shader.use();
+    shader.setInt("baseColorMap"_uniform, 0);
+    shader.setInt("ormMap"_uniform, 1);
+    shader.setInt("baseColorArray"_uniform, BASE_COLOR_ARRAY_UNIT);
+    shader.setInt("ormArray"_uniform, ORM_ARRAY_UNIT);
+    VirtualTexture::setupSamplers(shader);
+}
+
+bool MaterialManager::buildTextureArrays(GLsizei layerSize) {
+    if (materials.empty()) return false;
+    if (baseColorArray) {
+        glDeleteTextures(1, &baseColorArray);
+        glDeleteTextures(1, &ormArray);
+        GpuMemory::release(GpuMemoryCategory::MaterialArrays, arrayBytes);
+    }
+
+    GLsizei layers = static_cast<GLsizei>(materials.size());
+    GLint levels = 1;
+    while ((layerSize >> levels) > 0) levels++;
+
+    // Allocate every level up front (no glGenerateMipmap - each level is resampled from the source chain)
+    auto allocate = [&](GLuint& texture, GLenum internalFormat, GLenum format) {
+        glGenTextures(1, &texture);
+        glBindTexture(GL_TEXTURE_2D_ARRAY, texture);
+        for (GLint level = 0; level < levels; level++) {
+            GLsizei size = std::max(1, layerSize >> level);
+            glTexImage3D(GL_TEXTURE_2D_ARRAY, level, internalFormat, size, size, layers, 0, format, GL_UNSIGNED_BYTE, nullptr);
+        }
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAX_LEVEL, levels - 1);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_REPEAT);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_REPEAT);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        };
+    allocate(baseColorArray, GL_RGBA8, GL_RGBA);
+    allocate(ormArray, GL_RGBA8, GL_RGBA);
+
+    // Render each layer/level with a fullscreen triangle sampling the matching source mip
+    Shader packShader("shaders/material_pack.vert", "shaders/material_pack.frag");
+    packShader.use();
+    packShader.setInt("source"_uniform, 0);
+
+    GLint previousViewport[4];
+    glGetIntegerv(GL_VIEWPORT, previousViewport);
+    GLboolean depthTest = glIsEnabled(GL_DEPTH_TEST);
+    glDisable(GL_DEPTH_TEST);
+
+    GLuint framebuffer, emptyVAO;
+    glGenFramebuffers(1, &framebuffer);
+    glGenVertexArrays(1, &emptyVAO);
+    glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+    glBindVertexArray(emptyVAO);
+
+    for (GLsizei layer = 0; layer < layers; layer++) {
+        const Material& material = materials[layer];
+        float baseLod = matchingLod(material.baseColor, layerSize);
+        float ormLod = matchingLod(material.orm, layerSize);
+
+        for (GLint level = 0; level < levels; level++) {
+            GLsizei size = std::max(1, layerSize >> level);
+            glViewport(0, 0, size, size);
+            packShader.setVec2("targetSize"_uniform, static_cast<float>(size), static_cast<float>(size));
+
+            // Base color layer
+            glFramebufferTextureLayer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, baseColorArray, level, layer);
+            glActiveTexture(GL_TEXTURE0);
+            glBindTexture(GL_TEXTURE_2D, material.baseColor);
+            packShader.setFloat("lod"_uniform, baseLod + level);
+            glDrawArrays(GL_TRIANGLES, 0, 3);
+
+            // Occlusion/roughness/metallic layer
+            glFramebufferTextureLayer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, ormArray, level, layer);
+            glBindTexture(GL_TEXTURE_2D, material.orm);
+            packShader.setFloat("lod"_uniform, ormLod + level);
+            glDrawArrays(GL_TRIANGLES, 0, 3);
+        }
+    }
+
+    glBindVertexArray(0);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    glDeleteVertexArrays(1, &emptyVAO);
+    glDeleteFramebuffers(1, &framebuffer);
+    glDeleteProgram(packShader.ID);
+    glViewport(previousViewport[0], previousViewport[1], previousViewport[2], previousViewport[3]);
+    if (depthTest) glEnable(GL_DEPTH_TEST);
+    invalidate();
+
+    // Two RGBA8 texels per layer texel, plus a third for the mip chains
+    arrayBytes = size_t(layerSize) * layerSize * layers * 8 * 4 / 3;
+    GpuMemory::allocate(GpuMemoryCategory::MaterialArrays, arrayBytes);
+    std::cout << "Material arrays: " << layers << " layers of " << layerSize << "x" << layerSize
+        << " (" << arrayBytes / (1024 * 1024) << " MB)" << std::endl;
+    return true;
+}
+
+bool MaterialManager::isBackendAvailable(MaterialBackend candidate) {
+    switch (candidate) {
+    case MaterialBackend::TextureArrays: return hasTextureArrays();
+    case MaterialBackend::VirtualTextures: return VirtualTexture::isEnabled();
+    default: return true;
+    }
+}
+
+void MaterialManager::setBackend(MaterialBackend newBackend) {
+    if (!isBackendAvailable(newBackend)) return;
+    backend = newBackend;
+    invalidate();
+}
+
+void MaterialManager::setupView(const Shader& shader) {
+    shader.setBool("useMaterialArrays"_uniform, backend == MaterialBackend::TextureArrays);
+    if (backend == MaterialBackend::VirtualTextures) VirtualTexture::setupView(shader);
+}
+
+void MaterialManager::bind(MaterialHandle handle, const Shader& shader) {
+    if (backend == MaterialBackend::TextureArrays) {
+        // Arrays stay bound for the whole view, only the layer index changes
+        if (!viewTexturesBound) {
+            glActiveTexture(GL_TEXTURE0 + BASE_COLOR_ARRAY_UNIT);
+            glBindTexture(GL_TEXTURE_2D_ARRAY, baseColorArray);
+            glActiveTexture(GL_TEXTURE0 + ORM_ARRAY_UNIT);
+            glBindTexture(GL_TEXTURE_2D_ARRAY, ormArray);
+            glActiveTexture(GL_TEXTURE0);
+            viewTexturesBound = true;
+        }
+        if (handle == bound && shader.ID == boundProgram) return;
+        bound = handle;
+        boundProgram = shader.ID;
+        shader.setInt("materialLayer"_uniform, static_cast<int>(handle));
+        return;
+    }
+
+    const Material& material = materials[handle];
+    uint64_t frame = GpuMemory::getFrame();
+
+    if (backend == MaterialBackend::VirtualTextures && !material.lightSource) {
+        // Cache and page tables stay bound for the whole view; the layer index picks the
+        // material's row in the virtual texture info, only ORM is a per-material binding
+        if (!viewTexturesBound) {
+            VirtualTexture::bindTextures();
+            viewTexturesBound = true;
+        }
+        if (handle == bound && shader.ID == boundProgram) return;
+        bound = handle;
+        boundProgram = shader.ID;
+        shader.setInt("materialLayer"_uniform, static_cast<int>(handle));
+        if (GpuTexture* texture = material.ormTexture.get()) texture->lastUsedFrame = frame;
+        glActiveTexture(GL_TEXTURE1);
+        glBindTexture(GL_TEXTURE_2D, material.orm);
+        glActiveTexture(GL_TEXTURE0);
+        return;
+    }
+
+    // Texture bindings are context state, so they survive shader switches
+    if (handle == bound) return;
+    bound = handle;
+
+    if (GpuTexture* texture = material.baseColorTexture.get()) texture->lastUsedFrame = frame;
+    if (GpuTexture* texture = material.ormTexture.get()) texture->lastUsedFrame = frame;
+
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, material.baseColor);
+    glActiveTexture(GL_TEXTURE1);
+    glBindTexture(GL_TEXTURE_2D, material.orm);
+    glActiveTexture(GL_TEXTURE0);
+}
+
+void MaterialManager::invalidate() {
+    bound = INVALID_MATERIAL;
+    boundProgram = 0;
+    viewTexturesBound = false;
+}
+
+void MaterialManager::cleanup() {
+    if (baseColorArray) {
+        glDeleteTextures(1, &baseColorArray);
+        glDeleteTextures(1, &ormArray);
+        baseColorArray = ormArray = 0;
+        GpuMemory::release(GpuMemoryCategory::MaterialArrays, arrayBytes);
+        arrayBytes = 0;
+    }
+    materials.clear();
+    backend = MaterialBackend::BoundTextures;
+    invalidate();
+    std::cout << "Materials cleaned up." << std::endl;
+}
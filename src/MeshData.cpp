@@ -0,0 +1,61 @@
+#include "MeshData.hpp"
+#define TINYOBJLOADER_IMPLEMENTATION
+#include "tiny_obj_loader.h"
+#include <iostream>
+
+bool MeshData::loadObj(const std::string& path, MeshData& out) {
+    out.vertices.clear();
+
+    // Load OBJ file using TinyObjLoader library
+    tinyobj::attrib_t attrib;                    // Vertex attributes (positions, normals, UVs)
+    std::vector<tinyobj::shape_t> shapes;        // Mesh shapes/objects
+    std::vector<tinyobj::material_t> materials;  // Material definitions (unused)
+    std::string warn, err;                       // Warning and error messages
+
+    bool success = tinyobj::LoadObj(&attrib, &shapes, &materials, &warn, &err, path.c_str());
+    if (!success) {
+        std::cerr << "Failed to load OBJ: " << err << std::endl;
+        out.boundsMin = out.boundsMax = glm::vec3(0.0f);
+        return false;
+    }
+
+    // Process all shapes in the loaded model
+    for (const auto& shape : shapes) {
+        // Process each triangle face
+        for (const auto& index : shape.mesh.indices) {
+            // Extract vertex position from attribute arrays
+            float vx = attrib.vertices[3 * index.vertex_index + 0];  // X coordinate
+            float vy = attrib.vertices[3 * index.vertex_index + 1];  // Y coordinate
+            float vz = attrib.vertices[3 * index.vertex_index + 2];  // Z coordinate
+
+            // Extract vertex normal (or use default if model has no normals)
+            float nx = attrib.normals.empty() ? 0.0f : attrib.normals[3 * index.normal_index + 0];
+            float ny = attrib.normals.empty() ? 0.0f : attrib.normals[3 * index.normal_index + 1];
+            float nz = attrib.normals.empty() ? 0.0f : attrib.normals[3 * index.normal_index + 2];
+
+            // Extract texture coordinates (or use default if model has no UVs)
+            float tx = attrib.texcoords.empty() ? 0.0f : attrib.texcoords[2 * index.texcoord_index + 0];
+            float ty = attrib.texcoords.empty() ? 0.0f : attrib.texcoords[2 * index.texcoord_index + 1];
+
+            // Pack vertex data: [position(3) + normal(3) + texcoord(2)] = 8 floats per vertex
+            out.vertices.insert(out.vertices.end(), { vx, vy, vz, nx, ny, nz, tx, ty });
+        }
+    }
+
+    computeBounds(out.vertices.data(), out.vertexCount(), out.boundsMin, out.boundsMax);
+    return true;
+}
+
+void MeshData::computeBounds(const float* vertices, size_t count, glm::vec3& outMin, glm::vec3& outMax) {
+    if (count == 0) {
+        outMin = outMax = glm::vec3(0.0f);
+        return;
+    }
+
+    outMin = outMax = glm::vec3(vertices[0], vertices[1], vertices[2]);
+    for (size_t i = 1; i < count; i++) {
+        glm::vec3 p(vertices[i * 8 + 0], vertices[i * 8 + 1], vertices[i * 8 + 2]);
+        outMin = glm::min(outMin, p);
+        outMax = glm::max(outMax, p);
+    }
+}
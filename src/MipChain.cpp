@@ -0,0 +1,148 @@
+#include "MipChain.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define MIPCHAIN_SSE2 1
+#include <emmintrin.h>
+#endif
+
+namespace {
+    // sRGB <-> linear lookup tables (12-bit linear precision is plenty for 8-bit output)
+    struct GammaTables {
+        float toLinear[256];
+        uint8_t toSrgb[4096];
+
+        GammaTables() {
+            for (int i = 0; i < 256; i++) {
+                float c = i / 255.0f;
+                toLinear[i] = c <= 0.04045f ? c / 12.92f : std::pow((c + 0.055f) / 1.055f, 2.4f);
+            }
+            for (int i = 0; i < 4096; i++) {
+                float l = i / 4095.0f;
+                float c = l <= 0.0031308f ? l * 12.92f : 1.055f * std::pow(l, 1.0f / 2.4f) - 0.055f;
+                toSrgb[i] = static_cast<uint8_t>(std::min(255.0f, std::max(0.0f, c * 255.0f + 0.5f)));
+            }
+        }
+    };
+
+    const GammaTables& gammaTables() {
+        static const GammaTables tables;  // Thread-safe lazy init, decode workers share it
+        return tables;
+    }
+
+#ifdef MIPCHAIN_SSE2
+    inline __m128 linearPixel(const uint8_t* p, const GammaTables& tables) {
+        return _mm_set_ps(p[3] * (1.0f / 255.0f), tables.toLinear[p[2]], tables.toLinear[p[1]], tables.toLinear[p[0]]);
+    }
+
+    inline __m128i widenPixel(const uint8_t* p) {
+        int32_t packed;
+        std::memcpy(&packed, p, 4);
+        return _mm_unpacklo_epi8(_mm_cvtsi32_si128(packed), _mm_setzero_si128());
+    }
+#endif
+}
+
+void MipChain::expandToRGBA(const uint8_t* pixels, uint32_t width, uint32_t height, uint32_t channels,
+    std::vector<uint8_t>& rgba) {
+    size_t count = size_t(width) * height;
+    rgba.resize(count * 4);
+    if (channels == 4) {
+        std::memcpy(rgba.data(), pixels, count * 4);
+        return;
+    }
+    for (size_t i = 0; i < count; i++) {
+        const uint8_t* src = pixels + i * channels;
+        uint8_t* dst = &rgba[i * 4];
+        dst[0] = src[0];
+        dst[1] = channels > 2 ? src[1] : src[0];
+        dst[2] = channels > 2 ? src[2] : src[0];
+        dst[3] = channels == 2 ? src[1] : 255;  // Grey + alpha
+    }
+}
+
+void MipChain::downsample(const uint8_t* src, uint32_t width, uint32_t height, uint8_t* dst, bool gammaCorrect) {
+    uint32_t dstWidth = std::max(1u, width / 2), dstHeight = std::max(1u, height / 2);
+    const GammaTables& tables = gammaTables();
+
+    for (uint32_t y = 0; y < dstHeight; y++) {
+        // Clamp at odd edges (1-pixel-wide levels average the same texel twice)
+        const uint8_t* row0 = src + size_t(std::min(y * 2, height - 1)) * width * 4;
+        const uint8_t* row1 = src + size_t(std::min(y * 2 + 1, height - 1)) * width * 4;
+        uint8_t* out = dst + size_t(y) * dstWidth * 4;
+
+        for (uint32_t x = 0; x < dstWidth; x++, out += 4) {
+            size_t x0 = size_t(std::min(x * 2, width - 1)) * 4, x1 = size_t(std::min(x * 2 + 1, width - 1)) * 4;
+            const uint8_t* p[4] = { row0 + x0, row0 + x1, row1 + x0, row1 + x1 };
+
+#ifdef MIPCHAIN_SSE2
+            if (gammaCorrect) {
+                __m128 sum = _mm_add_ps(_mm_add_ps(linearPixel(p[0], tables), linearPixel(p[1], tables)),
+                    _mm_add_ps(linearPixel(p[2], tables), linearPixel(p[3], tables)));
+                __m128 scale = _mm_set_ps(255.0f * 0.25f, 4095.0f * 0.25f, 4095.0f * 0.25f, 4095.0f * 0.25f);
+                alignas(16) int32_t index[4];
+                _mm_store_si128(reinterpret_cast<__m128i*>(index), _mm_cvtps_epi32(_mm_mul_ps(sum, scale)));
+                out[0] = tables.toSrgb[index[0]];
+                out[1] = tables.toSrgb[index[1]];
+                out[2] = tables.toSrgb[index[2]];
+                out[3] = static_cast<uint8_t>(index[3]);
+            }
+            else {
+                __m128i sum = _mm_add_epi16(_mm_add_epi16(widenPixel(p[0]), widenPixel(p[1])),
+                    _mm_add_epi16(widenPixel(p[2]), widenPixel(p[3])));
+                sum = _mm_srli_epi16(_mm_add_epi16(sum, _mm_set1_epi16(2)), 2);
+                int32_t packed = _mm_cvtsi128_si32(_mm_packus_epi16(sum, sum));
+                std::memcpy(out, &packed, 4);
+            }
+#else
+            // Same rounding as the SSE2 path (nearest even), so both builds produce identical caches
+            for (int c = 0; c < 4; c++) {
+                if (gammaCorrect && c < 3) {
+                    float sum = (tables.toLinear[p[0][c]] + tables.toLinear[p[1][c]]) +
+                        (tables.toLinear[p[2][c]] + tables.toLinear[p[3][c]]);
+                    out[c] = tables.toSrgb[std::lrint(sum * (4095.0f * 0.25f))];
+                }
+                else if (gammaCorrect) {
+                    float sum = (p[0][c] * (1.0f / 255.0f) + p[1][c] * (1.0f / 255.0f)) +
+                        (p[2][c] * (1.0f / 255.0f) + p[3][c] * (1.0f / 255.0f));
+                    out[c] = static_cast<uint8_t>(std::lrint(sum * (255.0f * 0.25f)));
+                }
+                else {
+                    out[c] = static_cast<uint8_t>((p[0][c] + p[1][c] + p[2][c] + p[3][c] + 2) / 4);
+                }
+            }
+#endif
+        }
+    }
+}
+
+void MipChain::build(const uint8_t* rgba, uint32_t width, uint32_t height, bool gammaCorrect,
+    std::vector<ImageLevel>& levels, std::vector<uint8_t>& out) {
+    // Total size up front so levels can be filtered in place from the previous one
+    size_t total = 0;
+    for (uint32_t w = width, h = height; ; w = std::max(1u, w / 2), h = std::max(1u, h / 2)) {
+        total += size_t(w) * h * 4;
+        if (w == 1 && h == 1) break;
+    }
+    size_t base = out.size();
+    out.resize(base + total);
+    std::memcpy(out.data() + base, rgba, size_t(width) * height * 4);
+
+    size_t offset = base;
+    while (true) {
+        ImageLevel level;
+        level.width = width;
+        level.height = height;
+        level.offset = offset;
+        level.size = size_t(width) * height * 4;
+        levels.push_back(level);
+
+        if (width == 1 && height == 1) break;
+        downsample(out.data() + offset, width, height, out.data() + offset + level.size, gammaCorrect);
+        offset += level.size;
+        width = std::max(1u, width / 2);
+        height = std::max(1u, height / 2);
+    }
+}
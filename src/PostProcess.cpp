@@ -0,0 +1,108 @@
+#include "PostProcess.hpp"
+#include "GpuMemory.hpp"
+#include <iostream>
+
+// Static member definitions - scene target and resolve program
+// Old display clear color (0.01, 0.008, 0.005) through inverse gamma 2.2, Reinhard and tint
+const glm::vec3 PostProcess::BACKGROUND = glm::vec3(3.619e-5f, 2.565e-5f, 1.083e-5f);
+std::unique_ptr<Shader> PostProcess::shader;
+GLuint PostProcess::framebuffer = 0;
+GLuint PostProcess::colorTexture = 0;
+GLuint PostProcess::depthTexture = 0;
+GLuint PostProcess::fullscreenVAO = 0;
+int PostProcess::width = 0;
+int PostProcess::height = 0;
+size_t PostProcess::targetBytes = 0;
+
+namespace {
+    const GLint SCENE_UNIT = 0;
+}
+
+bool PostProcess::initialize() {
+    if (shader) return true;
+    shader = std::make_unique<Shader>("shaders/fullscreen.vert", "shaders/post.frag");
+    glGenVertexArrays(1, &fullscreenVAO);
+    return true;
+}
+
+void PostProcess::shutdown() {
+    destroyTarget();
+    if (shader) glDeleteProgram(shader->ID);
+    shader.reset();
+    if (fullscreenVAO) glDeleteVertexArrays(1, &fullscreenVAO);
+    fullscreenVAO = 0;
+}
+
+void PostProcess::createTarget(int targetWidth, int targetHeight) {
+    destroyTarget();
+    width = targetWidth;
+    height = targetHeight;
+
+    GLuint* textures[2] = { &colorTexture, &depthTexture };
+    const GLenum formats[2][3] = { { COLOR_FORMAT, GL_RGB, GL_FLOAT }, { GL_DEPTH_COMPONENT24, GL_DEPTH_COMPONENT, GL_UNSIGNED_INT } };
+    for (int i = 0; i < 2; i++) {
+        glGenTextures(1, textures[i]);
+        glBindTexture(GL_TEXTURE_2D, *textures[i]);
+        glTexImage2D(GL_TEXTURE_2D, 0, formats[i][0], width, height, 0, formats[i][1], formats[i][2], nullptr);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    }
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    glGenFramebuffers(1, &framebuffer);
+    glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, colorTexture, 0);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, depthTexture, 0);
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+        std::cerr << "HDR scene framebuffer incomplete (" << width << "x" << height << ")" << std::endl;
+    }
+
+    targetBytes = GpuMemory::imageBytes(width, height, COLOR_FORMAT) + GpuMemory::imageBytes(width, height, GL_DEPTH_COMPONENT24);
+    GpuMemory::allocate(GpuMemoryCategory::RenderTargets, targetBytes);
+}
+
+void PostProcess::destroyTarget() {
+    if (!framebuffer) return;
+    GLuint textures[] = { colorTexture, depthTexture };
+    glDeleteTextures(2, textures);
+    glDeleteFramebuffers(1, &framebuffer);
+    GpuMemory::release(GpuMemoryCategory::RenderTargets, targetBytes);
+    framebuffer = colorTexture = depthTexture = 0;
+    targetBytes = 0;
+    width = height = 0;
+}
+
+void PostProcess::beginScene(int targetWidth, int targetHeight) {
+    if (targetWidth <= 0 || targetHeight <= 0) return;  // Minimised
+    if (targetWidth != width || targetHeight != height) createTarget(targetWidth, targetHeight);
+
+    glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+    glViewport(0, 0, width, height);
+    clear();
+}
+
+void PostProcess::clear() {
+    glClearColor(BACKGROUND.r, BACKGROUND.g, BACKGROUND.b, 1.0f);
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+}
+
+void PostProcess::resolve() {
+    if (!framebuffer) return;
+
+    // Every pixel is written once - no depth, no blending
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    glViewport(0, 0, width, height);
+    glDisable(GL_DEPTH_TEST);
+    glDisable(GL_BLEND);
+
+    shader->use();
+    shader->setInt("hdrScene"_uniform, SCENE_UNIT);
+    glActiveTexture(GL_TEXTURE0 + SCENE_UNIT);
+    glBindTexture(GL_TEXTURE_2D, colorTexture);
+    glBindVertexArray(fullscreenVAO);
+    glDrawArrays(GL_TRIANGLES, 0, 3);
+    glBindVertexArray(0);
+    glEnable(GL_DEPTH_TEST);
+}
@@ -0,0 +1,45 @@
+#include "ShaderVariants.hpp"
+
+uint32_t ShaderFeatures::key() const {
+    uint32_t lights = gbuffer ? 0xFEu : clusteredLights ? 0xFFu : static_cast<uint32_t>(pointLights);
+    uint32_t baking = gbuffer || baked == BakedLighting::None ? 0u
+        : static_cast<uint32_t>(staticLights) | (static_cast<uint32_t>(baked) << 8);
+    return lights | (static_cast<uint32_t>(materials) << 8) | (baking << 16);
+}
+
+std::string ShaderFeatures::defines() const {
+    std::string defines = gbuffer ? "#define GBUFFER\n"
+        : clusteredLights ? "#define CLUSTERED_LIGHTS\n"
+        : "#define POINT_LIGHT_COUNT " + std::to_string(pointLights) + "\n";
+    if (materials == MaterialBackend::TextureArrays) defines += "#define MATERIAL_ARRAYS\n";
+    if (materials == MaterialBackend::VirtualTextures) defines += "#define VIRTUAL_TEXTURING\n";
+    if (!gbuffer && baked == BakedLighting::Lightmap) defines += "#define LIGHTMAP_STATIC_LIGHTS " + std::to_string(staticLights) + "\n";
+    if (!gbuffer && baked == BakedLighting::Probes) defines += "#define PROBE_STATIC_LIGHTS " + std::to_string(staticLights) + "\n";
+    return defines;
+}
+
+ShaderVariants::ShaderVariants(const char* vertexPath, const char* fragmentPath, Setup setup)
+    : vertexPath(vertexPath), fragmentPath(fragmentPath), setup(std::move(setup)) {
+}
+
+ShaderVariants::Variant& ShaderVariants::find(const ShaderFeatures& features) {
+    Variant& variant = variants[features.key()];
+    if (!variant.shader) {
+        variant.shader = std::make_unique<Shader>(vertexPath, fragmentPath, features.defines());
+    }
+    return variant;
+}
+
+Shader& ShaderVariants::get(const ShaderFeatures& features) {
+    Variant& variant = find(features);
+    if (!variant.ready) {
+        // First use waits for the link (see Shader::finishLink)
+        variant.ready = true;
+        if (setup) setup(*variant.shader);
+    }
+    return *variant.shader;
+}
+
+void ShaderVariants::prepare(const ShaderFeatures& features) {
+    find(features);
+}
@@ -0,0 +1,402 @@
+#include "ShadowAtlas.hpp"
+#include "UniformBuffers.hpp"
+#include "GpuMemory.hpp"
+#include <glm/gtc/matrix_transform.hpp>
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+// Static member definitions - both atlases, the matrix block and per-face state
+GLuint ShadowAtlas::atlas = 0;
+GLuint ShadowAtlas::atlasFramebuffer = 0;
+GLuint ShadowAtlas::cache = 0;
+GLuint ShadowAtlas::cacheFramebuffer = 0;
+GLuint ShadowAtlas::uniformBuffer = 0;
+GLuint ShadowAtlas::fallbackTexture = 0;
+GLuint ShadowAtlas::fallbackBuffer = 0;
+size_t ShadowAtlas::bytes = 0;
+int ShadowAtlas::faceBudget = 0;
+uint64_t ShadowAtlas::frame = 0;
+ShadowAtlas::Row ShadowAtlas::rows[ShadowAtlas::ROWS];
+std::vector<glm::mat4> ShadowAtlas::views;
+std::vector<glm::mat4> ShadowAtlas::seenViews;
+std::vector<glm::vec4> ShadowAtlas::seenPlanes;
+std::vector<glm::vec3> ShadowAtlas::seenCorners;
+std::vector<ShadowAtlas::Pending> ShadowAtlas::pending;
+int ShadowAtlas::lastStaticFaces = 0;
+int ShadowAtlas::lastMovingFaces = 0;
+int ShadowAtlas::lastSkippedFaces = 0;
+
+namespace {
+    const GLint SHADOW_UNIT = 11;        // After the lightmap (10)
+    const float NEAR_PLANE = 0.05f;
+    const float RANGE_HEADROOM = 1.25f;  // Far plane margin, so a flickering light keeps its cached faces
+    const int WIDTH = 6 * ShadowAtlas::FACE_SIZE;
+    const int HEIGHT = ShadowAtlas::ROWS * ShadowAtlas::FACE_SIZE;
+
+    // std140 mirror of the ShadowData block (standard.frag, deferred_light.frag)
+    struct ShadowData {
+        glm::mat4 matrices[ShadowAtlas::ROWS * 6];
+        glm::vec4 tile;  // xy = one face in atlas UV, zw = half a texel
+    };
+
+    // Cube face directions (GL cube map order: +X -X +Y -Y +Z -Z) - the face a direction
+    // falls in is its major axis, which is what the shaders pick
+    const glm::vec3 FACE_DIRECTIONS[6] = {
+        glm::vec3(1.0f, 0.0f, 0.0f), glm::vec3(-1.0f, 0.0f, 0.0f), glm::vec3(0.0f, 1.0f, 0.0f),
+        glm::vec3(0.0f, -1.0f, 0.0f), glm::vec3(0.0f, 0.0f, 1.0f), glm::vec3(0.0f, 0.0f, -1.0f)
+    };
+    const glm::vec3 FACE_UPS[6] = {
+        glm::vec3(0.0f, -1.0f, 0.0f), glm::vec3(0.0f, -1.0f, 0.0f), glm::vec3(0.0f, 0.0f, 1.0f),
+        glm::vec3(0.0f, 0.0f, -1.0f), glm::vec3(0.0f, -1.0f, 0.0f), glm::vec3(0.0f, -1.0f, 0.0f)
+    };
+
+    // Shaders compare against depth 0 through this - lit until the face is first rendered
+    glm::mat4 litMatrix() {
+        glm::mat4 matrix(0.0f);
+        matrix[3][3] = 1.0f;
+        return matrix;
+    }
+
+    // Clip space to the face's tile in the atlas (uv and depth in [0,1])
+    glm::mat4 tileMatrix(int row, int face) {
+        glm::vec2 scale(1.0f / 6.0f, 1.0f / ShadowAtlas::ROWS);
+        glm::vec2 offset = glm::vec2(face, row) * scale;
+        glm::mat4 matrix = glm::translate(glm::mat4(1.0f), glm::vec3(offset + scale * 0.5f, 0.5f));
+        return glm::scale(matrix, glm::vec3(scale * 0.5f, 0.5f));
+    }
+
+    // Frustum planes of a view-projection (normalised, inside where dot >= 0)
+    void extractPlanes(const glm::mat4& m, glm::vec4 planes[6]) {
+        glm::vec4 row0(m[0][0], m[1][0], m[2][0], m[3][0]);
+        glm::vec4 row1(m[0][1], m[1][1], m[2][1], m[3][1]);
+        glm::vec4 row2(m[0][2], m[1][2], m[2][2], m[3][2]);
+        glm::vec4 row3(m[0][3], m[1][3], m[2][3], m[3][3]);
+        planes[0] = row3 + row0;
+        planes[1] = row3 - row0;
+        planes[2] = row3 + row1;
+        planes[3] = row3 - row1;
+        planes[4] = row3 + row2;
+        planes[5] = row3 - row2;
+        for (int i = 0; i < 6; i++) planes[i] /= glm::length(glm::vec3(planes[i]));
+    }
+
+    void extractCorners(const glm::mat4& m, glm::vec3 corners[8]) {
+        glm::mat4 inverse = glm::inverse(m);
+        for (int i = 0; i < 8; i++) {
+            glm::vec4 corner = inverse * glm::vec4((i & 1) ? 1.0f : -1.0f, (i & 2) ? 1.0f : -1.0f, (i & 4) ? 1.0f : -1.0f, 1.0f);
+            corners[i] = glm::vec3(corner) / corner.w;
+        }
+    }
+
+    // Conservative: false only if one frustum's corners are all outside a plane of the other
+    bool frustaOverlap(const glm::vec4 planesA[6], const glm::vec3 cornersA[8],
+        const glm::vec4 planesB[6], const glm::vec3 cornersB[8]) {
+        for (int side = 0; side < 2; side++) {
+            const glm::vec4* planes = side ? planesB : planesA;
+            const glm::vec3* corners = side ? cornersA : cornersB;
+            for (int p = 0; p < 6; p++) {
+                int outside = 0;
+                for (int c = 0; c < 8; c++) {
+                    if (glm::dot(glm::vec3(planes[p]), corners[c]) + planes[p].w < 0.0f) outside++;
+                }
+                if (outside == 8) return false;
+            }
+        }
+        return true;
+    }
+
+    uint64_t hashCombine(uint64_t hash, const void* data, size_t size) {
+        const uint8_t* bytes = static_cast<const uint8_t*>(data);
+        for (size_t i = 0; i < size; i++) hash = (hash ^ bytes[i]) * 0x100000001B3ull;  // FNV-1a step
+        return hash;
+    }
+}
+
+bool ShadowAtlas::initialize(int budget) {
+    if (atlas) return true;
+    faceBudget = budget;
+
+    // Depth textures the size of every row's six faces; only the live one is sampled (with compare)
+    GLuint* textures[2] = { &atlas, &cache };
+    GLuint* framebuffers[2] = { &atlasFramebuffer, &cacheFramebuffer };
+    for (int i = 0; i < 2; i++) {
+        glGenTextures(1, textures[i]);
+        glBindTexture(GL_TEXTURE_2D, *textures[i]);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH_COMPONENT24, WIDTH, HEIGHT, 0, GL_DEPTH_COMPONENT, GL_UNSIGNED_INT, nullptr);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_COMPARE_MODE, GL_COMPARE_REF_TO_TEXTURE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_COMPARE_FUNC, GL_LEQUAL);
+
+        glGenFramebuffers(1, framebuffers[i]);
+        glBindFramebuffer(GL_FRAMEBUFFER, *framebuffers[i]);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, *textures[i], 0);
+        glDrawBuffer(GL_NONE);
+        glReadBuffer(GL_NONE);
+        if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+            std::cerr << "Shadow atlas framebuffer incomplete, point light shadows disabled" << std::endl;
+            glBindFramebuffer(GL_FRAMEBUFFER, 0);
+            shutdown();
+            createFallback();
+            return false;
+        }
+        glClear(GL_DEPTH_BUFFER_BIT);
+    }
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    glGenBuffers(1, &uniformBuffer);
+    glBindBuffer(GL_UNIFORM_BUFFER, uniformBuffer);
+    glBufferData(GL_UNIFORM_BUFFER, sizeof(ShadowData), nullptr, GL_DYNAMIC_DRAW);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+
+    bytes = 2 * GpuMemory::imageBytes(WIDTH, HEIGHT, GL_DEPTH_COMPONENT24);
+    GpuMemory::allocate(GpuMemoryCategory::RenderTargets, bytes);
+    GpuMemory::allocate(GpuMemoryCategory::Buffers, sizeof(ShadowData));
+
+    for (Row& row : rows) resetRow(row, -1);
+    uploadMatrices();
+    std::cout << "Shadow atlas: " << ROWS << " lights x 6 faces of " << FACE_SIZE << "x" << FACE_SIZE
+        << ", " << faceBudget << " faces per frame" << std::endl;
+    return true;
+}
+
+void ShadowAtlas::shutdown() {
+    if (atlas) glDeleteTextures(1, &atlas);
+    if (cache) glDeleteTextures(1, &cache);
+    if (atlasFramebuffer) glDeleteFramebuffers(1, &atlasFramebuffer);
+    if (cacheFramebuffer) glDeleteFramebuffers(1, &cacheFramebuffer);
+    if (uniformBuffer) {
+        glDeleteBuffers(1, &uniformBuffer);
+        GpuMemory::release(GpuMemoryCategory::RenderTargets, bytes);
+        GpuMemory::release(GpuMemoryCategory::Buffers, sizeof(ShadowData));
+    }
+    if (fallbackTexture) glDeleteTextures(1, &fallbackTexture);
+    if (fallbackBuffer) glDeleteBuffers(1, &fallbackBuffer);
+    atlas = cache = atlasFramebuffer = cacheFramebuffer = uniformBuffer = 0;
+    fallbackTexture = fallbackBuffer = 0;
+    bytes = 0;
+    views.clear();
+    pending.clear();
+}
+
+void ShadowAtlas::createFallback() {
+    // Sampler types may not share a unit, so the shadow sampler needs a depth texture of its own
+    const GLuint farDepth = 0xFFFFFFFFu;
+    glGenTextures(1, &fallbackTexture);
+    glBindTexture(GL_TEXTURE_2D, fallbackTexture);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH_COMPONENT24, 1, 1, 0, GL_DEPTH_COMPONENT, GL_UNSIGNED_INT, &farDepth);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_COMPARE_MODE, GL_COMPARE_REF_TO_TEXTURE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_COMPARE_FUNC, GL_LEQUAL);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    // Never read (no light gets a shadow slot), but the block must have a buffer behind it
+    ShadowData data;
+    std::memset(&data, 0, sizeof(data));
+    glGenBuffers(1, &fallbackBuffer);
+    glBindBuffer(GL_UNIFORM_BUFFER, fallbackBuffer);
+    glBufferData(GL_UNIFORM_BUFFER, sizeof(data), &data, GL_STATIC_DRAW);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+}
+
+void ShadowAtlas::setupSamplers(const Shader& shader) {
+    shader.use();
+    shader.setInt("shadowAtlas"_uniform, SHADOW_UNIT);
+}
+
+void ShadowAtlas::bindTexture() {
+    if (!atlas && !fallbackTexture) return;
+    glActiveTexture(GL_TEXTURE0 + SHADOW_UNIT);
+    glBindTexture(GL_TEXTURE_2D, atlas ? atlas : fallbackTexture);
+    glActiveTexture(GL_TEXTURE0);
+    glBindBufferBase(GL_UNIFORM_BUFFER, UniformBuffers::SHADOW_BINDING, atlas ? uniformBuffer : fallbackBuffer);
+}
+
+void ShadowAtlas::addView(const glm::mat4& viewProjection) {
+    if (atlas) views.push_back(viewProjection);
+}
+
+void ShadowAtlas::invalidate() {
+    for (Row& row : rows) {
+        for (Face& face : row.faces) face.cached = false;
+    }
+}
+
+void ShadowAtlas::resetRow(Row& row, int light) {
+    row.light = light;
+    for (Face& face : row.faces) {
+        face = Face();
+        face.matrix = litMatrix();
+    }
+}
+
+void ShadowAtlas::update(const LightingManager& lighting, const glm::mat4& mainViewProjection,
+    const std::vector<ShadowCaster>& casters, const DrawCasters& drawStatic, const DrawCasters& drawMoving) {
+    if (!atlas) return;
+    frame++;
+
+    // What can be seen: this frame's main view and last frame's portal views
+    seenViews.swap(views);
+    views.clear();
+    seenViews.push_back(mainViewProjection);
+    seenPlanes.resize(seenViews.size() * 6);
+    seenCorners.resize(seenViews.size() * 8);
+    for (size_t v = 0; v < seenViews.size(); v++) {
+        extractPlanes(seenViews[v], &seenPlanes[v * 6]);
+        extractCorners(seenViews[v], &seenCorners[v * 8]);
+    }
+
+    // Rows follow the shadowed lights; a row given to another light starts over
+    bool rowsChanged = false;
+    bool used[ROWS] = {};
+    const std::vector<int>& slots = lighting.getShadowSlots();
+    for (size_t i = 0; i < slots.size(); i++) {
+        if (slots[i] < 0) continue;
+        used[slots[i]] = true;
+        if (rows[slots[i]].light != static_cast<int>(i)) {
+            resetRow(rows[slots[i]], static_cast<int>(i));
+            rowsChanged = true;
+        }
+    }
+    for (int r = 0; r < ROWS; r++) {
+        if (!used[r] && rows[r].light >= 0) {
+            resetRow(rows[r], -1);
+            rowsChanged = true;
+        }
+    }
+
+    // Faces that are visible and out of date
+    pending.clear();
+    int skipped = 0;
+    for (int r = 0; r < ROWS; r++) {
+        if (rows[r].light < 0) continue;
+        const PointLight& light = lighting.pointLights[rows[r].light];
+        float lightRange = light.getRange();
+        if (lightRange <= NEAR_PLANE) continue;
+
+        for (int f = 0; f < 6; f++) {
+            Face& face = rows[r].faces[f];
+
+            // The cached far plane holds while the light's range stays within it (and above half of it)
+            bool moved = !face.cached || face.lightPosition != light.position ||
+                lightRange > face.range || lightRange * 2.0f < face.range;
+            float range = moved ? lightRange * RANGE_HEADROOM : face.range;
+            glm::mat4 projection = glm::perspective(glm::radians(90.0f), 1.0f, NEAR_PLANE, range);
+            glm::mat4 view = glm::lookAt(light.position, light.position + FACE_DIRECTIONS[f], FACE_UPS[f]);
+            glm::mat4 viewProjection = projection * view;
+            glm::vec4 planes[6];
+            glm::vec3 corners[8];
+            extractPlanes(viewProjection, planes);
+            extractCorners(viewProjection, corners);
+
+            bool visible = false;
+            for (size_t v = 0; v < seenViews.size() && !visible; v++) {
+                visible = frustaOverlap(planes, corners, &seenPlanes[v * 6], &seenCorners[v * 8]);
+            }
+            if (!visible) {
+                skipped++;
+                continue;
+            }
+
+            // Moving casters inside this face (a caster around the light itself doesn't shadow it)
+            uint64_t hash = 0;
+            for (uint32_t c = 0; c < casters.size(); c++) {
+                const ShadowCaster& caster = casters[c];
+                if (glm::length(caster.center - light.position) < caster.radius) continue;
+                bool inside = true;
+                for (int p = 0; p < 6 && inside; p++) {
+                    inside = glm::dot(glm::vec3(planes[p]), caster.center) + planes[p].w >= -caster.radius;
+                }
+                if (!inside) continue;
+                hash = hashCombine(hash ? hash : 0xCBF29CE484222325ull, &c, sizeof(c));
+                hash = hashCombine(hash, &caster, sizeof(caster));
+            }
+
+            if (!moved && face.rendered && hash == face.casterHash) continue;
+            pending.push_back({ r, f, moved, hash, range, view, projection });
+        }
+    }
+
+    // Oldest first, within the budget
+    std::stable_sort(pending.begin(), pending.end(), [](const Pending& a, const Pending& b) {
+        return rows[a.row].faces[a.face].lastFrame < rows[b.row].faces[b.face].lastFrame;
+        });
+    if (pending.size() > static_cast<size_t>(faceBudget)) pending.resize(faceBudget);
+
+    lastStaticFaces = lastMovingFaces = 0;
+    lastSkippedFaces = skipped;
+    if (!pending.empty()) {
+        GLint viewport[4];
+        glGetIntegerv(GL_VIEWPORT, viewport);
+        glEnable(GL_DEPTH_TEST);
+        glDepthFunc(GL_LESS);
+        glDepthMask(GL_TRUE);
+        glEnable(GL_SCISSOR_TEST);
+        glEnable(GL_POLYGON_OFFSET_FILL);
+        glPolygonOffset(2.0f, 4.0f);  // Slope-scaled bias; the shaders add a normal offset
+
+        for (const Pending& job : pending) {
+            Face& face = rows[job.row].faces[job.face];
+            const PointLight& light = lighting.pointLights[rows[job.row].light];
+            int x = job.face * FACE_SIZE, y = job.row * FACE_SIZE;
+            glViewport(x, y, FACE_SIZE, FACE_SIZE);
+            glScissor(x, y, FACE_SIZE, FACE_SIZE);
+            UniformBuffers::bindView(UniformBuffers::addView(job.view, job.projection, light.position));
+
+            // Static geometry only when the light moved (or the cache was dropped)
+            if (job.moved) {
+                glBindFramebuffer(GL_FRAMEBUFFER, cacheFramebuffer);
+                glClear(GL_DEPTH_BUFFER_BIT);
+                drawStatic(light.position);
+                face.cached = true;
+                face.lightPosition = light.position;
+                face.range = job.range;
+                lastStaticFaces++;
+            }
+
+            // Live tile = cached static depth + the moving casters
+            glBindFramebuffer(GL_READ_FRAMEBUFFER, cacheFramebuffer);
+            glBindFramebuffer(GL_DRAW_FRAMEBUFFER, atlasFramebuffer);
+            glBlitFramebuffer(x, y, x + FACE_SIZE, y + FACE_SIZE, x, y, x + FACE_SIZE, y + FACE_SIZE, GL_DEPTH_BUFFER_BIT, GL_NEAREST);
+            glBindFramebuffer(GL_FRAMEBUFFER, atlasFramebuffer);
+            if (job.casterHash != 0) {
+                drawMoving(light.position);
+                lastMovingFaces++;
+            }
+
+            face.matrix = tileMatrix(job.row, job.face) * job.projection * job.view;
+            face.casterHash = job.casterHash;
+            face.rendered = true;
+            face.lastFrame = frame;
+        }
+
+        glDisable(GL_POLYGON_OFFSET_FILL);
+        glDisable(GL_SCISSOR_TEST);
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        glViewport(viewport[0], viewport[1], viewport[2], viewport[3]);
+    }
+
+    if (!pending.empty() || rowsChanged) uploadMatrices();
+}
+
+void ShadowAtlas::uploadMatrices() {
+    ShadowData data;
+    for (int r = 0; r < ROWS; r++) {
+        for (int f = 0; f < 6; f++) data.matrices[r * 6 + f] = rows[r].faces[f].matrix;
+    }
+    data.tile = glm::vec4(1.0f / 6.0f, 1.0f / ROWS, 0.5f / WIDTH, 0.5f / HEIGHT);
+    glBindBuffer(GL_UNIFORM_BUFFER, uniformBuffer);
+    glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(data), &data);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+}
+
+void ShadowAtlas::printStats() {
+    if (!atlas) return;
+    std::cout << "Shadow faces last frame: " << lastStaticFaces << " static re-rendered, " << lastMovingFaces
+        << " with moving casters, " << lastSkippedFaces << " not visible" << std::endl;
+}
@@ -0,0 +1,186 @@
+#include "TextureStreamer.hpp"
+#include "GpuMemory.hpp"
+#include <cstring>
+#include <iostream>
+
+// Static member definitions - the mapped ring and its regions
+GLuint TextureStreamer::buffer = 0;
+uint8_t* TextureStreamer::mapped = nullptr;
+size_t TextureStreamer::capacity = 0;
+std::deque<TextureStreamer::Region> TextureStreamer::regions;
+uint64_t TextureStreamer::nextRegion = 1;
+bool TextureStreamer::cancelled = false;
+std::mutex TextureStreamer::mutex;
+std::condition_variable TextureStreamer::spaceFreed;
+
+namespace {
+    const size_t REGION_ALIGNMENT = 16;  // Keeps block rows and RGBA texels aligned for the DMA copy
+}
+
+bool TextureStreamer::initialize(size_t ringBytes) {
+    if (mapped) return true;
+    if (!GLEW_VERSION_4_4 && !GLEW_ARB_buffer_storage) {
+        std::cout << "Texture streaming: no ARB_buffer_storage, uploading from client memory" << std::endl;
+        return false;
+    }
+
+    // Persistent + coherent: workers write while the GL thread keeps drawing, no map/unmap per upload
+    const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+    glGenBuffers(1, &buffer);
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, buffer);
+    glBufferStorage(GL_PIXEL_UNPACK_BUFFER, static_cast<GLsizeiptr>(ringBytes), nullptr, flags);
+    mapped = static_cast<uint8_t*>(glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, static_cast<GLsizeiptr>(ringBytes), flags));
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+    if (!mapped) {
+        std::cerr << "Texture streaming: could not map the pixel buffer ring" << std::endl;
+        glDeleteBuffers(1, &buffer);
+        buffer = 0;
+        return false;
+    }
+
+    capacity = ringBytes;
+    cancelled = false;
+    GpuMemory::allocate(GpuMemoryCategory::Buffers, capacity);
+    std::cout << "Texture streaming: " << capacity / (1024 * 1024) << " MB pixel buffer ring" << std::endl;
+    return true;
+}
+
+void TextureStreamer::shutdown() {
+    if (!mapped) return;
+    for (Region& region : regions) {
+        if (region.fence) glDeleteSync(region.fence);
+    }
+    regions.clear();
+
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, buffer);
+    glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    glDeleteBuffers(1, &buffer);
+    GpuMemory::release(GpuMemoryCategory::Buffers, capacity);
+
+    buffer = 0;
+    mapped = nullptr;
+    capacity = 0;
+}
+
+bool TextureStreamer::findSpace(size_t size, size_t& offset) {
+    if (regions.empty()) {
+        offset = 0;
+        return size <= capacity;
+    }
+
+    size_t tail = regions.front().offset;
+    size_t head = regions.back().offset + regions.back().size;
+    head = (head + REGION_ALIGNMENT - 1) & ~(REGION_ALIGNMENT - 1);
+
+    // Newest region starts before the oldest one: free space is the gap between them
+    if (regions.back().offset < tail) {
+        offset = head;
+        return head + size <= tail;
+    }
+
+    // Otherwise after the newest region, or wrapped to the start (the end of the ring is skipped)
+    if (head + size <= capacity) {
+        offset = head;
+        return true;
+    }
+    offset = 0;
+    return size <= tail;
+}
+
+TextureStreamer::Region* TextureStreamer::findRegion(uint64_t id) {
+    for (Region& region : regions) {
+        if (region.id == id) return &region;
+    }
+    return nullptr;
+}
+
+bool TextureStreamer::stage(const DecodedImage& image, int droppedLevels, StagedImage& staged) {
+    if (!mapped || image.levels.empty()) return false;
+
+    size_t first = Texture::firstUploadLevel(image.levels, droppedLevels);
+    size_t size = 0;
+    for (size_t i = first; i < image.levels.size(); i++) size += image.levels[i].size;
+
+    size_t offset;
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        if (size == 0 || size > capacity) return false;
+        spaceFreed.wait(lock, [&] { return cancelled || findSpace(size, offset); });
+        if (cancelled) return false;
+
+        Region region;
+        region.id = nextRegion++;
+        region.offset = offset;
+        region.size = size;
+        regions.push_back(region);
+        staged.region = region.id;
+    }
+
+    // The region is ours until upload() fences it - copy outside the lock
+    staged.format = image.format;
+    staged.levels.clear();
+    size_t cursor = offset;
+    for (size_t i = first; i < image.levels.size(); i++) {
+        ImageLevel level = image.levels[i];
+        std::memcpy(mapped + cursor, image.pixels + level.offset, level.size);
+        level.offset = cursor;
+        staged.levels.push_back(level);
+        cursor += level.size;
+    }
+    return true;
+}
+
+size_t TextureStreamer::upload(GLuint textureID, const StagedImage& staged) {
+    size_t bytes = Texture::uploadStaged(textureID, staged, buffer);
+    GLsync fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+
+    std::lock_guard<std::mutex> lock(mutex);
+    if (Region* region = findRegion(staged.region)) region->fence = fence;
+    else glDeleteSync(fence);
+    return bytes;
+}
+
+void TextureStreamer::discard(const StagedImage& staged) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (Region* region = findRegion(staged.region)) region->discarded = true;
+}
+
+void TextureStreamer::retire() {
+    if (!mapped) return;
+    bool freed = false;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        while (!regions.empty()) {
+            Region& front = regions.front();
+            if (front.fence) {
+                // Zero timeout - only poll, never stall the frame on the copy
+                GLenum status = glClientWaitSync(front.fence, 0, 0);
+                if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED) break;
+                glDeleteSync(front.fence);
+            }
+            else if (!front.discarded) {
+                break;  // Still being written, or waiting for its upload
+            }
+            regions.pop_front();
+            freed = true;
+        }
+    }
+    if (freed) spaceFreed.notify_all();
+}
+
+void TextureStreamer::cancelStaging(bool cancel) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        cancelled = cancel;
+    }
+    spaceFreed.notify_all();
+}
+
+size_t TextureStreamer::getBytesInFlight() {
+    std::lock_guard<std::mutex> lock(mutex);
+    size_t bytes = 0;
+    for (const Region& region : regions) bytes += region.size;
+    return bytes;
+}
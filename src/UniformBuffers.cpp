@@ -0,0 +1,100 @@
+#include "UniformBuffers.hpp"
+#include "GpuMemory.hpp"
+
+// Static member definitions - the shared buffers and this frame's view ranges
+GLuint UniformBuffers::frameBuffer = 0;
+GLuint UniformBuffers::viewBuffer = 0;
+GLsizeiptr UniformBuffers::viewStride = 0;
+int UniformBuffers::maxViews = 0;
+int UniformBuffers::viewCount = 0;
+size_t UniformBuffers::bytes = 0;
+
+namespace {
+    // std140 mirrors of the shader blocks
+    struct FrameData {
+        float time;
+        float pad[3];
+    };
+
+    struct ViewData {
+        glm::mat4 view;
+        glm::mat4 projection;
+        glm::vec4 viewPos;  // vec3 padded to 16 bytes
+    };
+}
+
+void UniformBuffers::initialize(int views) {
+    if (frameBuffer) return;
+
+    GLint alignment = 256;
+    glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+    viewStride = (static_cast<GLsizeiptr>(sizeof(ViewData)) + alignment - 1) / alignment * alignment;
+    maxViews = views;
+
+    glGenBuffers(1, &frameBuffer);
+    glBindBuffer(GL_UNIFORM_BUFFER, frameBuffer);
+    glBufferData(GL_UNIFORM_BUFFER, sizeof(FrameData), nullptr, GL_DYNAMIC_DRAW);
+    glGenBuffers(1, &viewBuffer);
+    glBindBuffer(GL_UNIFORM_BUFFER, viewBuffer);
+    glBufferData(GL_UNIFORM_BUFFER, viewStride * maxViews, nullptr, GL_STREAM_DRAW);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+
+    // The frame block never moves
+    glBindBufferBase(GL_UNIFORM_BUFFER, FRAME_BINDING, frameBuffer);
+
+    bytes = sizeof(FrameData) + static_cast<size_t>(viewStride) * maxViews;
+    GpuMemory::allocate(GpuMemoryCategory::Buffers, bytes);
+}
+
+void UniformBuffers::shutdown() {
+    if (!frameBuffer) return;
+    glDeleteBuffers(1, &frameBuffer);
+    glDeleteBuffers(1, &viewBuffer);
+    GpuMemory::release(GpuMemoryCategory::Buffers, bytes);
+    frameBuffer = viewBuffer = 0;
+    bytes = 0;
+}
+
+void UniformBuffers::bindBlocks(GLuint program) {
+    const struct { const char* name; GLuint binding; } blocks[] = {
+        { "FrameData", FRAME_BINDING }, { "ViewData", VIEW_BINDING }, { "LightingData", LIGHTING_BINDING },
+        { "ShadowData", SHADOW_BINDING }
+    };
+    for (const auto& block : blocks) {
+        GLuint index = glGetUniformBlockIndex(program, block.name);
+        if (index != GL_INVALID_INDEX) glUniformBlockBinding(program, index, block.binding);
+    }
+}
+
+void UniformBuffers::beginFrame(float time) {
+    if (!frameBuffer) return;
+
+    FrameData frame = { time, { 0.0f, 0.0f, 0.0f } };
+    glBindBuffer(GL_UNIFORM_BUFFER, frameBuffer);
+    glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(frame), &frame);
+
+    // Orphan last frame's views, so writing this frame's never waits for the GPU to read them
+    glBindBuffer(GL_UNIFORM_BUFFER, viewBuffer);
+    glBufferData(GL_UNIFORM_BUFFER, viewStride * maxViews, nullptr, GL_STREAM_DRAW);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+    viewCount = 0;
+}
+
+int UniformBuffers::addView(const glm::mat4& view, const glm::mat4& projection, const glm::vec3& viewPos) {
+    // More views than ranges (deep portal recursion) - start over in a fresh buffer
+    if (viewCount == maxViews) {
+        glBindBuffer(GL_UNIFORM_BUFFER, viewBuffer);
+        glBufferData(GL_UNIFORM_BUFFER, viewStride * maxViews, nullptr, GL_STREAM_DRAW);
+        viewCount = 0;
+    }
+
+    ViewData data = { view, projection, glm::vec4(viewPos, 1.0f) };
+    glBindBuffer(GL_UNIFORM_BUFFER, viewBuffer);
+    glBufferSubData(GL_UNIFORM_BUFFER, viewStride * viewCount, sizeof(data), &data);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+    return viewCount++;
+}
+
+void UniformBuffers::bindView(int index) {
+    glBindBufferRange(GL_UNIFORM_BUFFER, VIEW_BINDING, viewBuffer, viewStride * index, sizeof(ViewData));
+}
@@ -0,0 +1,595 @@
+#include "VirtualTexture.hpp"
+#include "texture.hpp"
+#include "GpuMemory.hpp"
+#include <algorithm>
+#include <memory>
+#include <iostream>
+
+// Static member definitions - GPU objects, page bookkeeping and the loader thread
+int VirtualTexture::cacheSize = 0;
+GLuint VirtualTexture::cache = 0;
+GLuint VirtualTexture::pageTableBuffer = 0;
+GLuint VirtualTexture::pageTable = 0;
+GLuint VirtualTexture::infoBuffer = 0;
+GLuint VirtualTexture::info = 0;
+GLuint VirtualTexture::feedbackBuffer = 0;
+std::vector<VirtualTexture::Readback> VirtualTexture::readbacks;
+size_t VirtualTexture::gpuBytes = 0;
+std::vector<VirtualTexture::Source> VirtualTexture::sources;
+std::vector<VirtualTexture::Entry> VirtualTexture::entries;
+std::vector<VirtualTexture::Slot> VirtualTexture::slots;
+std::vector<int32_t> VirtualTexture::materialSources;
+uint32_t VirtualTexture::frame = 1;
+int VirtualTexture::residentPages = 0;
+int VirtualTexture::loadsInFlight = 0;
+size_t VirtualTexture::pagesUploaded = 0;
+size_t VirtualTexture::pagesDropped = 0;
+std::thread VirtualTexture::loader;
+std::mutex VirtualTexture::mutex;
+std::condition_variable VirtualTexture::wake;
+std::deque<VirtualTexture::Job> VirtualTexture::jobs;
+std::deque<VirtualTexture::JobResult> VirtualTexture::results;
+bool VirtualTexture::stopping = false;
+
+namespace {
+    // Must match standard.frag
+    const int PAGE_SIZE = 128;
+    const int PAGE_BORDER = 4;                           // Wrapped texels around a page for bilinear filtering
+    const int SLOT_SIZE = PAGE_SIZE + 2 * PAGE_BORDER;
+    const uint32_t TAIL_SIZE = 64;                       // Levels this small and below share the tail page
+    const int TAIL_GUTTER = 2;
+    const int MAX_TAIL_LEVELS = 7;                       // 64x64 down to 1x1
+    const int TAIL_ORIGIN[MAX_TAIL_LEVELS][2] = {        // Tail levels inside their slot (gutter included)
+        { 2, 2 }, { 70, 2 }, { 106, 2 }, { 2, 70 }, { 14, 70 }, { 22, 70 }, { 28, 70 }
+    };
+
+    const GLint CACHE_UNIT = 4;                          // After the material units (0-3)
+    const GLint PAGE_TABLE_UNIT = 5;
+    const GLint INFO_UNIT = 6;
+    const GLuint FEEDBACK_BINDING = 3;                   // After GpuDrivenRenderer's SSBOs (0-2)
+
+    const uint32_t MAX_ENTRIES = 1 << 18;                // Page table / feedback size (1 MB each)
+    const uint32_t MAX_MATERIALS = 4096;
+    const int READBACK_FRAMES = 3;                       // Feedback copies in flight
+    const int MAX_UPLOADS_PER_FRAME = 16;                // ~1 MB of page data
+    const int MAX_LOADS_IN_FLIGHT = 32;
+    const uint32_t EVICT_AFTER_FRAMES = 8;               // Pages requested this recently are never evicted
+    const size_t MAX_CACHED_IMAGES = 8;                  // Decoded chains kept by the loader thread
+
+    // Page table entry: physical slot, level it holds (the requested one or an ancestor), resident bit
+    uint32_t packEntry(int slot, int cacheSize, int level) {
+        return static_cast<uint32_t>(slot % cacheSize) | (static_cast<uint32_t>(slot / cacheSize) << 8) |
+            (static_cast<uint32_t>(level) << 16) | (1u << 24);
+    }
+
+    uint32_t levelWidth(uint32_t width, int level) { return std::max(1u, width >> level); }
+    uint32_t pageCount(uint32_t size) { return (size + PAGE_SIZE - 1) / PAGE_SIZE; }
+
+    // Texel of a level with repeat wrapping, expanded to RGBA (R8 chains are grey)
+    void fetchTexel(const DecodedImage& image, const ImageLevel& level, int x, int y, uint8_t* out) {
+        int width = static_cast<int>(level.width), height = static_cast<int>(level.height);
+        x %= width;
+        y %= height;
+        if (x < 0) x += width;
+        if (y < 0) y += height;
+
+        if (image.format == BlockFormat::R8) {
+            uint8_t grey = image.pixels[level.offset + size_t(y) * width + x];
+            out[0] = out[1] = out[2] = grey;
+            out[3] = 255;
+            return;
+        }
+        const uint8_t* texel = image.pixels + level.offset + (size_t(y) * width + x) * 4;
+        out[0] = texel[0];
+        out[1] = texel[1];
+        out[2] = texel[2];
+        out[3] = texel[3];
+    }
+}
+
+bool VirtualTexture::initialize(int requestedSize) {
+    if (cache) return true;
+    if (!GLEW_VERSION_4_3) {
+        std::cout << "Virtual texturing needs OpenGL 4.3" << std::endl;
+        return false;
+    }
+
+    // Slot coordinates are 8 bits in the page table
+    GLint maxTextureSize = 0;
+    glGetIntegerv(GL_MAX_TEXTURE_SIZE, &maxTextureSize);
+    cacheSize = std::min(std::min(requestedSize, maxTextureSize / SLOT_SIZE), 255);
+    GLsizei cachePixels = cacheSize * SLOT_SIZE;
+
+    glGenTextures(1, &cache);
+    glBindTexture(GL_TEXTURE_2D, cache);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, cachePixels, cachePixels, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, 0);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+    // Page table and per-material info are buffer textures, zero = nothing resident / not registered
+    std::vector<uint32_t> zeros(MAX_ENTRIES, 0);
+    auto createBufferTexture = [&](GLuint& buffer, GLuint& texture, GLenum format, size_t bytes) {
+        glGenBuffers(1, &buffer);
+        glBindBuffer(GL_TEXTURE_BUFFER, buffer);
+        glBufferData(GL_TEXTURE_BUFFER, static_cast<GLsizeiptr>(bytes), zeros.data(), GL_DYNAMIC_DRAW);
+        glGenTextures(1, &texture);
+        glBindTexture(GL_TEXTURE_BUFFER, texture);
+        glTexBuffer(GL_TEXTURE_BUFFER, format, buffer);
+        };
+    createBufferTexture(pageTableBuffer, pageTable, GL_R32UI, MAX_ENTRIES * sizeof(uint32_t));
+    createBufferTexture(infoBuffer, info, GL_RGBA32UI, MAX_MATERIALS * 4 * sizeof(uint32_t));
+    glBindTexture(GL_TEXTURE_BUFFER, 0);
+    glBindBuffer(GL_TEXTURE_BUFFER, 0);
+
+    // Feedback never needs clearing - every frame writes its own stamp
+    glGenBuffers(1, &feedbackBuffer);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, feedbackBuffer);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, MAX_ENTRIES * sizeof(uint32_t), zeros.data(), GL_DYNAMIC_COPY);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+    readbacks.resize(READBACK_FRAMES);
+    for (Readback& readback : readbacks) {
+        glGenBuffers(1, &readback.buffer);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, readback.buffer);
+        glBufferData(GL_COPY_WRITE_BUFFER, MAX_ENTRIES * sizeof(uint32_t), nullptr, GL_STREAM_READ);
+    }
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+    slots.assign(size_t(cacheSize) * cacheSize, Slot());
+    gpuBytes = GpuMemory::imageBytes(cachePixels, cachePixels, GL_RGBA8) +
+        (MAX_ENTRIES * 2 + MAX_ENTRIES * READBACK_FRAMES + MAX_MATERIALS * 4) * sizeof(uint32_t);
+    GpuMemory::allocate(GpuMemoryCategory::VirtualTextures, gpuBytes);
+
+    stopping = false;
+    loader = std::thread(loaderLoop);
+    std::cout << "Virtual texturing: " << cacheSize * cacheSize << " pages of " << PAGE_SIZE << "x" << PAGE_SIZE
+        << " (" << gpuBytes / (1024 * 1024) << " MB resident)" << std::endl;
+    return true;
+}
+
+void VirtualTexture::shutdown() {
+    if (!cache) return;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wake.notify_all();
+    loader.join();
+    jobs.clear();
+    results.clear();
+
+    for (Readback& readback : readbacks) {
+        if (readback.fence) glDeleteSync(readback.fence);
+        glDeleteBuffers(1, &readback.buffer);
+    }
+    readbacks.clear();
+    glDeleteTextures(1, &cache);
+    glDeleteTextures(1, &pageTable);
+    glDeleteTextures(1, &info);
+    glDeleteBuffers(1, &pageTableBuffer);
+    glDeleteBuffers(1, &infoBuffer);
+    glDeleteBuffers(1, &feedbackBuffer);
+    GpuMemory::release(GpuMemoryCategory::VirtualTextures, gpuBytes);
+
+    cache = pageTable = info = pageTableBuffer = infoBuffer = feedbackBuffer = 0;
+    gpuBytes = 0;
+    sources.clear();
+    entries.clear();
+    slots.clear();
+    materialSources.clear();
+    residentPages = 0;
+    loadsInFlight = 0;
+}
+
+void VirtualTexture::addMaterial(uint32_t material, const std::string& path) {
+    if (!cache || material >= MAX_MATERIALS || path.empty()) return;
+    if (materialSources.size() <= material) materialSources.resize(material + 1, -1);
+
+    for (size_t i = 0; i < sources.size(); i++) {
+        if (sources[i].path != path) continue;
+        materialSources[material] = static_cast<int32_t>(i);
+        if (sources[i].probed) writeInfo(material, sources[i]);
+        return;
+    }
+
+    // New image - the loader reads its size first
+    Source source;
+    source.path = path;
+    sources.push_back(source);
+    uint32_t sourceIndex = static_cast<uint32_t>(sources.size() - 1);
+    materialSources[material] = static_cast<int32_t>(sourceIndex);
+
+    Job job;
+    job.source = sourceIndex;
+    job.path = path;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        jobs.push_back(job);
+    }
+    wake.notify_one();
+}
+
+void VirtualTexture::setupSamplers(const Shader& shader) {
+    if (!cache) return;
+    shader.use();
+    shader.setInt("vtCache"_uniform, CACHE_UNIT);
+    shader.setInt("vtPageTable"_uniform, PAGE_TABLE_UNIT);
+    shader.setInt("vtInfo"_uniform, INFO_UNIT);
+
+    GLuint block = glGetProgramResourceIndex(shader.ID, GL_SHADER_STORAGE_BLOCK, "VirtualFeedback");
+    if (block != GL_INVALID_INDEX) glShaderStorageBlockBinding(shader.ID, block, FEEDBACK_BINDING);
+}
+
+void VirtualTexture::bindTextures() {
+    glActiveTexture(GL_TEXTURE0 + CACHE_UNIT);
+    glBindTexture(GL_TEXTURE_2D, cache);
+    glActiveTexture(GL_TEXTURE0 + PAGE_TABLE_UNIT);
+    glBindTexture(GL_TEXTURE_BUFFER, pageTable);
+    glActiveTexture(GL_TEXTURE0 + INFO_UNIT);
+    glBindTexture(GL_TEXTURE_BUFFER, info);
+    glActiveTexture(GL_TEXTURE0);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, FEEDBACK_BINDING, feedbackBuffer);
+}
+
+void VirtualTexture::setupView(const Shader& shader) {
+    // One pixel of every 4x4 tile reports per frame, cycling through the tile over 16 frames
+    static const int JITTER[16] = { 0, 10, 2, 8, 5, 15, 7, 13, 1, 11, 3, 9, 4, 14, 6, 12 };
+    int jitter = JITTER[frame % 16];
+    shader.setUint("vtFeedbackStamp"_uniform, frame);
+    shader.setIVec2("vtFeedbackJitter"_uniform, jitter % 4, jitter / 4);
+}
+
+void VirtualTexture::update() {
+    if (!cache) return;
+
+    // 1. Feedback the GPU has finished copying (a few frames old, never waits)
+    std::vector<uint32_t> feedback;
+    for (Readback& readback : readbacks) {
+        if (!readback.fence) continue;
+        GLenum status = glClientWaitSync(readback.fence, 0, 0);
+        if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED) continue;
+        glDeleteSync(readback.fence);
+        readback.fence = nullptr;
+
+        feedback.resize(readback.count);
+        glBindBuffer(GL_COPY_READ_BUFFER, readback.buffer);
+        glGetBufferSubData(GL_COPY_READ_BUFFER, 0, readback.count * sizeof(uint32_t), feedback.data());
+        glBindBuffer(GL_COPY_READ_BUFFER, 0);
+        processFeedback(feedback, readback.stamp);
+    }
+
+    // 2. Finished loader work - probes allocate page table entries, pages go into the cache
+    std::deque<JobResult> finished;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        while (!results.empty() && finished.size() < static_cast<size_t>(MAX_UPLOADS_PER_FRAME)) {
+            finished.push_back(std::move(results.front()));
+            results.pop_front();
+        }
+    }
+    for (JobResult& result : finished) {
+        if (result.entry < 0) {
+            allocateEntries(result.source, result);
+            continue;
+        }
+        loadsInFlight--;
+        uploadPage(result);
+    }
+
+    // 3. Point every changed page table at the pages now resident
+    for (Source& source : sources) {
+        if (source.dirty) rebuildPageTable(source);
+    }
+
+    frame++;
+}
+
+void VirtualTexture::endFrame() {
+    if (!cache || entries.empty()) return;
+
+    // Skip the copy while every readback is still in flight - the pages get requested again
+    for (Readback& readback : readbacks) {
+        if (readback.fence) continue;
+
+        // Shader writes must land before the copy reads them
+        glMemoryBarrier(GL_BUFFER_UPDATE_BARRIER_BIT);
+        readback.count = static_cast<uint32_t>(entries.size());
+        readback.stamp = frame;
+        glBindBuffer(GL_COPY_READ_BUFFER, feedbackBuffer);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, readback.buffer);
+        glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, readback.count * sizeof(uint32_t));
+        glBindBuffer(GL_COPY_READ_BUFFER, 0);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+        readback.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        return;
+    }
+}
+
+void VirtualTexture::allocateEntries(uint32_t sourceIndex, const JobResult& result) {
+    Source& source = sources[sourceIndex];
+    if (!result.ok) {
+        std::cerr << "Virtual texture: could not read " << source.path << std::endl;
+        return;
+    }
+
+    source.width = result.width;
+    source.height = result.height;
+    source.levels = result.levels;
+    source.tailLevel = 0;
+    while (source.tailLevel < source.levels - 1 &&
+        std::max(levelWidth(source.width, source.tailLevel), levelWidth(source.height, source.tailLevel)) > TAIL_SIZE) {
+        source.tailLevel++;
+    }
+
+    // Page grids of the levels above the tail, then the tail entry
+    source.levelBase.clear();
+    uint32_t count = 0;
+    for (int level = 0; level <= source.tailLevel; level++) {
+        source.levelBase.push_back(static_cast<uint32_t>(entries.size()) + count);
+        if (level < source.tailLevel) {
+            count += pageCount(levelWidth(source.width, level)) * pageCount(levelWidth(source.height, level));
+        }
+    }
+    count++;
+    if (entries.size() + count > MAX_ENTRIES) {
+        std::cerr << "Virtual texture: page table full, " << source.path << " left out" << std::endl;
+        return;
+    }
+
+    source.entryBase = static_cast<uint32_t>(entries.size());
+    source.entryCount = count;
+    for (int level = 0; level <= source.tailLevel; level++) {
+        uint32_t pagesX = level < source.tailLevel ? pageCount(levelWidth(source.width, level)) : 1;
+        uint32_t pagesY = level < source.tailLevel ? pageCount(levelWidth(source.height, level)) : 1;
+        for (uint32_t y = 0; y < pagesY; y++) {
+            for (uint32_t x = 0; x < pagesX; x++) {
+                Entry entry;
+                entry.source = sourceIndex;
+                entry.level = static_cast<uint16_t>(level);
+                entry.x = static_cast<uint16_t>(x);
+                entry.y = static_cast<uint16_t>(y);
+                entries.push_back(entry);
+            }
+        }
+    }
+    source.probed = true;
+
+    for (size_t material = 0; material < materialSources.size(); material++) {
+        if (materialSources[material] == static_cast<int32_t>(sourceIndex)) {
+            writeInfo(static_cast<uint32_t>(material), source);
+        }
+    }
+
+    // The tail right away, so there is something to show before any feedback arrives
+    Entry& tail = entries[source.entryBase + source.entryCount - 1];
+    tail.loading = true;
+    loadsInFlight++;
+    Job job;
+    job.source = sourceIndex;
+    job.entry = static_cast<int32_t>(source.entryBase + source.entryCount - 1);
+    job.path = source.path;
+    job.level = job.tailLevel = source.tailLevel;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        jobs.push_back(job);
+    }
+    wake.notify_one();
+}
+
+void VirtualTexture::writeInfo(uint32_t material, const Source& source) {
+    uint32_t row[4] = { source.entryBase, source.width, source.height,
+        static_cast<uint32_t>(source.levels) | (static_cast<uint32_t>(source.tailLevel) << 8) };
+    glBindBuffer(GL_TEXTURE_BUFFER, infoBuffer);
+    glBufferSubData(GL_TEXTURE_BUFFER, material * sizeof(row), sizeof(row), row);
+    glBindBuffer(GL_TEXTURE_BUFFER, 0);
+}
+
+int32_t VirtualTexture::parentEntry(uint32_t index) {
+    const Entry& entry = entries[index];
+    const Source& source = sources[entry.source];
+    int parent = entry.level + 1;
+    if (entry.level >= source.tailLevel) return -1;
+    if (parent == source.tailLevel) return static_cast<int32_t>(source.levelBase[parent]);
+
+    uint32_t pagesX = pageCount(levelWidth(source.width, parent));
+    return static_cast<int32_t>(source.levelBase[parent] + (entry.y / 2u) * pagesX + entry.x / 2u);
+}
+
+void VirtualTexture::request(uint32_t index, std::vector<uint32_t>& missing) {
+    // The page and all its ancestors - coarser levels are what gets shown while finer ones load
+    for (int32_t current = static_cast<int32_t>(index); current >= 0; current = parentEntry(current)) {
+        Entry& entry = entries[current];
+        if (entry.requestedFrame == frame) return;  // Rest of the chain already handled
+        entry.requestedFrame = frame;
+
+        if (entry.slot >= 0) slots[entry.slot].lastUsed = frame;
+        else if (!entry.loading) missing.push_back(static_cast<uint32_t>(current));
+    }
+}
+
+void VirtualTexture::processFeedback(const std::vector<uint32_t>& feedback, uint32_t stamp) {
+    std::vector<uint32_t> missing;
+    for (uint32_t index = 0; index < feedback.size(); index++) {
+        if (feedback[index] == stamp) request(index, missing);
+    }
+    if (missing.empty()) return;
+
+    // Coarse levels first - each one covers four times the area of the level below
+    std::sort(missing.begin(), missing.end(), [](uint32_t a, uint32_t b) {
+        return entries[a].level > entries[b].level;
+        });
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (uint32_t index : missing) {
+            if (loadsInFlight >= MAX_LOADS_IN_FLIGHT) break;
+            Entry& entry = entries[index];
+            const Source& source = sources[entry.source];
+            entry.loading = true;
+            loadsInFlight++;
+
+            Job job;
+            job.source = entry.source;
+            job.entry = static_cast<int32_t>(index);
+            job.path = source.path;
+            job.level = entry.level;
+            job.tailLevel = source.tailLevel;
+            job.x = entry.x;
+            job.y = entry.y;
+            jobs.push_back(job);
+        }
+    }
+    wake.notify_one();
+}
+
+int32_t VirtualTexture::allocateSlot() {
+    // Free slot, else the least recently requested page that no recent frame asked for
+    int32_t victim = -1;
+    for (size_t i = 0; i < slots.size(); i++) {
+        if (slots[i].entry < 0) return static_cast<int32_t>(i);
+        if (slots[i].lastUsed + EVICT_AFTER_FRAMES >= frame) continue;
+        if (victim < 0 || slots[i].lastUsed < slots[victim].lastUsed) victim = static_cast<int32_t>(i);
+    }
+    if (victim < 0) return -1;
+
+    Entry& evicted = entries[slots[victim].entry];
+    evicted.slot = -1;
+    sources[evicted.source].dirty = true;
+    slots[victim].entry = -1;
+    residentPages--;
+    return victim;
+}
+
+void VirtualTexture::uploadPage(const JobResult& result) {
+    Entry& entry = entries[result.entry];
+    entry.loading = false;
+    if (!result.ok) return;
+
+    // Every page is wanted right now - the request comes back next readback if still visible
+    int32_t slot = allocateSlot();
+    if (slot < 0) {
+        pagesDropped++;
+        return;
+    }
+
+    glBindTexture(GL_TEXTURE_2D, cache);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, (slot % cacheSize) * SLOT_SIZE, (slot / cacheSize) * SLOT_SIZE,
+        SLOT_SIZE, SLOT_SIZE, GL_RGBA, GL_UNSIGNED_BYTE, result.pixels.data());
+
+    entry.slot = slot;
+    slots[slot].entry = result.entry;
+    slots[slot].lastUsed = frame;
+    sources[entry.source].dirty = true;
+    residentPages++;
+    pagesUploaded++;
+}
+
+void VirtualTexture::rebuildPageTable(Source& source) {
+    source.dirty = false;
+    if (!source.probed) return;
+
+    // Coarse to fine, so every missing page can take its parent's already resolved value
+    std::vector<uint32_t> table(source.entryCount, 0);
+    for (int level = source.tailLevel; level >= 0; level--) {
+        uint32_t first = source.levelBase[level];
+        uint32_t last = level == source.tailLevel ? first + 1 : source.levelBase[level + 1];
+
+        for (uint32_t index = first; index < last; index++) {
+            const Entry& entry = entries[index];
+            if (entry.slot >= 0) {
+                table[index - source.entryBase] = packEntry(entry.slot, cacheSize, entry.level);
+                continue;
+            }
+            int32_t parent = parentEntry(index);
+            if (parent >= 0) table[index - source.entryBase] = table[parent - source.entryBase];
+        }
+    }
+
+    glBindBuffer(GL_TEXTURE_BUFFER, pageTableBuffer);
+    glBufferSubData(GL_TEXTURE_BUFFER, source.entryBase * sizeof(uint32_t), table.size() * sizeof(uint32_t), table.data());
+    glBindBuffer(GL_TEXTURE_BUFFER, 0);
+}
+
+void VirtualTexture::loaderLoop() {
+    // Recently used uncompressed chains, most recent at the back (only this thread touches them)
+    std::deque<std::pair<std::string, std::unique_ptr<DecodedImage>>> images;
+    auto findImage = [&](const std::string& path) -> const DecodedImage* {
+        for (auto it = images.begin(); it != images.end(); ++it) {
+            if (it->first != path) continue;
+            auto found = std::move(*it);
+            images.erase(it);
+            images.push_back(std::move(found));
+            return images.back().second.get();
+        }
+        std::unique_ptr<DecodedImage> image(new DecodedImage());
+        if (!Texture::decodeUncompressed(path, *image) || image->levels.empty()) return nullptr;
+        if (images.size() >= MAX_CACHED_IMAGES) images.pop_front();
+        images.emplace_back(path, std::move(image));
+        return images.back().second.get();
+        };
+
+    while (true) {
+        Job job;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            wake.wait(lock, [] { return stopping || !jobs.empty(); });
+            if (stopping) return;
+            job = std::move(jobs.front());
+            jobs.pop_front();
+        }
+
+        JobResult result;
+        result.source = job.source;
+        result.entry = job.entry;
+        const DecodedImage* image = findImage(job.path);
+        if (image && job.entry < 0) {
+            result.width = image->levels[0].width;
+            result.height = image->levels[0].height;
+            result.levels = static_cast<int>(image->levels.size());
+            result.ok = true;
+        }
+        else if (image) {
+            result.pixels.assign(size_t(SLOT_SIZE) * SLOT_SIZE * 4, 0);
+            auto texel = [&](int x, int y) { return &result.pixels[(size_t(y) * SLOT_SIZE + x) * 4]; };
+
+            if (job.level < job.tailLevel) {
+                // One page with a wrapped border (repeat addressing, same as the regular textures)
+                const ImageLevel& level = image->levels[job.level];
+                int originX = job.x * PAGE_SIZE - PAGE_BORDER, originY = job.y * PAGE_SIZE - PAGE_BORDER;
+                for (int y = 0; y < SLOT_SIZE; y++) {
+                    for (int x = 0; x < SLOT_SIZE; x++) {
+                        fetchTexel(*image, level, originX + x, originY + y, texel(x, y));
+                    }
+                }
+            }
+            else {
+                // Every tail level at its fixed spot, each with a wrapped gutter
+                int tailLevels = std::min(static_cast<int>(image->levels.size()) - job.tailLevel, MAX_TAIL_LEVELS);
+                for (int k = 0; k < tailLevels; k++) {
+                    const ImageLevel& level = image->levels[job.tailLevel + k];
+                    int width = static_cast<int>(level.width), height = static_cast<int>(level.height);
+                    for (int y = -TAIL_GUTTER; y < height + TAIL_GUTTER; y++) {
+                        for (int x = -TAIL_GUTTER; x < width + TAIL_GUTTER; x++) {
+                            fetchTexel(*image, level, x, y, texel(TAIL_ORIGIN[k][0] + x, TAIL_ORIGIN[k][1] + y));
+                        }
+                    }
+                }
+            }
+            result.ok = true;
+        }
+
+        std::lock_guard<std::mutex> lock(mutex);
+        results.push_back(std::move(result));
+    }
+}
+
+void VirtualTexture::printStats() {
+    if (!cache) return;
+    std::cout << "Virtual textures: " << sources.size() << " images, " << entries.size() << " pages, "
+        << residentPages << "/" << slots.size() << " resident (" << pagesUploaded << " uploaded, "
+        << pagesDropped << " dropped for a full cache)" << std::endl;
+}
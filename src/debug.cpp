@@ -1,4 +1,8 @@
 ﻿#include "debug.hpp"
+#include "GpuMemory.hpp"
+#include "AssetRegistry.hpp"
+#include "VirtualTexture.hpp"
+#include "ClusteredLighting.hpp"
 #include <iostream>
 #include <iomanip>
 #include <sstream>
@@ -11,6 +15,7 @@ bool DebugSystem::showPortalInfo = true;
 bool DebugSystem::showLightingInfo = false;
 bool DebugSystem::showSceneInfo = false;
 bool DebugSystem::showCameraInfo = true;
+bool DebugSystem::showMemoryInfo = true;
 
 // Performance tracking variables
 float DebugSystem::frameTime = 0.0f;
@@ -27,6 +32,7 @@ void DebugSystem::initialize() {
     std::cout << "  F3 - Lighting information" << std::endl;
     std::cout << "  F4 - Scene information" << std::endl;
     std::cout << "  F5 - Camera information" << std::endl;
+    std::cout << "  F6 - GPU memory" << std::endl;
     std::cout << "=======================================" << std::endl;
 }
 
@@ -77,20 +83,26 @@ void DebugSystem::printLightingInfo(const LightingManager& lightingManager) {
     std::cout << "\n=== LIGHTING INFO ===" << std::endl;
     std::cout << "Point lights: " << lightingManager.pointLights.size() << std::endl;
     std::cout << "Ambient strength: " << lightingManager.ambientStrength << std::endl;
+    ClusteredLighting::printStats();
     std::cout << "======================" << std::endl;
 }
 
+void DebugSystem::printMemoryInfo() {
+    if (!showMemoryInfo || !debugMode) return;
+
+    std::cout << "\n=== GPU MEMORY ===" << std::endl;
+    GpuMemory::printReport();
+    std::cout << "Reduced textures: " << AssetRegistry::getReducedTextureCount() << " of "
+        << AssetRegistry::getTextureCount() << std::endl;
+    VirtualTexture::printStats();
+    std::cout << "==================" << std::endl;
+}
+
 void DebugSystem::printSceneInfo(const Scene& scene,
-    const std::unique_ptr<Model>& bookModel,
-    const std::unique_ptr<Model>& bookshelfModel,
-    const std::unique_ptr<Model>& bookshelf2Model,
-    const std::unique_ptr<Model>& columnModel,
-    const std::unique_ptr<Model>& floorModel,
-    const std::unique_ptr<Model>& lampModel,
-    const std::unique_ptr<Model>& portalModel,
-    const std::unique_ptr<Model>& ceilingModel,
-    const std::unique_ptr<Model>& wallModel,
-    const std::unique_ptr<Model>& torchModel) {
+    const Model* bookModel,
+    const Model* bookshelfModel,
+    const Model* bookshelf2Model,
+    const Model* torchModel) {
 
     if (!showSceneInfo || !debugMode) return;
 
@@ -100,9 +112,9 @@ void DebugSystem::printSceneInfo(const Scene& scene,
     // Count different object types by comparing model pointers
     int books = 0, shelves = 0, torches = 0, animated = 0;
     for (const auto& obj : scene.objects) {
-        if (obj.model == bookModel.get()) books++;
-        else if (obj.model == bookshelfModel.get() || obj.model == bookshelf2Model.get()) shelves++;
-        else if (obj.model == torchModel.get()) torches++;
+        if (obj.model == bookModel) books++;
+        else if (obj.model == bookshelfModel || obj.model == bookshelf2Model) shelves++;
+        else if (obj.model == torchModel) torches++;
 
         // Count objects with any animation enabled
         if (obj.rotating || obj.floating || obj.orbiting || obj.pulsing) animated++;
@@ -142,4 +154,9 @@ void DebugSystem::toggleSceneInfo() {
 void DebugSystem::toggleCameraInfo() {
     showCameraInfo = !showCameraInfo;
     std::cout << "Camera info: " << (showCameraInfo ? "ON" : "OFF") << std::endl;
+}
+
+void DebugSystem::toggleMemoryInfo() {
+    showMemoryInfo = !showMemoryInfo;
+    std::cout << "GPU memory info: " << (showMemoryInfo ? "ON" : "OFF") << std::endl;
 }
\ No newline at end of file
@@ -10,19 +10,38 @@ extern "C" {
 #include <glm/gtc/matrix_transform.hpp>
 #include <iostream>
 #include <vector>
+#include <algorithm>
 #include <memory>
 #include <cmath>
 #include <cstdlib>
 #include <ctime>
+#include <chrono>
 
 #include "shader.hpp"
 #include "texture.hpp"
 #include "model.hpp"
 #include "scene.hpp"
 #include "TextureManager.hpp"
+#include "MaterialManager.hpp"
 #include "LightingManager.hpp"
 #include "portals.hpp"
 #include "debug.hpp"
+#include "AssetArchive.hpp"
+#include "GpuDrivenRenderer.hpp"
+#include "AnimatedInstanceRenderer.hpp"
+#include "AsyncLoader.hpp"
+#include "AssetRegistry.hpp"
+#include "GpuMemory.hpp"
+#include "TextureStreamer.hpp"
+#include "VirtualTexture.hpp"
+#include "UniformBuffers.hpp"
+#include "ShaderVariants.hpp"
+#include "ClusteredLighting.hpp"
+#include "DeferredRenderer.hpp"
+#include "Lightmap.hpp"
+#include "ShadowAtlas.hpp"
+#include "LightAnimator.hpp"
+#include "PostProcess.hpp"
 
 // Application constants
 namespace Config {
@@ -33,8 +52,36 @@ namespace Config {
     const int NUM_SIDES = 8;
     const float CAMERA_SPEED = 2.5f;
     const float MOUSE_SENSITIVITY = 0.2f;
+    const double UPLOAD_BUDGET_MS = 4.0;  // GL time per frame spent on streamed asset uploads
+    const size_t UPLOAD_BUDGET_BYTES = 8 * 1024 * 1024;     // Texture data submitted per frame
+    const size_t STREAMING_RING_BYTES = 64 * 1024 * 1024;   // Pixel buffer ring for texture uploads
+    const GLsizei MATERIAL_LAYER_SIZE = 1024;  // Texture array layer size for the array material backend
+    const int VIRTUAL_CACHE_PAGES = 24;        // Virtual texture cache is 24x24 pages of 128x128 (~40 MB)
+    const int SHADOW_FACES_PER_FRAME = 12;     // Point shadow faces re-rendered per frame at most (ShadowAtlas)
+    const int MAX_VIEWS_PER_FRAME = 64 + SHADOW_FACES_PER_FRAME; // Camera ranges in the per-view uniform buffer (main, portal and shadow views)
 }
 
+// Meshes used by the library (references keep them loaded)
+struct LibraryModels {
+    ModelRef book, bookshelf, bookshelf2, column, floor, ceiling, wall, torch, lamp, doorFrame;
+};
+
+// Materials used by the library (handles into MaterialManager)
+struct LibraryMaterials {
+    MaterialHandle book, bookshelf, column, floor, ceiling, wall, doorFrame, torch, lamp;
+};
+
+// Static room geometry. setupScene places it first, in this order, and --bake-lightmaps bakes it
+// (the lightmap is matched to the scene by object order and exact model matrices).
+enum class StaticPart { Floor, Ceiling, Wall, Column, DoorFrame, Bookshelf, Bookshelf2, Count };
+
+struct StaticPlacement {
+    StaticPart part;
+    glm::vec3 position;
+    glm::vec3 rotation;
+    glm::vec3 scale;
+};
+
 // Camera controls
 float yaw = -90.0f;
 float pitch = 0.0f;
@@ -52,16 +99,35 @@ static bool f2Pressed = false;
 static bool f3Pressed = false;
 static bool f4Pressed = false;
 static bool f5Pressed = false;
+static bool f6Pressed = false;
+static bool gpuDrivenPressed = false;
+static bool materialBackendPressed = false;
+static bool clusteredLightingPressed = false;
+static bool deferredShadingPressed = false;
 static bool recursivePortalsEnabled = true;
+static bool gpuDrivenEnabled = false;
+static bool clusteredLightingEnabled = true;
+static bool deferredShadingEnabled = false;
 
 void framebuffer_size_callback(GLFWwindow* window, int width, int height);
 void mouse_callback(GLFWwindow* window, double xposIn, double yposIn);
 void processInput(GLFWwindow* window, glm::vec3& cameraPos, glm::vec3& cameraFront,
     glm::vec3& cameraUp, float deltaTime, LightingManager& lightingManager,
-    PortalSystem& portalSystem);
-void setupScene(Scene& scene, const std::vector<std::unique_ptr<Model>>& models,
+    PortalSystem& portalSystem, const GpuDrivenRenderer& gpuRenderer);
+LibraryMaterials createMaterials();
+std::vector<StaticPlacement> staticLayout();
+const char* staticModelPath(StaticPart part);
+glm::vec3 staticAlbedo(StaticPart part);
+int bakeLightmaps();
+void setupScene(Scene& scene, const LibraryModels& models, const LibraryMaterials& materials,
     std::vector<size_t>& torchIndices);
 
+// Past the light block's 16 entries only the clustered path sees every light
+static bool useClusteredLighting(const LightingManager& lightingManager) {
+    return ClusteredLighting::isEnabled() && (clusteredLightingEnabled ||
+        lightingManager.pointLights.size() > static_cast<size_t>(LightingManager::MAX_POINT_LIGHTS));
+}
+
 void framebuffer_size_callback(GLFWwindow* window, int width, int height) {
     glViewport(0, 0, width, height);
 }
@@ -93,7 +159,7 @@ void mouse_callback(GLFWwindow* window, double xposIn, double yposIn) {
 
 void processInput(GLFWwindow* window, glm::vec3& cameraPos, glm::vec3& cameraFront,
     glm::vec3& cameraUp, float deltaTime, LightingManager& lightingManager,
-    PortalSystem& portalSystem) {
+    PortalSystem& portalSystem, const GpuDrivenRenderer& gpuRenderer) {
 
     const float cameraSpeed = Config::CAMERA_SPEED * deltaTime;
 
@@ -146,6 +212,73 @@ void processInput(GLFWwindow* window, glm::vec3& cameraPos, glm::vec3& cameraFro
         dramaModePressed = false;
     }
 
+    // GPU-driven rendering toggle
+    if (glfwGetKey(window, GLFW_KEY_G) == GLFW_PRESS && !gpuDrivenPressed) {
+        gpuDrivenPressed = true;
+        if (gpuRenderer.isInitialized()) {
+            gpuDrivenEnabled = !gpuDrivenEnabled;
+            std::cout << "GPU-driven rendering " << (gpuDrivenEnabled ? "ENABLED" : "DISABLED") << std::endl;
+        }
+        else if (GpuDrivenRenderer::isSupported()) {
+            std::cout << "GPU-driven rendering available once assets finish streaming" << std::endl;
+        }
+        else {
+            std::cout << "GPU-driven rendering needs OpenGL 4.3" << std::endl;
+        }
+    }
+    if (glfwGetKey(window, GLFW_KEY_G) == GLFW_RELEASE) {
+        gpuDrivenPressed = false;
+    }
+
+    // Material backend cycle (bound textures -> texture arrays -> virtual textures), skipping unavailable ones
+    if (glfwGetKey(window, GLFW_KEY_T) == GLFW_PRESS && !materialBackendPressed) {
+        materialBackendPressed = true;
+        const MaterialBackend order[] = { MaterialBackend::BoundTextures, MaterialBackend::TextureArrays,
+            MaterialBackend::VirtualTextures };
+        const char* names[] = { "BOUND TEXTURES", "TEXTURE ARRAYS", "VIRTUAL TEXTURES" };
+        int current = static_cast<int>(MaterialManager::getBackend());
+        for (int step = 1; step <= 3; step++) {
+            int next = (current + step) % 3;
+            if (!MaterialManager::isBackendAvailable(order[next])) continue;
+            MaterialManager::setBackend(order[next]);
+            if (next != current) std::cout << "Materials: " << names[next] << std::endl;
+            break;
+        }
+        if (!MaterialManager::hasTextureArrays()) {
+            std::cout << "Texture arrays available once assets finish streaming" << std::endl;
+        }
+    }
+    if (glfwGetKey(window, GLFW_KEY_T) == GLFW_RELEASE) {
+        materialBackendPressed = false;
+    }
+
+    // Clustered light lists vs. looping over every light (only possible up to the block's 16 lights)
+    if (glfwGetKey(window, GLFW_KEY_C) == GLFW_PRESS && !clusteredLightingPressed) {
+        clusteredLightingPressed = true;
+        if (lightingManager.pointLights.size() > static_cast<size_t>(LightingManager::MAX_POINT_LIGHTS)) {
+            std::cout << "Clustered lighting is required for more than " << LightingManager::MAX_POINT_LIGHTS
+                << " lights" << std::endl;
+        }
+        else if (ClusteredLighting::isEnabled()) {
+            clusteredLightingEnabled = !clusteredLightingEnabled;
+            std::cout << "Clustered lighting " << (clusteredLightingEnabled ? "ENABLED" : "DISABLED") << std::endl;
+        }
+    }
+    if (glfwGetKey(window, GLFW_KEY_C) == GLFW_RELEASE) {
+        clusteredLightingPressed = false;
+    }
+
+    // Forward vs. deferred shading of the main view (compare frame times with F1 as lights are added)
+    if (glfwGetKey(window, GLFW_KEY_R) == GLFW_PRESS && !deferredShadingPressed) {
+        deferredShadingPressed = true;
+        deferredShadingEnabled = !deferredShadingEnabled;
+        std::cout << "Shading: " << (deferredShadingEnabled ? "DEFERRED" : "FORWARD") << " ("
+            << lightingManager.pointLights.size() << " lights)" << std::endl;
+    }
+    if (glfwGetKey(window, GLFW_KEY_R) == GLFW_RELEASE) {
+        deferredShadingPressed = false;
+    }
+
     // Torch intensity control
     if (glfwGetKey(window, GLFW_KEY_L) == GLFW_PRESS) {
         if (glfwGetKey(window, GLFW_KEY_UP) == GLFW_PRESS) {
@@ -166,6 +299,10 @@ void processInput(GLFWwindow* window, glm::vec3& cameraPos, glm::vec3& cameraFro
         std::cout << "  WASD + Mouse - Move camera" << std::endl;
         std::cout << "  Space/Ctrl - Up/Down" << std::endl;
         std::cout << "  P - Toggle portals" << std::endl;
+        std::cout << "  G - Toggle GPU-driven rendering (GL 4.3+)" << std::endl;
+        std::cout << "  T - Toggle material texture arrays" << std::endl;
+        std::cout << "  C - Toggle clustered lighting" << std::endl;
+        std::cout << "  R - Toggle forward/deferred shading" << std::endl;
         std::cout << "\nLIGHTING:" << std::endl;
         std::cout << "  M - Drama Mode (warmer & brighter)" << std::endl;
         std::cout << "  L + up key - Bright warm torches" << std::endl;
@@ -177,6 +314,7 @@ void processInput(GLFWwindow* window, glm::vec3& cameraPos, glm::vec3& cameraFro
         std::cout << "  F3 - Lighting information" << std::endl;
         std::cout << "  F4 - Scene information" << std::endl;
         std::cout << "  F5 - Camera information" << std::endl;
+        std::cout << "  F6 - GPU memory" << std::endl;
         std::cout << "  H - Show this help" << std::endl;
         std::cout << "==============================\n" << std::endl;
     }
@@ -239,36 +377,46 @@ void processInput(GLFWwindow* window, glm::vec3& cameraPos, glm::vec3& cameraFro
     if (glfwGetKey(window, GLFW_KEY_F5) == GLFW_RELEASE) {
         f5Pressed = false;
     }
-}
 
-void setupScene(Scene& scene, const std::vector<std::unique_ptr<Model>>& models,
-    std::vector<size_t>& torchIndices) {
+    // GPU memory toggle (F6)
+    if (glfwGetKey(window, GLFW_KEY_F6) == GLFW_PRESS && !f6Pressed) {
+        f6Pressed = true;
+        DebugSystem::toggleMemoryInfo();
+    }
+    if (glfwGetKey(window, GLFW_KEY_F6) == GLFW_RELEASE) {
+        f6Pressed = false;
+    }
+}
 
-    // Extract models from vector for easier access
-    const auto& bookModel = models[0];
-    const auto& bookshelfModel = models[1];
-    const auto& bookshelf2Model = models[2];
-    const auto& columnModel = models[3];
-    const auto& floorModel = models[4];
-    const auto& ceilingModel = models[5];
-    const auto& wallModel = models[6];
-    const auto& torchModel = models[7];
-    const auto& lampModel = models[8];
-    const auto& doorFrameModel = models[9];
+LibraryMaterials createMaterials() {
+    // Stone and metal reuse the column ORM texture
+    LibraryMaterials materials;
+    materials.book = MaterialManager::create("book", "book_basecolor", "book_orm");
+    materials.bookshelf = MaterialManager::create("bookshelf", "wood_basecolor", "wood_orm");
+    materials.column = MaterialManager::create("column", "column_basecolor", "column_orm");
+    materials.floor = MaterialManager::create("floor", "floor_basecolor", "column_orm");
+    materials.ceiling = MaterialManager::create("ceiling", "ceiling_basecolor", "column_orm");
+    materials.wall = MaterialManager::create("wall", "wall_basecolor", "column_orm");
+    materials.doorFrame = MaterialManager::create("doorframe", "doorframe_basecolor", "column_orm");
+    materials.torch = MaterialManager::create("torch", "torch_basecolor", "column_orm", true);
+    materials.lamp = MaterialManager::create("lamp", "metal_basecolor", "column_orm", true);
+    return materials;
+}
 
-    std::cout << "Building the library..." << std::endl;
+std::vector<StaticPlacement> staticLayout() {
+    std::vector<StaticPlacement> layout;
 
     // Floor
-    scene.addObject(floorModel.get(),
+    layout.push_back({ StaticPart::Floor,
         glm::vec3(0.0f, 0.0f, 0.0f), // p
         glm::vec3(0.0f, glm::radians(90.0f), 0.0f), // r
-        glm::vec3(3.4f, 1.0f, 3.4f)); // s
+        glm::vec3(3.4f, 1.0f, 3.4f) }); // s
 
     // Ceiling
-    scene.addObject(ceilingModel.get(),
+    layout.push_back({ StaticPart::Ceiling,
         glm::vec3(0.0f, Config::ROOM_HEIGHT + 1.2f, 0.0f),
         glm::vec3(0.0f, glm::radians(105.0f), 0.0f),
-        glm::vec3(3.5f, 2.0f, 3.5f));
+        glm::vec3(3.5f, 2.0f, 3.5f) });
 
     // Walls
     for (int i = 0; i < Config::NUM_SIDES; i++) {
@@ -281,10 +429,10 @@ void setupScene(Scene& scene, const std::vector<std::unique_ptr<Model>>& models,
             wallRotation += glm::radians(180.0f);
         }
 
-        scene.addObject(wallModel.get(),
+        layout.push_back({ StaticPart::Wall,
             glm::vec3(x, 0.1f, z),
             glm::vec3(0.0f, wallRotation, 0.0f),
-            glm::vec3(0.015f, 0.05f, 0.015f));
+            glm::vec3(0.015f, 0.05f, 0.015f) });
     }
 
     // Columns
@@ -293,10 +441,10 @@ void setupScene(Scene& scene, const std::vector<std::unique_ptr<Model>>& models,
         float x = 3.2f * cos(angle);
         float z = 3.2f * sin(angle);
 
-        scene.addObject(columnModel.get(),
+        layout.push_back({ StaticPart::Column,
             glm::vec3(x, 0.0f, z),
             glm::vec3(0.0f, 0.0f, 0.0f),
-            glm::vec3(1.8f, 3.5f, 1.8f));
+            glm::vec3(1.8f, 3.5f, 1.8f) });
     }
 
     // Door frames
@@ -306,10 +454,10 @@ void setupScene(Scene& scene, const std::vector<std::unique_ptr<Model>>& models,
         float z = Config::ROOM_RADIUS * 0.85f * sin(angle);
         float rotationToCenter = angle + glm::radians(90.0f);
 
-        scene.addObject(doorFrameModel.get(),
+        layout.push_back({ StaticPart::DoorFrame,
             glm::vec3(x, 0.0f, z),
             glm::vec3(0.0f, rotationToCenter, 0.0f),
-            glm::vec3(1.5f, 1.5f, 1.5f));
+            glm::vec3(1.5f, 1.5f, 1.5f) });
     }
 
     // Bookshelves
@@ -318,19 +466,129 @@ void setupScene(Scene& scene, const std::vector<std::unique_ptr<Model>>& models,
         float x = Config::ROOM_RADIUS * 0.90f * cos(angle);
         float z = Config::ROOM_RADIUS * 0.90f * sin(angle);
 
-        Model* shelfModel = (i % 2 == 0) ? bookshelfModel.get() : bookshelf2Model.get();
+        StaticPart shelf = (i % 2 == 0) ? StaticPart::Bookshelf : StaticPart::Bookshelf2;
         float rotationToCenter = angle + glm::radians(90.0f) + (i % 2 == 0 ? glm::radians(360.0f) : 135.0f);
         glm::vec3 scale = (i % 2 == 0) ? glm::vec3(2.0f, 4.3f, 3.0f) : glm::vec3(1.4f, 4.0f, 1.6f);
 
-        scene.addObject(shelfModel,
+        layout.push_back({ shelf,
             glm::vec3(x, 1.2f, z),
             glm::vec3(0.0f, rotationToCenter, 0.0f),
-            scale);
+            scale });
+    }
+    return layout;
+}
+
+const char* staticModelPath(StaticPart part) {
+    switch (part) {
+    case StaticPart::Floor: return "assets/models/floor.obj";
+    case StaticPart::Ceiling: return "assets/models/ceiling.obj";
+    case StaticPart::Wall: return "assets/models/wall.obj";
+    case StaticPart::Column: return "assets/models/column.obj";
+    case StaticPart::DoorFrame: return "assets/models/door.obj";
+    case StaticPart::Bookshelf: return "assets/models/bookshelf.obj";
+    case StaticPart::Bookshelf2: return "assets/models/Bookshelf2.obj";
+    default: return "";
+    }
+}
+
+// Average colour of each part's base colour texture - what its bounce light is tinted by
+glm::vec3 staticAlbedo(StaticPart part) {
+    switch (part) {
+    case StaticPart::Floor: return glm::vec3(0.35f, 0.30f, 0.25f);
+    case StaticPart::Ceiling: return glm::vec3(0.40f, 0.36f, 0.30f);
+    case StaticPart::Wall: return glm::vec3(0.45f, 0.38f, 0.30f);
+    case StaticPart::Column: return glm::vec3(0.50f, 0.47f, 0.42f);
+    case StaticPart::DoorFrame: return glm::vec3(0.30f, 0.20f, 0.12f);
+    case StaticPart::Bookshelf:
+    case StaticPart::Bookshelf2: return glm::vec3(0.32f, 0.20f, 0.11f);
+    default: return glm::vec3(0.5f);
+    }
+}
+
+// Headless lightmap bake (BABEL --bake-lightmaps): the static layout under the static lights of
+// setupLibraryLighting, written to Lightmap::FILE_PATH for the next start to pick up
+int bakeLightmaps() {
+    std::cout << "===== BABEL LIGHTMAP BAKE =====" << std::endl;
+    if (!AssetArchive::mount("assets.bpak")) {
+        std::cout << "No asset archive, loading loose files" << std::endl;
+    }
+
+    // One mesh per part, packed or loose like the runtime loads it. A mesh that doesn't load is
+    // baked without coordinates (its objects stay dynamically lit) and casts no shadows.
+    std::vector<BakeMesh> meshes(static_cast<size_t>(StaticPart::Count));
+    for (size_t m = 0; m < meshes.size(); m++) {
+        BakeMesh& mesh = meshes[m];
+        mesh.path = staticModelPath(static_cast<StaticPart>(m));
+
+        const ArchiveEntry* entry = AssetArchive::find(mesh.path);
+        if (entry && entry->type == static_cast<uint32_t>(ArchiveEntryType::Mesh)) {
+            std::vector<uint8_t> scratch;
+            const float* vertices = reinterpret_cast<const float*>(AssetArchive::data(*entry, scratch));
+            if (vertices) {
+                mesh.data.vertices.assign(vertices, vertices + size_t(entry->width) * 8);
+                continue;
+            }
+        }
+        if (!MeshData::loadObj(mesh.path, mesh.data)) {
+            std::cerr << "Lightmap: couldn't load " << mesh.path << ", not baking it" << std::endl;
+        }
+    }
+
+    // Model matrices built exactly as the scene builds them, so the runtime match is bit-exact
+    std::vector<BakeInstance> instances;
+    for (const StaticPlacement& placement : staticLayout()) {
+        SceneObject object(nullptr, INVALID_MATERIAL, placement.position, placement.rotation, placement.scale);
+        instances.push_back({ static_cast<uint32_t>(placement.part), object.modelMatrix, staticAlbedo(placement.part) });
+    }
+
+    LightingManager lightingManager;
+    lightingManager.setupLibraryLighting(Config::ROOM_RADIUS, Config::ROOM_HEIGHT);
+
+    LightmapData lightmap;
+    BakeSettings settings;
+    bool baked = LightmapBaker::bake(meshes, instances, Lightmap::bakeLights(lightingManager),
+        Lightmap::bakeAmbient(lightingManager), settings, lightmap) && lightmap.save(Lightmap::FILE_PATH);
+    AssetArchive::unmount();
+    if (!baked) {
+        std::cerr << "Lightmap bake failed" << std::endl;
+        return -1;
+    }
+    std::cout << "Wrote " << Lightmap::FILE_PATH << std::endl;
+    return 0;
+}
+
+void setupScene(Scene& scene, const LibraryModels& models, const LibraryMaterials& materials,
+    std::vector<size_t>& torchIndices) {
+    const ModelRef& bookModel = models.book;
+    const ModelRef& bookshelfModel = models.bookshelf;
+    const ModelRef& bookshelf2Model = models.bookshelf2;
+    const ModelRef& columnModel = models.column;
+    const ModelRef& floorModel = models.floor;
+    const ModelRef& ceilingModel = models.ceiling;
+    const ModelRef& wallModel = models.wall;
+    const ModelRef& torchModel = models.torch;
+    const ModelRef& lampModel = models.lamp;
+    const ModelRef& doorFrameModel = models.doorFrame;
+
+    std::cout << "Building the library..." << std::endl;
+
+    // Floor, ceiling, walls, columns, door frames and bookshelves
+    for (const StaticPlacement& placement : staticLayout()) {
+        switch (placement.part) {
+        case StaticPart::Floor: scene.addObject(floorModel, materials.floor, placement.position, placement.rotation, placement.scale); break;
+        case StaticPart::Ceiling: scene.addObject(ceilingModel, materials.ceiling, placement.position, placement.rotation, placement.scale); break;
+        case StaticPart::Wall: scene.addObject(wallModel, materials.wall, placement.position, placement.rotation, placement.scale); break;
+        case StaticPart::Column: scene.addObject(columnModel, materials.column, placement.position, placement.rotation, placement.scale); break;
+        case StaticPart::DoorFrame: scene.addObject(doorFrameModel, materials.doorFrame, placement.position, placement.rotation, placement.scale); break;
+        case StaticPart::Bookshelf: scene.addObject(bookshelfModel, materials.bookshelf, placement.position, placement.rotation, placement.scale); break;
+        case StaticPart::Bookshelf2: scene.addObject(bookshelf2Model, materials.bookshelf, placement.position, placement.rotation, placement.scale); break;
+        default: break;
+        }
     }
 
     // Central lamp with rotation
     size_t lampIndex = scene.objects.size();
-    scene.addObject(lampModel.get(),
+    scene.addObject(lampModel, materials.lamp,
         glm::vec3(0.0f, 8.0f, 0.0f),
         glm::vec3(0.0f, 0.0f, 0.0f),
         glm::vec3(2.0f, 2.0f, 2.0f));
@@ -351,7 +609,7 @@ void setupScene(Scene& scene, const std::vector<std::unique_ptr<Model>>& models,
         size_t torchIndex = scene.objects.size();
         torchIndices.push_back(torchIndex);
 
-        scene.addObject(torchModel.get(),
+        scene.addObject(torchModel, materials.torch,
             torchPos,
             glm::vec3(0.0f, columnAngle + glm::radians(90.0f), 0.0f),
             glm::vec3(0.8f, 0.8f, 0.8f));
@@ -367,7 +625,7 @@ void setupScene(Scene& scene, const std::vector<std::unique_ptr<Model>>& models,
         float height = 2.0f + sin(angle * 3.0f) * 1.0f;
 
         size_t bookIndex = scene.objects.size();
-        scene.addObject(bookModel.get(),
+        scene.addObject(bookModel, materials.book,
             glm::vec3(radius * cos(angle), height, radius * sin(angle)),
             glm::vec3(glm::radians(15.0f), angle, glm::radians(10.0f)),
             glm::vec3(1.2f, 1.2f, 1.2f));
@@ -394,18 +652,35 @@ void setupScene(Scene& scene, const std::vector<std::unique_ptr<Model>>& models,
     }
 }
 
-int main() {
+int main(int argc, char** argv) {
+    auto startupBegin = std::chrono::steady_clock::now();
+    auto msSinceStartup = [&]() {
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startupBegin).count();
+        };
+
+    // --bake-lightmaps bakes the static lighting without opening a window
+    for (int i = 1; i < argc; i++) {
+        if (std::string(argv[i]) == "--bake-lightmaps") return bakeLightmaps();
+    }
+
     if (!glfwInit()) {
         std::cerr << "Failed to initialize GLFW" << std::endl;
         return -1;
     }
 
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+    // Prefer GL 4.3 (compute + multi-draw indirect), fall back to 3.3
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
     glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
     glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
 
     GLFWwindow* window = glfwCreateWindow(Config::WIDTH, Config::HEIGHT,
         "BABEL - Infinite Library", nullptr, nullptr);
+    if (!window) {
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+        window = glfwCreateWindow(Config::WIDTH, Config::HEIGHT,
+            "BABEL - Infinite Library", nullptr, nullptr);
+    }
     if (!window) {
         std::cerr << "Failed to create GLFW window" << std::endl;
         glfwTerminate();
@@ -422,6 +697,30 @@ int main() {
         return -1;
     }
 
+    // BCn textures unless --uncompressed-textures (for before/after VRAM and frame time comparisons).
+    // --texture-quality=medium/low drops the top 1/2 mip levels on low-memory machines.
+    // --gpu-budget=<MB> overrides the video memory budget detected from the driver (0 = unlimited).
+    bool compressTextures = true;
+    bool syncTextureUploads = false;
+    bool virtualTextures = false;
+    int torchWing = 0;
+    GpuMemory::detectBudget();
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--uncompressed-textures") compressTextures = false;
+        else if (arg == "--sync-texture-uploads") syncTextureUploads = true;
+        else if (arg == "--virtual-textures") virtualTextures = true;
+        else if (arg == "--deferred") deferredShadingEnabled = true;
+        else if (arg.compare(0, 13, "--torch-wing=") == 0) torchWing = std::atoi(arg.c_str() + 13);
+        else if (arg == "--texture-quality=medium") Texture::setQuality(TextureQuality::Medium);
+        else if (arg == "--texture-quality=low") Texture::setQuality(TextureQuality::Low);
+        else if (arg.compare(0, 13, "--gpu-budget=") == 0) {
+            GpuMemory::setBudget(std::strtoull(arg.c_str() + 13, nullptr, 10) * 1024 * 1024);
+            std::cout << "GPU memory budget: " << arg.substr(13) << " MB" << std::endl;
+        }
+    }
+    Texture::configureCompression(compressTextures);
+
     glEnable(GL_DEPTH_TEST);
     glDepthFunc(GL_LESS);
     glDisable(GL_CULL_FACE);
@@ -433,32 +732,159 @@ int main() {
     DebugSystem::initialize();
 
     std::cout << "\n===== BABEL LIBRARY =====" << std::endl;
+
+    // Packed assets (built by BABELPack) replace loose files when present
+    if (!AssetArchive::mount("assets.bpak")) {
+        std::cout << "No asset archive, loading loose files" << std::endl;
+    }
+
+    // Decode textures and meshes in the background, first frame shows placeholders.
+    // Textures go through the pixel buffer ring unless --sync-texture-uploads (for comparison).
+    if (!syncTextureUploads) {
+        TextureStreamer::initialize(Config::STREAMING_RING_BYTES);
+    }
+    AsyncLoader::start();
     std::cout << "Loading atmospheric lighting..." << std::endl;
+    UniformBuffers::initialize(Config::MAX_VIEWS_PER_FRAME);
+    ClusteredLighting::initialize();
+    bool pointShadows = ShadowAtlas::initialize(Config::SHADOW_FACES_PER_FRAME);
+    PostProcess::initialize();
+
+    // Virtual textures (--virtual-textures): materials register their base colour image on creation,
+    // drawn with the VIRTUAL_TEXTURING variants of standard.frag
+    if (virtualTextures) VirtualTexture::initialize(Config::VIRTUAL_CACHE_PAGES);
+
+    LightingManager lightingManager;
+    lightingManager.setupLibraryLighting(Config::ROOM_RADIUS, Config::ROOM_HEIGHT);
+    size_t firstWingLight = lightingManager.pointLights.size();
+    if (torchWing > 0) lightingManager.addTorchWing(torchWing, Config::ROOM_RADIUS, Config::ROOM_HEIGHT);
+    lightingManager.enableShadows(pointShadows);
 
-    Shader standardShader("shaders/standard.vert", "shaders/standard.frag");
     Shader lightShader("shaders/light.vert", "shaders/light.frag");
     Shader portalShader("shaders/portal.vert", "shaders/portal.frag");
 
-    TextureManager::loadAllTextures();
+    // Depth-only programs for the shadow atlas faces (static and moving objects, animated books)
+    Shader shadowShader("shaders/standard.vert", "shaders/shadow.frag");
+    Shader animatedShadowShader("shaders/animated.vert", "shaders/shadow.frag");
+
+    // Lit scene programs are specialised on the light path and material backend (ShaderVariants).
+    // Texture units are fixed per program, so samplers are set once per variant instead of per draw.
+    auto setupSceneSamplers = [](const Shader& shader) {
+        MaterialManager::setupSamplers(shader);
+        ClusteredLighting::setupSamplers(shader);
+        Lightmap::setupSamplers(shader);
+        ShadowAtlas::setupSamplers(shader);
+        };
+    ShaderVariants standardShaders("shaders/standard.vert", "shaders/standard.frag", setupSceneSamplers);
+    ShaderVariants animatedShaders("shaders/animated.vert", "shaders/standard.frag", setupSceneSamplers);
+    ShaderVariants indirectShaders("shaders/indirect.vert", "shaders/standard.frag", setupSceneSamplers);
+
+    // Start compiling the variants the first frame draws with
+    ShaderFeatures startFeatures;
+    startFeatures.pointLights = lightingManager.getActiveLightCount();
+    startFeatures.clusteredLights = useClusteredLighting(lightingManager);
+    startFeatures.materials = VirtualTexture::isEnabled() ? MaterialBackend::VirtualTextures : MaterialBackend::BoundTextures;
+    standardShaders.prepare(startFeatures);
+    animatedShaders.prepare(startFeatures);
+
+    // Baked static lighting (--bake-lightmaps), attached once the static meshes have streamed in
+    if (Lightmap::load(Lightmap::FILE_PATH)) {
+        ShaderFeatures lightmapFeatures = startFeatures;
+        lightmapFeatures.baked = BakedLighting::Lightmap;
+        lightmapFeatures.staticLights = lightingManager.getStaticLightCount();
+        standardShaders.prepare(lightmapFeatures);
+        lightmapFeatures.baked = BakedLighting::Probes;
+        animatedShaders.prepare(lightmapFeatures);
+    }
+
+    // G-buffer variants for the deferred path (R or --deferred)
+    DeferredRenderer deferredRenderer;
+    deferredRenderer.initialize();
+    if (deferredShadingEnabled) {
+        ShaderFeatures gbufferFeatures = startFeatures;
+        gbufferFeatures.gbuffer = true;
+        standardShaders.prepare(gbufferFeatures);
+        animatedShaders.prepare(gbufferFeatures);
+    }
+
+    // Programs for the GPU-driven path (see gpuRenderer below)
+    std::unique_ptr<Shader> indirectLightShader;
+    if (GpuDrivenRenderer::isSupported()) {
+        indirectShaders.prepare(startFeatures);
+        indirectLightShader = std::make_unique<Shader>("shaders/indirect.vert", "shaders/light.frag");
+    }
 
-    std::vector<std::unique_ptr<Model>> models;
-    models.push_back(std::make_unique<Model>("assets/models/book.obj"));
-    models.push_back(std::make_unique<Model>("assets/models/bookshelf.obj"));
-    models.push_back(std::make_unique<Model>("assets/models/Bookshelf2.obj"));
-    models.push_back(std::make_unique<Model>("assets/models/column.obj"));
-    models.push_back(std::make_unique<Model>("assets/models/floor.obj"));
-    models.push_back(std::make_unique<Model>("assets/models/ceiling.obj"));
-    models.push_back(std::make_unique<Model>("assets/models/wall.obj"));
-    models.push_back(std::make_unique<Model>("assets/models/torch.obj"));
-    models.push_back(std::make_unique<Model>("assets/models/lamb.obj"));
-    models.push_back(std::make_unique<Model>("assets/models/door.obj"));
+    // Every program above is still compiling on the driver's side; textures and meshes load meanwhile
+    TextureManager::loadAllTextures();
+    LibraryMaterials materials = createMaterials();
+
+    LibraryModels models;
+    models.book = AssetRegistry::loadModel("assets/models/book.obj");
+    models.bookshelf = AssetRegistry::loadModel(staticModelPath(StaticPart::Bookshelf));
+    models.bookshelf2 = AssetRegistry::loadModel(staticModelPath(StaticPart::Bookshelf2));
+    models.column = AssetRegistry::loadModel(staticModelPath(StaticPart::Column));
+    models.floor = AssetRegistry::loadModel(staticModelPath(StaticPart::Floor));
+    models.ceiling = AssetRegistry::loadModel(staticModelPath(StaticPart::Ceiling));
+    models.wall = AssetRegistry::loadModel(staticModelPath(StaticPart::Wall));
+    models.torch = AssetRegistry::loadModel("assets/models/torch.obj");
+    models.lamp = AssetRegistry::loadModel("assets/models/lamb.obj");
+    models.doorFrame = AssetRegistry::loadModel(staticModelPath(StaticPart::DoorFrame));
+
+    // Raw pointers for batching and torch lookup (the refs above keep them alive)
+    const Model* bookModel = models.book.get();
+    const Model* bookshelfModel = models.bookshelf.get();
+    const Model* bookshelf2Model = models.bookshelf2.get();
+    const Model* torchModel = models.torch.get();
 
     Scene scene;
     std::vector<size_t> torchIndices;
-    setupScene(scene, models, torchIndices);
+    setupScene(scene, models, materials, torchIndices);
 
-    LightingManager lightingManager;
-    lightingManager.setupLibraryLighting(Config::ROOM_RADIUS, Config::ROOM_HEIGHT);
+    // Torch lights ride on the torch meshes (lights 1-4, in setupLibraryLighting order) and every
+    // flame flickers, the wall sconces too - all evaluated in one pass per frame
+    LightAnimator lightAnimator;
+    for (size_t i = 0; i < torchIndices.size(); i++) {
+        lightAnimator.attach(lightingManager, static_cast<int>(i + 1), scene, torchIndices[i]);
+    }
+    for (size_t i = 0; i < lightingManager.pointLights.size(); i++) {
+        if (lightingManager.pointLights[i].isStatic) continue;  // The lamp is baked
+        LightTrack flame;
+        flame.flickerAmount = i < firstWingLight ? 0.15f : 0.3f;
+        flame.flickerSpeed = 7.0f + 0.6f * static_cast<float>(i % 5);
+        flame.curveAmount = 0.05f;
+        flame.phase = 2.39996323f * static_cast<float>(i);  // Golden angle - no two flames in step
+        lightAnimator.animate(lightingManager, static_cast<int>(i), flame);
+    }
+
+    // Floating books are pure functions of time - let the vertex shader animate them
+    for (auto& obj : scene.objects) {
+        if (obj.model == bookModel) obj.gpuAnimated = true;
+    }
+
+    // Materials and the meshes that use them (shared by the batched renderers)
+    std::vector<DrawBatch> batches = {
+        { materials.book, { bookModel } },
+        { materials.bookshelf, { bookshelfModel, bookshelf2Model } },
+        { materials.column, { models.column.get() } },
+        { materials.floor, { models.floor.get() } },
+        { materials.ceiling, { models.ceiling.get() } },
+        { materials.wall, { models.wall.get() } },
+        { materials.doorFrame, { models.doorFrame.get() } },
+        { materials.torch, { torchModel } },
+        { materials.lamp, { models.lamp.get() } }
+    };
+
+    // Texture units are fixed per program, so samplers are set once here instead of per draw
+    MaterialManager::setupSamplers(lightShader);
+    if (indirectLightShader) MaterialManager::setupSamplers(*indirectLightShader);
+    if (VirtualTexture::isEnabled()) MaterialManager::setBackend(MaterialBackend::VirtualTextures);
+
+    AnimatedInstanceRenderer animatedRenderer;
+    animatedRenderer.initialize(scene, batches, static_cast<float>(glfwGetTime()));
+
+    // GPU-driven path: one multi-draw per material, culled per view in a compute pass.
+    // Its merged vertex buffer is built once the real meshes have streamed in.
+    GpuDrivenRenderer gpuRenderer;
 
     PortalSystem portalSystem;
     portalSystem.initialize();
@@ -486,82 +912,185 @@ int main() {
     float deltaTime = 0.0f;
     float lastFrame = 0.0f;
 
-    // Lambda function for rendering
-    auto renderSceneFunc = [&](const glm::mat4& view, const glm::mat4& projection) {
-        glm::mat4 invView = glm::inverse(view);
-        glm::vec3 currentCameraPos = glm::vec3(invView[3]);
-        float currentFrame = static_cast<float>(glfwGetTime());
+    // Per-view state left in plain uniforms - which material backend to sample
+    auto setViewUniforms = [&](Shader& shader) {
+        shader.use();
+        MaterialManager::setupView(shader);
+        };
+
+    // Programs specialised for the current light path and material backend
+    auto viewFeatures = [&]() {
+        ShaderFeatures features;
+        features.pointLights = lightingManager.getActiveLightCount();
+        features.clusteredLights = useClusteredLighting(lightingManager);
+        features.materials = MaterialManager::getBackend();
+        return features;
+        };
+
+    // Camera of this view for every program at once (frame and lighting blocks are already bound)
+    auto beginView = [&](const glm::mat4& view, const glm::mat4& projection, const ShaderFeatures& features) {
+        glm::vec3 currentCameraPos = glm::vec3(glm::inverse(view)[3]);
+        UniformBuffers::bindView(UniformBuffers::addView(view, projection, currentCameraPos));
+        ShadowAtlas::addView(projection * view);  // Next frame's shadow update renders what this view sees
+        if (features.clusteredLights && !features.gbuffer) ClusteredLighting::buildView(view, projection);
 
         glEnable(GL_DEPTH_TEST);
         glDepthFunc(GL_LESS);
         glDepthMask(GL_TRUE);
 
-        // Render standard objects with lighting
-        standardShader.use();
-        standardShader.setMat4("view", &view[0][0]);
-        standardShader.setMat4("projection", &projection[0][0]);
-        standardShader.setVec3("viewPos", currentCameraPos.x, currentCameraPos.y, currentCameraPos.z);
-        standardShader.setFloat("time", currentFrame);
-        lightingManager.bindToShader(standardShader);
+        // Portal surfaces of the previous view rebound texture units
+        MaterialManager::invalidate();
+        if (!features.gbuffer) Lightmap::bindTexture();
+        ShadowAtlas::bindTexture();
+        };
 
-        for (const auto& obj : scene.objects) {
-            if (obj.model == models[7].get() || obj.model == models[8].get()) continue;
+    // Opaque lit geometry - lit directly, or into the G-buffer with features.gbuffer
+    auto drawLitObjects = [&](const glm::mat4& view, const glm::mat4& projection, const ShaderFeatures& features) {
+        if (gpuDrivenEnabled) {
+            // Cull once for this view, drawLightSources reuses the indirect commands
+            gpuRenderer.cull(view, projection);
 
-            if (obj.model == models[0].get()) {
-                TextureManager::bindTextureForObject("book", standardShader);
-            }
-            else if (obj.model == models[1].get() || obj.model == models[2].get()) {
-                TextureManager::bindTextureForObject("bookshelf", standardShader);
-            }
-            else if (obj.model == models[3].get()) {
-                TextureManager::bindTextureForObject("column", standardShader);
-            }
-            else if (obj.model == models[4].get()) {
-                TextureManager::bindTextureForObject("floor", standardShader);
-            }
-            else if (obj.model == models[6].get()) {
-                TextureManager::bindTextureForObject("wall", standardShader);
-            }
-            else if (obj.model == models[5].get()) {
-                TextureManager::bindTextureForObject("ceiling", standardShader);
+            Shader& indirectShader = indirectShaders.get(features);
+            setViewUniforms(indirectShader);
+            gpuRenderer.drawBatches(indirectShader, false);
+        }
+        else {
+            // Static objects with baked lighting first, then the rest with every light
+            bool lightmapped = Lightmap::isActive() && !features.gbuffer;
+            if (lightmapped) {
+                ShaderFeatures lightmapFeatures = features;
+                lightmapFeatures.baked = BakedLighting::Lightmap;
+                lightmapFeatures.staticLights = Lightmap::getStaticLightCount();
+                Shader& lightmapShader = standardShaders.get(lightmapFeatures);
+                setViewUniforms(lightmapShader);
+                UniformHandle lightmapModel = lightmapShader.getUniform("model"_uniform);
+                UniformHandle lightmapRect = lightmapShader.getUniform("lightmapScaleOffset"_uniform);
+
+                for (const auto& obj : scene.objects) {
+                    if (!obj.lightmapped) continue;
+
+                    MaterialManager::bind(obj.material, lightmapShader);
+                    lightmapShader.setMat4(lightmapModel, &obj.modelMatrix[0][0]);
+                    const glm::vec4& rect = obj.lightmapScaleOffset;
+                    lightmapShader.setVec4(lightmapRect, rect.x, rect.y, rect.z, rect.w);
+                    obj.model->draw();
+                }
             }
-            else if (obj.model == models[9].get()) {
-                TextureManager::bindTextureForObject("doorframe", standardShader);
+
+            // Render standard objects with lighting
+            Shader& sceneShader = standardShaders.get(features);
+            setViewUniforms(sceneShader);
+            UniformHandle sceneModel = sceneShader.getUniform("model"_uniform);  // Looked up once per view
+
+            for (const auto& obj : scene.objects) {
+                if (obj.gpuAnimated) continue;  // Drawn by animatedRenderer below
+                if (lightmapped && obj.lightmapped) continue;
+                if (MaterialManager::get(obj.material).lightSource) continue;
+
+                MaterialManager::bind(obj.material, sceneShader);
+                sceneShader.setMat4(sceneModel, &obj.modelMatrix[0][0]);
+                obj.model->draw();
             }
+        }
+
+        // GPU-animated books (transform evaluated in animated.vert), lit by the bake's probes while it applies
+        ShaderFeatures bookFeatures = features;
+        if (Lightmap::getProbes() && !features.gbuffer) {
+            bookFeatures.baked = BakedLighting::Probes;
+            bookFeatures.staticLights = Lightmap::getStaticLightCount();
+        }
+        Shader& booksShader = animatedShaders.get(bookFeatures);
+        setViewUniforms(booksShader);
+        animatedRenderer.draw(booksShader);
+        };
 
-            standardShader.setMat4("model", &obj.modelMatrix[0][0]);
+    // Shadow casters. Static ones (never animated) are drawn into a face's cached depth once per light
+    // position, moving ones on top whenever they change; an object around the light itself is skipped.
+    auto isStaticCaster = [](const SceneObject& obj) {
+        return !obj.gpuAnimated && !obj.rotating && !obj.floating && !obj.orbiting && !obj.pulsing;
+        };
+    auto casterSphere = [](const SceneObject& obj) {
+        glm::vec3 center = glm::vec3(obj.modelMatrix * glm::vec4((obj.model->boundsMin + obj.model->boundsMax) * 0.5f, 1.0f));
+        float scale = std::max(glm::length(glm::vec3(obj.modelMatrix[0])),
+            std::max(glm::length(glm::vec3(obj.modelMatrix[1])), glm::length(glm::vec3(obj.modelMatrix[2]))));
+        return ShadowCaster{ center, glm::length(obj.model->boundsMax - obj.model->boundsMin) * 0.5f * scale };
+        };
+    auto drawShadowCasters = [&](const glm::vec3& lightPosition, bool staticCasters) {
+        shadowShader.use();
+        UniformHandle shadowModel = shadowShader.getUniform("model"_uniform);
+        for (const auto& obj : scene.objects) {
+            if (obj.gpuAnimated || isStaticCaster(obj) != staticCasters || obj.model->vertexCount == 0) continue;
+            ShadowCaster sphere = casterSphere(obj);
+            if (glm::length(sphere.center - lightPosition) < sphere.radius) continue;
+            shadowShader.setMat4(shadowModel, &obj.modelMatrix[0][0]);
             obj.model->draw();
         }
+        if (!staticCasters) {
+            animatedShadowShader.use();
+            animatedRenderer.draw(animatedShadowShader);
+        }
+        };
+
+    // Self-lit light source meshes, always forward
+    auto drawLightSources = [&]() {
+        if (gpuDrivenEnabled) {
+            setViewUniforms(*indirectLightShader);
+            gpuRenderer.drawBatches(*indirectLightShader, true);
+            return;
+        }
 
-        // Render light sources
-        lightShader.use();
-        lightShader.setMat4("view", &view[0][0]);
-        lightShader.setMat4("projection", &projection[0][0]);
-        lightShader.setVec3("viewPos", currentCameraPos.x, currentCameraPos.y, currentCameraPos.z);
-        lightShader.setFloat("time", currentFrame);
-        lightingManager.bindToShader(lightShader);
+        setViewUniforms(lightShader);
+        UniformHandle lightModel = lightShader.getUniform("model"_uniform);
 
         for (const auto& obj : scene.objects) {
-            if (obj.model == models[7].get()) { // Torch
-                TextureManager::bindTextureForObject("torch", lightShader);
-                lightShader.setMat4("model", &obj.modelMatrix[0][0]);
-                obj.model->draw();
-            }
-            else if (obj.model == models[8].get()) { // Lamp
-                TextureManager::bindTextureForObject("lamp", lightShader);
-                lightShader.setMat4("model", &obj.modelMatrix[0][0]);
-                obj.model->draw();
-            }
+            if (!MaterialManager::get(obj.material).lightSource) continue;
+
+            MaterialManager::bind(obj.material, lightShader);
+            lightShader.setMat4(lightModel, &obj.modelMatrix[0][0]);
+            obj.model->draw();
         }
+        };
+
+    // Forward rendering of one view (main camera, or a portal camera into its render target)
+    auto renderSceneFunc = [&](const glm::mat4& view, const glm::mat4& projection) {
+        ShaderFeatures features = viewFeatures();
+        beginView(view, projection, features);
+        drawLitObjects(view, projection, features);
+        drawLightSources();
 
         if (recursivePortalsEnabled) {
-            portalSystem.renderPortalSurfaces(portalShader, view, projection, currentCameraPos, currentFrame);
+            portalSystem.renderPortalSurfaces(portalShader);
+        }
+        };
+
+    // Deferred rendering of the main view: G-buffer, light volumes and resolve into the default
+    // framebuffer, then light sources and portal surfaces forward on top
+    auto renderDeferred = [&](const glm::mat4& view, const glm::mat4& projection, int width, int height) {
+        ShaderFeatures features = viewFeatures();
+        features.gbuffer = true;
+        beginView(view, projection, features);
+        deferredRenderer.beginGeometry(width, height);
+        drawLitObjects(view, projection, features);
+        deferredRenderer.resolve(view, projection, PostProcess::getFramebuffer());
+
+        MaterialManager::invalidate();  // The light and resolve passes used the material units
+        drawLightSources();
+
+        if (recursivePortalsEnabled) {
+            portalSystem.renderPortalSurfaces(portalShader);
         }
         };
 
     // Debug info counter
     static int debugFrameCounter = 0;
 
+    // Startup timing (first frame is drawn with placeholders)
+    bool firstFramePresented = false;
+    bool fullyLoaded = false;
+
+    // Moving shadow casters, refilled every frame
+    std::vector<ShadowCaster> movingCasters;
+
     // Main render loop
     while (!glfwWindowShouldClose(window)) {
         float currentFrame = static_cast<float>(glfwGetTime());
@@ -570,8 +1099,31 @@ int main() {
 
         // UPDATE DEBUG SYSTEM PERFORMANCE STATS
         DebugSystem::updatePerformanceStats(deltaTime);
-
-        processInput(window, cameraPos, cameraFront, cameraUp, deltaTime, lightingManager, portalSystem);
+        GpuMemory::beginFrame();
+
+        processInput(window, cameraPos, cameraFront, cameraUp, deltaTime, lightingManager, portalSystem, gpuRenderer);
+
+        // Upload whatever the loader finished decoding, within this frame's budget
+        // (after the initial load these are textures the memory budget reloaded at another mip level)
+        AsyncLoader::processUploads(Config::UPLOAD_BUDGET_MS, Config::UPLOAD_BUDGET_BYTES);
+        VirtualTexture::update();  // Pages requested by earlier frames' feedback
+        if (!fullyLoaded && AsyncLoader::isIdle()) {
+            fullyLoaded = true;
+            std::cout << "Time to fully loaded: " << msSinceStartup() << " ms" << std::endl;
+            std::cout << "Texture memory: " << AssetRegistry::getTextureMemory() / (1024 * 1024) << " MB in "
+                << AssetRegistry::getTextureCount() << " textures ("
+                << (Texture::isCompressionEnabled() ? "BCn" : "uncompressed") << ", "
+                << static_cast<int>(Texture::getQuality()) << " top mips dropped)" << std::endl;
+
+            if (GpuDrivenRenderer::isSupported()) {
+                gpuRenderer.initialize(scene, batches);
+            }
+            MaterialManager::buildTextureArrays(Config::MATERIAL_LAYER_SIZE);
+            Lightmap::attach(scene);
+            ShadowAtlas::invalidate();  // Static depth was rendered with placeholder meshes
+            std::cout << "GPU memory:" << std::endl;
+            GpuMemory::printReport();
+        }
 
         // Update camera direction
         glm::vec3 direction;
@@ -582,16 +1134,22 @@ int main() {
 
         scene.update(deltaTime);
 
-        // Update light positions based on torch objects
-        std::vector<glm::vec3> currentTorchPositions;
-        for (const auto& obj : scene.objects) {
-            if (obj.model == models[7].get()) { // Torch model
-                currentTorchPositions.push_back(glm::vec3(obj.modelMatrix[3]));
-            }
+        // Stream transforms to the GPU once per frame (all views share them)
+        if (gpuDrivenEnabled) {
+            gpuRenderer.updateTransforms(scene);
         }
 
-        if (!currentTorchPositions.empty()) {
-            lightingManager.updateTorchPositions(currentTorchPositions);
+        // Torch lights follow their meshes, flames flicker
+        lightAnimator.update(currentFrame, scene, lightingManager);
+
+        // Shared uniform blocks: time, and the lights if anything about them changed
+        UniformBuffers::beginFrame(currentFrame);
+        lightingManager.updateUniformBuffer();
+        ClusteredLighting::updateLights(lightingManager);
+        deferredRenderer.updateLights(lightingManager);
+        Lightmap::updateLights(lightingManager);
+        if (const IrradianceProbes* probes = Lightmap::getProbes()) {
+            animatedRenderer.updateProbeLighting(*probes, currentFrame);
         }
 
         portalSystem.updateDistances(cameraPos);
@@ -601,9 +1159,9 @@ int main() {
         if (debugFrameCounter % 60 == 0) { // Every 2 seconds at 60fps
             DebugSystem::printCameraInfo(cameraPos, cameraFront, yaw, pitch);
             DebugSystem::printLightingInfo(lightingManager);
-            DebugSystem::printSceneInfo(scene, models[0], models[1], models[2],
-                models[3], models[4], models[8], nullptr,
-                models[5], models[6], models[7]);
+            DebugSystem::printSceneInfo(scene, bookModel, bookshelfModel, bookshelf2Model, torchModel);
+            DebugSystem::printMemoryInfo();
+            if (DebugSystem::isDebugMode()) ShadowAtlas::printStats();
         }
 
         // Setup matrices
@@ -611,9 +1169,22 @@ int main() {
         glm::mat4 projection = glm::perspective(glm::radians(60.0f),
             static_cast<float>(Config::WIDTH) / static_cast<float>(Config::HEIGHT), 0.1f, 100.0f);
 
-        // Clear screen with dark atmosphere
-        glClearColor(0.01f, 0.008f, 0.005f, 1.0f);
-        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        // Point shadow faces the views can see, within the per-frame budget
+        if (ShadowAtlas::isEnabled()) {
+            movingCasters.clear();
+            for (const auto& obj : scene.objects) {
+                if (!obj.gpuAnimated && !isStaticCaster(obj) && obj.model->vertexCount > 0) movingCasters.push_back(casterSphere(obj));
+            }
+            animatedRenderer.getInstanceSpheres(currentFrame, movingCasters);
+            ShadowAtlas::update(lightingManager, projection * view, movingCasters,
+                [&](const glm::vec3& lightPosition) { drawShadowCasters(lightPosition, true); },
+                [&](const glm::vec3& lightPosition) { drawShadowCasters(lightPosition, false); });
+        }
+
+        // HDR scene target, cleared to the dark atmosphere (portal views return to it)
+        int framebufferWidth = 0, framebufferHeight = 0;
+        glfwGetFramebufferSize(window, &framebufferWidth, &framebufferHeight);
+        PostProcess::beginScene(framebufferWidth, framebufferHeight);
 
         // Render portal views first for infinite effect
         if (recursivePortalsEnabled) {
@@ -621,15 +1192,51 @@ int main() {
         }
 
         // Render main scene
-        renderSceneFunc(view, projection);
+        if (deferredShadingEnabled) {
+            renderDeferred(view, projection, framebufferWidth, framebufferHeight);
+        }
+        else {
+            renderSceneFunc(view, projection);
+        }
+        VirtualTexture::endFrame();  // After all views - portal views request pages too
+
+        // Tint, tone mapping and gamma once for the whole frame, portals included
+        PostProcess::resolve();
 
         glfwSwapBuffers(window);
         glfwPollEvents();
+
+        // Free meshes/textures nothing references any more, then drop or restore mips for the budget
+        AssetRegistry::collectGarbage();
+        AssetRegistry::enforceTextureBudget();
+
+        if (!firstFramePresented) {
+            firstFramePresented = true;
+            std::cout << "Time to first frame: " << msSinceStartup() << " ms ("
+                << AsyncLoader::getPendingCount() << " assets still streaming)" << std::endl;
+        }
     }
 
     // Cleanup
+    AsyncLoader::stop();
+    TextureStreamer::shutdown();
+    VirtualTexture::shutdown();
     portalSystem.cleanup();
+    lightingManager.cleanup();
+    ClusteredLighting::shutdown();
+    deferredRenderer.cleanup();
+    Lightmap::shutdown();
+    ShadowAtlas::shutdown();
+    PostProcess::shutdown();
+    UniformBuffers::shutdown();
+    gpuRenderer.cleanup();
+    animatedRenderer.cleanup();
+    MaterialManager::cleanup();
     TextureManager::cleanup();
+    scene.clear();
+    models = LibraryModels();
+    AssetRegistry::shutdown();
+    AssetArchive::unmount();
     glfwDestroyWindow(window);
     glfwTerminate();
     return 0;
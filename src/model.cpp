@@ -1,75 +1,128 @@
 #include "model.hpp"
-#define TINYOBJLOADER_IMPLEMENTATION
-#include "tiny_obj_loader.h"
+#include "MeshData.hpp"
+#include "AssetArchive.hpp"
+#include "GpuMemory.hpp"
 #include <iostream>
 
+namespace {
+    // Unit cube (36 vertices) drawn in place of a mesh that is still loading
+    std::vector<float> placeholderCube() {
+        const glm::vec3 normals[6] = {
+            { 1, 0, 0 }, { -1, 0, 0 }, { 0, 1, 0 }, { 0, -1, 0 }, { 0, 0, 1 }, { 0, 0, -1 }
+        };
+        const float corners[6][2] = { { -1, -1 }, { 1, -1 }, { 1, 1 }, { -1, -1 }, { 1, 1 }, { -1, 1 } };
+
+        std::vector<float> vertices;
+        vertices.reserve(36 * 8);
+        for (const glm::vec3& n : normals) {
+            // Two tangent axes spanning the face
+            glm::vec3 u = (n.x != 0.0f) ? glm::vec3(0, 1, 0) : glm::vec3(1, 0, 0);
+            glm::vec3 v = glm::cross(n, u);
+            for (const auto& c : corners) {
+                glm::vec3 p = 0.5f * (n + c[0] * u + c[1] * v);
+                float vertex[8] = { p.x, p.y, p.z, n.x, n.y, n.z, 0.5f + 0.5f * c[0], 0.5f + 0.5f * c[1] };
+                vertices.insert(vertices.end(), vertex, vertex + 8);
+            }
+        }
+        return vertices;
+    }
+}
+
+Model::Model() {
+    // Render a stand-in until the worker thread has the real mesh ready
+    std::vector<float> cube = placeholderCube();
+    upload(cube.data(), cube.size() / 8);
+}
+
 Model::Model(const std::string& path) {
-	std::vector<float> vertexData; // Vector to hold vertex data (positions, normals, UVs)
-
-    // Load OBJ file using TinyObjLoader library
-    tinyobj::attrib_t attrib;                    // Vertex attributes (positions, normals, UVs)
-    std::vector<tinyobj::shape_t> shapes;        // Mesh shapes/objects
-    std::vector<tinyobj::material_t> materials;  // Material definitions (unused)
-    std::string warn, err;                       // Warning and error messages
-
-    bool success = tinyobj::LoadObj(&attrib, &shapes, &materials, &warn, &err, path.c_str());
-    if (!success) {
-        std::cerr << "Failed to load OBJ: " << err << std::endl;
-        vertexCount = 0;
+    boundsMin = boundsMax = glm::vec3(0.0f);
+
+    // Packed meshes are already flattened - upload straight from the mapped archive
+    const ArchiveEntry* entry = AssetArchive::find(path);
+    if (entry && entry->type == static_cast<uint32_t>(ArchiveEntryType::Mesh)) {
+        std::vector<uint8_t> scratch;
+        const uint8_t* blob = AssetArchive::data(*entry, scratch);
+        if (blob) {
+            upload(reinterpret_cast<const float*>(blob), entry->width);
+            return;
+        }
+    }
+
+    // Loose OBJ file
+    MeshData mesh;
+    if (!MeshData::loadObj(path, mesh)) {
         return;
     }
+    upload(mesh.vertices.data(), mesh.vertexCount());
+}
 
-    // Process all shapes in the loaded model
-    for (const auto& shape : shapes) {
-        // Process each triangle face
-        for (const auto& index : shape.mesh.indices) {
-            // Extract vertex position from attribute arrays
-            float vx = attrib.vertices[3 * index.vertex_index + 0];  // X coordinate
-            float vy = attrib.vertices[3 * index.vertex_index + 1];  // Y coordinate
-            float vz = attrib.vertices[3 * index.vertex_index + 2];  // Z coordinate
-
-            // Extract vertex normal (or use default if model has no normals)
-            float nx = attrib.normals.empty() ? 0.0f : attrib.normals[3 * index.normal_index + 0];
-            float ny = attrib.normals.empty() ? 0.0f : attrib.normals[3 * index.normal_index + 1];
-            float nz = attrib.normals.empty() ? 0.0f : attrib.normals[3 * index.normal_index + 2];
-
-            // Extract texture coordinates (or use default if model has no UVs)
-            float tx = attrib.texcoords.empty() ? 0.0f : attrib.texcoords[2 * index.texcoord_index + 0];
-            float ty = attrib.texcoords.empty() ? 0.0f : attrib.texcoords[2 * index.texcoord_index + 1];
-
-            // Pack vertex data: [position(3) + normal(3) + texcoord(2)] = 8 floats per vertex
-            vertexData.insert(vertexData.end(), { vx, vy, vz, nx, ny, nz, tx, ty });
-        }
+Model::~Model() {
+    if (VBO) glDeleteBuffers(1, &VBO);
+    GpuMemory::release(GpuMemoryCategory::Meshes, vertexCount * 8 * sizeof(float));
+    if (lightmapVBO) {
+        glDeleteBuffers(1, &lightmapVBO);
+        GpuMemory::release(GpuMemoryCategory::Meshes, vertexCount * 2 * sizeof(float));
     }
+    if (VAO) glDeleteVertexArrays(1, &VAO);
+}
+
+void Model::upload(const float* vertices, size_t count) {
+    GpuMemory::release(GpuMemoryCategory::Meshes, vertexCount * 8 * sizeof(float));
+    GpuMemory::allocate(GpuMemoryCategory::Meshes, count * 8 * sizeof(float));
+    vertexCount = count;
+    MeshData::computeBounds(vertices, count, boundsMin, boundsMax);
+
+    // Create OpenGL buffer objects on first upload
+    if (VAO == 0) {
+        glGenVertexArrays(1, &VAO);  // Vertex Array Object - stores vertex attribute setup
+        glGenBuffers(1, &VBO);       // Vertex Buffer Object - stores actual vertex data (raw data)
+        glBindVertexArray(VAO);      // Bind VAO to set up vertex attributes
+        glBindBuffer(GL_ARRAY_BUFFER, VBO);
+
+        // Position attribute (location = 0 in vertex shader)
+        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)0);
+        glEnableVertexAttribArray(0);
 
-    vertexCount = vertexData.size() / 8; // Each vertex is 8 floats
+        // Normal attribute (location = 1 in vertex shader)
+        glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(3 * sizeof(float)));
+        glEnableVertexAttribArray(1);
 
-    // Create OpenGL buffer objects
-    glGenVertexArrays(1, &VAO);  // Vertex Array Object - stores vertex attribute setup
-	glGenBuffers(1, &VBO);       // Vertex Buffer Object - stores actual vertex data (raw data)
-	glBindVertexArray(VAO);      // Bind VAO to set up vertex attributes
+        // Texture coordinate attribute (location = 2 in vertex shader)
+        glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(6 * sizeof(float)));
+        glEnableVertexAttribArray(2);
 
-    // Upload vertex data to GPU
+        glBindVertexArray(0);  // Unbind VAO to prevent accidental modification
+    }
+
+    // Upload vertex data to GPU (replaces any placeholder contents)
     glBindBuffer(GL_ARRAY_BUFFER, VBO);
-    glBufferData(GL_ARRAY_BUFFER, vertexData.size() * sizeof(float), vertexData.data(), GL_STATIC_DRAW);
+    glBufferData(GL_ARRAY_BUFFER, count * 8 * sizeof(float), vertices, GL_STATIC_DRAW);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
 
-    // Position attribute (location = 0 in vertex shader)
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)0);
-    glEnableVertexAttribArray(0);
+bool Model::setLightmapCoords(const float* coords, size_t count) {
+    if (VAO == 0 || count != vertexCount) return false;
 
-    // Normal attribute (location = 1 in vertex shader)
-    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(3 * sizeof(float)));
-    glEnableVertexAttribArray(1);
+    if (!lightmapVBO) {
+        glGenBuffers(1, &lightmapVBO);
+        GpuMemory::allocate(GpuMemoryCategory::Meshes, count * 2 * sizeof(float));
+    }
+    glBindVertexArray(VAO);
+    glBindBuffer(GL_ARRAY_BUFFER, lightmapVBO);
+    glBufferData(GL_ARRAY_BUFFER, count * 2 * sizeof(float), coords, GL_STATIC_DRAW);
 
-    // Texture coordinate attribute (location = 2 in vertex shader)
-    glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(6 * sizeof(float)));
-    glEnableVertexAttribArray(2);
+    // Lightmap coordinate attribute (location = 3, only read by the LIGHTMAP_STATIC_LIGHTS programs)
+    glVertexAttribPointer(3, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float), (void*)0);
+    glEnableVertexAttribArray(3);
 
-    glBindVertexArray(0);  // Unbind VAO to prevent accidental modification
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    return true;
 }
 
 void Model::draw() const {
+    if (vertexCount == 0) return;                                    // Failed to load
     glBindVertexArray(VAO);                                          // Bind this model's VAO
     glDrawArrays(GL_TRIANGLES, 0, static_cast<GLsizei>(vertexCount)); // Draw all triangles
     glBindVertexArray(0);                                            // Unbind VAO
-}
\ No newline at end of file
+}
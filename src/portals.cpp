@@ -1,5 +1,7 @@
 ﻿// unfortunately its a bit of a mess, but it works...sort of
 #include "portals.hpp"
+#include "GpuMemory.hpp"
+#include "PostProcess.hpp"
 #include <iostream>
 #include <cmath>
 
@@ -32,10 +34,10 @@ void PortalSystem::addPortal(const glm::vec3& position, const glm::vec3& normal)
     glGenFramebuffers(1, &portal.framebuffer);
     glBindFramebuffer(GL_FRAMEBUFFER, portal.framebuffer);
 
-    // Color texture - what you see through the portal
+    // Color texture - what you see through the portal, kept HDR (tone mapped once, with the main view)
     glGenTextures(1, &portal.colorTexture);
     glBindTexture(GL_TEXTURE_2D, portal.colorTexture);
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, textureSize, textureSize, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+    glTexImage2D(GL_TEXTURE_2D, 0, PostProcess::COLOR_FORMAT, textureSize, textureSize, 0, GL_RGB, GL_FLOAT, nullptr);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
@@ -64,6 +66,7 @@ void PortalSystem::addPortal(const glm::vec3& position, const glm::vec3& normal)
     }
 
     generatePortalGeometry(portal);
+    GpuMemory::allocate(GpuMemoryCategory::RenderTargets, renderTargetBytes());
 
     portals.push_back(portal);
     glBindFramebuffer(GL_FRAMEBUFFER, 0);
@@ -106,6 +109,7 @@ void PortalSystem::generatePortalGeometry(Portal& portal) { // had quad.obj but
     // Upload index data
     glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, portal.portalEBO);
     glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(indices), indices, GL_STATIC_DRAW);
+    GpuMemory::allocate(GpuMemoryCategory::Buffers, sizeof(vertices) + sizeof(indices));
 
     // Position attribute (location = 0 in vertex shader)
     glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void*)0);
@@ -126,6 +130,7 @@ void PortalSystem::cleanupPortalGeometry(Portal& portal) {
     if (portal.portalVBO) {
         glDeleteBuffers(1, &portal.portalVBO);
         portal.portalVBO = 0;
+        GpuMemory::release(GpuMemoryCategory::Buffers, 4 * 5 * sizeof(float) + 6 * sizeof(unsigned int));
     }
     if (portal.portalEBO) {
         glDeleteBuffers(1, &portal.portalEBO);
@@ -195,8 +200,7 @@ void PortalSystem::renderAllPortalsAtDepth(
 
         // Only clear on the deepest level to avoid overwriting recursion
         if (targetDepth == PortalConstants::RENDER_RECURSION_LIMIT - 1) {
-            glClearColor(0.01f, 0.008f, 0.005f, 1.0f);
-            glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+            PostProcess::clear();
         }
 
         // Set render state
@@ -310,15 +314,10 @@ void PortalSystem::calculateTransformedCamera(const Portal& fromPortal, const Po
     outUp = glm::vec3(0, 1, 0);
 }
 
-void PortalSystem::renderPortalSurfaces(Shader& portalShader, const glm::mat4& view, const glm::mat4& projection,
-    const glm::vec3& cameraPos, float time) {
-
+void PortalSystem::renderPortalSurfaces(Shader& portalShader) {
     if (!areActive()) return;
 
     portalShader.use();
-    portalShader.setMat4("view", &view[0][0]);
-    portalShader.setMat4("projection", &projection[0][0]);
-    portalShader.setFloat("time", time);
 
     // CRITICAL FIX: Proper depth testing for portals
     glEnable(GL_DEPTH_TEST);
@@ -354,13 +353,13 @@ void PortalSystem::renderPortalSurfaces(Shader& portalShader, const glm::mat4& v
         // CRITICAL: Scale the portal slightly smaller to fit within doorframe
         portalMatrix = glm::scale(portalMatrix, glm::vec3(0.85f, 0.85f, 1.0f));
 
-        portalShader.setMat4("model", &portalMatrix[0][0]);
-        portalShader.setBool("portalActive", true);
+        portalShader.setMat4("model"_uniform, &portalMatrix[0][0]);
+        portalShader.setBool("portalActive"_uniform, true);
 
         // Bind portal's rendered view texture
         glActiveTexture(GL_TEXTURE0);
         glBindTexture(GL_TEXTURE_2D, portal.colorTexture);
-        portalShader.setInt("portalView", 0);
+        portalShader.setInt("portalView"_uniform, 0);
 
         // Render portal quad
         if (portal.portalVAO != 0) {
@@ -437,6 +436,11 @@ bool PortalSystem::checkPortalCollision(const glm::vec3& oldPos, const glm::vec3
     return false;
 }
 
+size_t PortalSystem::renderTargetBytes() const {
+    return GpuMemory::imageBytes(textureSize, textureSize, PostProcess::COLOR_FORMAT) +
+        GpuMemory::imageBytes(textureSize, textureSize, GL_DEPTH_COMPONENT24);
+}
+
 void PortalSystem::updateDistances(const glm::vec3& playerPos) {
     for (auto& portal : portals) {
         portal.distanceFromPlayer = glm::length(portal.position - playerPos);
@@ -452,6 +456,7 @@ void PortalSystem::cleanup() {
         if (portal.colorTexture) {
             glDeleteTextures(1, &portal.colorTexture);
             portal.colorTexture = 0;
+            GpuMemory::release(GpuMemoryCategory::RenderTargets, renderTargetBytes());
         }
         if (portal.depthTexture) {
             glDeleteTextures(1, &portal.depthTexture);
@@ -2,8 +2,9 @@
 #include <cmath>
 #include <cstdlib>
 
-SceneObject::SceneObject(const Model* modelPtr, const glm::vec3& pos, const glm::vec3& rot, const glm::vec3& scl)
-    : model(modelPtr), position(pos), rotation(rot), scale(scl), basePosition(pos), orbitCenter(pos) {
+SceneObject::SceneObject(const Model* modelPtr, MaterialHandle materialHandle,
+    const glm::vec3& pos, const glm::vec3& rot, const glm::vec3& scl)
+    : model(modelPtr), material(materialHandle), position(pos), rotation(rot), scale(scl), basePosition(pos), orbitCenter(pos) {
     updateModelMatrix();
 
     // Randomize animation start times so objects don't all sync up
@@ -96,14 +97,28 @@ void SceneObject::setOrbiting(bool enabled, const glm::vec3& center, float radiu
 }
 
 // SCNENE CLASS IMPLEMENTATION
-void Scene::addObject(const Model* model, const glm::vec3& position, const glm::vec3& rotation, const glm::vec3& scale) {
-    // Add new object to scene with specified transform
-    objects.emplace_back(model, position, rotation, scale);
+void Scene::addObject(const ModelRef& model, MaterialHandle material,
+    const glm::vec3& position, const glm::vec3& rotation, const glm::vec3& scale) {
+    // Add new object to scene with specified material and transform
+    objects.emplace_back(model.get(), material, position, rotation, scale);
+
+    // Hold the mesh for as long as the scene uses it
+    bool referenced = false;
+    for (const auto& held : models) {
+        if (held.getHandle() == model.getHandle()) referenced = true;
+    }
+    if (!referenced) models.push_back(model);
+}
+
+void Scene::clear() {
+    objects.clear();
+    models.clear();
 }
 
 void Scene::update(float deltaTime) {
     // Update all objects' animations
     for (auto& obj : objects) {
+        if (obj.gpuAnimated) continue;  // Evaluated in the vertex shader instead
         obj.update(deltaTime);
     }
 }
@@ -112,7 +127,7 @@ void Scene::draw(Shader& shader) const {
     // Render all objects using provided shader
     for (const auto& obj : objects) {
         // Set model matrix uniform for this object
-        shader.setMat4("model", &obj.modelMatrix[0][0]);
+        shader.setMat4("model"_uniform, &obj.modelMatrix[0][0]);
         obj.model->draw();  // Render the mesh
     }
 }
\ No newline at end of file
@@ -1,66 +1,365 @@
 #include "shader.hpp"
+#include "AssetArchive.hpp"
+#include "UniformBuffers.hpp"
 #include <fstream>
 #include <sstream>
 #include <iostream>
+#include <algorithm>
+#include <cstring>
+#include <cstdio>
+#include <iterator>
 
-Shader::Shader(const char* vertexPath, const char* fragmentPath) {
-    // Read shader source code from files
-    std::ifstream vShaderFile(vertexPath), fShaderFile(fragmentPath);
-    std::stringstream vShaderStream, fShaderStream;
+#ifdef _WIN32
+#include <direct.h>
+#else
+#include <sys/stat.h>
+#endif
 
-    // Read file contents into string streams
-    vShaderStream << vShaderFile.rdbuf();
-    fShaderStream << fShaderFile.rdbuf();
+namespace {
+    const char* SHADER_CACHE_DIR = "shader_cache";
+    const uint32_t BINARY_MAGIC = 0x42534250;  // "PBSB"
+    const uint32_t CACHE_VERSION = 1;          // Bump when the file layout changes
 
-    // Convert to C strings for OpenGL
-    std::string vertexCode = vShaderStream.str();
-    std::string fragmentCode = fShaderStream.str();
-    const char* vCode = vertexCode.c_str();
-    const char* fCode = fragmentCode.c_str();
+    double millisecondsSince(std::chrono::steady_clock::time_point start) {
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
 
-    // Compile vertex shader
-    GLuint vertex = glCreateShader(GL_VERTEX_SHADER);
-    glShaderSource(vertex, 1, &vCode, NULL);    // Upload source code
-    glCompileShader(vertex);                    // Compile to GPU bytecode
+    // Program binaries need GL 4.1 (or ARB_get_program_binary) and a driver offering at least one format
+    bool binaryCacheSupported() {
+        static int supported = -1;
+        if (supported < 0) {
+            GLint formats = 0;
+            if (GLEW_VERSION_4_1 || GLEW_ARB_get_program_binary) {
+                glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+            }
+            supported = formats > 0 ? 1 : 0;
+            if (supported) {
+#ifdef _WIN32
+                _mkdir(SHADER_CACHE_DIR);
+#else
+                mkdir(SHADER_CACHE_DIR, 0755);
+#endif
+            }
+            else {
+                std::cout << "Program binaries not supported, shaders compile on every run" << std::endl;
+            }
+        }
+        return supported == 1;
+    }
 
-    // Compile fragment shader
-    GLuint fragment = glCreateShader(GL_FRAGMENT_SHADER);
-    glShaderSource(fragment, 1, &fCode, NULL);  // Upload source code
-    glCompileShader(fragment);                  // Compile to GPU bytecode
+    // Binaries only load on the driver that wrote them, so it is part of the cache key
+    const std::string& driverString() {
+        static std::string driver;
+        if (driver.empty()) {
+            for (GLenum name : { GL_VENDOR, GL_RENDERER, GL_VERSION }) {
+                const GLubyte* value = glGetString(name);
+                if (value) driver += reinterpret_cast<const char*>(value);
+                driver += '\n';
+            }
+        }
+        return driver;
+    }
+
+    // Let the driver compile on as many threads as it likes (once, before the first compile)
+    void enableParallelCompile() {
+        static bool done = false;
+        if (done) return;
+        done = true;
+        if (GLEW_KHR_parallel_shader_compile) glMaxShaderCompilerThreadsKHR(0xFFFFFFFFu);
+        else if (GLEW_ARB_parallel_shader_compile) glMaxShaderCompilerThreadsARB(0xFFFFFFFFu);
+    }
+
+    // Cache file: magic, version, binary format, then the binary as returned by glGetProgramBinary
+    bool loadBinary(GLuint program, const std::string& path) {
+        std::ifstream file(path, std::ios::binary);
+        if (!file) return false;
+        uint32_t header[3] = {};
+        file.read(reinterpret_cast<char*>(header), sizeof(header));
+        if (!file || header[0] != BINARY_MAGIC || header[1] != CACHE_VERSION) return false;
+        std::vector<char> binary((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+        if (binary.empty()) return false;
+
+        // No compiling involved, so asking for the status right away doesn't stall
+        glProgramBinary(program, header[2], binary.data(), static_cast<GLsizei>(binary.size()));
+        GLint status = GL_FALSE;
+        glGetProgramiv(program, GL_LINK_STATUS, &status);
+        return status == GL_TRUE;
+    }
+
+    void saveBinary(GLuint program, const std::string& path) {
+        GLint length = 0;
+        glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+        if (length <= 0) return;
+        std::vector<char> binary(static_cast<size_t>(length));
+        GLenum format = 0;
+        glGetProgramBinary(program, length, &length, &format, binary.data());
+
+        std::ofstream file(path, std::ios::binary);
+        const uint32_t header[3] = { BINARY_MAGIC, CACHE_VERSION, format };
+        file.write(reinterpret_cast<const char*>(header), sizeof(header));
+        file.write(binary.data(), length);
+        if (!file) std::cerr << "Failed to write " << path << std::endl;
+    }
+
+    std::string shaderInfoLog(GLuint shader) {
+        GLint length = 0;
+        glGetShaderiv(shader, GL_INFO_LOG_LENGTH, &length);
+        std::string log(static_cast<size_t>(std::max(length, 1)), '\0');
+        glGetShaderInfoLog(shader, length, nullptr, &log[0]);
+        return log;
+    }
+
+    std::string programInfoLog(GLuint program) {
+        GLint length = 0;
+        glGetProgramiv(program, GL_INFO_LOG_LENGTH, &length);
+        std::string log(static_cast<size_t>(std::max(length, 1)), '\0');
+        glGetProgramInfoLog(program, length, nullptr, &log[0]);
+        return log;
+    }
+}
+
+// Read shader source from the mounted asset archive, or from disk if not packed
+static std::string readShaderSource(const char* path) {
+    const ArchiveEntry* entry = AssetArchive::find(path);
+    if (entry) {
+        std::vector<uint8_t> scratch;
+        const uint8_t* text = AssetArchive::data(*entry, scratch);
+        if (text) return std::string(reinterpret_cast<const char*>(text), static_cast<size_t>(entry->size));
+    }
+
+    std::ifstream file(path);
+    std::stringstream stream;
+    stream << file.rdbuf();
+    return stream.str();
+}
+
+// Variants of one source file: #version has to stay the first line, so defines go right after it
+static void insertDefines(std::string& source, const std::string& defines) {
+    if (defines.empty()) return;
+    size_t lineEnd = source.find('\n');
+    source.insert(lineEnd == std::string::npos ? source.size() : lineEnd + 1, defines);
+}
+
+Shader::Shader(const char* vertexPath, const char* fragmentPath, const std::string& defines) {
+    // Read shader source code (archive or loose files)
+    std::vector<Stage> stages = {
+        { GL_VERTEX_SHADER, vertexPath, readShaderSource(vertexPath) },
+        { GL_FRAGMENT_SHADER, fragmentPath, readShaderSource(fragmentPath) }
+    };
+    for (Stage& stage : stages) insertDefines(stage.source, defines);
+    build(stages);
+
+    // Name variants in the log by their defines
+    if (!defines.empty()) {
+        std::string variant = defines;
+        std::replace(variant.begin(), variant.end(), '\n', ' ');
+        label += " [" + variant.substr(0, variant.find_last_not_of(' ') + 1) + "]";
+    }
+}
+
+Shader::Shader(const char* computePath) {
+    // Compute programs have a single stage (compute can't be mixed with graphics stages)
+    std::vector<Stage> stages = {
+        { GL_COMPUTE_SHADER, computePath, readShaderSource(computePath) }
+    };
+    build(stages);
+}
+
+void Shader::build(const std::vector<Stage>& stages) {
+    submitTime = std::chrono::steady_clock::now();
+    enableParallelCompile();
+    for (size_t i = 0; i < stages.size(); i++) {
+        label += (i > 0 ? " + " : "") + std::string(stages[i].path);
+    }
 
-    // Create shader program and link shaders together
     ID = glCreateProgram();
-    glAttachShader(ID, vertex);      // Attach vertex shader
-    glAttachShader(ID, fragment);    // Attach fragment shader
-    glLinkProgram(ID);               // Link into complete program
+
+    // Same sources on the same driver = same binary, so skip the compiler entirely
+    if (binaryCacheSupported()) {
+        std::string keyData = driverString();
+        for (const Stage& stage : stages) {
+            keyData += std::to_string(stage.type) + '\n' + stage.source + '\0';
+        }
+        uint64_t key = AssetArchive::hashBytes(reinterpret_cast<const uint8_t*>(keyData.data()), keyData.size());
+        char name[32];
+        std::snprintf(name, sizeof(name), "/%016llx.bin", static_cast<unsigned long long>(key));
+        binaryPath = std::string(SHADER_CACHE_DIR) + name;
+
+        if (loadBinary(ID, binaryPath)) {
+            binaryPath.clear();
+            submitMs = millisecondsSince(submitTime);
+            return;
+        }
+        glProgramParameteri(ID, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+    }
+
+    // Compile and link without asking for the result - the driver works on it until first use
+    for (const Stage& stage : stages) {
+        const char* code = stage.source.c_str();
+        GLuint shader = glCreateShader(stage.type);
+        glShaderSource(shader, 1, &code, NULL);  // Upload source code
+        glCompileShader(shader);                 // Compile to GPU bytecode
+        glAttachShader(ID, shader);
+        shaders.push_back(shader);
+    }
+    glLinkProgram(ID);
+    submitMs = millisecondsSince(submitTime);
+}
+
+void Shader::completeLink() const {
+    finished = true;
+    bool fromCache = shaders.empty();
+
+    // First status query - blocks until the driver has finished compiling and linking
+    auto waitStart = std::chrono::steady_clock::now();
+    GLint status = GL_FALSE;
+    glGetProgramiv(ID, GL_LINK_STATUS, &status);
+    double waitMs = millisecondsSince(waitStart);
+    linked = status == GL_TRUE;
+
+    if (!linked) {
+        std::cerr << "Shader " << label << " failed to link" << std::endl;
+        for (GLuint shader : shaders) {
+            GLint compiled = GL_FALSE;
+            glGetShaderiv(shader, GL_COMPILE_STATUS, &compiled);
+            if (!compiled) std::cerr << "Compile error:\n" << shaderInfoLog(shader) << std::endl;
+        }
+        std::cerr << "Link error:\n" << programInfoLog(ID) << std::endl;
+    }
 
     // Clean up individual shader objects (no longer needed after linking)
-    glDeleteShader(vertex);
-    glDeleteShader(fragment);
+    for (GLuint shader : shaders) {
+        glDetachShader(ID, shader);
+        glDeleteShader(shader);
+    }
+    shaders.clear();
+
+    if (fromCache) {
+        std::cout << "Shader " << label << ": cached binary loaded in " << submitMs << " ms" << std::endl;
+    }
+    else {
+        std::cout << "Shader " << label << ": compiled and linked within " << millisecondsSince(submitTime)
+                  << " ms (" << submitMs << " ms to submit, " << waitMs << " ms waited at first use)" << std::endl;
+    }
+    if (!linked) return;
+
+    reflectUniforms();
+    UniformBuffers::bindBlocks(ID);
+    if (!binaryPath.empty()) saveBinary(ID, binaryPath);
 }
 
 void Shader::use() const {
+    finishLink();
     glUseProgram(ID);  // Make this shader program active for rendering
 }
 
-// Utility functions for setting shader uniforms
-void Shader::setBool(const std::string& name, bool value) const {
-    glUniform1i(glGetUniformLocation(ID, name.c_str()), (int)value);
+void Shader::reflectUniforms() const {
+    GLint count = 0, maxLength = 0;
+    glGetProgramiv(ID, GL_ACTIVE_UNIFORMS, &count);
+    glGetProgramiv(ID, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxLength);
+    std::vector<char> buffer(static_cast<size_t>(std::max(maxLength, 1)));
+
+    auto add = [&](const std::string& name) {
+        Uniform uniform;
+        uniform.hash = hashUniformName(name.data(), name.size());
+        uniform.location = glGetUniformLocation(ID, name.c_str());
+        if (uniform.location < 0) return;  // Block members have no location
+        uniform.value = values.size();
+        for (const Uniform& other : uniforms) {
+            if (other.location == uniform.location) uniform.value = other.value;
+        }
+        if (uniform.value == values.size()) values.emplace_back();
+        uniforms.push_back(uniform);
+        };
+
+    for (GLint i = 0; i < count; i++) {
+        GLsizei length = 0;
+        GLint size = 0;
+        GLenum type = 0;
+        glGetActiveUniform(ID, static_cast<GLuint>(i), maxLength, &length, &size, &type, buffer.data());
+        std::string name(buffer.data(), static_cast<size_t>(length));
+
+        // Arrays are reported once as "name[0]" - register the bare name and every element
+        size_t bracket = name.size() > 3 ? name.rfind("[0]") : std::string::npos;
+        if (bracket == name.size() - 3) {
+            std::string base = name.substr(0, bracket);
+            add(base);
+            for (GLint element = 1; element < size; element++) {
+                add(base + "[" + std::to_string(element) + "]");
+            }
+        }
+        add(name);
+    }
+
+    std::sort(uniforms.begin(), uniforms.end(), [](const Uniform& a, const Uniform& b) { return a.hash < b.hash; });
+    for (size_t i = 1; i < uniforms.size(); i++) {
+        if (uniforms[i].hash == uniforms[i - 1].hash && uniforms[i].location != uniforms[i - 1].location) {
+            std::cerr << "Shader " << ID << ": uniform name hash collision" << std::endl;
+        }
+    }
+}
+
+UniformHandle Shader::getUniform(UniformName name) const {
+    finishLink();
+    auto it = std::lower_bound(uniforms.begin(), uniforms.end(), name.hash,
+        [](const Uniform& uniform, uint32_t hash) { return uniform.hash < hash; });
+    if (it == uniforms.end() || it->hash != name.hash) return -1;
+    return static_cast<UniformHandle>(it - uniforms.begin());
+}
+
+bool Shader::changed(UniformHandle handle, const void* data, size_t bytes) const {
+    if (handle < 0) return false;
+    UniformValue& value = values[uniforms[handle].value];
+    if (value.cached && std::memcmp(value.bits, data, bytes) == 0) return false;
+    std::memcpy(value.bits, data, bytes);
+    value.cached = true;
+    return true;
 }
 
-void Shader::setInt(const std::string& name, int value) const {
-    glUniform1i(glGetUniformLocation(ID, name.c_str()), value);
+// Utility functions for setting shader uniforms (skipped when the value is already there)
+void Shader::setInt(UniformHandle uniform, int value) const {
+    if (changed(uniform, &value, sizeof(value))) glUniform1i(uniforms[uniform].location, value);
 }
 
-void Shader::setFloat(const std::string& name, float value) const {
-    glUniform1f(glGetUniformLocation(ID, name.c_str()), value);
+void Shader::setUint(UniformHandle uniform, unsigned int value) const {
+    if (changed(uniform, &value, sizeof(value))) glUniform1ui(uniforms[uniform].location, value);
 }
 
-void Shader::setVec3(const std::string& name, float x, float y, float z) const {
-    glUniform3f(glGetUniformLocation(ID, name.c_str()), x, y, z);
+void Shader::setFloat(UniformHandle uniform, float value) const {
+    if (changed(uniform, &value, sizeof(value))) glUniform1f(uniforms[uniform].location, value);
 }
 
-void Shader::setMat4(const std::string& name, const float* mat) const {
+void Shader::setVec2(UniformHandle uniform, float x, float y) const {
+    const float value[2] = { x, y };
+    if (changed(uniform, value, sizeof(value))) glUniform2f(uniforms[uniform].location, x, y);
+}
+
+void Shader::setIVec2(UniformHandle uniform, int x, int y) const {
+    const int value[2] = { x, y };
+    if (changed(uniform, value, sizeof(value))) glUniform2i(uniforms[uniform].location, x, y);
+}
+
+void Shader::setVec3(UniformHandle uniform, float x, float y, float z) const {
+    const float value[3] = { x, y, z };
+    if (changed(uniform, value, sizeof(value))) glUniform3f(uniforms[uniform].location, x, y, z);
+}
+
+void Shader::setVec4(UniformHandle uniform, float x, float y, float z, float w) const {
+    const float value[4] = { x, y, z, w };
+    if (changed(uniform, value, sizeof(value))) glUniform4f(uniforms[uniform].location, x, y, z, w);
+}
+
+void Shader::setMat4(UniformHandle uniform, const float* mat) const {
     // Upload 4x4 matrix (GL_FALSE means don't transpose)
-    glUniformMatrix4fv(glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE, mat);
-}
\ No newline at end of file
+    if (changed(uniform, mat, 16 * sizeof(float))) glUniformMatrix4fv(uniforms[uniform].location, 1, GL_FALSE, mat);
+}
+
+void Shader::setVec4Array(UniformHandle uniform, const float* data, GLsizei count) const {
+    // Too big for the cache - always uploaded, and the elements' cached values no longer hold
+    if (uniform < 0) return;
+    glUniform4fv(uniforms[uniform].location, count, data);
+    GLint first = uniforms[uniform].location;
+    for (const Uniform& entry : uniforms) {
+        if (entry.location >= first && entry.location < first + count) values[entry.value].cached = false;
+    }
+}
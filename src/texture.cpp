@@ -1,37 +1,477 @@
 #define STB_IMAGE_IMPLEMENTATION  // Include implementation of stb_image
 #include "texture.hpp"
 #include "stb_image.h"
+#include "AssetArchive.hpp"
+#include "DdsFile.hpp"
+#include "GpuMemory.hpp"
 #include <iostream>
+#include <fstream>
+#include <iterator>
+#include <cstdio>
+#include <cstring>
+#include <algorithm>
+#include <atomic>
 
-GLuint Texture::load(const std::string& path, bool flip) {
+#ifdef _WIN32
+#include <direct.h>
+#else
+#include <sys/stat.h>
+#endif
+
+// Static member definitions - block compression and quality settings
+bool Texture::compressionEnabled = false;
+bool Texture::bc7Supported = false;
+TextureQuality Texture::quality = TextureQuality::High;
+
+namespace {
+    const char* TEXTURE_CACHE_DIR = "texture_cache";
+    const uint64_t CACHE_VERSION = 2;  // Bump when filtering or encoding changes, old entries are then ignored
+
+    void makeCacheDirectory() {
+#ifdef _WIN32
+        _mkdir(TEXTURE_CACHE_DIR);
+#else
+        mkdir(TEXTURE_CACHE_DIR, 0755);
+#endif
+    }
+
+    GLenum compressedFormat(BlockFormat format) {
+        switch (format) {
+        case BlockFormat::BC1: return GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+        case BlockFormat::BC3: return GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+        case BlockFormat::BC4: return GL_COMPRESSED_RED_RGTC1;
+        case BlockFormat::BC5: return GL_COMPRESSED_RG_RGTC2;
+        case BlockFormat::BC7: return GL_COMPRESSED_RGBA_BPTC_UNORM;
+        default: return 0;
+        }
+    }
+
+    bool readFile(const std::string& path, std::vector<uint8_t>& bytes) {
+        std::ifstream file(path, std::ios::binary);
+        if (!file) return false;
+        bytes.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+        return true;
+    }
+
+    // Written under a temporary name and renamed into place, so decode workers producing the same
+    // key at once never leave (or read) a half-written entry. Losing the race is fine: same content.
+    bool writeFile(const std::string& path, const std::vector<uint8_t>& bytes) {
+        static std::atomic<unsigned> tempCounter(0);
+        std::string tempPath = path + "." + std::to_string(tempCounter++) + ".tmp";
+        {
+            std::ofstream file(tempPath, std::ios::binary);
+            if (!file) return false;
+            file.write(reinterpret_cast<const char*>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+            if (!file) {
+                file.close();
+                std::remove(tempPath.c_str());
+                return false;
+            }
+        }
+        if (std::rename(tempPath.c_str(), path.c_str()) == 0) return true;
+        std::remove(tempPath.c_str());  // Windows refuses to rename over an existing file
+        return static_cast<bool>(std::ifstream(path, std::ios::binary));
+    }
+
+    // Encoded image bytes for path: a packed PNG/JPEG entry, or the loose file (also for cooked entries,
+    // which only cover the compressed case). Decoded archive entries have no source bytes.
+    bool readSource(const std::string& path, std::vector<uint8_t>& buffer, const uint8_t*& data, size_t& size) {
+        const ArchiveEntry* entry = AssetArchive::find(path);
+        if (entry && entry->type == static_cast<uint32_t>(ArchiveEntryType::TextureEncoded)) {
+            data = AssetArchive::data(*entry, buffer);
+            size = static_cast<size_t>(entry->size);
+            return data != nullptr;
+        }
+        if (entry && entry->type != static_cast<uint32_t>(ArchiveEntryType::TextureCompressed)) return false;
+        if (!readFile(path, buffer) || buffer.empty()) return false;
+        data = buffer.data();
+        size = buffer.size();
+        return true;
+    }
+
+    std::string cacheFileName(uint64_t key) {
+        char name[64];
+        std::snprintf(name, sizeof(name), "%s/%016llx.dds", TEXTURE_CACHE_DIR, static_cast<unsigned long long>(key));
+        return name;
+    }
+
+    // One decoded ORM source channel (pixels is null when the constant is used)
+    struct OrmChannel {
+        std::unique_ptr<unsigned char, ImageFree> pixels;
+        int width = 0, height = 0;
+    };
+
+    // Bilinear sample of a channel at the centre of texel (x, y) of a width x height image
+    uint8_t sampleChannel(const OrmChannel& channel, int x, int y, int width, int height) {
+        const unsigned char* pixels = channel.pixels.get();
+        if (channel.width == width && channel.height == height) return pixels[size_t(y) * width + x];
+
+        float u = std::max(0.0f, (x + 0.5f) * channel.width / width - 0.5f);
+        float v = std::max(0.0f, (y + 0.5f) * channel.height / height - 0.5f);
+        int x0 = std::min(static_cast<int>(u), channel.width - 1), x1 = std::min(x0 + 1, channel.width - 1);
+        int y0 = std::min(static_cast<int>(v), channel.height - 1), y1 = std::min(y0 + 1, channel.height - 1);
+        float fx = u - x0, fy = v - y0;
+        auto at = [&](int sx, int sy) { return static_cast<float>(pixels[size_t(sy) * channel.width + sx]); };
+        float top = at(x0, y0) + (at(x1, y0) - at(x0, y0)) * fx;
+        float bottom = at(x0, y1) + (at(x1, y1) - at(x0, y1)) * fx;
+        return static_cast<uint8_t>(top + (bottom - top) * fy + 0.5f);
+    }
+
+    // Repeat wrapping and trilinear filtering for material textures
+    void setSampling() {
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);     // Horizontal wrapping
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);     // Vertical wrapping
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR); // Minification filter
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR); // Magnification filter
+    }
+
+    // Point image at a DDS file held in memory (scratch or the mapped archive)
+    bool useDds(const uint8_t* file, size_t size, DecodedImage& image) {
+        const uint8_t* payload = nullptr;
+        if (!DdsFile::parse(file, size, image.format, image.levels, payload)) return false;
+        image.pixels = payload;
+        image.width = static_cast<int>(image.levels[0].width);
+        image.height = static_cast<int>(image.levels[0].height);
+        return true;
+    }
+}
+
+std::string OrmSource::key() const {
+    return "orm:" + occlusion + "|" + roughness + "|" + metallic + "|" + std::to_string(occlusionValue) + "," +
+        std::to_string(roughnessValue) + "," + std::to_string(metallicValue);
+}
+
+void ImageFree::operator()(unsigned char* pixels) const {
+    stbi_image_free(pixels);
+}
+
+GpuTexture::~GpuTexture() {
+    glDeleteTextures(1, &id);
+    GpuMemory::release(GpuMemoryCategory::Textures, bytes);
+}
+
+void GpuTexture::setBytes(size_t newBytes) {
+    GpuMemory::release(GpuMemoryCategory::Textures, bytes);
+    GpuMemory::allocate(GpuMemoryCategory::Textures, newBytes);
+    bytes = newBytes;
+    if (droppedLevels == 0) fullBytes = newBytes;
+}
+
+void Texture::configureCompression(bool enabled) {
+    // S3TC is an extension on desktop GL (always present in practice), RGTC is core 3.0, BPTC core 4.2
+    compressionEnabled = enabled && GLEW_EXT_texture_compression_s3tc;
+    bc7Supported = GLEW_VERSION_4_2 || GLEW_ARB_texture_compression_bptc;
+
+    if (enabled && !compressionEnabled) {
+        std::cout << "S3TC not supported, textures stay uncompressed" << std::endl;
+    }
+    std::cout << "Texture compression: " << (compressionEnabled ? "BCn" : "OFF")
+        << (compressionEnabled && bc7Supported ? " (BC7 available)" : "") << std::endl;
+}
+
+bool Texture::decodeCached(const std::string& path, bool flip, bool allowCompression, DecodedImage& image) {
+    bool compress = compressionEnabled && allowCompression;
+
+    // 1. Cooked by BABELPack --compress-textures - straight from the mapping. The packer cooks BC7
+    // where it fits; without BPTC such entries go through the source and the cache (BC3/BC1) instead.
+    const ArchiveEntry* entry = AssetArchive::find(path);
+    bool cooked = entry && entry->type == static_cast<uint32_t>(ArchiveEntryType::TextureCompressed);
+    if (cooked && flip && compress) {
+        const uint8_t* file = AssetArchive::data(*entry, image.scratch);
+        if (!file || !useDds(file, static_cast<size_t>(entry->size), image)) return false;
+        if (image.format != BlockFormat::BC7 || bc7Supported) return true;
+        image = DecodedImage();
+    }
+
+    // Source bytes (packed PNG/JPEG or loose file)
+    std::vector<uint8_t> sourceBuffer;
+    const uint8_t* source = nullptr;
+    size_t sourceSize = 0;
+    if (!readSource(path, sourceBuffer, source, sourceSize)) return false;
+
+    // 2. Cache hit - key covers the image content and everything that changes the output
+    TextureUsage usage = BlockCompression::usageFromPath(path);
+    uint64_t key = AssetArchive::hashBytes(source, sourceSize);
+    key ^= (static_cast<uint64_t>(usage) << 1) | (flip ? 1 : 0) | (bc7Supported ? 8 : 0) |
+        (compress ? 16 : 0) | (CACHE_VERSION << 8);
+    std::string cacheName = cacheFileName(key);
+
+    if (readFile(cacheName, image.scratch) && useDds(image.scratch.data(), image.scratch.size(), image)) {
+        return true;
+    }
+
+    // 3. First load - decode, filter the mip chain, encode and cache the result
+    int width, height, channels;
+    std::unique_ptr<unsigned char, ImageFree> pixels(stbi_load_from_memory(source, static_cast<int>(sourceSize),
+        &width, &height, &channels, 0));
+    if (!pixels) return false;
+
+    BlockFormat format = channels == 1 ? BlockFormat::R8 : BlockFormat::RGBA8;
+    if (compress) {
+        bool alpha = BlockCompression::hasAlpha(pixels.get(), width, height, channels);
+        format = BlockCompression::chooseFormat(usage, alpha, bc7Supported);
+    }
+
+    std::vector<ImageLevel> levels;
+    std::vector<uint8_t> encoded;
+    BlockCompression::encodeMipChain(pixels.get(), width, height, channels, format,
+        usage == TextureUsage::Albedo, levels, encoded);
+    pixels.reset();
+    DdsFile::serialize(format, levels, encoded.data(), image.scratch);
+
+    makeCacheDirectory();
+    if (!writeFile(cacheName, image.scratch)) {
+        std::cerr << "Could not write texture cache " << cacheName << std::endl;
+    }
+    return useDds(image.scratch.data(), image.scratch.size(), image);
+}
+
+bool Texture::decodeOrm(const OrmSource& source, DecodedImage& image) {
+    stbi_set_flip_vertically_on_load_thread(true);
+    const std::string* paths[3] = { &source.occlusion, &source.roughness, &source.metallic };
+    const float constants[3] = { source.occlusionValue, source.roughnessValue, source.metallicValue };
+
+    // 1. Cache hit - key covers each channel's image content (or constant) and the output settings
+    std::vector<uint8_t> buffers[3];
+    const uint8_t* sources[3] = {};
+    size_t sourceSizes[3] = {};
+    uint64_t keyParts[4] = {};
+    for (int c = 0; c < 3; c++) {
+        if (!paths[c]->empty() && readSource(*paths[c], buffers[c], sources[c], sourceSizes[c])) {
+            keyParts[c] = AssetArchive::hashBytes(sources[c], sourceSizes[c]);
+            continue;
+        }
+        if (!paths[c]->empty()) {
+            std::cerr << "ORM channel image not found: " << *paths[c] << ", using constant" << std::endl;
+        }
+        sources[c] = nullptr;
+        uint32_t bits;
+        std::memcpy(&bits, &constants[c], sizeof(bits));
+        keyParts[c] = bits;
+    }
+    keyParts[3] = 32 | (bc7Supported ? 8 : 0) | (compressionEnabled ? 16 : 0) | (CACHE_VERSION << 8);
+    uint64_t key = AssetArchive::hashBytes(reinterpret_cast<const uint8_t*>(keyParts), sizeof(keyParts));
+    std::string cacheName = cacheFileName(key);
+
+    if (readFile(cacheName, image.scratch) && useDds(image.scratch.data(), image.scratch.size(), image)) {
+        return true;
+    }
+
+    // 2. Decode the channels as grey - the output takes the size of the largest one
+    OrmChannel channels[3];
+    int width = 0, height = 0;
+    for (int c = 0; c < 3; c++) {
+        if (!sources[c]) continue;
+        int components;
+        channels[c].pixels.reset(stbi_load_from_memory(sources[c], static_cast<int>(sourceSizes[c]),
+            &channels[c].width, &channels[c].height, &components, 1));
+        if (!channels[c].pixels) {
+            std::cerr << "Failed to decode ORM channel " << *paths[c] << ", using constant" << std::endl;
+            continue;
+        }
+        width = std::max(width, channels[c].width);
+        height = std::max(height, channels[c].height);
+        buffers[c].clear();
+        buffers[c].shrink_to_fit();
+    }
+    if (width == 0 || height == 0) width = height = 4;  // All constants - one block is enough
+
+    // 3. Interleave (smaller channels resampled, alpha unused), filter linearly and cache
+    std::vector<uint8_t> packed(size_t(width) * height * 4);
+    for (int y = 0; y < height; y++) {
+        for (int x = 0; x < width; x++) {
+            uint8_t* out = &packed[(size_t(y) * width + x) * 4];
+            for (int c = 0; c < 3; c++) {
+                out[c] = channels[c].pixels ? sampleChannel(channels[c], x, y, width, height) :
+                    static_cast<uint8_t>(std::min(1.0f, std::max(0.0f, constants[c])) * 255.0f + 0.5f);
+            }
+            out[3] = 255;
+        }
+    }
+    for (OrmChannel& channel : channels) channel.pixels.reset();
+
+    BlockFormat format = BlockFormat::RGBA8;
+    if (compressionEnabled) format = bc7Supported ? BlockFormat::BC7 : BlockFormat::BC1;
+
+    std::vector<ImageLevel> levels;
+    std::vector<uint8_t> encoded;
+    BlockCompression::encodeMipChain(packed.data(), width, height, 4, format, false, levels, encoded);
+    packed.clear();
+    packed.shrink_to_fit();
+    DdsFile::serialize(format, levels, encoded.data(), image.scratch);
+
+    makeCacheDirectory();
+    if (!writeFile(cacheName, image.scratch)) {
+        std::cerr << "Could not write texture cache " << cacheName << std::endl;
+    }
+    return useDds(image.scratch.data(), image.scratch.size(), image);
+}
+
+bool Texture::decode(const std::string& path, bool flip, DecodedImage& image) {
+    // Set vertical flip option (some image formats are upside down).
+    // Per-thread setting - the global stbi_set_flip_vertically_on_load would race between decode workers.
+    stbi_set_flip_vertically_on_load_thread(flip);
+
+    if (decodeCached(path, flip, true, image)) {
+        return true;
+    }
+    image = DecodedImage();
+
+    // Already decoded and flipped by the packer (--decode-textures) - only the mips are built here
+    const ArchiveEntry* entry = AssetArchive::find(path);
+    if (entry && entry->type == static_cast<uint32_t>(ArchiveEntryType::TextureRaw) && flip) {
+        std::vector<uint8_t> raw;
+        const uint8_t* pixels = AssetArchive::data(*entry, raw);
+        if (pixels) {
+            BlockFormat format = entry->channels == 1 ? BlockFormat::R8 : BlockFormat::RGBA8;
+            BlockCompression::encodeMipChain(pixels, entry->width, entry->height, entry->channels, format,
+                BlockCompression::usageFromPath(path) == TextureUsage::Albedo, image.levels, image.scratch);
+            image.format = format;
+            image.pixels = image.scratch.data();
+            image.width = static_cast<int>(entry->width);
+            image.height = static_cast<int>(entry->height);
+        }
+    }
+
+    if (!image.pixels) {
+        std::cerr << "Failed to load texture: " << path << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool Texture::decodeUncompressed(const std::string& path, DecodedImage& image) {
+    stbi_set_flip_vertically_on_load_thread(true);
+    if (decodeCached(path, true, false, image)) return true;
+    std::cerr << "Failed to load texture: " << path << std::endl;
+    return false;
+}
+
+size_t Texture::upload(GLuint textureID, const DecodedImage& image, int droppedLevels) {
+    glBindTexture(GL_TEXTURE_2D, textureID);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);  // R8 rows aren't 4-byte aligned
+    size_t bytes = 0;
+
+    if (image.levels.empty()) {
+        // Single level without a chain (placeholders)
+        GLenum format = image.channels == 1 ? GL_RED : (image.channels == 3 ? GL_RGB : GL_RGBA);
+        glTexImage2D(GL_TEXTURE_2D, 0, format, image.width, image.height, 0, format, GL_UNSIGNED_BYTE, image.pixels);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, 0);
+        bytes = size_t(image.width) * image.height * (image.channels == 1 ? 1 : 4);
+    }
+    else {
+        // Prebuilt chain: skip the top levels for lower quality tiers and the memory budget
+        size_t first = firstUploadLevel(image.levels, droppedLevels);
+
+        GLenum compressed = compressedFormat(image.format);
+        GLenum format = image.format == BlockFormat::R8 ? GL_RED : GL_RGBA;
+        for (size_t i = first; i < image.levels.size(); i++) {
+            const ImageLevel& level = image.levels[i];
+            GLint target = static_cast<GLint>(i - first);
+            if (compressed) {
+                glCompressedTexImage2D(GL_TEXTURE_2D, target, compressed, level.width, level.height, 0,
+                    static_cast<GLsizei>(level.size), image.pixels + level.offset);
+            }
+            else {
+                glTexImage2D(GL_TEXTURE_2D, target, format, level.width, level.height, 0, format, GL_UNSIGNED_BYTE,
+                    image.pixels + level.offset);
+            }
+            bytes += level.size;
+        }
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, static_cast<GLint>(image.levels.size() - first) - 1);
+    }
+
+    setSampling();
+    return bytes;
+}
+
+size_t Texture::uploadStaged(GLuint textureID, const StagedImage& image, GLuint pixelBuffer) {
+    glBindTexture(GL_TEXTURE_2D, textureID);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    GLenum compressed = compressedFormat(image.format);
+    GLenum format = image.format == BlockFormat::R8 ? GL_RED : GL_RGBA;
+
+    // 1. Storage for every level, no source data (placeholders and budget reloads change the size)
+    for (size_t i = 0; i < image.levels.size(); i++) {
+        const ImageLevel& level = image.levels[i];
+        GLint target = static_cast<GLint>(i);
+        if (compressed) {
+            glCompressedTexImage2D(GL_TEXTURE_2D, target, compressed, level.width, level.height, 0,
+                static_cast<GLsizei>(level.size), nullptr);
+        }
+        else {
+            glTexImage2D(GL_TEXTURE_2D, target, format, level.width, level.height, 0, format, GL_UNSIGNED_BYTE, nullptr);
+        }
+    }
+
+    // 2. Contents from the pixel buffer - pointers are buffer offsets while it is bound
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, pixelBuffer);
+    size_t bytes = 0;
+    for (size_t i = 0; i < image.levels.size(); i++) {
+        const ImageLevel& level = image.levels[i];
+        GLint target = static_cast<GLint>(i);
+        const void* offset = reinterpret_cast<const void*>(static_cast<uintptr_t>(level.offset));
+        if (compressed) {
+            glCompressedTexSubImage2D(GL_TEXTURE_2D, target, 0, 0, level.width, level.height, compressed,
+                static_cast<GLsizei>(level.size), offset);
+        }
+        else {
+            glTexSubImage2D(GL_TEXTURE_2D, target, 0, 0, level.width, level.height, format, GL_UNSIGNED_BYTE, offset);
+        }
+        bytes += level.size;
+    }
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);  // Client-memory uploads elsewhere must not read from it
+
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, static_cast<GLint>(image.levels.size()) - 1);
+    setSampling();
+    return bytes;
+}
+
+size_t Texture::firstUploadLevel(const std::vector<ImageLevel>& levels, int droppedLevels) {
+    // Never below 4x4 (one block)
+    size_t skip = static_cast<size_t>(quality) + static_cast<size_t>(std::max(0, droppedLevels));
+    size_t first = 0;
+    while (first < skip && first + 1 < levels.size() && levels[first + 1].width >= 4 && levels[first + 1].height >= 4) {
+        first++;
+    }
+    return first;
+}
+
+GLuint Texture::load(const std::string& path, bool flip, size_t* bytes) {
     GLuint textureID;
     glGenTextures(1, &textureID);  // Generate OpenGL texture object
 
-    // Set vertical flip option (some image formats are upside down)
-    if (flip) stbi_set_flip_vertically_on_load(true);
+    // CPU image data is freed when image goes out of scope (it's now on the GPU)
+    DecodedImage image;
+    decode(path, flip, image);
+    size_t uploaded = upload(textureID, image);
+    if (bytes) *bytes = uploaded;
+    return textureID;
+}
 
-    // Load image data from file
-    int width, height, nrChannels;
-    unsigned char* data = stbi_load(path.c_str(), &width, &height, &nrChannels, 0);
+GLuint Texture::loadOrm(const OrmSource& source, size_t* bytes) {
+    GLuint textureID;
+    glGenTextures(1, &textureID);
 
-    // Determine OpenGL format based on number of channels
-    GLenum format = GL_RGB;
-    if (nrChannels == 1) format = GL_RED;        // Grayscale
-    else if (nrChannels == 3) format = GL_RGB;   // RGB
-    else if (nrChannels == 4) format = GL_RGBA;  // RGBA with alpha
+    DecodedImage image;
+    if (!decodeOrm(source, image)) {
+        std::cerr << "Failed to build ORM texture: " << source.key() << std::endl;
+    }
+    size_t uploaded = upload(textureID, image);
+    if (bytes) *bytes = uploaded;
+    return textureID;
+}
 
-    // Upload texture data to GPU
-    glBindTexture(GL_TEXTURE_2D, textureID);
-    glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, data);
-    glGenerateMipmap(GL_TEXTURE_2D);  // Generate mipmap chain for better quality at distance
+GLuint Texture::createPlaceholder() {
+    static const unsigned char grey[4] = { 128, 128, 128, 255 };
 
-    // Set texture filtering and wrapping parameters
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);     // Horizontal wrapping
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);     // Vertical wrapping
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR); // Minification filter
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR); // Magnification filter
+    DecodedImage image;
+    image.width = image.height = 1;
+    image.channels = 4;
+    image.pixels = grey;
 
-    // Free CPU image data (it's now on the GPU)
-    stbi_image_free(data);
+    GLuint textureID;
+    glGenTextures(1, &textureID);
+    upload(textureID, image);
     return textureID;
-}
\ No newline at end of file
+}
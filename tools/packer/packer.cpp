@@ -0,0 +1,235 @@
+// BABELPack - offline packer that bakes assets/ and shaders/ into a single .bpak archive
+// Usage: BABELPack [--compress] [--decode-textures] [--compress-textures] [-o assets.bpak] [dir|file ...]
+// Run from the repository root so entry names match the paths the game loads.
+#define STB_IMAGE_IMPLEMENTATION
+#include "stb_image.h"
+#include "AssetArchive.hpp"
+#include "BlockCompression.hpp"
+#include "Compression.hpp"
+#include "DdsFile.hpp"
+#include "MeshData.hpp"
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+struct PackedEntry {
+    std::string name;           // Normalized path, e.g. "assets/models/book.obj"
+    ArchiveEntry entry{};
+    std::vector<uint8_t> blob;  // Bytes as stored (possibly compressed)
+};
+
+struct PackOptions {
+    bool compress = false;        // LZ-compress entries that shrink by at least 10%
+    bool decodeTextures = false;  // Store decoded pixels instead of the original PNG/JPEG
+    bool compressTextures = false;  // Store BCn mip chains (DDS) - overrides decodeTextures
+};
+
+static bool readFile(const fs::path& path, std::vector<uint8_t>& out) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) return false;
+    out.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    return true;
+}
+
+static std::string normalizedName(const fs::path& path) {
+    std::string name = path.lexically_normal().generic_string();
+    if (name.rfind("./", 0) == 0) name = name.substr(2);
+    return name;
+}
+
+static std::string lowerExtension(const fs::path& path) {
+    std::string ext = path.extension().string();
+    std::transform(ext.begin(), ext.end(), ext.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    return ext;
+}
+
+// Convert one source file into its GPU-ready archive form
+static bool packFile(const fs::path& path, const PackOptions& options, PackedEntry& out) {
+    std::string ext = lowerExtension(path);
+    std::vector<uint8_t> raw;
+    out.name = normalizedName(path);
+
+    if (ext == ".obj") {
+        MeshData mesh;
+        if (!MeshData::loadObj(out.name, mesh)) return false;
+        raw.resize(mesh.vertices.size() * sizeof(float));
+        std::memcpy(raw.data(), mesh.vertices.data(), raw.size());
+        out.entry.type = static_cast<uint32_t>(ArchiveEntryType::Mesh);
+        out.entry.width = static_cast<uint32_t>(mesh.vertexCount());
+    }
+    else if (ext == ".png" || ext == ".jpg" || ext == ".jpeg") {
+        if (!readFile(path, raw)) return false;
+        if (options.compressTextures) {
+            // Flipped like Texture::load, format picked from the file name (BC7 for alpha albedo),
+            // gamma-correct mips for albedo
+            int width, height, channels;
+            stbi_set_flip_vertically_on_load(true);
+            unsigned char* pixels = stbi_load_from_memory(raw.data(), static_cast<int>(raw.size()), &width, &height, &channels, 0);
+            if (!pixels) return false;
+
+            TextureUsage usage = BlockCompression::usageFromPath(out.name);
+            bool alpha = BlockCompression::hasAlpha(pixels, width, height, channels);
+            BlockFormat format = BlockCompression::chooseFormat(usage, alpha, true);
+
+            std::vector<ImageLevel> levels;
+            std::vector<uint8_t> blocks;
+            BlockCompression::encodeMipChain(pixels, width, height, channels, format,
+                usage == TextureUsage::Albedo, levels, blocks);
+            stbi_image_free(pixels);
+            DdsFile::serialize(format, levels, blocks.data(), raw);
+
+            out.entry.type = static_cast<uint32_t>(ArchiveEntryType::TextureCompressed);
+            out.entry.width = width;
+            out.entry.height = height;
+            out.entry.channels = channels;
+        }
+        else if (options.decodeTextures) {
+            // Decode once here, flipped the way Texture::load expects
+            int width, height, channels;
+            stbi_set_flip_vertically_on_load(true);
+            unsigned char* pixels = stbi_load_from_memory(raw.data(), static_cast<int>(raw.size()), &width, &height, &channels, 0);
+            if (!pixels) return false;
+            raw.assign(pixels, pixels + size_t(width) * height * channels);
+            stbi_image_free(pixels);
+            out.entry.type = static_cast<uint32_t>(ArchiveEntryType::TextureRaw);
+            out.entry.width = width;
+            out.entry.height = height;
+            out.entry.channels = channels;
+        }
+        else {
+            out.entry.type = static_cast<uint32_t>(ArchiveEntryType::TextureEncoded);
+        }
+    }
+    else if (ext == ".vert" || ext == ".frag" || ext == ".comp" || ext == ".glsl") {
+        if (!readFile(path, raw)) return false;
+        out.entry.type = static_cast<uint32_t>(ArchiveEntryType::Shader);
+    }
+    else {
+        return false;  // Not something the game loads (EXR, displacement maps, ...)
+    }
+
+    out.entry.nameHash = AssetArchive::hashName(out.name);
+    out.entry.size = raw.size();
+
+    // Keep compressed data only when it actually pays off
+    if (options.compress && !raw.empty()) {
+        std::vector<uint8_t> compressed;
+        Compression::compress(raw.data(), raw.size(), compressed);
+        if (compressed.size() < raw.size() - raw.size() / 10) {
+            out.entry.flags |= ArchiveFlags::COMPRESSED;
+            raw.swap(compressed);
+        }
+    }
+
+    out.entry.storedSize = raw.size();
+    out.blob.swap(raw);
+    return true;
+}
+
+static uint64_t alignUp(uint64_t value, uint64_t alignment) {
+    return (value + alignment - 1) / alignment * alignment;
+}
+
+static bool writeArchive(const std::string& outputPath, std::vector<PackedEntry>& packed) {
+    std::sort(packed.begin(), packed.end(),
+        [](const PackedEntry& a, const PackedEntry& b) { return a.entry.nameHash < b.entry.nameHash; });
+
+    for (size_t i = 1; i < packed.size(); i++) {
+        if (packed[i].entry.nameHash == packed[i - 1].entry.nameHash) {
+            std::cerr << "Hash collision: " << packed[i].name << " / " << packed[i - 1].name << std::endl;
+            return false;
+        }
+    }
+
+    ArchiveHeader header{};
+    std::memcpy(header.magic, ArchiveFormat::MAGIC, 4);
+    header.version = ArchiveFormat::VERSION;
+    header.entryCount = static_cast<uint32_t>(packed.size());
+    header.tocOffset = alignUp(sizeof(ArchiveHeader), 64);
+
+    // Assign aligned blob offsets after the TOC
+    uint64_t offset = alignUp(header.tocOffset + packed.size() * sizeof(ArchiveEntry), ArchiveFormat::ALIGNMENT);
+    for (auto& item : packed) {
+        item.entry.offset = offset;
+        offset = alignUp(offset + item.entry.storedSize, ArchiveFormat::ALIGNMENT);
+    }
+
+    std::ofstream file(outputPath, std::ios::binary);
+    if (!file) return false;
+
+    std::vector<char> zeros(ArchiveFormat::ALIGNMENT, 0);
+    auto padTo = [&](uint64_t position) {
+        uint64_t current = static_cast<uint64_t>(file.tellp());
+        if (position > current) file.write(zeros.data(), static_cast<std::streamsize>(position - current));
+    };
+
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    padTo(header.tocOffset);
+    for (const auto& item : packed) {
+        file.write(reinterpret_cast<const char*>(&item.entry), sizeof(ArchiveEntry));
+    }
+    for (const auto& item : packed) {
+        padTo(item.entry.offset);
+        file.write(reinterpret_cast<const char*>(item.blob.data()), static_cast<std::streamsize>(item.blob.size()));
+    }
+    return static_cast<bool>(file);
+}
+
+int main(int argc, char** argv) {
+    PackOptions options;
+    std::string outputPath = "assets.bpak";
+    std::vector<fs::path> inputs;
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--compress") options.compress = true;
+        else if (arg == "--decode-textures") options.decodeTextures = true;
+        else if (arg == "--compress-textures") options.compressTextures = true;
+        else if (arg == "-o" && i + 1 < argc) outputPath = argv[++i];
+        else inputs.push_back(arg);
+    }
+    if (inputs.empty()) inputs = { "assets", "shaders" };
+
+    // Gather files (directories are walked recursively)
+    std::vector<fs::path> files;
+    for (const auto& input : inputs) {
+        if (fs::is_directory(input)) {
+            for (const auto& item : fs::recursive_directory_iterator(input)) {
+                if (item.is_regular_file()) files.push_back(item.path());
+            }
+        }
+        else if (fs::is_regular_file(input)) {
+            files.push_back(input);
+        }
+        else {
+            std::cerr << "Skipping missing input: " << input.string() << std::endl;
+        }
+    }
+
+    std::vector<PackedEntry> packed;
+    uint64_t rawBytes = 0, storedBytes = 0;
+    for (const auto& path : files) {
+        PackedEntry item;
+        if (!packFile(path, options, item)) continue;
+
+        rawBytes += item.entry.size;
+        storedBytes += item.entry.storedSize;
+        std::cout << "Packed " << item.name << " (" << item.entry.size << " -> " << item.entry.storedSize << " bytes)" << std::endl;
+        packed.push_back(std::move(item));
+    }
+
+    if (!writeArchive(outputPath, packed)) {
+        std::cerr << "Failed to write " << outputPath << std::endl;
+        return 1;
+    }
+
+    std::cout << "Wrote " << outputPath << ": " << packed.size() << " entries, "
+        << rawBytes / 1024 << " KB raw, " << storedBytes / 1024 << " KB stored" << std::endl;
+    return 0;
+}